@@ -118,6 +118,15 @@ extern "C"
 
 typedef void (*halUARTCBack_t) (uint8 port, uint8 event);
 
+/* Caller-owned buffer queued by HalUARTWriteDesc() and transmitted in place. */
+typedef struct halUARTTxDesc
+{
+  struct halUARTTxDesc *next;                    // Used by the driver while queued
+  uint8  *pBuf;                                  // Data; must stay valid until pfnDone
+  uint16 len;                                    // Number of bytes to send, 1 to 8191 on DMA
+  void   (*pfnDone) (struct halUARTTxDesc *pDesc); // Called from HalUARTPoll() when sent; may be NULL
+} halUARTTxDesc_t;
+
 typedef struct
 {
   // The head or tail is updated by the Tx or Rx ISR respectively, when not polled.
@@ -188,6 +197,11 @@ extern uint16 HalUARTRead ( uint8 port, uint8 *pBuffer, uint16 length );
  */
 extern uint16 HalUARTWrite ( uint8 port, uint8 *pBuffer, uint16 length );
 
+/*
+ * Queue a caller-owned buffer to be sent in place, without copying
+ */
+extern uint8 HalUARTWriteDesc ( uint8 port, halUARTTxDesc_t *pDesc );
+
 /*
  * Write a buffer to the UART
  */
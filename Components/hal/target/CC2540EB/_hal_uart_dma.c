@@ -51,7 +51,7 @@
 #if defined MT_TASK
 #include "mt_uart.h"
 #endif
-#include "osal.h"
+#include "OSAL.h"
 
 /*********************************************************************
  * MACROS
@@ -173,6 +173,9 @@
 #define HAL_UART_DMA_FULL         (HAL_UART_DMA_RX_MAX - 16)
 #endif
 
+// Longest descriptor buffer: the 13-bit transfer count of one DMA arm.
+#define HAL_UART_DMA_DESC_MAX     (((uint16)HAL_DMA_LEN_H << 8) | 0xFF)
+
 #if defined HAL_BOARD_CC2430EB || defined HAL_BOARD_CC2430DB || defined HAL_BOARD_CC2430BB
 #define HAL_DMA_U0DBUF             0xDFC1
 #define HAL_DMA_U1DBUF             0xDFF9
@@ -203,10 +206,13 @@ typedef struct
 #if HAL_UART_DMA_RX_MAX < 256
   uint8 rxHead;
   uint8 rxTail;
+  uint8 rxCnt;            // Number of bytes between rxHead and rxTail.
 #else
   uint16 rxHead;
   uint16 rxTail;
+  uint16 rxCnt;
 #endif
+  uint8 rxNew;            // findTail() has found bytes not yet seen by the poll.
   uint8 rxTick;
   uint8 rxShdw;
 
@@ -227,6 +233,13 @@ typedef struct
   volatile uint8 txShdwValid; // TX shadow value is valid
   uint8 txDMAPending;     // UART TX DMA is pending
 
+  // Caller-owned buffers sent in place after the copy buffers drain, oldest first.
+  halUARTTxDesc_t *txHead;    // Oldest descriptor not yet given back.
+  halUARTTxDesc_t *txTail;    // Newest descriptor.
+  halUARTTxDesc_t *txNext;    // Next descriptor to send, NULL if all are sent.
+  volatile uint8 txDesc;      // The TX DMA is sending a descriptor.
+  volatile uint8 txDescDone;  // Descriptors sent but not yet given back.
+
   halUARTCBack_t uartCB;
 } uartDMACfg_t;
 
@@ -250,13 +263,14 @@ static uartDMACfg_t dmaCfg;
  * LOCAL FUNCTIONS
  */
 
-static uint16 findTail(void);
+static void findTail(void);
 
 // Invoked by functions in hal_uart.c when this file is included.
 static void HalUARTInitDMA(void);
 static void HalUARTOpenDMA(halUARTCfg_t *config);
 static uint16 HalUARTReadDMA(uint8 *buf, uint16 len);
 static uint16 HalUARTWriteDMA(uint8 *buf, uint16 len);
+static uint8 HalUARTWriteDescDMA(halUARTTxDesc_t *pDesc);
 static void HalUARTPollDMA(void);
 static uint16 HalUARTRxAvailDMA(void);
 static void HalUARTSuspendDMA(void);
@@ -265,30 +279,27 @@ static void HalUARTResumeDMA(void);
 /*****************************************************************************
  * @fn      findTail
  *
- * @brief   Find the rxBuf index where the DMA RX engine is working.
+ * @brief   Advance rxTail to the rxBuf index where the DMA RX engine is working.
+ *          The DMA controller has no readable address or count register, so
+ *          the tail is found from the pad markers; but the walk resumes from
+ *          the last known tail and so only visits the bytes received since,
+ *          and an idle poll checks a single slot.
  *
  * @param   None.
  *
- * @return  Index of tail of rxBuf.
+ * @return  None.
  *****************************************************************************/
-static uint16 findTail(void)
+static void findTail(void)
 {
-  uint16 idx = dmaCfg.rxHead;
-
-  do
+  while ((dmaCfg.rxCnt < HAL_UART_DMA_RX_MAX) && HAL_UART_DMA_NEW_RX_BYTE(dmaCfg.rxTail))
   {
-    if (!HAL_UART_DMA_NEW_RX_BYTE(idx))
-    {
-      break;
-    }
-
-    if (++idx >= HAL_UART_DMA_RX_MAX)
+    if (++(dmaCfg.rxTail) >= HAL_UART_DMA_RX_MAX)
     {
-      idx = 0;
+      dmaCfg.rxTail = 0;
     }
-  } while (idx != dmaCfg.rxHead);
-
-  return idx;
+    dmaCfg.rxCnt++;
+    dmaCfg.rxNew = TRUE;
+  }
 }
 
 /******************************************************************************
@@ -462,6 +473,9 @@ static void HalUARTOpenDMA(halUARTCfg_t *config)
   HAL_DMA_CLEAR_IRQ(HAL_DMA_CH_RX);
   HAL_DMA_ARM_CH(HAL_DMA_CH_RX);
   osal_memset(dmaCfg.rxBuf, (DMA_PAD ^ 0xFF), HAL_UART_DMA_RX_MAX*2);
+  dmaCfg.rxHead = dmaCfg.rxTail = 0;  // The armed DMA restarts at the top of rxBuf.
+  dmaCfg.rxCnt = 0;
+  dmaCfg.rxNew = FALSE;
 
   UxCSR |= CSR_RE;
   
@@ -484,12 +498,14 @@ static uint16 HalUARTReadDMA(uint8 *buf, uint16 len)
 {
   uint16 cnt;
 
+  findTail();
+  if (len > dmaCfg.rxCnt)
+  {
+    len = dmaCfg.rxCnt;
+  }
+
   for (cnt = 0; cnt < len; cnt++)
   {
-    if (!HAL_UART_DMA_NEW_RX_BYTE(dmaCfg.rxHead))
-    {
-      break;
-    }
     *buf++ = HAL_UART_DMA_GET_RX_BYTE(dmaCfg.rxHead);
     HAL_UART_DMA_CLR_RX_BYTE(dmaCfg.rxHead);
     if (++(dmaCfg.rxHead) >= HAL_UART_DMA_RX_MAX)
@@ -497,6 +513,7 @@ static uint16 HalUARTReadDMA(uint8 *buf, uint16 len)
       dmaCfg.rxHead = 0;
     }
   }
+  dmaCfg.rxCnt -= cnt;
   PxOUT &= ~HAL_UART_Px_RTS;  // Re-enable the flow on any read.
 
   return cnt;
@@ -523,8 +540,8 @@ static uint16 HalUARTWriteDMA(uint8 *buf, uint16 len)
   uint16 txIdx;
 #endif
 
-  // Enforce all or none.
-  if ((len + dmaCfg.txIdx[dmaCfg.txSel]) > HAL_UART_DMA_TX_MAX)
+  // Enforce all or none, and keep the bytes behind any descriptor not yet sent.
+  if (((len + dmaCfg.txIdx[dmaCfg.txSel]) > HAL_UART_DMA_TX_MAX) || (dmaCfg.txNext != NULL))
   {
     return 0;
   }
@@ -555,7 +572,7 @@ static uint16 HalUARTWriteDMA(uint8 *buf, uint16 len)
 
   dmaCfg.txIdx[txSel] = txIdx;
 
-  if (dmaCfg.txIdx[(txSel ^ 1)] == 0)
+  if ((dmaCfg.txIdx[(txSel ^ 1)] == 0) && !dmaCfg.txDesc)
   {
     // TX DMA is expected to be fired
     dmaCfg.txDMAPending = TRUE;
@@ -564,6 +581,56 @@ static uint16 HalUARTWriteDMA(uint8 *buf, uint16 len)
   return cnt;
 }
 
+/******************************************************************************
+ * @fn      HalUARTWriteDescDMA
+ *
+ * @brief   Queue a caller-owned buffer for the TX DMA to send in place, after
+ *          any bytes already written. The buffer is sent by a single DMA arm,
+ *          so it may be up to HAL_UART_DMA_DESC_MAX (8191) bytes, far more
+ *          than the copy buffers hold; HalUARTWriteDMA() holds off new bytes
+ *          until the queued descriptors are sent.
+ *
+ * @param   pDesc - descriptor of the buffer
+ *
+ * @return  HAL_UART_SUCCESS, or HAL_UART_NOT_SUPPORTED if the length is 0 or
+ *          more than HAL_UART_DMA_DESC_MAX; the caller then keeps the buffer
+ *****************************************************************************/
+static uint8 HalUARTWriteDescDMA(halUARTTxDesc_t *pDesc)
+{
+  halIntState_t his;
+
+  if ((pDesc->len == 0) || (pDesc->len > HAL_UART_DMA_DESC_MAX))
+  {
+    return HAL_UART_NOT_SUPPORTED;
+  }
+  pDesc->next = NULL;
+
+  HAL_ENTER_CRITICAL_SECTION(his);
+  if (dmaCfg.txTail != NULL)
+  {
+    dmaCfg.txTail->next = pDesc;
+  }
+  else
+  {
+    dmaCfg.txHead = pDesc;
+  }
+  dmaCfg.txTail = pDesc;
+
+  if (dmaCfg.txNext == NULL)
+  {
+    dmaCfg.txNext = pDesc;
+  }
+
+  if ((dmaCfg.txIdx[(dmaCfg.txSel ^ 1)] == 0) && !dmaCfg.txDesc)
+  {
+    // TX DMA is expected to be fired
+    dmaCfg.txDMAPending = TRUE;
+  }
+  HAL_EXIT_CRITICAL_SECTION(his);
+
+  return HAL_UART_SUCCESS;
+}
+
 /******************************************************************************
  * @fn      HalUARTPollDMA
  *
@@ -578,14 +645,14 @@ static void HalUARTPollDMA(void)
   uint16 cnt = 0;
   uint8 evt = 0;
 
-  if (HAL_UART_DMA_NEW_RX_BYTE(dmaCfg.rxHead))
-  {
-    uint16 tail = findTail();
+  findTail();
 
+  if (dmaCfg.rxCnt)
+  {
     // If the DMA has transferred in more Rx bytes, reset the Rx idle timer.
-    if (dmaCfg.rxTail != tail)
+    if (dmaCfg.rxNew)
     {
-      dmaCfg.rxTail = tail;
+      dmaCfg.rxNew = FALSE;
 
       // Re-sync the shadow on any 1st byte(s) received.
       if (dmaCfg.rxTick == 0)
@@ -609,10 +676,11 @@ static void HalUARTPollDMA(void)
         dmaCfg.rxTick = 0;
       }
     }
-    cnt = HalUARTRxAvailDMA();
+    cnt = dmaCfg.rxCnt;
   }
   else
   {
+    dmaCfg.rxNew = FALSE;
     dmaCfg.rxTick = 0;
   }
 
@@ -649,7 +717,8 @@ static void HalUARTPollDMA(void)
     }
   }
   
-  if (dmaCfg.txDMAPending && !dmaCfg.txShdwValid)
+  if (dmaCfg.txDMAPending && !dmaCfg.txShdwValid &&
+      (dmaCfg.txIdx[dmaCfg.txSel] || (dmaCfg.txNext != NULL)))
   {
     // UART TX DMA is expected to be fired and enough time has lapsed since last DMA ISR
     // to know that DBUF can be overwritten
@@ -658,10 +727,22 @@ static void HalUARTPollDMA(void)
 
     // Clear the DMA pending flag
     dmaCfg.txDMAPending = FALSE;
-    
-    HAL_DMA_SET_SOURCE(ch, dmaCfg.txBuf[dmaCfg.txSel]);
-    HAL_DMA_SET_LEN(ch, dmaCfg.txIdx[dmaCfg.txSel]);
-    dmaCfg.txSel ^= 1;
+
+    // Bytes in the copy buffer were written before any queued descriptor.
+    if (dmaCfg.txIdx[dmaCfg.txSel])
+    {
+      HAL_DMA_SET_SOURCE(ch, dmaCfg.txBuf[dmaCfg.txSel]);
+      HAL_DMA_SET_LEN(ch, dmaCfg.txIdx[dmaCfg.txSel]);
+      dmaCfg.txSel ^= 1;
+    }
+    else
+    {
+      // HalUARTWriteDescDMA() took only lengths the transfer count holds.
+      HAL_DMA_SET_SOURCE(ch, dmaCfg.txNext->pBuf);
+      HAL_DMA_SET_LEN(ch, dmaCfg.txNext->len);
+      dmaCfg.txNext = dmaCfg.txNext->next;
+      dmaCfg.txDesc = TRUE;
+    }
     HAL_ENTER_CRITICAL_SECTION(intState);
     HAL_DMA_ARM_CH(HAL_DMA_CH_TX);
     do
@@ -673,6 +754,28 @@ static void HalUARTPollDMA(void)
     HAL_EXIT_CRITICAL_SECTION(intState);
   }
 
+  // Give back the descriptors sent, oldest first.
+  while (dmaCfg.txDescDone)
+  {
+    halUARTTxDesc_t *pDesc;
+    halIntState_t intState;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    pDesc = dmaCfg.txHead;
+    dmaCfg.txHead = pDesc->next;
+    if (dmaCfg.txHead == NULL)
+    {
+      dmaCfg.txTail = NULL;
+    }
+    dmaCfg.txDescDone--;
+    HAL_EXIT_CRITICAL_SECTION(intState);
+
+    if (pDesc->pfnDone != NULL)
+    {
+      pDesc->pfnDone(pDesc);
+    }
+  }
+
   if (evt && (dmaCfg.uartCB != NULL))
   {
     dmaCfg.uartCB(HAL_UART_DMA-1, evt);
@@ -690,22 +793,9 @@ static void HalUARTPollDMA(void)
  **************************************************************************************************/
 static uint16 HalUARTRxAvailDMA(void)
 {
-  uint16 cnt = 0;
+  findTail();
 
-  if (HAL_UART_DMA_NEW_RX_BYTE(dmaCfg.rxHead))
-  {
-    uint16 idx;
-
-    for (idx = 0; idx < HAL_UART_DMA_RX_MAX; idx++)
-    {
-      if (HAL_UART_DMA_NEW_RX_BYTE(idx))
-      {
-        cnt++;
-      }
-    }
-  }
-
-  return cnt;
+  return dmaCfg.rxCnt;
 }
 
 /******************************************************************************
@@ -751,8 +841,17 @@ void HalUARTIsrDMA(void)
 {
   HAL_DMA_CLEAR_IRQ(HAL_DMA_CH_TX);
 
-  // Indicate that the other buffer is free now.
-  dmaCfg.txIdx[(dmaCfg.txSel ^ 1)] = 0;
+  if (dmaCfg.txDesc)
+  {
+    // The descriptor is given back by the next poll.
+    dmaCfg.txDesc = FALSE;
+    dmaCfg.txDescDone++;
+  }
+  else
+  {
+    // Indicate that the other buffer is free now.
+    dmaCfg.txIdx[(dmaCfg.txSel ^ 1)] = 0;
+  }
   dmaCfg.txMT = TRUE;
   
   // Set TX shadow
@@ -760,7 +859,7 @@ void HalUARTIsrDMA(void)
   dmaCfg.txShdwValid = TRUE;
 
   // If there is more Tx data ready to go, re-start the DMA immediately on it.
-  if (dmaCfg.txIdx[dmaCfg.txSel])
+  if (dmaCfg.txIdx[dmaCfg.txSel] || (dmaCfg.txNext != NULL))
   {
     // UART TX DMA is expected to be fired
     dmaCfg.txDMAPending = TRUE;
@@ -87,6 +87,7 @@
 #include "hal_adc.h"
 #include "hal_key.h"
 #include "osal.h"
+#include "OSAL_PwrMgr.h"
 
 #if (defined HAL_KEY) && (HAL_KEY == TRUE)
 
@@ -532,6 +533,9 @@ void halProcessKeyInterrupt (void)
 #endif
   if (valid)
   {
+#if ( OSAL_PWRMGR_STATS )
+    osal_pwrmgr_wake( PWRMGR_WAKE_KEY );
+#endif
     osal_start_timerEx (Hal_TaskID, HAL_KEY_EVENT, HAL_KEY_DEBOUNCE_VALUE);
   }
 }
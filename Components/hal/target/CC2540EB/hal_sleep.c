@@ -252,6 +252,9 @@ void halSleep( uint16 osal_timeout )
 {
   uint32 timeout;
   uint32 llTimeout = 0;
+#if ( OSAL_PWRMGR_STATS )
+  uint8 wakeCause = PWRMGR_WAKE_TIMER;
+#endif
 
   /* get next OSAL timer expiration and convert to 32kHz units */
   timeout = HAL_SLEEP_MS_TO_32KHZ(osal_timeout);
@@ -259,6 +262,9 @@ void halSleep( uint16 osal_timeout )
   {
     /* get next LL event (in 625us ticks) and convert to 32kHz units */
     timeout = HAL_SLEEP_625US_TO_32KHZ(LL_TimeToNextRfEvent());
+#if ( OSAL_PWRMGR_STATS )
+    wakeCause = (timeout == 0) ? PWRMGR_WAKE_OTHER : PWRMGR_WAKE_RADIO;
+#endif
 
     /* since LL time is in 625us, its specification of when to start is more
      * coarse than it needs to be which results in wasted power consumption,
@@ -279,6 +285,9 @@ void halSleep( uint16 osal_timeout )
     {
       /* ...and use a common variable */
       timeout = llTimeout;
+#if ( OSAL_PWRMGR_STATS )
+      wakeCause = PWRMGR_WAKE_RADIO;
+#endif
 
       /* since LL time is in 625us, its specification of when to start is more
       * coarse than it needs to be which results in wasted power consumption,
@@ -334,6 +343,12 @@ void halSleep( uint16 osal_timeout )
 
       /* save interrupt enable registers and disable all interrupts */
       HAL_SLEEP_IE_BACKUP_AND_DISABLE(ien0, ien1, ien2);
+
+#if ( OSAL_PWRMGR_STATS )
+      /* account the sleep to its power mode and expected wakeup cause */
+      osal_pwrmgr_sleep((halPwrMgtMode == HAL_SLEEP_DEEP) ? PWRMGR_MODE_DEEP : PWRMGR_MODE_TIMER,
+                        wakeCause);
+#endif
       HAL_ENABLE_INTERRUPTS();
 
       /* set CC2540 power mode, interrupt is disabled after this function */
@@ -221,6 +221,34 @@ uint16 HalUARTWrite(uint8 port, uint8 *buf, uint16 len)
 #endif
 }
 
+/******************************************************************************
+ * @fn      HalUARTWriteDesc
+ *
+ * @brief   Queue a caller-owned buffer to be sent in place. Only the DMA
+ *          driver transmits without copying.
+ *
+ * @param   port  - UART port
+ *          pDesc - descriptor of the buffer, owned by the driver until its
+ *                  pfnDone is called
+ *
+ * @return  HAL_UART_SUCCESS, or HAL_UART_NOT_SUPPORTED if the port does not
+ *          take descriptors or not of this length; the caller then keeps
+ *          the buffer
+ *****************************************************************************/
+uint8 HalUARTWriteDesc(uint8 port, halUARTTxDesc_t *pDesc)
+{
+#if (HAL_UART_DMA == 1)
+  if (port == HAL_UART_PORT_0)  return HalUARTWriteDescDMA(pDesc);
+#endif
+#if (HAL_UART_DMA == 2)
+  if (port == HAL_UART_PORT_1)  return HalUARTWriteDescDMA(pDesc);
+#endif
+
+  (void) port;   // unused argument
+  (void) pDesc;  // unused argument
+  return HAL_UART_NOT_SUPPORTED;
+}
+
 /******************************************************************************
  * @fn      HalUARTSuspend
  *
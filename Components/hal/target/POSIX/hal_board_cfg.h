@@ -0,0 +1,159 @@
+/**************************************************************************************************
+  Filename:       hal_board_cfg.h
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Board configuration for the POSIX host target.
+
+
+  Copyright 2006-2009 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+#ifndef HAL_BOARD_CFG_H
+#define HAL_BOARD_CFG_H
+
+/*
+ *     =============================================================
+ *     |        POSIX host                                         |
+ *     | --------------------------------------------------------- |
+ *     |  Native build of OSAL and HAL; flash is a RAM image and   |
+ *     |  time is a virtual clock advanced by the host program.    |
+ *     =============================================================
+ */
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+
+#include "hal_mcu.h"
+#include "hal_defs.h"
+#include "hal_types.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Clock Speed
+ * ------------------------------------------------------------------------------------------------
+ */
+#define HAL_CPU_CLOCK_MHZ     32
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       LED Configuration
+ * ------------------------------------------------------------------------------------------------
+ */
+
+#define HAL_NUM_LEDS            0
+#define HAL_LED_BLINK_DELAY()
+
+/* ------------------------------------------------------------------------------------------------
+ *                         OSAL NV implemented by internal flash pages.
+ * ------------------------------------------------------------------------------------------------
+ */
+
+// The geometry matches the banked CC2540 so that SNV behaves identically on the host.
+#define HAL_FLASH_PAGE_PER_BANK    16
+#define HAL_FLASH_PAGE_SIZE        2048
+#define HAL_FLASH_PAGE_CNT         128
+#define HAL_FLASH_WORD_SIZE        4
+
+#define HAL_FLASH_LOCK_BITS        16
+#define HAL_NV_PAGE_END            126
+
+#define HAL_FLASH_IEEE_SIZE        8
+#define HAL_FLASH_IEEE_PAGE       (HAL_NV_PAGE_END+1)
+#define HAL_FLASH_IEEE_OSET       (HAL_FLASH_PAGE_SIZE - HAL_FLASH_LOCK_BITS - HAL_FLASH_IEEE_SIZE)
+
+#define HAL_NV_PAGE_CNT            2
+#define HAL_NV_PAGE_BEG           (HAL_NV_PAGE_END-HAL_NV_PAGE_CNT+1)
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                            Macros
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* ----------- Board Initialization ---------- */
+#define HAL_BOARD_INIT()
+
+/* ----------- Debounce ---------- */
+#define HAL_DEBOUNCE(expr)
+
+/* ----------- Push Buttons ---------- */
+#define HAL_PUSH_BUTTON1()        (0)
+#define HAL_PUSH_BUTTON2()        (0)
+#define HAL_PUSH_BUTTON3()        (0)
+#define HAL_PUSH_BUTTON4()        (0)
+#define HAL_PUSH_BUTTON5()        (0)
+#define HAL_PUSH_BUTTON6()        (0)
+
+/* ----------- LED's ---------- */
+#define HAL_TURN_OFF_LED1()
+#define HAL_TURN_OFF_LED2()
+#define HAL_TURN_OFF_LED3()
+#define HAL_TURN_OFF_LED4()
+
+#define HAL_TURN_ON_LED1()
+#define HAL_TURN_ON_LED2()
+#define HAL_TURN_ON_LED3()
+#define HAL_TURN_ON_LED4()
+
+#define HAL_TOGGLE_LED1()
+#define HAL_TOGGLE_LED2()
+#define HAL_TOGGLE_LED3()
+#define HAL_TOGGLE_LED4()
+
+#define HAL_STATE_LED1()          0
+#define HAL_STATE_LED2()          0
+#define HAL_STATE_LED3()          0
+#define HAL_STATE_LED4()          0
+
+/* ------------------------------------------------------------------------------------------------
+ *                                     Driver Configuration
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Only the flash driver is simulated on the host; every peripheral driver is compiled out. */
+#define HAL_TIMER     FALSE
+#define HAL_ADC       FALSE
+#define HAL_DMA       FALSE
+#define HAL_FLASH     TRUE
+#define HAL_AES       FALSE
+#define HAL_AES_DMA   FALSE
+#define HAL_LCD       FALSE
+#define HAL_LED       FALSE
+#define HAL_KEY       FALSE
+#define HAL_UART      FALSE
+#define HAL_UART_DMA  0
+#define HAL_UART_ISR  0
+
+/*******************************************************************************************************
+*/
+#endif
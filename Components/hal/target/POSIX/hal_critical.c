@@ -0,0 +1,219 @@
+/*************************************************************************************************
+  Filename:       hal_critical.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Critical section timing for the POSIX host target.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <time.h>
+
+#include "hal_types.h"
+#include "hal_mcu.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+
+static struct timespec halCriticalStart;  // Entry time of the open critical section.
+static uint32 halCriticalCnt;             // Critical sections timed.
+static uint32 halCriticalMax;             // Longest critical section in nanoseconds.
+
+// Critical sections by length, bucket n holding those of 2^n to 2^(n+1)-1 nanoseconds.
+static uint32 halCriticalHist[HAL_CRITICAL_HIST_CNT];
+
+/**************************************************************************************************
+ * @fn          halCriticalEnter
+ *
+ * @brief       Note the entry into an outermost critical section. Called through
+ *              HAL_ENTER_CRITICAL_SECTION() when built with HAL_CRITICAL_STATS.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void halCriticalEnter(void)
+{
+  clock_gettime(CLOCK_MONOTONIC, &halCriticalStart);
+}
+
+/**************************************************************************************************
+ * @fn          halCriticalExit
+ *
+ * @brief       Time the outermost critical section being left. Called through
+ *              HAL_EXIT_CRITICAL_SECTION() when built with HAL_CRITICAL_STATS.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void halCriticalExit(void)
+{
+  struct timespec now;
+  uint32 nsec;
+  uint8 bucket = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  nsec = (uint32)((now.tv_sec - halCriticalStart.tv_sec) * 1000000000L +
+                  (now.tv_nsec - halCriticalStart.tv_nsec));
+
+  halCriticalCnt++;
+  if (nsec > halCriticalMax)
+  {
+    halCriticalMax = nsec;
+  }
+
+  while ((nsec >>= 1) != 0)
+  {
+    bucket++;
+  }
+  halCriticalHist[bucket]++;
+}
+
+/**************************************************************************************************
+ * @fn          HalCriticalStats
+ *
+ * @brief       Read the critical section statistics since the last reset.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * @param       pCount - If not NULL, receives the number of critical sections timed.
+ * @param       pMaxNsec - If not NULL, receives the longest critical section in nanoseconds.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void HalCriticalStats(uint32 *pCount, uint32 *pMaxNsec)
+{
+  if (pCount != NULL)
+  {
+    *pCount = halCriticalCnt;
+  }
+  if (pMaxNsec != NULL)
+  {
+    *pMaxNsec = halCriticalMax;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          HalCriticalPercentile
+ *
+ * @brief       Estimate a percentile of the critical section length from the histogram. Unlike
+ *              the maximum, a high percentile is not dominated by the rare sections in which the
+ *              host preempted the process.
+ *
+ * input parameters
+ *
+ * @param       pct - Percentile, 1 to 100.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      Upper bound in nanoseconds of the histogram bucket holding the percentile,
+ *              0 if no critical section was timed.
+ **************************************************************************************************
+ */
+uint32 HalCriticalPercentile(uint8 pct)
+{
+  uint32 rank = (uint32)(((uint64_t)halCriticalCnt * pct + 99) / 100);
+  uint32 sum = 0;
+  uint8 bucket;
+
+  if (halCriticalCnt == 0)
+  {
+    return 0;
+  }
+
+  for (bucket = 0; bucket < HAL_CRITICAL_HIST_CNT - 1; bucket++)
+  {
+    sum += halCriticalHist[bucket];
+    if (sum >= rank)
+    {
+      break;
+    }
+  }
+
+  return ((uint32)2 << bucket) - 1;
+}
+
+/**************************************************************************************************
+ * @fn          HalCriticalStatsReset
+ *
+ * @brief       Clear the critical section statistics.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void HalCriticalStatsReset(void)
+{
+  halCriticalCnt = 0;
+  halCriticalMax = 0;
+  memset(halCriticalHist, 0, sizeof(halCriticalHist));
+}
+
+/**************************************************************************************************
+*/
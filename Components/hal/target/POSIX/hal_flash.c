@@ -0,0 +1,287 @@
+/**************************************************************************************************
+  Filename:       hal_flash.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    RAM-backed flash driver for the POSIX host target.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+
+#include "hal_board_cfg.h"
+#include "hal_flash.h"
+#include "hal_mcu.h"
+#include "hal_types.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* RAM image of the whole internal flash. Like real flash it powers up erased, a write can only
+ * clear bits, and only a page erase can set them again.
+ */
+static uint8 halFlashImage[HAL_FLASH_PAGE_CNT * HAL_FLASH_PAGE_SIZE];
+static bool halFlashInit = FALSE;
+
+/* Operation counters, so that a host program can weigh the flash wear of an SNV access pattern. */
+static uint32 halFlashWriteCnt;
+static uint32 halFlashEraseCnt;
+
+/* Power loss model: flash operations (words programmed and pages erased) left before the power
+ * fails, or -1 when no failure is armed, and the function called in place of the failing one.
+ */
+static int32 halFlashFailOps = -1;
+static halFlashFailCback_t halFlashFailCback;
+
+/**************************************************************************************************
+ * @fn          halFlashCheckInit
+ *
+ * @brief       Erase the whole flash image on first use.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+static void halFlashCheckInit(void)
+{
+  if (!halFlashInit)
+  {
+    uint32 i;
+
+    for (i = 0; i < sizeof(halFlashImage); i++)
+    {
+      halFlashImage[i] = 0xFF;
+    }
+    halFlashInit = TRUE;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          halFlashPowerCheck
+ *
+ * @brief       Count down one flash operation of an armed power loss and, when none is left,
+ *              call the power loss callback in place of the operation.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+static void halFlashPowerCheck(void)
+{
+  if (halFlashFailOps == 0)
+  {
+    halFlashFailOps = -1;
+    halFlashFailCback();
+  }
+  else if (halFlashFailOps > 0)
+  {
+    halFlashFailOps--;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          HalFlashRead
+ *
+ * @brief       This function reads 'cnt' bytes from the internal flash.
+ *
+ * input parameters
+ *
+ * @param       pg - A valid flash page number.
+ * @param       offset - A valid offset into the page.
+ * @param       buf - A valid buffer space at least as big as the 'cnt' parameter.
+ * @param       cnt - A valid number of bytes to read.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void HalFlashRead(uint8 pg, uint16 offset, uint8 *buf, uint16 cnt)
+{
+  uint8 *ptr = halFlashImage + ((uint32)pg * HAL_FLASH_PAGE_SIZE) + offset;
+
+  halFlashCheckInit();
+
+  while (cnt--)
+  {
+    *buf++ = *ptr++;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          HalFlashWrite
+ *
+ * @brief       This function writes 'cnt' bytes to the internal flash.
+ *
+ * input parameters
+ *
+ * @param       addr - Valid HAL flash write address: actual addr / 4 and quad-aligned.
+ * @param       buf - Valid buffer space at least as big as 'cnt' X 4.
+ * @param       cnt - Number of 4-byte blocks to write.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void HalFlashWrite(uint16 addr, uint8 *buf, uint16 cnt)
+{
+  uint8 *ptr = halFlashImage + ((uint32)addr * HAL_FLASH_WORD_SIZE);
+
+  halFlashCheckInit();
+  halFlashWriteCnt++;
+
+  while (cnt--)
+  {
+    uint8 len = HAL_FLASH_WORD_SIZE;
+
+    halFlashPowerCheck();
+
+    while (len--)
+    {
+      *ptr++ &= *buf++;  // Programming can only clear bits.
+    }
+  }
+}
+
+/**************************************************************************************************
+ * @fn          HalFlashErase
+ *
+ * @brief       This function erases the specified page of the internal flash.
+ *
+ * input parameters
+ *
+ * @param       pg - A valid flash page number to erase.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void HalFlashErase(uint8 pg)
+{
+  uint8 *ptr = halFlashImage + ((uint32)pg * HAL_FLASH_PAGE_SIZE);
+  uint16 cnt = HAL_FLASH_PAGE_SIZE;
+
+  halFlashCheckInit();
+  halFlashPowerCheck();
+  halFlashEraseCnt++;
+
+  while (cnt--)
+  {
+    *ptr++ = 0xFF;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          HalFlashStats
+ *
+ * @brief       Report the number of write and erase operations since power-up (host only).
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * @param       pWrites - If not NULL, receives the number of HalFlashWrite() calls.
+ * @param       pErases - If not NULL, receives the number of HalFlashErase() calls.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void HalFlashStats(uint32 *pWrites, uint32 *pErases)
+{
+  if (pWrites != NULL)
+  {
+    *pWrites = halFlashWriteCnt;
+  }
+  if (pErases != NULL)
+  {
+    *pErases = halFlashEraseCnt;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          HalFlashPowerLoss
+ *
+ * @brief       Arm a power loss (host only): after 'ops' more flash operations, a word programmed
+ *              or a page erased, the next one is not carried out and 'pCback' is called instead.
+ *              The callback is expected not to return, e.g. to longjmp() to a simulated reset;
+ *              if it does return, the operation goes ahead.
+ *
+ * input parameters
+ *
+ * @param       ops - Number of operations that still complete, or -1 to disarm.
+ * @param       pCback - Function called at the power loss.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void HalFlashPowerLoss(int32 ops, halFlashFailCback_t pCback)
+{
+  halFlashFailCback = pCback;
+  halFlashFailOps = (pCback != NULL) ? ops : -1;
+}
+
+/**************************************************************************************************
+*/
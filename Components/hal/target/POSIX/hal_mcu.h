@@ -0,0 +1,168 @@
+/**************************************************************************************************
+  Filename:       hal_mcu.h
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    HAL MCU abstraction for the POSIX host target.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+#ifndef _HAL_MCU_H
+#define _HAL_MCU_H
+
+/*
+ *  Target : POSIX host (single-threaded simulation of the CC2540 HAL)
+ *
+ */
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdlib.h>
+#include "hal_defs.h"
+#include "hal_types.h"
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Target Defines
+ * ------------------------------------------------------------------------------------------------
+ */
+#define HAL_MCU_POSIX
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                     Compiler Abstraction
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* ---------------------- GNU Compiler ---------------------- */
+#if defined __GNUC__
+
+#define HAL_COMPILER_GCC
+#define HAL_MCU_LITTLE_ENDIAN()   (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+
+/* IAR extended keywords used by the OSAL sources have no meaning on the host. */
+#define __no_init
+#define __near_func
+
+/* There are no interrupt vectors on the host: an "ISR" is an ordinary function that a test
+ * harness may call directly to simulate the interrupt.
+ */
+#define HAL_ISR_FUNC_DECLARATION(f,v)   void f(void)
+#define HAL_ISR_FUNC_PROTOTYPE(f,v)     void f(void)
+#define HAL_ISR_FUNCTION(f,v)           HAL_ISR_FUNC_PROTOTYPE(f,v); HAL_ISR_FUNC_DECLARATION(f,v)
+
+/* ------------------ Unrecognized Compiler ------------------ */
+#else
+#error "ERROR: Unknown compiler."
+#endif
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Interrupt Macros
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* The 8051 global interrupt enable bit is modelled by a plain variable so that critical
+ * sections nest and restore exactly as they do on the target.
+ */
+extern volatile uint8 EA;
+
+#define HAL_ENABLE_INTERRUPTS()         st( EA = 1; )
+#define HAL_DISABLE_INTERRUPTS()        st( EA = 0; )
+#define HAL_INTERRUPTS_ARE_ENABLED()    (EA)
+
+typedef unsigned char halIntState_t;
+#if defined ( HAL_CRITICAL_STATS )
+/* Time the outermost critical sections (hal_critical.c), those entered with interrupts enabled. */
+#define HAL_ENTER_CRITICAL_SECTION(x)   st( x = EA;  HAL_DISABLE_INTERRUPTS(); if (x) halCriticalEnter(); )
+#define HAL_EXIT_CRITICAL_SECTION(x)    st( if (x) halCriticalExit();  EA = x; )
+#else
+#define HAL_ENTER_CRITICAL_SECTION(x)   st( x = EA;  HAL_DISABLE_INTERRUPTS(); )
+#define HAL_EXIT_CRITICAL_SECTION(x)    st( EA = x; )
+#endif
+#define HAL_CRITICAL_STATEMENT(x)       st( halIntState_t _s; HAL_ENTER_CRITICAL_SECTION(_s); x; HAL_EXIT_CRITICAL_SECTION(_s); )
+
+#define HAL_ENTER_ISR()
+#define HAL_EXIT_ISR()                  CLEAR_SLEEP_MODE();
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Reset Macro
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* A reset request ends the host process; abort() leaves a core for post-mortem analysis. */
+#define HAL_SYSTEM_RESET()  st( HAL_DISABLE_INTERRUPTS(); abort(); )
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Sleep common code
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Only read by ResetReason(); the host never resets from sleep. */
+#define SLEEPSTA  0
+
+#define CLEAR_SLEEP_MODE()
+#define ALLOW_SLEEP_MODE()
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Host Simulation
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Virtual time (hal_sleep.c): the host program advances it; OSAL timers fire as it passes. */
+extern void HalClockAdvance(uint32 usec);
+extern uint32 HalClockRead(void);
+extern uint16 HalClockSubTick(void);
+extern uint8 HalClockSleepTimer(void);
+
+/* Flash wear counters of the RAM-backed flash image (hal_flash.c). */
+extern void HalFlashStats(uint32 *pWrites, uint32 *pErases);
+
+/* Power loss during flash operations (hal_flash.c), for power-fail tests of SNV. */
+typedef void (*halFlashFailCback_t)(void);
+extern void HalFlashPowerLoss(int32 ops, halFlashFailCback_t pCback);
+
+/* Critical section timing (hal_critical.c), recorded when built with HAL_CRITICAL_STATS. */
+#define HAL_CRITICAL_HIST_CNT  32
+extern void halCriticalEnter(void);
+extern void halCriticalExit(void);
+extern void HalCriticalStats(uint32 *pCount, uint32 *pMaxNsec);
+extern uint32 HalCriticalPercentile(uint8 pct);
+extern void HalCriticalStatsReset(void);
+
+/**************************************************************************************************
+ */
+#endif
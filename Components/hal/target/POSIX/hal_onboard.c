@@ -0,0 +1,173 @@
+/*************************************************************************************************
+  Filename:       hal_onboard.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Board support routines for the POSIX host target: the pieces of
+                  OnBoard.c and the HAL drivers that the OSAL core links against.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+
+#include "hal_types.h"
+#include "hal_mcu.h"
+#include "hal_assert.h"
+#include "hal_drivers.h"
+#include "OnBoard.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* State of the random number generator; a fixed seed keeps host runs reproducible. */
+static uint16 halRandState = 0xACE1;
+
+/**************************************************************************************************
+ * @fn          Onboard_rand
+ *
+ * @brief       Random number generator. The target draws from the LL; the host uses a 16-bit
+ *              Galois LFSR, which never yields zero.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      New random number.
+ **************************************************************************************************
+ */
+uint16 Onboard_rand( void )
+{
+  uint8 bit;
+
+  for (bit = 0; bit < 16; bit++)
+  {
+    halRandState = (halRandState >> 1) ^ ((halRandState & 1) ? 0xB400 : 0);
+  }
+
+  return halRandState;
+}
+
+/**************************************************************************************************
+ * @fn          _itoa
+ *
+ * @brief       Convert a 16-bit number to ASCII, as OnBoard.c does on the target.
+ *
+ * input parameters
+ *
+ * @param       num - Number to convert.
+ * @param       radix - Base of the conversion, 2 to 36.
+ *
+ * output parameters
+ *
+ * @param       buf - Receives the digits and a terminating null; at least 17 bytes for radix 2.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void _itoa(uint16 num, uint8 *buf, uint8 radix)
+{
+  uint8 rst[16];
+  uint8 i = 0;
+  uint8 c;
+
+  do
+  {
+    c = num % radix;  // Isolate a digit
+    rst[i++] = c + (( c < 10 ) ? '0' : '7');  // Convert to Ascii
+    num /= radix;
+  } while (num);
+
+  while (i)
+  {
+    *buf++ = rst[--i];  // Reverse character order
+  }
+
+  *buf = '\0';
+}
+
+/**************************************************************************************************
+ * @fn          halAssertHandler
+ *
+ * @brief       Logic to handle an assert. The host has no hazard lights to flash: report the
+ *              assert and end the process so that a test run fails loudly.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void halAssertHandler(void)
+{
+  fprintf(stderr, "HAL assert at %lu us\n", (unsigned long)HalClockRead());
+  fflush(stderr);
+  HAL_SYSTEM_RESET();
+}
+
+/**************************************************************************************************
+ * @fn          Hal_ProcessPoll
+ *
+ * @brief       Poll the HAL drivers from the OSAL loop; the host target has no drivers to poll.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void Hal_ProcessPoll (void)
+{
+}
+
+/**************************************************************************************************
+*/
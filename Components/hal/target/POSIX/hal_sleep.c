@@ -0,0 +1,330 @@
+/**************************************************************************************************
+  Filename:       hal_sleep.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Virtual clock and power management for the POSIX host target.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "hal_types.h"
+#include "hal_mcu.h"
+#include "hal_sleep.h"
+#include "OSAL.h"
+#include "OSAL_Clock.h"
+#include "OSAL_PwrMgr.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Macros
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Resolution of the free-running LL timer read by osalTimeUpdate(). */
+#define HAL_CLOCK_TICK_USEC   625
+
+/* The 32.768 kHz sleep timer ticks every 15625 / 512 us. */
+#define HAL_CLOCK_SLEEP_NUM   15625
+#define HAL_CLOCK_SLEEP_DEN   512
+
+/* osalTimeUpdate() works on the 16-bit difference of the LL timer, so a long advance is fed to it
+ * in steps that cannot wrap that counter.
+ */
+#define HAL_CLOCK_MAX_TICKS   0x4000
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Global Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Model of the 8051 global interrupt enable bit; interrupts are disabled out of reset. */
+volatile uint8 EA = 0;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+
+static uint32 halClockUsec;      // Virtual time since power-up in microseconds (wraps).
+static uint16 halClockTicks;     // Virtual LL timer in 625 us ticks (wraps).
+static uint16 halClockRemUsec;   // Microseconds not yet accounted as a whole tick.
+static uint32 halClockSleepTicks; // Virtual sleep timer in 32.768 kHz ticks (wraps).
+static uint16 halClockSleepRem;  // Remainder of the sleep timer, in 1/512 us.
+
+/**************************************************************************************************
+ * @fn          ll_McuPrecisionCount
+ *
+ * @brief       Host replacement for the LL free-running timer used by osalTimeUpdate().
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      Virtual time in 625 us ticks.
+ **************************************************************************************************
+ */
+uint16 ll_McuPrecisionCount(void)
+{
+  return halClockTicks;
+}
+
+/**************************************************************************************************
+ * @fn          HalClockAdvance
+ *
+ * @brief       Advance the virtual clock and let OSAL process the elapsed time, firing any timers
+ *              that expire. This is the host equivalent of time passing on the target.
+ *
+ * input parameters
+ *
+ * @param       usec - Number of microseconds to advance.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void HalClockAdvance(uint32 usec)
+{
+  uint64_t sleep = (uint64_t)usec * HAL_CLOCK_SLEEP_DEN + halClockSleepRem;
+
+  halClockSleepTicks += (uint32)(sleep / HAL_CLOCK_SLEEP_NUM);
+  halClockSleepRem = (uint16)(sleep % HAL_CLOCK_SLEEP_NUM);
+
+  halClockUsec += usec;
+  usec += halClockRemUsec;
+
+  while (usec >= HAL_CLOCK_TICK_USEC)
+  {
+    uint32 ticks = usec / HAL_CLOCK_TICK_USEC;
+
+    if (ticks > HAL_CLOCK_MAX_TICKS)
+    {
+      ticks = HAL_CLOCK_MAX_TICKS;
+    }
+
+    halClockTicks += (uint16)ticks;
+    usec -= ticks * HAL_CLOCK_TICK_USEC;
+    osalTimeUpdate();
+  }
+
+  halClockRemUsec = (uint16)usec;
+}
+
+/**************************************************************************************************
+ * @fn          HalClockRead
+ *
+ * @brief       Read the virtual clock.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      Virtual time since power-up in microseconds; wraps after about 71 minutes.
+ **************************************************************************************************
+ */
+uint32 HalClockRead(void)
+{
+  return halClockUsec;
+}
+
+/**************************************************************************************************
+ * @fn          HalClockSubTick
+ *
+ * @brief       Read the part of the virtual clock finer than the LL timer, the host stand-in for
+ *              the sleep timer interpolation of osal_getClockUs().
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      Microseconds since the last 625 us tick of ll_McuPrecisionCount().
+ **************************************************************************************************
+ */
+uint16 HalClockSubTick(void)
+{
+  return halClockRemUsec;
+}
+
+/**************************************************************************************************
+ * @fn          HalClockSleepTimer
+ *
+ * @brief       Read the low byte of the virtual sleep timer, the host model of ST0.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      Virtual time since power-up in 32.768 kHz ticks, modulo 256.
+ **************************************************************************************************
+ */
+uint8 HalClockSleepTimer(void)
+{
+  return (uint8)halClockSleepTicks;
+}
+
+/**************************************************************************************************
+ * @fn          halSleep
+ *
+ * @brief       This function is called from the OSAL task loop when there is nothing to do.
+ *              On the host, sleeping means skipping the virtual clock straight to the next
+ *              OSAL timeout, so an idle device costs no wall-clock time.
+ *
+ * input parameters
+ *
+ * @param       osal_timeout - Next OSAL timer timeout in msec; zero if no timer is running.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void halSleep( uint16 osal_timeout )
+{
+  // With no timer pending nothing could ever wake the device; return and let the caller decide.
+  if (osal_timeout != 0)
+  {
+#if ( OSAL_PWRMGR_STATS )
+    osal_pwrmgr_sleep(PWRMGR_MODE_TIMER, PWRMGR_WAKE_TIMER);
+#endif
+    HalClockAdvance((uint32)osal_timeout * 1000);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          halSleepWait
+ *
+ * @brief       Perform a blocking wait for the specified number of microseconds.
+ *
+ * input parameters
+ *
+ * @param       duration - Duration of wait in microseconds.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void halSleepWait(uint16 duration)
+{
+  HalClockAdvance(duration);
+}
+
+/**************************************************************************************************
+ * @fn          halRestoreSleepLevel
+ *
+ * @brief       Restore the deepest timer sleep level; nothing to restore on the host.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void halRestoreSleepLevel( void )
+{
+}
+
+/**************************************************************************************************
+ * @fn          halSleepExit
+ *
+ * @brief       Used by the interrupt routines to exit from sleep; nothing to do on the host.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void halSleepExit(void)
+{
+}
+
+/**************************************************************************************************
+ * @fn          TimerElapsed
+ *
+ * @brief       Determine the number of OSAL timer ticks elapsed during sleep.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      Number of timer ticks elapsed during sleep; always zero since halSleep() already
+ *              fed the elapsed time to osalTimeUpdate().
+ **************************************************************************************************
+ */
+uint32 TimerElapsed( void )
+{
+  return( 0 );
+}
+
+/**************************************************************************************************
+*/
@@ -56,6 +56,7 @@
 
 /* HAL */
 #include "hal_drivers.h"
+#include "hal_assert.h"
 
 #ifdef IAR_ARMCM3_LM
   #include "FreeRTOSConfig.h"
@@ -66,21 +67,114 @@
  * MACROS
  */
 
+// Host builds leave the memory primitives to the C library, whose word and
+// vector loops beat a byte loop. The 8051 keeps the byte loops, since its
+// library routines go through generic pointers. Define OSAL_MEM_BYTE_LOOPS
+// to keep the byte loops on the host as well, e.g. to compare the two.
+#if defined ( HAL_MCU_POSIX ) && !defined ( OSAL_MEM_BYTE_LOOPS )
+  #define OSAL_MEM_LIBC
+#endif
+
+// Mark a task as ready / not ready in the ready-task bitmap. Ints must be disabled.
+#define OSAL_READY_SET( task_id ) \
+  st( osalReadyTbl[(task_id) >> 3] |= BV( (task_id) & 0x07 ); \
+      osalReadyGrp |= BV( (task_id) >> 3 ); )
+
+#define OSAL_READY_CLR( task_id ) \
+  st( osalReadyTbl[(task_id) >> 3] &= ~BV( (task_id) & 0x07 ); \
+      if ( osalReadyTbl[(task_id) >> 3] == 0 ) \
+      { \
+        osalReadyGrp &= ~BV( (task_id) >> 3 ); \
+      } )
+
+#if ( OSAL_RUN_TRACE ) || ( OSAL_RUN_STATS )
+// Timestamp of the scheduler trace and handler statistics, in the 625 us ticks
+// of the LL free-running timer by default. A build may supply a finer clock,
+// e.g. the sleep timer.
+#if !defined ( OSAL_RUN_CLOCK )
+  #define OSAL_RUN_CLOCK()  ll_McuPrecisionCount()
+#endif
+#endif
+
+#if ( OSAL_RUN_STATS )
+// Called from osal_run_system() when an event processor runs over its budget.
+#if !defined ( OSAL_RUN_OVERRUN_HOOK )
+  #define OSAL_RUN_OVERRUN_HOOK( task_id, events, duration )
+#endif
+#endif
+
+#if ( OSAL_RUN_TRACE )
+// Note the time a task became ready. Ints must be disabled and the task
+// must have had no events pending.
+#define OSAL_TRACE_READY( task_id ) \
+  st( osalTrcReady[(task_id)] = OSAL_RUN_CLOCK(); )
+#else
+#define OSAL_TRACE_READY( task_id )
+#endif
+
 /*********************************************************************
  * CONSTANTS
  */
 
+// Maximum number of tasks the ready-task bitmap can hold (up to 64)
+#if !defined ( OSAL_MAX_TASKS )
+  #define OSAL_MAX_TASKS  32
+#endif
+
+#define OSAL_READY_ROWS  ( (OSAL_MAX_TASKS + 7) / 8 )
+
+// Number of records held by the scheduler trace ring buffer
+#if !defined ( OSAL_RUN_TRACE_LEN )
+  #define OSAL_RUN_TRACE_LEN  32
+#endif
+
+// Budget every task starts with, in OSAL_RUN_CLOCK() ticks (0 for no limit)
+#if !defined ( OSAL_RUN_BUDGET )
+  #define OSAL_RUN_BUDGET  16
+#endif
+
 /*********************************************************************
  * TYPEDEFS
  */
 
+// Message queue of a task
+typedef struct
+{
+  osal_msg_q_t head;      // First message waiting for the task
+  osal_msg_q_t tail;      // Last message waiting for the task
+  uint16       depth;     // Number of messages waiting for the task
+  uint16       maxDepth;  // Most messages ever waiting for the task at once
+} osal_task_q_t;
+
+#if ( OSAL_RUN_TRACE )
+// Scheduler trace record - one task dispatch
+typedef struct
+{
+  uint8  taskID;    // Task dispatched
+  uint16 events;    // Events passed to the task's event processor
+  uint16 ready;     // Time the task became ready
+  uint16 dispatch;  // Time the event processor was called
+  uint16 duration;  // Time the event processor ran
+} osalRunTrace_t;
+#endif
+
+#if ( OSAL_RUN_STATS )
+// Event processor time of a task
+typedef struct
+{
+  uint32 total;      // Time of all runs counted
+  uint16 runs;       // Runs counted
+  uint16 max;        // Longest run
+  uint16 maxEvents;  // Events passed to the longest run
+  uint16 overruns;   // Runs over the budget
+  uint16 budget;     // Time allowed per run, 0 for no limit
+} osalRunAcc_t;
+#endif
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
 
-// Message Pool Definitions
-osal_msg_q_t osal_qHead;
-
 /*********************************************************************
  * EXTERNAL VARIABLES
  */
@@ -89,6 +183,10 @@ osal_msg_q_t osal_qHead;
  * EXTERNAL FUNCTIONS
  */
 
+#if ( OSAL_RUN_TRACE ) || ( OSAL_RUN_STATS )
+extern uint16 ll_McuPrecisionCount( void );
+#endif
+
 /*********************************************************************
  * LOCAL VARIABLES
  */
@@ -96,12 +194,45 @@ osal_msg_q_t osal_qHead;
 // Index of active task
 static uint8 activeTaskID = TASK_NO_TASK;
 
+// Message Pool Definitions - one queue per task, indexed by task ID
+static osal_task_q_t *osal_qTable;
+
+// Ready-task bitmap - bit n of osalReadyTbl[r] is set while task (8 * r + n)
+// has events pending and bit r of osalReadyGrp while any task in row r does.
+static uint8 osalReadyGrp;
+static uint8 osalReadyTbl[OSAL_READY_ROWS];
+
+// Index of the lowest set bit of a nibble
+static CONST uint8 osalFfsTbl[16] = { 0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0 };
+
+#if ( OSAL_RUN_TRACE )
+static uint16 osalTrcReady[OSAL_MAX_TASKS];  // Time each task last became ready.
+static osalRunTrace_t osalTrcBuf[OSAL_RUN_TRACE_LEN];
+static uint8 osalTrcHead;     // Index of the oldest record.
+static uint8 osalTrcCnt;      // Number of records held.
+static uint8 osalTrcOn;       // Recording is enabled.
+static uint16 osalTrcDrop;    // Number of records overwritten before they were read.
+#endif
+
+#if ( OSAL_RUN_STATS )
+static osalRunAcc_t osalRunAcc[OSAL_MAX_TASKS];
+static uint16 osalRunStart;   // Time the active task's event processor was called.
+#endif
+
 /*********************************************************************
  * LOCAL FUNCTION PROTOTYPES
  */
 
 static uint8 osal_msg_enqueue_push( uint8 destination_task, uint8 *msg_ptr, uint8 urgent );
 
+#if ( OSAL_RUN_TRACE )
+static void osalRunTraceAdd( uint8 task_id, uint16 events, uint16 dispatch, uint16 duration );
+#endif
+
+#if ( OSAL_RUN_STATS )
+static void osalRunStatsAdd( uint8 task_id, uint16 events, uint16 duration );
+#endif
+
 /*********************************************************************
  * HELPER FUNCTIONS
  */
@@ -149,6 +280,9 @@ int osal_strlen( char *pString )
  */
 void *osal_memcpy( void *dst, const void GENERIC *src, unsigned int len )
 {
+#if defined ( OSAL_MEM_LIBC )
+  return ( (uint8 *)memcpy( dst, src, len ) + len );
+#else
   uint8 *pDst;
   const uint8 GENERIC *pSrc;
 
@@ -159,6 +293,66 @@ void *osal_memcpy( void *dst, const void GENERIC *src, unsigned int len )
     *pDst++ = *pSrc++;
 
   return ( pDst );
+#endif
+}
+
+/*********************************************************************
+ * @fn      osal_memcpy_xx
+ *
+ * @brief   Memory copy between two buffers in xdata. Both pointers are
+ *          typed, so the 8051 moves each byte with MOVX through a data
+ *          pointer instead of calling the generic pointer routines.
+ *
+ * @param   dst - destination address in xdata
+ * @param   src - source address in xdata
+ * @param   len - number of bytes to copy
+ *
+ * @return  pointer to end of destination buffer
+ */
+void *osal_memcpy_xx( void XDATA *dst, const void XDATA *src, unsigned int len )
+{
+#if defined ( OSAL_MEM_LIBC )
+  return ( (uint8 *)memcpy( dst, src, len ) + len );
+#else
+  uint8 XDATA *pDst = dst;
+  const uint8 XDATA *pSrc = src;
+
+  while ( len-- )
+  {
+    *pDst++ = *pSrc++;
+  }
+
+  return ( (void *)pDst );
+#endif
+}
+
+/*********************************************************************
+ * @fn      osal_memcpy_cx
+ *
+ * @brief   Memory copy from a constant table in code memory to xdata.
+ *          The 8051 reads the source with MOVC.
+ *
+ * @param   dst - destination address in xdata
+ * @param   src - source address in code memory
+ * @param   len - number of bytes to copy
+ *
+ * @return  pointer to end of destination buffer
+ */
+void *osal_memcpy_cx( void XDATA *dst, const void CODE *src, unsigned int len )
+{
+#if defined ( OSAL_MEM_LIBC )
+  return ( (uint8 *)memcpy( dst, src, len ) + len );
+#else
+  uint8 XDATA *pDst = dst;
+  const uint8 CODE *pSrc = src;
+
+  while ( len-- )
+  {
+    *pDst++ = *pSrc++;
+  }
+
+  return ( (void *)pDst );
+#endif
 }
 
 /*********************************************************************
@@ -187,6 +381,22 @@ void *osal_revmemcpy( void *dst, const void GENERIC *src, unsigned int len )
   pSrc += (len-1);
   pDst = dst;
 
+#if defined ( OSAL_MEM_LIBC ) && defined ( __GNUC__ )
+  // Reverse eight bytes at a time
+  while ( len >= 8 )
+  {
+    unsigned long long word;
+
+    VOID memcpy( &word, pSrc - 7, 8 );
+    word = __builtin_bswap64( word );
+    VOID memcpy( pDst, &word, 8 );
+
+    pDst += 8;
+    pSrc -= 8;
+    len -= 8;
+  }
+#endif
+
   while ( len-- )
     *pDst++ = *pSrc--;
 
@@ -233,6 +443,9 @@ void *osal_memdup( const void GENERIC *src, unsigned int len )
  */
 uint8 osal_memcmp( const void GENERIC *src1, const void GENERIC *src2, unsigned int len )
 {
+#if defined ( OSAL_MEM_LIBC )
+  return ( memcmp( src1, src2, len ) == 0 );
+#else
   const uint8 GENERIC *pSrc1;
   const uint8 GENERIC *pSrc2;
 
@@ -245,6 +458,7 @@ uint8 osal_memcmp( const void GENERIC *src1, const void GENERIC *src2, unsigned
       return FALSE;
   }
   return TRUE;
+#endif
 }
 
 
@@ -320,9 +534,9 @@ uint32 osal_build_uint32( uint8 *swapped, uint8 len )
  *
  * @return  pointer to buffer
  */
-unsigned char * _ltoa(unsigned long l, unsigned char *buf, unsigned char radix)
+uint8 * _ltoa(uint32 l, uint8 *buf, uint8 radix)
 {
-#if defined( __GNUC__ )
+#if defined( __GNUC__ ) && !defined( HAL_MCU_POSIX )
   return ( (char*)ltoa( l, buf, radix ) );
 #else
   unsigned char tmp1[10] = "", tmp2[10] = "", tmp3[10] = "";
@@ -537,6 +751,9 @@ uint8 osal_msg_push_front( uint8 destination_task, uint8 *msg_ptr )
  */
 static uint8 osal_msg_enqueue_push( uint8 destination_task, uint8 *msg_ptr, uint8 push )
 {
+  osal_task_q_t *q;
+  halIntState_t intState;
+
   if ( msg_ptr == NULL )
   {
     return ( INVALID_MSG_POINTER );
@@ -558,20 +775,46 @@ static uint8 osal_msg_enqueue_push( uint8 destination_task, uint8 *msg_ptr, uint
 
   OSAL_MSG_ID( msg_ptr ) = destination_task;
 
+  q = &osal_qTable[destination_task];
+
+  // Hold off interrupts
+  HAL_ENTER_CRITICAL_SECTION(intState);
+
   if ( push == TRUE )
   {
     // prepend the message
-    osal_msg_push( &osal_qHead, msg_ptr );
+    OSAL_MSG_NEXT( msg_ptr ) = q->head;
+    if ( q->head == NULL )
+    {
+      q->tail = msg_ptr;
+    }
+    q->head = msg_ptr;
   }
   else
   {
     // append the message
-    osal_msg_enqueue( &osal_qHead, msg_ptr );
+    if ( q->head == NULL )
+    {
+      q->head = msg_ptr;
+    }
+    else
+    {
+      OSAL_MSG_NEXT( q->tail ) = msg_ptr;
+    }
+    q->tail = msg_ptr;
+  }
+
+  if ( ++q->depth > q->maxDepth )
+  {
+    q->maxDepth = q->depth;
   }
 
   // Signal the task that a message is waiting
   osal_set_event( destination_task, SYS_EVENT_MSG );
 
+  // Release interrupts
+  HAL_EXIT_CRITICAL_SECTION(intState);
+
   return ( SUCCESS );
 }
 
@@ -590,42 +833,37 @@ static uint8 osal_msg_enqueue_push( uint8 destination_task, uint8 *msg_ptr, uint
  */
 uint8 *osal_msg_receive( uint8 task_id )
 {
-  osal_msg_hdr_t *listHdr;
-  osal_msg_hdr_t *prevHdr = NULL;
+  osal_task_q_t  *q;
   osal_msg_hdr_t *foundHdr = NULL;
   halIntState_t   intState;
 
+  if ( task_id >= tasksCnt )
+  {
+    return ( NULL );
+  }
+
+  q = &osal_qTable[task_id];
+
   // Hold off interrupts
   HAL_ENTER_CRITICAL_SECTION(intState);
 
-  // Point to the top of the queue
-  listHdr = osal_qHead;
-
-  // Look through the queue for a message that belongs to the asking task
-  while ( listHdr != NULL )
+  // Take the first message waiting for the task
+  if ( q->head != NULL )
   {
-    if ( (listHdr - 1)->dest_id == task_id )
-    {
-      if ( foundHdr == NULL )
-      {
-        // Save the first one
-        foundHdr = listHdr;
-      }
-      else
-      {
-        // Second msg found, stop looking
-        break;
-      }
-    }
-    if ( foundHdr == NULL )
+    foundHdr = q->head;
+    q->head = OSAL_MSG_NEXT( foundHdr );
+    if ( q->head == NULL )
     {
-      prevHdr = listHdr;
+      q->tail = NULL;
     }
-    listHdr = OSAL_MSG_NEXT( listHdr );
+    q->depth--;
+
+    OSAL_MSG_NEXT( foundHdr ) = NULL;
+    OSAL_MSG_ID( foundHdr ) = TASK_NO_TASK;
   }
 
   // Is there more than one?
-  if ( listHdr != NULL )
+  if ( q->head != NULL )
   {
     // Yes, Signal the task that a message is waiting
     osal_set_event( task_id, SYS_EVENT_MSG );
@@ -636,19 +874,45 @@ uint8 *osal_msg_receive( uint8 task_id )
     osal_clear_event( task_id, SYS_EVENT_MSG );
   }
 
-  // Did we find a message?
-  if ( foundHdr != NULL )
-  {
-    // Take out of the link list
-    osal_msg_extract( &osal_qHead, foundHdr, prevHdr );
-  }
-
   // Release interrupts
   HAL_EXIT_CRITICAL_SECTION(intState);
 
   return ( (uint8*) foundHdr );
 }
 
+/*********************************************************************
+ * @fn      osal_msg_queue_depth
+ *
+ * @brief
+ *
+ *    This function returns the number of messages waiting for a task.
+ *
+ * @param   uint8 task_id - task ID
+ *
+ * @return  number of queued messages, 0 for an invalid task
+ */
+uint16 osal_msg_queue_depth( uint8 task_id )
+{
+  return ( (task_id < tasksCnt) ? osal_qTable[task_id].depth : 0 );
+}
+
+/*********************************************************************
+ * @fn      osal_msg_queue_max
+ *
+ * @brief
+ *
+ *    This function returns the most messages ever waiting for a task
+ *    at once.
+ *
+ * @param   uint8 task_id - task ID
+ *
+ * @return  queue depth high-water mark, 0 for an invalid task
+ */
+uint16 osal_msg_queue_max( uint8 task_id )
+{
+  return ( (task_id < tasksCnt) ? osal_qTable[task_id].maxDepth : 0 );
+}
+
 /**************************************************************************************************
  * @fn          osal_msg_find
  *
@@ -672,14 +936,19 @@ osal_event_hdr_t *osal_msg_find(uint8 task_id, uint8 event)
   osal_msg_hdr_t *pHdr;
   halIntState_t intState;
 
+  if (task_id >= tasksCnt)
+  {
+    return NULL;
+  }
+
   HAL_ENTER_CRITICAL_SECTION(intState);  // Hold off interrupts.
 
-  pHdr = osal_qHead;  // Point to the top of the queue.
+  pHdr = osal_qTable[task_id].head;  // Point to the top of the task's queue.
 
-  // Look through the queue for a message that matches the task_id and event parameters.
+  // Look through the queue for a message that matches the event parameter.
   while (pHdr != NULL)
   {
-    if (((pHdr-1)->dest_id == task_id) && (((osal_event_hdr_t *)pHdr)->event == event))
+    if (((osal_event_hdr_t *)pHdr)->event == event)
     {
       break;
     }
@@ -904,7 +1173,15 @@ uint8 osal_set_event( uint8 task_id, uint16 event_flag )
   {
     halIntState_t   intState;
     HAL_ENTER_CRITICAL_SECTION(intState);    // Hold off interrupts
+    if ( (tasksEvents[task_id] == 0) && event_flag )
+    {
+      OSAL_TRACE_READY( task_id );
+    }
     tasksEvents[task_id] |= event_flag;  // Stuff the event bit(s)
+    if ( tasksEvents[task_id] )
+    {
+      OSAL_READY_SET( task_id );
+    }
     HAL_EXIT_CRITICAL_SECTION(intState);     // Release interrupts
     return ( SUCCESS );
   }
@@ -934,6 +1211,10 @@ uint8 osal_clear_event( uint8 task_id, uint16 event_flag )
     halIntState_t   intState;
     HAL_ENTER_CRITICAL_SECTION(intState);    // Hold off interrupts
     tasksEvents[task_id] &= ~(event_flag);   // Clear the event bit(s)
+    if ( tasksEvents[task_id] == 0 )
+    {
+      OSAL_READY_CLR( task_id );
+    }
     HAL_EXIT_CRITICAL_SECTION(intState);     // Release interrupts
     return ( SUCCESS );
   }
@@ -1042,8 +1323,27 @@ uint8 osal_init_system( void )
   // Initialize the Memory Allocation System
   osal_mem_init();
 
-  // Initialize the message queue
-  osal_qHead = NULL;
+  // Initialize the message queues
+  osal_qTable = (osal_task_q_t *)osal_mem_alloc( sizeof( osal_task_q_t ) * tasksCnt );
+  HAL_ASSERT( osal_qTable != NULL );
+  osal_memset( osal_qTable, 0, sizeof( osal_task_q_t ) * tasksCnt );
+
+  // Initialize the ready-task bitmap
+  HAL_ASSERT( tasksCnt <= OSAL_MAX_TASKS );
+  osalReadyGrp = 0;
+  osal_memset( osalReadyTbl, 0, sizeof( osalReadyTbl ) );
+
+#if ( OSAL_RUN_STATS )
+  // Start every task with the default budget
+  {
+    uint8 idx;
+
+    for ( idx = 0; idx < tasksCnt; idx++ )
+    {
+      osalRunAcc[idx].budget = OSAL_RUN_BUDGET;
+    }
+  }
+#endif
 
   // Initialize the timers
   osalTimerInit();
@@ -1087,10 +1387,10 @@ void osal_start_system( void )
  *
  * @brief
  *
- *   This function will make one pass through the OSAL taskEvents table
- *   and call the task_event_processor() function for the first task that
- *   is found with at least one event pending. If there are no pending
- *   events (all tasks), this function puts the processor into Sleep.
+ *   This function will find the highest priority task with at least
+ *   one event pending in the ready-task bitmap and call its
+ *   task_event_processor() function. If there are no pending events
+ *   (all tasks), this function puts the processor into Sleep.
  *
  * @param   void
  *
@@ -1098,34 +1398,65 @@ void osal_start_system( void )
  */
 void osal_run_system( void )
 {
-  uint8 idx = 0;
+  uint8 idx;
 
   osalTimeUpdate();
   Hal_ProcessPoll();
 
-  do {
-    if (tasksEvents[idx])  // Task is highest priority that is ready.
-    {
-      break;
-    }
-  } while (++idx < tasksCnt);
-
-  if (idx < tasksCnt)
+  if (osalReadyGrp)
   {
     uint16 events;
     halIntState_t intState;
+#if ( OSAL_RUN_TRACE ) || ( OSAL_RUN_STATS )
+    uint16 dispatch;
+    uint16 duration;
+    uint16 traced;
+#endif
 
     HAL_ENTER_CRITICAL_SECTION(intState);
+    idx = osal_ffs(osalReadyGrp);
+    idx = (idx << 3) + osal_ffs(osalReadyTbl[idx]);  // Task is highest priority that is ready.
     events = tasksEvents[idx];
     tasksEvents[idx] = 0;  // Clear the Events for this task.
+    OSAL_READY_CLR(idx);
     HAL_EXIT_CRITICAL_SECTION(intState);
 
+#if ( OSAL_PWRMGR_STATS )
+    osal_pwrmgr_dispatch( idx, events );
+#endif
+
+#if ( OSAL_RUN_TRACE ) || ( OSAL_RUN_STATS )
+    traced = events;
+    dispatch = OSAL_RUN_CLOCK();
+#endif
+#if ( OSAL_RUN_STATS )
+    osalRunStart = dispatch;
+#endif
+
     activeTaskID = idx;
     events = (tasksArr[idx])( idx, events );
     activeTaskID = TASK_NO_TASK;
 
+#if ( OSAL_RUN_TRACE ) || ( OSAL_RUN_STATS )
+    duration = OSAL_RUN_CLOCK() - dispatch;
+#endif
+#if ( OSAL_RUN_STATS )
+    osalRunStatsAdd( idx, traced, duration );
+#endif
+
     HAL_ENTER_CRITICAL_SECTION(intState);
+#if ( OSAL_RUN_TRACE )
+    osalRunTraceAdd( idx, traced, dispatch, duration );
+    if ( (tasksEvents[idx] == 0) && events )
+    {
+      OSAL_TRACE_READY( idx );
+    }
+#endif
     tasksEvents[idx] |= events;  // Add back unprocessed events to the current task.
+    if (tasksEvents[idx])
+    {
+      OSAL_READY_SET(idx);
+    }
     HAL_EXIT_CRITICAL_SECTION(intState);
   }
 #if defined( POWER_SAVING )
@@ -1143,6 +1474,307 @@ void osal_run_system( void )
 #endif
 }
 
+#if ( OSAL_RUN_TRACE )
+/*********************************************************************
+ * @fn      osalRunTraceAdd
+ *
+ * @brief   Append a task dispatch to the scheduler trace ring buffer,
+ *          overwriting the oldest record when it is full. Interrupts
+ *          must be disabled.
+ *
+ * @param   task_id - task dispatched
+ * @param   events - events passed to the task's event processor
+ * @param   dispatch - time the event processor was called
+ * @param   duration - time the event processor ran
+ *
+ * @return  none
+ */
+static void osalRunTraceAdd( uint8 task_id, uint16 events, uint16 dispatch, uint16 duration )
+{
+  osalRunTrace_t *pRec;
+
+  if ( !osalTrcOn )
+  {
+    return;
+  }
+
+  if ( osalTrcCnt < OSAL_RUN_TRACE_LEN )
+  {
+    pRec = &osalTrcBuf[(osalTrcHead + osalTrcCnt) % OSAL_RUN_TRACE_LEN];
+    osalTrcCnt++;
+  }
+  else
+  {
+    pRec = &osalTrcBuf[osalTrcHead];
+    osalTrcHead = (osalTrcHead + 1) % OSAL_RUN_TRACE_LEN;
+    if ( osalTrcDrop != 0xFFFF )
+    {
+      osalTrcDrop++;
+    }
+  }
+
+  pRec->taskID = task_id;
+  pRec->events = events;
+  pRec->ready = osalTrcReady[task_id];
+  pRec->dispatch = dispatch;
+  pRec->duration = duration;
+}
+
+/*********************************************************************
+ * @fn      osal_run_trace_enable
+ *
+ * @brief   Start or stop recording task dispatches. Starting discards
+ *          the records not read yet.
+ *
+ * @param   enable - TRUE to start, FALSE to stop.
+ *
+ * @return  none
+ */
+void osal_run_trace_enable( uint8 enable )
+{
+  halIntState_t intState;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+  if ( enable && !osalTrcOn )
+  {
+    osalTrcHead = osalTrcCnt = 0;
+    osalTrcDrop = 0;
+  }
+  osalTrcOn = enable;
+
+  HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+}
+
+/*********************************************************************
+ * @fn      osal_run_trace_read
+ *
+ * @brief   Copy out and remove the oldest scheduler trace records. Each
+ *          record takes OSAL_RUN_TRACE_RECSZ bytes: the task ID, then
+ *          the events, the ready time, the dispatch time and the
+ *          duration, each as a uint16 LSB first. Times are in
+ *          OSAL_RUN_CLOCK() ticks and wrap, so the wait of a
+ *          record is (dispatch - ready) modulo 2^16.
+ *
+ * @param   pBuf - buffer of at least maxCnt * OSAL_RUN_TRACE_RECSZ bytes.
+ * @param   maxCnt - maximum number of records to copy.
+ *
+ * @return  Number of records copied.
+ */
+uint8 osal_run_trace_read( uint8 *pBuf, uint8 maxCnt )
+{
+  halIntState_t intState;
+  uint8 cnt = 0;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+  while ( (cnt < maxCnt) && (osalTrcCnt != 0) )
+  {
+    osalRunTrace_t *pRec = &osalTrcBuf[osalTrcHead];
+
+    *pBuf++ = pRec->taskID;
+    *pBuf++ = LO_UINT16( pRec->events );
+    *pBuf++ = HI_UINT16( pRec->events );
+    *pBuf++ = LO_UINT16( pRec->ready );
+    *pBuf++ = HI_UINT16( pRec->ready );
+    *pBuf++ = LO_UINT16( pRec->dispatch );
+    *pBuf++ = HI_UINT16( pRec->dispatch );
+    *pBuf++ = LO_UINT16( pRec->duration );
+    *pBuf++ = HI_UINT16( pRec->duration );
+
+    osalTrcHead = (osalTrcHead + 1) % OSAL_RUN_TRACE_LEN;
+    osalTrcCnt--;
+    cnt++;
+  }
+
+  HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+
+  return cnt;
+}
+
+/*********************************************************************
+ * @fn      osal_run_trace_dropped
+ *
+ * @brief   Return the number of scheduler trace records overwritten
+ *          before they were read since recording was last started.
+ *
+ * @param   none
+ *
+ * @return  Number of lost records, saturating at 0xFFFF.
+ */
+uint16 osal_run_trace_dropped( void )
+{
+  return osalTrcDrop;
+}
+#endif // OSAL_RUN_TRACE
+
+#if ( OSAL_RUN_STATS )
+/*********************************************************************
+ * @fn      osalRunStatsAdd
+ *
+ * @brief   Account one run of a task's event processor and check it
+ *          against the task's budget. When the run count would wrap,
+ *          the count and the total are both halved so that the average
+ *          keeps following recent runs.
+ *
+ * @param   task_id - task dispatched
+ * @param   events - events passed to the task's event processor
+ * @param   duration - time the event processor ran
+ *
+ * @return  none
+ */
+static void osalRunStatsAdd( uint8 task_id, uint16 events, uint16 duration )
+{
+  osalRunAcc_t *pAcc = &osalRunAcc[task_id];
+
+  if ( pAcc->runs == 0xFFFF )
+  {
+    pAcc->runs >>= 1;
+    pAcc->total >>= 1;
+  }
+  pAcc->runs++;
+  pAcc->total += duration;
+
+  if ( duration >= pAcc->max )
+  {
+    pAcc->max = duration;
+    pAcc->maxEvents = events;
+  }
+
+  if ( (pAcc->budget != 0) && (duration > pAcc->budget) )
+  {
+    if ( pAcc->overruns != 0xFFFF )
+    {
+      pAcc->overruns++;
+    }
+    OSAL_RUN_OVERRUN_HOOK( task_id, events, duration );
+  }
+}
+
+/*********************************************************************
+ * @fn      osal_run_budget
+ *
+ * @brief   Set the time a task's event processor may run per call
+ *          before it counts as an overrun.
+ *
+ * @param   task_id - task ID
+ * @param   budget - time in OSAL_RUN_CLOCK() ticks, 0 for no limit
+ *
+ * @return  SUCCESS, INVALID_TASK
+ */
+uint8 osal_run_budget( uint8 task_id, uint16 budget )
+{
+  if ( task_id >= tasksCnt )
+  {
+    return ( INVALID_TASK );
+  }
+
+  osalRunAcc[task_id].budget = budget;
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      osal_run_stats
+ *
+ * @brief   Read the event processor time statistics of a task.
+ *
+ * @param   task_id - task ID
+ * @param   pStats - statistics to fill in
+ *
+ * @return  SUCCESS, INVALID_TASK
+ */
+uint8 osal_run_stats( uint8 task_id, osalRunStats_t *pStats )
+{
+  osalRunAcc_t *pAcc;
+
+  if ( task_id >= tasksCnt )
+  {
+    return ( INVALID_TASK );
+  }
+
+  pAcc = &osalRunAcc[task_id];
+  pStats->runs = pAcc->runs;
+  pStats->avg = ( pAcc->runs ) ? (uint16)(pAcc->total / pAcc->runs) : 0;
+  pStats->max = pAcc->max;
+  pStats->maxEvents = pAcc->maxEvents;
+  pStats->overruns = pAcc->overruns;
+  pStats->budget = pAcc->budget;
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      osal_run_stats_reset
+ *
+ * @brief   Clear the event processor time statistics of a task,
+ *          keeping its budget.
+ *
+ * @param   task_id - task ID
+ *
+ * @return  SUCCESS, INVALID_TASK
+ */
+uint8 osal_run_stats_reset( uint8 task_id )
+{
+  uint16 budget;
+
+  if ( task_id >= tasksCnt )
+  {
+    return ( INVALID_TASK );
+  }
+
+  budget = osalRunAcc[task_id].budget;
+  (void)osal_memset( &osalRunAcc[task_id], 0, sizeof( osalRunAcc_t ) );
+  osalRunAcc[task_id].budget = budget;
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      osal_run_expired
+ *
+ * @brief   Check whether the active task's event processor has used up
+ *          its budget. Long-running work polls this and, when it
+ *          returns TRUE, saves its state and calls osal_run_continue()
+ *          so that other tasks get to run.
+ *
+ * @param   none
+ *
+ * @return  TRUE if the budget is used up, FALSE otherwise or when
+ *          called outside an event processor.
+ */
+uint8 osal_run_expired( void )
+{
+  uint16 budget;
+
+  if ( activeTaskID == TASK_NO_TASK )
+  {
+    return ( FALSE );
+  }
+
+  budget = osalRunAcc[activeTaskID].budget;
+
+  return ( (budget != 0) && ((uint16)(OSAL_RUN_CLOCK() - osalRunStart) >= budget) );
+}
+#endif // OSAL_RUN_STATS
+
+/*********************************************************************
+ * @fn      osal_run_continue
+ *
+ * @brief   Post a continuation event to the active task, to be called
+ *          by an event processor that stops long-running work early.
+ *          The event is handled on a later pass of osal_run_system(),
+ *          after any higher priority task that became ready meanwhile.
+ *
+ * @param   event_flag - event that resumes the work
+ *
+ * @return  SUCCESS, INVALID_TASK if called outside an event processor
+ */
+uint8 osal_run_continue( uint16 event_flag )
+{
+  return ( osal_set_event( activeTaskID, event_flag ) );
+}
+
 /*********************************************************************
  * @fn      osal_buffer_uint32
  *
@@ -1203,13 +1835,20 @@ uint8* osal_buffer_uint24( uint8 *buf, uint24 val )
  */
 uint8 osal_isbufset( uint8 *buf, uint8 val, uint8 len )
 {
+#if !defined ( OSAL_MEM_LIBC )
   uint8 x;
+#endif
 
   if ( buf == NULL )
   {
     return ( FALSE );
   }
 
+#if defined ( OSAL_MEM_LIBC )
+  // Every byte equals the first one when the buffer equals itself shifted
+  // by one byte
+  return ( (len == 0) || ((buf[0] == val) && (memcmp( buf, buf + 1, len - 1 ) == 0)) );
+#else
   for ( x = 0; x < len; x++ )
   {
     // Check for non-initialized value
@@ -1219,6 +1858,38 @@ uint8 osal_isbufset( uint8 *buf, uint8 val, uint8 len )
     }
   }
   return ( TRUE );
+#endif
+}
+
+/*********************************************************************
+ * @fn      osal_ffs
+ *
+ * @brief
+ *
+ *   Find the lowest set bit of a bitmap.
+ *
+ * @param   map - non-zero bitmap
+ *
+ * @return  index of the lowest set bit
+ */
+uint8 osal_ffs( uint16 map )
+{
+  uint8 idx = 0;
+  uint8 bits = LO_UINT16( map );
+
+  if ( bits == 0 )
+  {
+    bits = HI_UINT16( map );
+    idx = 8;
+  }
+
+  if ( (bits & 0x0F) == 0 )
+  {
+    bits >>= 4;
+    idx += 4;
+  }
+
+  return ( idx + osalFfsTbl[bits & 0x0F] );
 }
 
 /*********************************************************************
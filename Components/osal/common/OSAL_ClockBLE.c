@@ -49,7 +49,6 @@
  * MACROS
  */
 
-#define	YearLength(yr)	(IsLeapYear(yr) ? 366 : 365)
 
 /*********************************************************************
  * CONSTANTS
@@ -63,6 +62,41 @@
 
 #define	DAY             86400UL  // 24 hours * 60 minutes * 60 seconds
 
+// Days from 1 January to 1 March 2000; the calendar conversions count
+// years from 1 March so that the leap day falls at the end of a year.
+#define MAR1DAYS        60
+
+#define DAYSPER4YRS     1461     // 4 * 365 + 1
+#define DAYSPER100YRS   36524    // 100 * 365 + 24, the 400th year is leap
+
+// Length of the free-running LL timer tick
+#define TICK_USEC       625
+
+// Set to TRUE to interpolate osal_getClockUs() within the LL timer tick from
+// the sleep timer. The host instead reads the exact fraction of the tick
+// from its virtual clock, unless this is set to test the interpolation.
+#if !defined ( OSAL_CLOCK_INTERPOLATE )
+  #if defined ( HAL_MCU_POSIX )
+    #define OSAL_CLOCK_INTERPOLATE  FALSE
+  #else
+    #define OSAL_CLOCK_INTERPOLATE  TRUE
+  #endif
+#endif
+
+// Low byte of the 32.768 kHz sleep timer; ST0 latches ST1 and ST2 when read,
+// which does no harm when they are not read after it.
+#if !defined ( OSAL_CLOCK_SLEEP_TIMER )
+  #if defined ( HAL_MCU_POSIX )
+    #define OSAL_CLOCK_SLEEP_TIMER()  HalClockSleepTimer()
+  #else
+    #define OSAL_CLOCK_SLEEP_TIMER()  ST0
+  #endif
+#endif
+
+// A sleep timer tick is 1000000 / 32768 = 15625 / 512 us
+#define SLEEP_TICK_US_NUM   15625UL
+#define SLEEP_TICK_US_DEN   512
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -87,6 +121,18 @@ static uint16 previousLLTimerTick = 0;
 static uint16 remUsTicks = 0;
 static uint16 timeMSec = 0;
 
+// LL timer ticks accounted by osalTimeUpdate() since power-up
+static uint32 elapsedTicks = 0;
+
+// Last value returned by osal_getClockUs()
+static uint32 lastClockUs = 0;
+
+#if OSAL_CLOCK_INTERPOLATE
+// LL timer count and sleep timer when osal_getClockUs() first saw that count
+static uint16 clockLLTick = 0;
+static uint8 clockSleepTick = 0;
+#endif
+
 // number of seconds since 0 hrs, 0 minutes, 0 seconds, on the
 // 1st of January 2000 UTC
 UTCTime OSAL_timeSeconds = 0;
@@ -94,9 +140,8 @@ UTCTime OSAL_timeSeconds = 0;
 /*********************************************************************
  * LOCAL FUNCTION PROTOTYPES
  */
-static uint8 monthLength( uint8 lpyr, uint8 mon );
-
 static void osalClockUpdate( uint16 elapsedMSec );
+static uint16 osalClockSubTick( uint16 llTick );
 
 /*********************************************************************
  * FUNCTIONS
@@ -118,6 +163,7 @@ static void osalClockUpdate( uint16 elapsedMSec );
  */
 void osalTimeUpdate( void )
 {
+  halIntState_t intState;
   uint16 tmp;
   uint16 ticks625us;
   uint16 elapsedMSec = 0;
@@ -130,9 +176,16 @@ void osalTimeUpdate( void )
     // Calculate the elapsed ticks of the free-running timer.
     ticks625us = tmp - previousLLTimerTick;
 
+    // osal_getClockUs() reads both from interrupts as well
+    HAL_ENTER_CRITICAL_SECTION( intState );
+
+    elapsedTicks += ticks625us;
+
     // Store the LL Timer tick count for the next time through this function.
     previousLLTimerTick = tmp;
 
+    HAL_EXIT_CRITICAL_SECTION( intState );
+
     /* It is necessary to loop to convert the usecs to msecs in increments so as
      * not to overflow the 16-bit variables.
      */
@@ -182,6 +235,43 @@ static void osalClockUpdate( uint16 elapsedMSec )
   }
 }
 
+/*********************************************************************
+ * @fn      osalClockSubTick
+ *
+ * @brief   Microseconds elapsed within the current LL timer tick. With
+ *          OSAL_CLOCK_INTERPOLATE they are counted on the sleep timer
+ *          from the first call that saw the tick, so they lag the tick
+ *          by up to the time between calls and are never ahead of it by
+ *          more than one sleep timer tick. Called with interrupts off.
+ *
+ * @param   llTick - LL timer count read with the sub tick
+ *
+ * @return  microseconds since the tick, below TICK_USEC
+ */
+static uint16 osalClockSubTick( uint16 llTick )
+{
+#if OSAL_CLOCK_INTERPOLATE
+  uint8 sleepTick = OSAL_CLOCK_SLEEP_TIMER();
+  uint32 subTick;
+
+  if ( llTick != clockLLTick )
+  {
+    clockLLTick = llTick;
+    clockSleepTick = sleepTick;
+
+    return ( 0 );
+  }
+
+  subTick = (uint8)(sleepTick - clockSleepTick) * SLEEP_TICK_US_NUM / SLEEP_TICK_US_DEN;
+
+  return ( (subTick < TICK_USEC) ? (uint16)subTick : (TICK_USEC - 1) );
+#else
+  (void)llTick;
+
+  return ( HalClockSubTick() );
+#endif
+}
+
 /*********************************************************************
  * @fn      osal_setClock
  *
@@ -215,6 +305,47 @@ UTCTime osal_getClock( void )
   return ( OSAL_timeSeconds );
 }
 
+/*********************************************************************
+ * @fn      osal_getClockUs
+ *
+ * @brief   Gets a monotonic timestamp in microseconds since power-up,
+ *          for instrumentation and sensor timestamping. It counts the
+ *          625 us ticks of the LL free-running timer, including those
+ *          osalTimeUpdate() has not picked up yet, and adds the
+ *          fraction of the current tick interpolated from the sleep
+ *          timer. It never returns less than the last value returned.
+ *          Unlike osal_getClock() it is not changed by osal_setClock().
+ *
+ * @param   none
+ *
+ * @return  microseconds since power-up, wrapping after about 71.6
+ *          minutes, so compare timestamps by their difference
+ */
+uint32 osal_getClockUs( void )
+{
+  halIntState_t intState;
+  uint16 llTick;
+  uint32 clockUs;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+  llTick = ll_McuPrecisionCount();
+  clockUs = (elapsedTicks + (uint16)(llTick - previousLLTimerTick)) * TICK_USEC;
+  clockUs += osalClockSubTick( llTick );
+
+  // Never step back, e.g. when the LL timer count came round to the same
+  // value since the sleep timer reference was taken
+  if ( (int32)(clockUs - lastClockUs) < 0 )
+  {
+    clockUs = lastClockUs;
+  }
+  lastClockUs = clockUs;
+
+  HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+
+  return ( clockUs );
+}
+
 /*********************************************************************
  * @fn      osal_ConvertUTCTime
  *
@@ -240,55 +371,29 @@ void osal_ConvertUTCTime( UTCTimeStruct *tm, UTCTime secTime )
   // Fill in the calendar - day, month, year
   {
     uint16 numDays = secTime / DAY;
-    tm->year = BEGYEAR;
-    while ( numDays >= YearLength( tm->year ) )
-    {
-      numDays -= YearLength( tm->year );
-      tm->year++;
-    }
-
-    tm->month = 0;
-    while ( numDays >= monthLength( IsLeapYear( tm->year ), tm->month ) )
-    {
-      numDays -= monthLength( IsLeapYear( tm->year ), tm->month );
-      tm->month++;
-    }
-
-    tm->day = numDays;
-  }
-}
-
-/*********************************************************************
- * @fn      monthLength
- *
- * @param   lpyr - 1 for leap year, 0 if not
- *
- * @param   mon - 0 - 11 (jan - dec)
- *
- * @return  number of days in specified month
- */
-static uint8 monthLength( uint8 lpyr, uint8 mon )
-{
-  uint8 days = 31;
 
-  if ( mon == 1 ) // feb
-  {
-    days = ( 28 + lpyr );
-  }
-  else
-  {
-    if ( mon > 6 ) // aug-dec
+    if ( numDays < MAR1DAYS )
     {
-      mon--;
+      // January and February 2000 precede the first March-based year
+      tm->year = BEGYEAR;
+      tm->month = ( numDays >= 31 ) ? 1 : 0;
+      tm->day = numDays - (tm->month * 31);
     }
-
-    if ( mon & 1 )
+    else
     {
-      days = 30;
+      // Days since 1 March 2000, which starts a 400 year cycle. Dropping
+      // the leap days before doe leaves 365 days per year; the range of
+      // UTCTime ends in 2136, so the 400 year term is always 0.
+      uint16 doe = numDays - MAR1DAYS;
+      uint16 yoe = (doe - (doe / (DAYSPER4YRS - 1)) + (doe / DAYSPER100YRS)) / 365;
+      uint16 doy = doe - ((365 * yoe) + (yoe / 4) - (yoe / 100));
+      uint8 mp = ((5 * doy) + 2) / 153;  // Month counted from March
+
+      tm->day = doy - (((153 * mp) + 2) / 5);
+      tm->month = ( mp < 10 ) ? (mp + 2) : (mp - 10);
+      tm->year = BEGYEAR + yoe + (( mp < 10 ) ? 0 : 1);
     }
   }
-
-  return ( days );
 }
 
 /*********************************************************************
@@ -309,25 +414,21 @@ UTCTime osal_ConvertUTCSecs( UTCTimeStruct *tm )
 
   /* Account for previous complete days */
   {
-    /* Start with complete days in current month */
-    uint16 days = tm->day;
+    uint16 days;
 
-    /* Next, complete months in current year */
+    if ( (tm->year == BEGYEAR) && (tm->month < 2) )
     {
-      int8 month = tm->month;
-      while ( --month >= 0 )
-      {
-        days += monthLength( IsLeapYear( tm->year ), month );
-      }
+      /* January and February 2000 precede the first March-based year */
+      days = (tm->month * 31) + tm->day;
     }
-
-    /* Next, complete years before current year */
+    else
     {
-      uint16 year = tm->year;
-      while ( --year >= BEGYEAR )
-      {
-        days += YearLength( year );
-      }
+      /* Count years and months from 1 March, as osal_ConvertUTCTime() */
+      uint16 yoe = tm->year - BEGYEAR - (( tm->month < 2 ) ? 1 : 0);
+      uint8 mp = ( tm->month < 2 ) ? (tm->month + 10) : (tm->month - 2);
+      uint16 doy = (((153 * mp) + 2) / 5) + tm->day;
+
+      days = MAR1DAYS + (365 * yoe) + (yoe / 4) - (yoe / 100) + doy;
     }
 
     /* Add total seconds before partial day */
@@ -140,6 +140,41 @@
 #define OSALMEM_PROFILER_LL        FALSE  // Special profiling of the Long-Lived bucket.
 #endif
 
+/* Manage the big-block area after the small-block bucket with segregated free lists instead of
+ * the first-fit walk. Free blocks are kept on one list per power-of-two size class and every block
+ * in the area carries a footer with its length, so allocation is a bitmap lookup and a free is
+ * coalesced immediately with both neighbours.
+ */
+#if !defined OSALMEM_SEGREGATED
+#define OSALMEM_SEGREGATED         FALSE
+#endif
+
+#if OSALMEM_SEGREGATED
+// Size of the length footer at the end of each block in the big-block area.
+#define OSALMEM_SEG_FTRSZ          sizeof(uint16)
+// Smallest block in the big-block area - it must hold the free list links and the footer.
+#define OSALMEM_SEG_MINSZ          (OSALMEM_ROUND((sizeof(osalMemFree_t) + OSALMEM_SEG_FTRSZ)))
+// One size class per power of two of a 15-bit block length.
+#define OSALMEM_SEG_CLASSES        15
+
+// Length footer of a block in the big-block area.
+#define OSALMEM_SEG_FTR(HDR, LEN)  (*((uint16 *)((uint8 *)(HDR) + (LEN)) - 1))
+// Bytes at the end of a block not available to the user: the footer in the big-block area.
+#define OSALMEM_TAILSZ(HDR)        (((HDR) >= (theHeap + OSALMEM_BIGBLK_IDX)) ? OSALMEM_SEG_FTRSZ : 0)
+#else
+#define OSALMEM_TAILSZ(HDR)        0
+#endif
+
+#if OSALMEM_TRACE
+#if defined DPRINTF_OSALHEAPTRACE
+#error OSALMEM_TRACE and DPRINTF_OSALHEAPTRACE cannot be used together!
+#endif
+// Number of records held by the heap trace ring buffer.
+#if !defined OSALMEM_TRACE_LEN
+#define OSALMEM_TRACE_LEN          16
+#endif
+#endif
+
 #if OSALMEM_PROFILER
 #define OSALMEM_INIT              'X'
 #define OSALMEM_ALOC              'A'
@@ -167,6 +202,24 @@ typedef union {
   osalMemHdrHdr_t hdr;
 } osalMemHdr_t;
 
+#if OSALMEM_TRACE
+typedef struct {
+  uint16 site;  // Call site - the low 16 bits of the address of its file name, 0 when unknown.
+  uint16 line;  // Call site line number, with the OSALMEM_TRACE_ event type in the two MSBs.
+  uint16 len;   // Block length, including the header.
+  uint16 time;  // Low 16 bits of the OSAL system clock in msecs.
+} osalMemTrace_t;
+#endif
+
+#if OSALMEM_SEGREGATED
+// A free block in the big-block area, linked into the list of its size class.
+typedef struct osalMemFree {
+  osalMemHdr_t hdr;
+  struct osalMemFree *next;
+  struct osalMemFree *prev;
+} osalMemFree_t;
+#endif
+
 /* ------------------------------------------------------------------------------------------------
  *                                           Local Variables
  * ------------------------------------------------------------------------------------------------
@@ -177,6 +230,11 @@ static __no_init osalMemHdr_t *ff1;  // First free block in the small-block buck
 
 static uint8 osalMemStat;            // Discrete status flags: 0x01 = kicked.
 
+#if OSALMEM_SEGREGATED
+static osalMemFree_t *osalMemSegList[OSALMEM_SEG_CLASSES];  // Free blocks by size class.
+static uint16 osalMemSegMap;                                 // Bitmap of non-empty size classes.
+#endif
+
 #if OSALMEM_METRICS
 static uint16 blkMax;  // Max cnt of all blocks ever seen at once.
 static uint16 blkCnt;  // Current cnt of all blocks.
@@ -185,6 +243,14 @@ static uint16 memAlo;  // Current total memory allocated.
 static uint16 memMax;  // Max total memory ever allocated at once.
 #endif
 
+#if OSALMEM_TRACE
+static osalMemTrace_t trcBuf[OSALMEM_TRACE_LEN];
+static uint8 trcHead;     // Index of the oldest record.
+static uint8 trcCnt;      // Number of records held.
+static uint8 trcOn;       // Recording is enabled.
+static uint16 trcDrop;    // Number of records overwritten before they were read.
+#endif
+
 #if OSALMEM_PROFILER
 #define OSALMEM_PROMAX  8
 /* The profiling buckets must differ by at least OSALMEM_MIN_BLKSZ; the
@@ -208,6 +274,22 @@ static uint16 proSmallBlkMiss;
 extern int dprintf(const char *fmt, ...);
 #endif /* DPRINTF_HEAPTRACE */
 
+/* ------------------------------------------------------------------------------------------------
+ *                                           Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+
+#if OSALMEM_TRACE
+static void osalMemTraceAdd(const char *fname, uint16 lnum, uint16 len, uint16 type);
+#endif
+#if OSALMEM_SEGREGATED
+static uint8 osalMemSegClass(uint16 len);
+static void osalMemSegInsert(osalMemHdr_t *hdr);
+static void osalMemSegUnlink(osalMemHdr_t *hdr);
+static osalMemHdr_t *osalMemSegAlloc(uint16 size);
+static void osalMemSegFree(osalMemHdr_t *hdr);
+#endif
+
 /**************************************************************************************************
  * @fn          osal_mem_init
  *
@@ -246,6 +328,14 @@ void osal_mem_init(void)
   // Setup the wilderness.
   theHeap[OSALMEM_BIGBLK_IDX].val = OSALMEM_BIGBLK_SZ;  // Set 'len' & clear 'inUse' field.
 
+#if OSALMEM_SEGREGATED
+  // The end-of-heap block is never coalesced and the wilderness is the only free big block.
+  theHeap[OSALMEM_LASTBLK_IDX].val = OSALMEM_IN_USE;
+  (void)osal_memset(osalMemSegList, 0, sizeof(osalMemSegList));
+  osalMemSegMap = 0;
+  osalMemSegInsert(theHeap + OSALMEM_BIGBLK_IDX);
+#endif
+
 #if ( OSALMEM_METRICS )
   /* Start with the small-block bucket and the wilderness - don't count the
    * end-of-heap NULL block nor the end-of-small-block NULL block.
@@ -308,6 +398,8 @@ void osal_mem_kick(void)
  */
 #ifdef DPRINTF_OSALHEAPTRACE
 void *osal_mem_alloc_dbg( uint16 size, const char *fname, unsigned lnum )
+#elif OSALMEM_TRACE
+void *osal_mem_alloc_trc( uint16 size, const char *fname, uint16 lnum )
 #else /* DPRINTF_OSALHEAPTRACE */
 void *osal_mem_alloc( uint16 size )
 #endif /* DPRINTF_OSALHEAPTRACE */
@@ -341,13 +433,25 @@ void *osal_mem_alloc( uint16 size )
   if ((osalMemStat == 0) || (size <= OSALMEM_SMALL_BLKSZ))
   {
     hdr = ff1;
+
+#if OSALMEM_SEGREGATED
+    // Once the small-block bucket is full, ff1 rests on the header that ends it.
+    if ( hdr >= (theHeap + OSALMEM_SMALLBLK_HDRCNT) )
+    {
+      hdr = NULL;
+    }
+#endif
   }
   else
   {
+#if OSALMEM_SEGREGATED
+    hdr = NULL;  // Taken from the segregated free lists below.
+#else
     hdr = (theHeap + OSALMEM_BIGBLK_IDX);
+#endif
   }
 
-  do
+  while ( hdr != NULL )
   {
     if ( hdr->hdr.inUse )
     {
@@ -384,12 +488,21 @@ void *osal_mem_alloc( uint16 size )
 
     hdr = (osalMemHdr_t *)((uint8 *)hdr + hdr->hdr.len);
 
+#if OSALMEM_SEGREGATED
+    // The walk ends at the header blocking the small-block bucket from the big-block area.
+    if ( hdr == (theHeap + OSALMEM_SMALLBLK_HDRCNT) )
+    {
+      hdr = NULL;
+      break;
+    }
+#endif
+
     if ( hdr->val == 0 )
     {
       hdr = NULL;
       break;
     }
-  } while (1);
+  }
 
   if ( hdr != NULL )
   {
@@ -421,7 +534,16 @@ void *osal_mem_alloc( uint16 size )
 
       hdr->hdr.inUse = TRUE;
     }
+  }
+#if OSALMEM_SEGREGATED
+  else
+  {
+    hdr = osalMemSegAlloc(size);
+  }
+#endif
 
+  if ( hdr != NULL )
+  {
 #if ( OSALMEM_METRICS )
     if ( memMax < memAlo )
     {
@@ -464,7 +586,8 @@ void *osal_mem_alloc( uint16 size )
       }
     }
 
-    (void)osal_memset((uint8 *)(hdr+1), OSALMEM_ALOC, (hdr->hdr.len - OSALMEM_HDRSZ));
+    (void)osal_memset((uint8 *)(hdr+1), OSALMEM_ALOC,
+                      (hdr->hdr.len - OSALMEM_HDRSZ - OSALMEM_TAILSZ(hdr)));
 #endif
 
     if ((osalMemStat != 0) && (ff1 == hdr))
@@ -475,6 +598,10 @@ void *osal_mem_alloc( uint16 size )
     hdr++;
   }
 
+#if OSALMEM_TRACE
+  osalMemTraceAdd(fname, lnum, size, ((hdr != NULL) ? OSALMEM_TRACE_ALLOC : OSALMEM_TRACE_FAIL));
+#endif
+
   HAL_EXIT_CRITICAL_SECTION( intState );  // Re-enable interrupts.
 #pragma diag_suppress=Pe767
   HAL_ASSERT(((halDataAlign_t)hdr % sizeof(halDataAlign_t)) == 0);
@@ -503,6 +630,8 @@ void *osal_mem_alloc( uint16 size )
  */
 #ifdef DPRINTF_OSALHEAPTRACE
 void osal_mem_free_dbg(void *ptr, const char *fname, unsigned lnum)
+#elif OSALMEM_TRACE
+void osal_mem_free_trc(void *ptr, const char *fname, uint16 lnum)
 #else /* DPRINTF_OSALHEAPTRACE */
 void osal_mem_free(void *ptr)
 #endif /* DPRINTF_OSALHEAPTRACE */
@@ -520,6 +649,10 @@ void osal_mem_free(void *ptr)
   HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
   hdr->hdr.inUse = FALSE;
 
+#if OSALMEM_TRACE
+  osalMemTraceAdd(fname, lnum, hdr->hdr.len, OSALMEM_TRACE_FREE);
+#endif
+
   if (ff1 > hdr)
   {
     ff1 = hdr;
@@ -550,9 +683,517 @@ void osal_mem_free(void *ptr)
   blkFree++;
 #endif
 
+#if OSALMEM_SEGREGATED
+  if (hdr >= (theHeap + OSALMEM_BIGBLK_IDX))
+  {
+    osalMemSegFree(hdr);
+  }
+#endif
+
   HAL_EXIT_CRITICAL_SECTION( intState );  // Re-enable interrupts.
 }
 
+#if OSALMEM_TRACE
+/**************************************************************************************************
+ * @fn          osal_mem_alloc
+ *
+ * @brief       Allocation entry point for code not built against the OSAL_Memory.h trace macros,
+ *              such as pre-built libraries. Its records carry an unknown (zero) call site.
+ *
+ * input parameters
+ *
+ * @param size - the number of bytes to allocate from the HEAP.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      A pointer to the allocated memory, NULL if none is available.
+ */
+void *(osal_mem_alloc)(uint16 size)
+{
+  return osal_mem_alloc_trc(size, NULL, 0);
+}
+
+/**************************************************************************************************
+ * @fn          osal_mem_free
+ *
+ * @brief       De-allocation entry point for code not built against the OSAL_Memory.h trace
+ *              macros, such as pre-built libraries. Its records carry an unknown (zero) call site.
+ *
+ * input parameters
+ *
+ * @param ptr - A valid pointer (i.e. a pointer returned by osal_mem_alloc()) to the memory to free.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ */
+void (osal_mem_free)(void *ptr)
+{
+  osal_mem_free_trc(ptr, NULL, 0);
+}
+
+/**************************************************************************************************
+ * @fn          osalMemTraceAdd
+ *
+ * @brief       Append a record to the heap trace ring buffer, overwriting the oldest record when
+ *              it is full. Interrupts must be disabled.
+ *
+ * input parameters
+ *
+ * @param fname - the file name of the call site, NULL when unknown.
+ * @param lnum - the line number of the call site.
+ * @param len - the block length.
+ * @param type - OSALMEM_TRACE_ALLOC, OSALMEM_TRACE_FREE or OSALMEM_TRACE_FAIL.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ */
+static void osalMemTraceAdd(const char *fname, uint16 lnum, uint16 len, uint16 type)
+{
+  osalMemTrace_t *pRec;
+
+  if (!trcOn)
+  {
+    return;
+  }
+
+  if (trcCnt < OSALMEM_TRACE_LEN)
+  {
+    pRec = &trcBuf[(trcHead + trcCnt) % OSALMEM_TRACE_LEN];
+    trcCnt++;
+  }
+  else
+  {
+    pRec = &trcBuf[trcHead];
+    trcHead = (trcHead + 1) % OSALMEM_TRACE_LEN;
+    if (trcDrop != 0xFFFF)
+    {
+      trcDrop++;
+    }
+  }
+
+  pRec->site = (uint16)(unsigned long)fname;
+  pRec->line = (lnum & ~(OSALMEM_TRACE_FREE | OSALMEM_TRACE_FAIL)) | type;
+  pRec->len = len;
+  pRec->time = (uint16)osal_GetSystemClock();
+}
+
+/*********************************************************************
+ * @fn      osal_mem_trace_enable
+ *
+ * @brief   Start or stop recording heap allocations and frees. Starting
+ *          discards the records not read yet.
+ *
+ * @param   enable - TRUE to start, FALSE to stop.
+ *
+ * @return  none
+ */
+void osal_mem_trace_enable( uint8 enable )
+{
+  halIntState_t intState;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+  if ( enable && !trcOn )
+  {
+    trcHead = trcCnt = 0;
+    trcDrop = 0;
+  }
+  trcOn = enable;
+
+  HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+}
+
+/*********************************************************************
+ * @fn      osal_mem_trace_read
+ *
+ * @brief   Copy out and remove the oldest heap trace records. Each
+ *          record takes OSALMEM_TRACE_RECSZ bytes: the call site, the
+ *          line number and event type, the block length and the
+ *          timestamp, each as a uint16 LSB first.
+ *
+ * @param   pBuf - buffer of at least maxCnt * OSALMEM_TRACE_RECSZ bytes.
+ * @param   maxCnt - maximum number of records to copy.
+ *
+ * @return  Number of records copied.
+ */
+uint8 osal_mem_trace_read( uint8 *pBuf, uint8 maxCnt )
+{
+  halIntState_t intState;
+  uint8 cnt = 0;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+  while ( (cnt < maxCnt) && (trcCnt != 0) )
+  {
+    osalMemTrace_t *pRec = &trcBuf[trcHead];
+
+    *pBuf++ = LO_UINT16( pRec->site );
+    *pBuf++ = HI_UINT16( pRec->site );
+    *pBuf++ = LO_UINT16( pRec->line );
+    *pBuf++ = HI_UINT16( pRec->line );
+    *pBuf++ = LO_UINT16( pRec->len );
+    *pBuf++ = HI_UINT16( pRec->len );
+    *pBuf++ = LO_UINT16( pRec->time );
+    *pBuf++ = HI_UINT16( pRec->time );
+
+    trcHead = (trcHead + 1) % OSALMEM_TRACE_LEN;
+    trcCnt--;
+    cnt++;
+  }
+
+  HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+
+  return cnt;
+}
+
+/*********************************************************************
+ * @fn      osal_mem_trace_dropped
+ *
+ * @brief   Return the number of heap trace records overwritten before
+ *          they were read since recording was last started.
+ *
+ * @param   none
+ *
+ * @return  Number of lost records, saturating at 0xFFFF.
+ */
+uint16 osal_mem_trace_dropped( void )
+{
+  return trcDrop;
+}
+
+/*********************************************************************
+ * @fn      osal_heap_frag
+ *
+ * @brief   Walk the heap and measure its fragmentation. Adjacent free
+ *          blocks count as one since they are coalesced on demand. The
+ *          walk is done with interrupts held off and visits every
+ *          block, so it is meant for diagnostics only.
+ *
+ * @param   pFree - returns the total number of free bytes, may be NULL.
+ * @param   pLargest - returns the size of the largest free run, may be NULL.
+ *
+ * @return  Fragmentation index: 0 when all free memory is in a single
+ *          block up to 100 as it gets scattered into small blocks.
+ */
+uint8 osal_heap_frag( uint16 *pFree, uint16 *pLargest )
+{
+  halIntState_t intState;
+  osalMemHdr_t *hdr = theHeap;
+  uint16 freeLen = 0;
+  uint16 maxLen = 0;
+  uint16 runLen = 0;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+  // The end of the heap is marked by a zero length block.
+  while ( hdr->hdr.len != 0 )
+  {
+    if ( hdr->hdr.inUse )
+    {
+      runLen = 0;
+    }
+    else
+    {
+      freeLen += hdr->hdr.len;
+      runLen += hdr->hdr.len;
+      if ( maxLen < runLen )
+      {
+        maxLen = runLen;
+      }
+    }
+
+    hdr = (osalMemHdr_t *)((uint8 *)hdr + hdr->hdr.len);
+  }
+
+  HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+
+  if ( pFree != NULL )
+  {
+    *pFree = freeLen;
+  }
+  if ( pLargest != NULL )
+  {
+    *pLargest = maxLen;
+  }
+
+  return ( (freeLen == 0) ? 0 : (uint8)(100 - (uint8)(((uint32)maxLen * 100) / freeLen)) );
+}
+#endif
+
+#if OSALMEM_SEGREGATED
+/**************************************************************************************************
+ * @fn          osalMemSegClass
+ *
+ * @brief       Find the size class of a block length in the big-block area.
+ *
+ * input parameters
+ *
+ * @param len - the block length.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      The index of the most significant bit set in the length.
+ */
+static uint8 osalMemSegClass(uint16 len)
+{
+  uint8 cls = 0;
+
+  if (len & 0xFF00)
+  {
+    len >>= 8;
+    cls = 8;
+  }
+  if (len & 0x00F0)
+  {
+    len >>= 4;
+    cls += 4;
+  }
+  if (len & 0x000C)
+  {
+    len >>= 2;
+    cls += 2;
+  }
+  if (len & 0x0002)
+  {
+    cls++;
+  }
+
+  return cls;
+}
+
+/**************************************************************************************************
+ * @fn          osalMemSegInsert
+ *
+ * @brief       Write the footer of a free block in the big-block area and push it onto the list
+ *              of its size class. Interrupts must be disabled.
+ *
+ * input parameters
+ *
+ * @param hdr - the free block.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ */
+static void osalMemSegInsert(osalMemHdr_t *hdr)
+{
+  osalMemFree_t *blk = (osalMemFree_t *)hdr;
+  uint8 cls = osalMemSegClass(hdr->hdr.len);
+
+  OSALMEM_SEG_FTR(hdr, hdr->hdr.len) = hdr->hdr.len;
+
+  blk->prev = NULL;
+  blk->next = osalMemSegList[cls];
+  if (blk->next != NULL)
+  {
+    blk->next->prev = blk;
+  }
+  osalMemSegList[cls] = blk;
+  osalMemSegMap |= BV(cls);
+}
+
+/**************************************************************************************************
+ * @fn          osalMemSegUnlink
+ *
+ * @brief       Take a free block in the big-block area off the list of its size class.
+ *              Interrupts must be disabled.
+ *
+ * input parameters
+ *
+ * @param hdr - the free block.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ */
+static void osalMemSegUnlink(osalMemHdr_t *hdr)
+{
+  osalMemFree_t *blk = (osalMemFree_t *)hdr;
+
+  if (blk->prev != NULL)
+  {
+    blk->prev->next = blk->next;
+  }
+  else
+  {
+    uint8 cls = osalMemSegClass(hdr->hdr.len);
+
+    osalMemSegList[cls] = blk->next;
+    if (blk->next == NULL)
+    {
+      osalMemSegMap &= ~BV(cls);
+    }
+  }
+
+  if (blk->next != NULL)
+  {
+    blk->next->prev = blk->prev;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          osalMemSegAlloc
+ *
+ * @brief       Allocate a block from the segregated free lists of the big-block area.
+ *              The first block of the smallest size class whose blocks are all big enough is
+ *              taken; only when no such class has a free block is the list of the request's own
+ *              class searched. Interrupts must be disabled.
+ *
+ * input parameters
+ *
+ * @param size - the aligned block size needed, including the header.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      A pointer to the header of the allocated block, NULL if none is big enough.
+ */
+static osalMemHdr_t *osalMemSegAlloc(uint16 size)
+{
+  osalMemFree_t *blk = NULL;
+  uint16 map;
+  uint16 tmp;
+  uint8 cls;
+
+  size = OSALMEM_ROUND(size + OSALMEM_SEG_FTRSZ);
+  if (size < OSALMEM_SEG_MINSZ)
+  {
+    size = OSALMEM_SEG_MINSZ;
+  }
+
+  // All blocks of a class above the class of 'size' are big enough, and so are all blocks of its
+  // own class when 'size' is an exact power of two.
+  cls = osalMemSegClass(size);
+  map = osalMemSegMap & ~(BV(cls) - 1);
+  if (size != BV(cls))
+  {
+    map &= ~BV(cls);
+  }
+
+  if (map != 0)
+  {
+    blk = osalMemSegList[osal_ffs(map)];
+  }
+  else
+  {
+    for (blk = osalMemSegList[cls]; blk != NULL; blk = blk->next)
+    {
+      if (blk->hdr.hdr.len >= size)
+      {
+        break;
+      }
+    }
+  }
+
+  if (blk == NULL)
+  {
+    return NULL;
+  }
+
+  osalMemSegUnlink(&blk->hdr);
+  tmp = blk->hdr.hdr.len - size;
+
+  // Determine whether the threshold for splitting is met.
+  if (tmp >= OSALMEM_SEG_MINSZ)
+  {
+    // Split the block and return the remainder to the free lists.
+    osalMemHdr_t *next = (osalMemHdr_t *)((uint8 *)blk + size);
+    next->val = tmp;                          // Set 'len' & clear 'inUse' field.
+    osalMemSegInsert(next);
+    blk->hdr.val = (size | OSALMEM_IN_USE);   // Set 'len' & 'inUse' field.
+
+#if ( OSALMEM_METRICS )
+    blkCnt++;
+    if ( blkMax < blkCnt )
+    {
+      blkMax = blkCnt;
+    }
+    memAlo += size;
+#endif
+  }
+  else
+  {
+#if ( OSALMEM_METRICS )
+    memAlo += blk->hdr.hdr.len;
+    blkFree--;
+#endif
+
+    blk->hdr.hdr.inUse = TRUE;
+  }
+
+  OSALMEM_SEG_FTR(blk, blk->hdr.hdr.len) = blk->hdr.hdr.len;
+
+  return &blk->hdr;
+}
+
+/**************************************************************************************************
+ * @fn          osalMemSegFree
+ *
+ * @brief       Coalesce a freed block in the big-block area with its free neighbours and put the
+ *              result on the free list of its size class. Interrupts must be disabled.
+ *
+ * input parameters
+ *
+ * @param hdr - the block, already marked as not in use.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ */
+static void osalMemSegFree(osalMemHdr_t *hdr)
+{
+  osalMemHdr_t *next = (osalMemHdr_t *)((uint8 *)hdr + hdr->hdr.len);
+
+  if (!next->hdr.inUse)
+  {
+    osalMemSegUnlink(next);
+    hdr->hdr.len += next->hdr.len;
+
+#if ( OSALMEM_METRICS )
+    blkCnt--;
+    blkFree--;
+#endif
+  }
+
+  // The first block of the area has no footer in front of it.
+  if (hdr != (theHeap + OSALMEM_BIGBLK_IDX))
+  {
+    osalMemHdr_t *prev = (osalMemHdr_t *)((uint8 *)hdr - *((uint16 *)hdr - 1));
+
+    if (!prev->hdr.inUse)
+    {
+      osalMemSegUnlink(prev);
+      prev->hdr.len += hdr->hdr.len;
+      hdr = prev;
+
+#if ( OSALMEM_METRICS )
+      blkCnt--;
+      blkFree--;
+#endif
+    }
+  }
+
+  osalMemSegInsert(hdr);
+}
+#endif
+
 #if OSALMEM_METRICS
 /*********************************************************************
  * @fn      osal_heap_block_max
@@ -47,6 +47,9 @@
 #include "OSAL_Tasks.h"
 #include "OSAL_Timers.h"
 #include "OSAL_PwrMgr.h"
+#if ( OSAL_PWRMGR_STATS )
+  #include "OSAL_Clock.h"
+#endif
 
 /*********************************************************************
  * MACROS
@@ -56,10 +59,26 @@
  * CONSTANTS
  */
 
+// One task state bit per task, so at most 16 tasks
+#define PWRMGR_MAX_TASKS  16
+
+// Index of the awake time no task was charged with: from power-up to the
+// first sleep and after wakeups that dispatched no task.
+#define PWRMGR_NO_TASK    PWRMGR_MAX_TASKS
+
 /*********************************************************************
  * TYPEDEFS
  */
 
+#if ( OSAL_PWRMGR_STATS )
+// Time accumulated in milliseconds and a microsecond remainder
+typedef struct
+{
+  uint32 msec;
+  uint16 usec;
+} pwrmgrTime_t;
+#endif
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -80,10 +99,31 @@ pwrmgr_attribute_t pwrmgr_attribute;
  * LOCAL VARIABLES
  */
 
+#if ( OSAL_PWRMGR_STATS )
+static pwrmgrTime_t pwrmgrModeTime[PWRMGR_MODE_CNT];
+static uint16 pwrmgrWakes[PWRMGR_WAKE_CNT];
+
+static pwrmgrTime_t pwrmgrTaskTime[PWRMGR_MAX_TASKS + 1];
+static uint16 pwrmgrTaskWakes[PWRMGR_MAX_TASKS + 1];
+static uint16 pwrmgrTaskEvents[PWRMGR_MAX_TASKS + 1];
+
+static uint32 pwrmgrStamp;      // Time of the last wakeup or accounting, in usec.
+static uint8 pwrmgrMode;        // Power mode reported for the current sleep.
+static uint8 pwrmgrCause;       // Cause of the current sleep's wakeup.
+static uint8 pwrmgrCauseSet;    // An ISR has set pwrmgrCause.
+static uint8 pwrmgrAwakeTask;   // Task charged with the awake time, TASK_NO_TASK until the first dispatch.
+#endif
+
 /*********************************************************************
  * LOCAL FUNCTION PROTOTYPES
  */
 
+#if ( OSAL_PWRMGR_STATS )
+static void pwrmgrTimeAdd( pwrmgrTime_t *pTime, uint32 usec );
+static void pwrmgrCharge( pwrmgrTime_t *pTime, uint8 task );
+static void pwrmgrChargeAwake( void );
+#endif
+
 /*********************************************************************
  * FUNCTIONS
  *********************************************************************/
@@ -101,6 +141,10 @@ void osal_pwrmgr_init( void )
 {
   pwrmgr_attribute.pwrmgr_device = PWRMGR_ALWAYS_ON; // Default to no power conservation.
   pwrmgr_attribute.pwrmgr_task_state = 0;            // Cleared.  All set to conserve
+
+#if ( OSAL_PWRMGR_STATS )
+  osal_pwrmgr_stats_reset();
+#endif
 }
 
 /*********************************************************************
@@ -182,12 +226,243 @@ void osal_pwrmgr_powerconserve( void )
       // Re-enable interrupts.
       HAL_EXIT_CRITICAL_SECTION( intState );
 
+#if ( OSAL_PWRMGR_STATS )
+      // Close the awake period; the HAL reports the mode if it does sleep
+      pwrmgrChargeAwake();
+      pwrmgrMode = PWRMGR_MODE_AWAKE;
+      pwrmgrCause = PWRMGR_WAKE_OTHER;
+      pwrmgrCauseSet = FALSE;
+#endif
+
       // Put the processor into sleep mode
       OSAL_SET_CPU_INTO_SLEEP( next );
+
+#if ( OSAL_PWRMGR_STATS )
+      if ( pwrmgrMode != PWRMGR_MODE_AWAKE )
+      {
+        pwrmgrCharge( &pwrmgrModeTime[pwrmgrMode], TASK_NO_TASK );
+        if ( pwrmgrWakes[pwrmgrCause] != 0xFFFF )
+        {
+          pwrmgrWakes[pwrmgrCause]++;
+        }
+
+        // Charge the coming awake period to the first task dispatched
+        pwrmgrMode = PWRMGR_MODE_AWAKE;
+        pwrmgrAwakeTask = TASK_NO_TASK;
+      }
+#endif
     }
   }
 }
 #endif /* POWER_SAVING */
 
+#if ( OSAL_PWRMGR_STATS )
+/*********************************************************************
+ * @fn      pwrmgrTimeAdd
+ *
+ * @brief   Add microseconds to an accumulated time.
+ *
+ * @param   pTime - time to add to
+ * @param   usec - microseconds to add
+ *
+ * @return  none
+ */
+static void pwrmgrTimeAdd( pwrmgrTime_t *pTime, uint32 usec )
+{
+  usec += pTime->usec;
+  pTime->msec += usec / 1000;
+  pTime->usec = usec % 1000;
+}
+
+/*********************************************************************
+ * @fn      pwrmgrCharge
+ *
+ * @brief   Charge the time since the last accounting to a power mode
+ *          and, for awake time, to a task.
+ *
+ * @param   pTime - time of the power mode
+ * @param   task - task charged, TASK_NO_TASK for sleep time
+ *
+ * @return  none
+ */
+static void pwrmgrCharge( pwrmgrTime_t *pTime, uint8 task )
+{
+  uint32 now = osal_getClockUs();
+  uint32 usec = now - pwrmgrStamp;
+
+  pwrmgrStamp = now;
+  pwrmgrTimeAdd( pTime, usec );
+
+  if ( task != TASK_NO_TASK )
+  {
+    pwrmgrTimeAdd( &pwrmgrTaskTime[task], usec );
+  }
+}
+
+/*********************************************************************
+ * @fn      pwrmgrChargeAwake
+ *
+ * @brief   Charge the awake time since the last accounting, to the
+ *          task dispatched first since the last wakeup if any.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void pwrmgrChargeAwake( void )
+{
+  pwrmgrCharge( &pwrmgrModeTime[PWRMGR_MODE_AWAKE],
+                ( pwrmgrAwakeTask == TASK_NO_TASK ) ? PWRMGR_NO_TASK : pwrmgrAwakeTask );
+}
+
+/*********************************************************************
+ * @fn      osal_pwrmgr_sleep
+ *
+ * @brief   Called by the HAL sleep manager with interrupts disabled
+ *          right before it enters a power mode. A sleep the HAL
+ *          declines is not reported and stays counted as awake time.
+ *
+ * @param   mode - PWRMGR_MODE_TIMER or PWRMGR_MODE_DEEP
+ * @param   cause - PWRMGR_WAKE_ cause expected to end the sleep
+ *
+ * @return  none
+ */
+void osal_pwrmgr_sleep( uint8 mode, uint8 cause )
+{
+  pwrmgrMode = mode;
+  if ( !pwrmgrCauseSet )
+  {
+    pwrmgrCause = cause;
+  }
+}
+
+/*********************************************************************
+ * @fn      osal_pwrmgr_wake
+ *
+ * @brief   Called by an ISR that can end a sleep. The first such ISR
+ *          after the sleep is entered names the wakeup cause; calls
+ *          while awake are ignored.
+ *
+ * @param   cause - PWRMGR_WAKE_ cause
+ *
+ * @return  none
+ */
+void osal_pwrmgr_wake( uint8 cause )
+{
+  if ( (pwrmgrMode != PWRMGR_MODE_AWAKE) && !pwrmgrCauseSet )
+  {
+    pwrmgrCause = cause;
+    pwrmgrCauseSet = TRUE;
+  }
+}
+
+/*********************************************************************
+ * @fn      osal_pwrmgr_dispatch
+ *
+ * @brief   Called by OSAL as it dispatches a task. The first task
+ *          dispatched after a wakeup is charged with the wakeup and
+ *          the awake time until the next sleep.
+ *
+ * @param   task_id - task dispatched
+ * @param   events - events passed to the task
+ *
+ * @return  none
+ */
+void osal_pwrmgr_dispatch( uint8 task_id, uint16 events )
+{
+  if ( pwrmgrAwakeTask == TASK_NO_TASK )
+  {
+    pwrmgrAwakeTask = task_id;
+    if ( pwrmgrTaskWakes[task_id] != 0xFFFF )
+    {
+      pwrmgrTaskWakes[task_id]++;
+    }
+    pwrmgrTaskEvents[task_id] |= events;
+  }
+}
+
+/*********************************************************************
+ * @fn      osal_pwrmgr_stats
+ *
+ * @brief   Take a snapshot of the power mode time and wakeup counts.
+ *          The awake time includes the current awake period.
+ *
+ * @param   pStats - snapshot to fill in
+ *
+ * @return  none
+ */
+void osal_pwrmgr_stats( pwrmgr_stats_t *pStats )
+{
+  uint8 idx;
+
+  pwrmgrChargeAwake();
+
+  for ( idx = 0; idx < PWRMGR_MODE_CNT; idx++ )
+  {
+    pStats->modeMSec[idx] = pwrmgrModeTime[idx].msec;
+  }
+
+  for ( idx = 0; idx < PWRMGR_WAKE_CNT; idx++ )
+  {
+    pStats->wakes[idx] = pwrmgrWakes[idx];
+  }
+}
+
+/*********************************************************************
+ * @fn      osal_pwrmgr_task_stats
+ *
+ * @brief   Take a snapshot of the awake time charged to a task.
+ *
+ * @param   task_id - task ID, or tasksCnt for the time no task was
+ *                    charged with
+ * @param   pStats - snapshot to fill in
+ *
+ * @return  SUCCESS, INVALID_TASK
+ */
+uint8 osal_pwrmgr_task_stats( uint8 task_id, pwrmgr_task_stats_t *pStats )
+{
+  if ( task_id > tasksCnt )
+  {
+    return ( INVALID_TASK );
+  }
+  else if ( task_id == tasksCnt )
+  {
+    task_id = PWRMGR_NO_TASK;
+  }
+
+  pwrmgrChargeAwake();
+
+  pStats->awakeMSec = pwrmgrTaskTime[task_id].msec;
+  pStats->wakes = pwrmgrTaskWakes[task_id];
+  pStats->events = pwrmgrTaskEvents[task_id];
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      osal_pwrmgr_stats_reset
+ *
+ * @brief   Clear all power statistics and start a new awake period
+ *          charged to no task.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osal_pwrmgr_stats_reset( void )
+{
+  osal_memset( pwrmgrModeTime, 0, sizeof( pwrmgrModeTime ) );
+  osal_memset( pwrmgrWakes, 0, sizeof( pwrmgrWakes ) );
+  osal_memset( pwrmgrTaskTime, 0, sizeof( pwrmgrTaskTime ) );
+  osal_memset( pwrmgrTaskWakes, 0, sizeof( pwrmgrTaskWakes ) );
+  osal_memset( pwrmgrTaskEvents, 0, sizeof( pwrmgrTaskEvents ) );
+
+  pwrmgrStamp = osal_getClockUs();
+  pwrmgrMode = PWRMGR_MODE_AWAKE;
+  pwrmgrCauseSet = FALSE;
+  pwrmgrAwakeTask = PWRMGR_NO_TASK;
+}
+#endif /* OSAL_PWRMGR_STATS */
+
 /*********************************************************************
 *********************************************************************/
@@ -51,29 +51,61 @@
  * MACROS
  */
 
+// Slot of a wheel level that an expiry time falls into
+#define TIMER_WHEEL_IDX( expiry, level ) \
+          ( (uint8)( (expiry) >> ( (level) * OSAL_TIMERS_WHEEL_BITS ) ) & OSAL_TIMERS_WHEEL_MASK )
+
+// Index into timerWheel[] of a level and slot
+#define TIMER_WHEEL_SLOT( level, idx )   ( ( (level) << OSAL_TIMERS_WHEEL_BITS ) + (idx) )
+
+// Lookup bucket of a task/event pair
+#define TIMER_HASH( task_id, event_flag ) \
+          ( ( (task_id) ^ LO_UINT16( event_flag ) ^ HI_UINT16( event_flag ) ^ \
+              ( (event_flag) >> 3 ) ) & ( OSAL_TIMERS_HASH_SIZE - 1 ) )
+
 /*********************************************************************
  * CONSTANTS
  */
 
+/* Timers are kept on a hierarchical timing wheel of OSAL_TIMERS_WHEEL_LEVELS
+ * levels with OSAL_TIMERS_WHEEL_SLOTS slots each. A slot at level n spans
+ * 16^n msecs, so four levels cover the whole 16-bit timeout range. A timer is
+ * linked at the highest level whose slot span does not exceed its remaining
+ * time and is cascaded to a lower level when the wheel reaches its slot, so
+ * it is touched at most once per level before it expires.
+ */
+#define OSAL_TIMERS_WHEEL_BITS    4
+#define OSAL_TIMERS_WHEEL_SLOTS   ( 1 << OSAL_TIMERS_WHEEL_BITS )
+#define OSAL_TIMERS_WHEEL_MASK    ( OSAL_TIMERS_WHEEL_SLOTS - 1 )
+#define OSAL_TIMERS_WHEEL_LEVELS  4
+
+// Number of buckets used to look up a timer by task and event (power of 2)
+#if !defined ( OSAL_TIMERS_HASH_SIZE )
+  #define OSAL_TIMERS_HASH_SIZE   8
+#endif
+
 /*********************************************************************
  * TYPEDEFS
  */
 
-typedef struct
+typedef struct osalTimerRec
 {
-  void   *next;
-  uint16 timeout;
+  struct osalTimerRec *next;      // Next timer in the same wheel slot
+  struct osalTimerRec *prev;      // Previous timer in the same wheel slot
+  struct osalTimerRec *hashNext;  // Next timer in the same lookup bucket
+  struct osalTimerRec *slackNext; // Next timer with a slack window
+  uint16 expiry;                  // Expiry time - low 16 bits of the system clock
+  uint16 slack;                   // Msecs before expiry from which the timer may fire early
   uint16 event_flag;
-  uint8  task_id;
   uint16 reloadTimeout;
+  uint8  task_id;
+  uint8  slot;                    // Index into timerWheel[] of the slot holding the timer
 } osalTimerRec_t;
 
 /*********************************************************************
  * GLOBAL VARIABLES
  */
 
-osalTimerRec_t *timerHead;
-
 /*********************************************************************
  * EXTERNAL VARIABLES
  */
@@ -88,13 +120,56 @@ osalTimerRec_t *timerHead;
 // Milliseconds since last reboot
 static uint32 osal_systemClock;
 
+// Time up to which the timing wheel has been processed - low 16 bits of the system clock
+static uint16 timerNow;
+
+// Timing wheel slots and a bitmap of the non-empty slots of each level
+static osalTimerRec_t *timerWheel[OSAL_TIMERS_WHEEL_LEVELS * OSAL_TIMERS_WHEEL_SLOTS];
+static uint16 timerWheelMap[OSAL_TIMERS_WHEEL_LEVELS];
+
+// Active timers hashed by task ID and event
+static osalTimerRec_t *timerHash[OSAL_TIMERS_HASH_SIZE];
+
+// Number of active timers
+static uint16 timerCnt;
+
+// Active timers with a slack window
+static osalTimerRec_t *timerSlackHead;
+
+// Number of slack timers fired early along with another timer
+static uint16 timerWakeupsSaved;
+
+#if OSAL_TIMERS_POOL_CNT
+// Static pool of timer records and its list of free records
+static osalTimerRec_t timerPool[OSAL_TIMERS_POOL_CNT];
+static osalTimerRec_t *timerPoolFree;
+#endif
+
+// Timer records now taken from the pool and the most ever taken at once
+static uint16 timerPoolCnt;
+static uint16 timerPoolMax;
+
+// Timer records requested while the pool was exhausted
+static uint16 timerPoolOverflow;
+
 /*********************************************************************
  * LOCAL FUNCTION PROTOTYPES
  */
-osalTimerRec_t  *osalAddTimer( uint8 task_id, uint16 event_flag, uint16 timeout );
+osalTimerRec_t  *osalAddTimer( uint8 task_id, uint16 event_flag, uint16 timeout, uint16 slack );
 osalTimerRec_t *osalFindTimer( uint8 task_id, uint16 event_flag );
 void osalDeleteTimer( osalTimerRec_t *rmTimer );
 
+static osalTimerRec_t *osalTimerAlloc( void );
+static void   osalTimerFree( osalTimerRec_t *tmr );
+static void   osalTimerLink( osalTimerRec_t *tmr );
+static void   osalTimerUnlink( osalTimerRec_t *tmr );
+static void   osalTimerSlackRemove( osalTimerRec_t *tmr );
+static uint8  osalTimerFirstSlot( uint8 level, uint16 *pTick );
+static uint16 osalTimerNextTick( void );
+static void   osalTimerCascade( uint8 level );
+static uint8  osalTimerExpire( void );
+static void   osalTimerSlackExpire( void );
+
 /*********************************************************************
  * FUNCTIONS
  *********************************************************************/
@@ -111,6 +186,218 @@ void osalDeleteTimer( osalTimerRec_t *rmTimer );
 void osalTimerInit( void )
 {
   osal_systemClock = 0;
+  timerNow = 0;
+  timerCnt = 0;
+  timerSlackHead = NULL;
+  timerWakeupsSaved = 0;
+
+  osal_memset( timerWheel, 0, sizeof( timerWheel ) );
+  osal_memset( timerWheelMap, 0, sizeof( timerWheelMap ) );
+  osal_memset( timerHash, 0, sizeof( timerHash ) );
+
+#if OSAL_TIMERS_POOL_CNT
+  {
+    uint16 idx;
+
+    // Chain all the pool records onto the free list
+    timerPoolFree = NULL;
+    for ( idx = OSAL_TIMERS_POOL_CNT; idx > 0; idx-- )
+    {
+      timerPool[idx-1].next = timerPoolFree;
+      timerPoolFree = &timerPool[idx-1];
+    }
+  }
+#endif
+
+  timerPoolCnt = 0;
+  timerPoolMax = 0;
+  timerPoolOverflow = 0;
+}
+
+/*********************************************************************
+ * @fn      osalTimerAlloc
+ *
+ * @brief   Take a timer record from the static pool. When the pool is
+ *          exhausted the record comes from the heap if
+ *          OSAL_TIMERS_POOL_HEAP_FALLBACK is set.
+ *          Ints must be disabled.
+ *
+ * @param   none
+ *
+ * @return  osalTimerRec_t * - new record, NULL if none is available
+ */
+static osalTimerRec_t *osalTimerAlloc( void )
+{
+  osalTimerRec_t *tmr;
+
+#if OSAL_TIMERS_POOL_CNT
+  tmr = timerPoolFree;
+  if ( tmr )
+  {
+    timerPoolFree = tmr->next;
+
+    if ( ++timerPoolCnt > timerPoolMax )
+    {
+      timerPoolMax = timerPoolCnt;
+    }
+
+    return ( tmr );
+  }
+#endif
+
+  if ( timerPoolOverflow != 0xFFFF )
+  {
+    timerPoolOverflow++;
+  }
+
+#if OSAL_TIMERS_POOL_HEAP_FALLBACK
+  tmr = osal_mem_alloc( sizeof( osalTimerRec_t ) );
+#else
+  tmr = NULL;
+#endif
+
+  return ( tmr );
+}
+
+/*********************************************************************
+ * @fn      osalTimerFree
+ *
+ * @brief   Return a timer record to the static pool, or to the heap if
+ *          it was allocated there.
+ *
+ * @param   tmr - record taken out of the timer tables
+ *
+ * @return  none
+ */
+static void osalTimerFree( osalTimerRec_t *tmr )
+{
+#if OSAL_TIMERS_POOL_CNT
+  if ( tmr >= &timerPool[0] && tmr < &timerPool[OSAL_TIMERS_POOL_CNT] )
+  {
+    halIntState_t intState;
+
+    HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+    tmr->next = timerPoolFree;
+    timerPoolFree = tmr;
+    timerPoolCnt--;
+
+    HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+
+    return;
+  }
+#endif
+
+#if OSAL_TIMERS_POOL_HEAP_FALLBACK
+  osal_mem_free( tmr );
+#endif
+}
+
+/*********************************************************************
+ * @fn      osalTimerLink
+ *
+ * @brief   Link a timer into the wheel slot matching its expiry time.
+ *          Ints must be disabled.
+ *
+ *          The level is chosen so that the slot is never the one the
+ *          wheel is currently processing at that level. A timer due at
+ *          timerNow (only possible while cascading) goes to the current
+ *          level 0 slot, which is expired right after the cascade.
+ *
+ * @param   tmr - timer with a valid expiry
+ *
+ * @return  none
+ */
+static void osalTimerLink( osalTimerRec_t *tmr )
+{
+  uint16 delta = tmr->expiry - timerNow;
+  uint8 level;
+  uint8 idx;
+
+  if ( delta < 0x0010 )
+  {
+    level = 0;
+  }
+  else if ( delta < 0x0100 )
+  {
+    level = 1;
+  }
+  else if ( delta < 0x1000 )
+  {
+    level = 2;
+  }
+  else
+  {
+    level = 3;
+  }
+
+  idx = TIMER_WHEEL_IDX( tmr->expiry, level );
+  tmr->slot = TIMER_WHEEL_SLOT( level, idx );
+
+  tmr->prev = NULL;
+  tmr->next = timerWheel[tmr->slot];
+  if ( tmr->next != NULL )
+  {
+    tmr->next->prev = tmr;
+  }
+  timerWheel[tmr->slot] = tmr;
+
+  timerWheelMap[level] |= ( (uint16)1 << idx );
+}
+
+/*********************************************************************
+ * @fn      osalTimerUnlink
+ *
+ * @brief   Unlink a timer from its wheel slot.
+ *          Ints must be disabled.
+ *
+ * @param   tmr - linked timer
+ *
+ * @return  none
+ */
+static void osalTimerUnlink( osalTimerRec_t *tmr )
+{
+  if ( tmr->prev != NULL )
+  {
+    tmr->prev->next = tmr->next;
+  }
+  else
+  {
+    timerWheel[tmr->slot] = tmr->next;
+  }
+
+  if ( tmr->next != NULL )
+  {
+    tmr->next->prev = tmr->prev;
+  }
+
+  if ( timerWheel[tmr->slot] == NULL )
+  {
+    // Slot is empty now
+    timerWheelMap[tmr->slot >> OSAL_TIMERS_WHEEL_BITS] &=
+      ~( (uint16)1 << (tmr->slot & OSAL_TIMERS_WHEEL_MASK) );
+  }
+}
+
+/*********************************************************************
+ * @fn      osalTimerSlackRemove
+ *
+ * @brief   Take a timer off the list of timers with a slack window.
+ *          Ints must be disabled.
+ *
+ * @param   tmr - timer on the slack list
+ *
+ * @return  none
+ */
+static void osalTimerSlackRemove( osalTimerRec_t *tmr )
+{
+  osalTimerRec_t **ppTimer = &timerSlackHead;
+
+  while ( *ppTimer != tmr )
+  {
+    ppTimer = &(*ppTimer)->slackNext;
+  }
+  *ppTimer = tmr->slackNext;
 }
 
 /*********************************************************************
@@ -119,57 +406,81 @@ void osalTimerInit( void )
  * @brief   Add a timer to the timer list.
  *          Ints must be disabled.
  *
+ *          A timer with slack is placed on the wheel at the end of its
+ *          window, timeout + slack, and may be fired early by
+ *          osalTimerSlackExpire() once timeout has elapsed.
+ *
  * @param   task_id
  * @param   event_flag
  * @param   timeout
+ * @param   slack - msecs the expiry may be delayed to share a wakeup
  *
  * @return  osalTimerRec_t * - pointer to newly created timer
  */
-osalTimerRec_t * osalAddTimer( uint8 task_id, uint16 event_flag, uint16 timeout )
+osalTimerRec_t * osalAddTimer( uint8 task_id, uint16 event_flag, uint16 timeout, uint16 slack )
 {
   osalTimerRec_t *newTimer;
-  osalTimerRec_t *srchTimer;
+
+  // A zero timeout expires on the next tick
+  if ( timeout == 0 )
+  {
+    timeout = 1;
+  }
+
+  // The whole window must fit in the timer range
+  if ( slack > (OSAL_TIMERS_MAX_TIMEOUT - timeout) )
+  {
+    slack = OSAL_TIMERS_MAX_TIMEOUT - timeout;
+  }
 
   // Look for an existing timer first
   newTimer = osalFindTimer( task_id, event_flag );
   if ( newTimer )
   {
-    // Timer is found - update it.
-    newTimer->timeout = timeout;
+    // Timer is found - move it to its new slot.
+    osalTimerUnlink( newTimer );
+    newTimer->expiry = timerNow + timeout + slack;
+    osalTimerLink( newTimer );
+
+    if ( (newTimer->slack == 0) && (slack != 0) )
+    {
+      newTimer->slackNext = timerSlackHead;
+      timerSlackHead = newTimer;
+    }
+    else if ( (newTimer->slack != 0) && (slack == 0) )
+    {
+      osalTimerSlackRemove( newTimer );
+    }
+    newTimer->slack = slack;
 
     return ( newTimer );
   }
   else
   {
     // New Timer
-    newTimer = osal_mem_alloc( sizeof( osalTimerRec_t ) );
+    newTimer = osalTimerAlloc();
 
     if ( newTimer )
     {
+      uint8 bucket = TIMER_HASH( task_id, event_flag );
+
       // Fill in new timer
       newTimer->task_id = task_id;
       newTimer->event_flag = event_flag;
-      newTimer->timeout = timeout;
-      newTimer->next = (void *)NULL;
+      newTimer->expiry = timerNow + timeout + slack;
+      newTimer->slack = slack;
       newTimer->reloadTimeout = 0;
 
-      // Does the timer list already exist
-      if ( timerHead == NULL )
-      {
-        // Start task list
-        timerHead = newTimer;
-      }
-      else
-      {
-        // Add it to the end of the timer list
-        srchTimer = timerHead;
-
-        // Stop at the last record
-        while ( srchTimer->next )
-          srchTimer = srchTimer->next;
+      // Add it to the wheel and to the lookup table
+      osalTimerLink( newTimer );
+      newTimer->hashNext = timerHash[bucket];
+      timerHash[bucket] = newTimer;
+      timerCnt++;
 
-        // Add to the list
-        srchTimer->next = newTimer;
+      if ( slack != 0 )
+      {
+        newTimer->slackNext = timerSlackHead;
+        timerSlackHead = newTimer;
       }
 
       return ( newTimer );
@@ -194,8 +505,8 @@ osalTimerRec_t *osalFindTimer( uint8 task_id, uint16 event_flag )
 {
   osalTimerRec_t *srchTimer;
 
-  // Head of the timer list
-  srchTimer = timerHead;
+  // Head of the lookup bucket
+  srchTimer = timerHash[TIMER_HASH( task_id, event_flag )];
 
   // Stop when found or at the end
   while ( srchTimer )
@@ -205,7 +516,7 @@ osalTimerRec_t *osalFindTimer( uint8 task_id, uint16 event_flag )
       break;
 
     // Not this one, check another
-    srchTimer = srchTimer->next;
+    srchTimer = srchTimer->hashNext;
   }
 
   return ( srchTimer );
@@ -214,21 +525,35 @@ osalTimerRec_t *osalFindTimer( uint8 task_id, uint16 event_flag )
 /*********************************************************************
  * @fn      osalDeleteTimer
  *
- * @brief   Delete a timer from a timer list.
+ * @brief   Take a timer out of the wheel and the lookup table.
+ *          Ints must be disabled. The caller frees the record.
  *
- * @param   table
  * @param   rmTimer
  *
  * @return  none
  */
 void osalDeleteTimer( osalTimerRec_t *rmTimer )
 {
-  // Does the timer list really exist
+  osalTimerRec_t **ppTimer;
+
+  // Does the timer really exist
   if ( rmTimer )
   {
-    // Clear the event flag and osalTimerUpdate() will delete 
-    // the timer from the list.
-    rmTimer->event_flag = 0;
+    osalTimerUnlink( rmTimer );
+
+    ppTimer = &timerHash[TIMER_HASH( rmTimer->task_id, rmTimer->event_flag )];
+    while ( *ppTimer != rmTimer )
+    {
+      ppTimer = &(*ppTimer)->hashNext;
+    }
+    *ppTimer = rmTimer->hashNext;
+
+    if ( rmTimer->slack != 0 )
+    {
+      osalTimerSlackRemove( rmTimer );
+    }
+
+    timerCnt--;
   }
 }
 
@@ -254,7 +579,7 @@ uint8 osal_start_timerEx( uint8 taskID, uint16 event_id, uint16 timeout_value )
   HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
 
   // Add timer
-  newTimer = osalAddTimer( taskID, event_id, timeout_value );
+  newTimer = osalAddTimer( taskID, event_id, timeout_value, 0 );
 
   HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
 
@@ -284,7 +609,86 @@ uint8 osal_start_reload_timer( uint8 taskID, uint16 event_id, uint16 timeout_val
   HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
 
   // Add timer
-  newTimer = osalAddTimer( taskID, event_id, timeout_value );
+  newTimer = osalAddTimer( taskID, event_id, timeout_value, 0 );
+  if ( newTimer )
+  {
+    // Load the reload timeout value
+    newTimer->reloadTimeout = timeout_value;
+  }
+
+  HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+
+  return ( (newTimer != NULL) ? SUCCESS : NO_TIMER_AVAIL );
+}
+
+/*********************************************************************
+ * @fn      osal_start_timerEx_slack
+ *
+ * @brief
+ *
+ *   This function is called to start a timer to expire in n mSecs,
+ *   allowing the expiry to be delayed by up to slack mSecs so that it
+ *   can fire in the same wakeup as another timer. The timer fires at
+ *   the first timer wakeup after timeout_value mSecs, and at the latest
+ *   after timeout_value + slack mSecs. osal_get_timeoutEx() reports the
+ *   time to the end of the window.
+ *
+ * @param   uint8 taskID - task id to set timer for
+ * @param   uint16 event_id - event to be notified with
+ * @param   uint16 timeout_value - in milliseconds.
+ * @param   uint16 slack - in milliseconds.
+ *
+ * @return  SUCCESS, or NO_TIMER_AVAIL.
+ */
+uint8 osal_start_timerEx_slack( uint8 taskID, uint16 event_id, uint16 timeout_value, uint16 slack )
+{
+  halIntState_t intState;
+  osalTimerRec_t *newTimer;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+  // Add timer
+  newTimer = osalAddTimer( taskID, event_id, timeout_value, slack );
+
+  HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+
+  return ( (newTimer != NULL) ? SUCCESS : NO_TIMER_AVAIL );
+}
+
+/*********************************************************************
+ * @fn      osal_start_reload_timer_slack
+ *
+ * @brief
+ *
+ *   This function is called to start a reloading timer whose expiries
+ *   may each be delayed by up to slack mSecs, as for
+ *   osal_start_timerEx_slack(). Reloads keep the original period, so
+ *   firing early or late does not make the timer drift. The slack is
+ *   limited to less than the period.
+ *
+ * @param   uint8 taskID - task id to set timer for
+ * @param   uint16 event_id - event to be notified with
+ * @param   uint16 timeout_value - in milliseconds.
+ * @param   uint16 slack - in milliseconds.
+ *
+ * @return  SUCCESS, or NO_TIMER_AVAIL.
+ */
+uint8 osal_start_reload_timer_slack( uint8 taskID, uint16 event_id, uint16 timeout_value, uint16 slack )
+{
+  halIntState_t intState;
+  osalTimerRec_t *newTimer;
+
+  // The window must close before the next period starts, so that a
+  // reload never falls due in the same wakeup as the expiry before it.
+  if ( slack >= timeout_value )
+  {
+    slack = ( timeout_value != 0 ) ? ( timeout_value - 1 ) : 0;
+  }
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+  // Add timer
+  newTimer = osalAddTimer( taskID, event_id, timeout_value, slack );
   if ( newTimer )
   {
     // Load the reload timeout value
@@ -326,6 +730,11 @@ uint8 osal_stop_timerEx( uint8 task_id, uint16 event_id )
 
   HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
 
+  if ( foundTimer )
+  {
+    osalTimerFree( foundTimer );
+  }
+
   return ( (foundTimer != NULL) ? SUCCESS : INVALID_EVENT_ID );
 }
 
@@ -351,7 +760,7 @@ uint16 osal_get_timeoutEx( uint8 task_id, uint16 event_id )
 
   if ( tmr )
   {
-    rtrn = tmr->timeout;
+    rtrn = tmr->expiry - timerNow;
   }
 
   HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
@@ -366,117 +775,290 @@ uint16 osal_get_timeoutEx( uint8 task_id, uint16 event_id )
  *
  *   This function counts the number of active timers.
  *
- * @return  uint8 - number of timers
+ * @return  uint8 - number of timers, 255 for 255 or more
  */
 uint8 osal_timer_num_active( void )
 {
-  halIntState_t intState;
-  uint8 num_timers = 0;
-  osalTimerRec_t *srchTimer;
-
-  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
-
-  // Head of the timer list
-  srchTimer = timerHead;
+  return ( (timerCnt < 0xFF) ? (uint8)timerCnt : 0xFF );
+}
 
-  // Count timers in the list
-  while ( srchTimer != NULL )
+/*********************************************************************
+ * @fn      osalTimerFirstSlot
+ *
+ * @brief   Find the first occupied slot of a wheel level that the wheel
+ *          will reach after timerNow. Ints must be disabled.
+ *
+ * @param   level - wheel level with at least one occupied slot
+ * @param   pTick - set to the msecs from timerNow to that slot's boundary
+ *
+ * @return  index into timerWheel[] of the slot
+ *********************************************************************/
+static uint8 osalTimerFirstSlot( uint8 level, uint16 *pTick )
+{
+  uint8 shift = level * OSAL_TIMERS_WHEEL_BITS;
+  // First slot boundary of this level after timerNow
+  uint16 base = (timerNow >> shift) + 1;
+  uint8 rot = (uint8)base & OSAL_TIMERS_WHEEL_MASK;
+  uint16 map = timerWheelMap[level];
+  uint8 idx;
+
+  // Rotate the bitmap so that bit 0 is the slot reached first
+  if ( rot )
   {
-    num_timers++;
-    srchTimer = srchTimer->next;
+    map = (uint16)(map >> rot) | (uint16)(map << (OSAL_TIMERS_WHEEL_SLOTS - rot));
   }
+  idx = osal_ffs( map );
 
-  HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+  *pTick = (uint16)((uint16)(base + idx) << shift) - timerNow;
 
-  return num_timers;
+  return ( TIMER_WHEEL_SLOT( level, (idx + rot) & OSAL_TIMERS_WHEEL_MASK ) );
 }
 
 /*********************************************************************
- * @fn      osalTimerUpdate
+ * @fn      osalTimerNextTick
  *
- * @brief   Update the timer structures for a timer tick.
+ * @brief   Find the next wheel tick with work pending - either a level 0
+ *          slot to expire or a higher level slot to cascade.
+ *          Ints must be disabled.
  *
  * @param   none
  *
+ * @return  msecs from timerNow to the tick, zero if there are no timers
+ *********************************************************************/
+static uint16 osalTimerNextTick( void )
+{
+  uint16 next = 0;
+  uint16 tick;
+  uint8 level;
+
+  for ( level = 0; level < OSAL_TIMERS_WHEEL_LEVELS; level++ )
+  {
+    if ( timerWheelMap[level] )
+    {
+      (void)osalTimerFirstSlot( level, &tick );
+
+      if ( (next == 0) || (tick < next) )
+      {
+        next = tick;
+      }
+    }
+  }
+
+  return ( next );
+}
+
+/*********************************************************************
+ * @fn      osalTimerCascade
+ *
+ * @brief   Move the timers of the current slot of a wheel level down to
+ *          lower levels. Interrupts are held off for one timer at a time.
+ *
+ * @param   level - wheel level, 1 or higher
+ *
  * @return  none
  *********************************************************************/
-void osalTimerUpdate( uint16 updateTime )
+static void osalTimerCascade( uint8 level )
 {
   halIntState_t intState;
-  osalTimerRec_t *srchTimer;
-  osalTimerRec_t *prevTimer;
+  osalTimerRec_t *tmr;
+  uint8 slot = TIMER_WHEEL_SLOT( level, TIMER_WHEEL_IDX( timerNow, level ) );
 
-  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
-  // Update the system time
-  osal_systemClock += updateTime;
-  HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+  do
+  {
+    HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
 
-  // Look for open timer slot
-  if ( timerHead != NULL )
+    tmr = timerWheel[slot];
+    if ( tmr )
+    {
+      // Remaining time is now below this level's span
+      osalTimerUnlink( tmr );
+      osalTimerLink( tmr );
+    }
+
+    HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+  } while ( tmr );
+}
+
+/*********************************************************************
+ * @fn      osalTimerExpire
+ *
+ * @brief   Fire all timers due at timerNow. Interrupts are held off for
+ *          one timer at a time.
+ *
+ * @param   none
+ *
+ * @return  TRUE if any timer fired
+ *********************************************************************/
+static uint8 osalTimerExpire( void )
+{
+  halIntState_t intState;
+  osalTimerRec_t *tmr;
+  osalTimerRec_t *freeTimer;
+  uint8 fired = FALSE;
+  uint8 slot = TIMER_WHEEL_SLOT( 0, TIMER_WHEEL_IDX( timerNow, 0 ) );
+
+  do
   {
-    // Add it to the end of the timer list
-    srchTimer = timerHead;
-    prevTimer = (void *)NULL;
+    freeTimer = NULL;
 
-    // Look for open timer slot
-    while ( srchTimer )
+    HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+    tmr = timerWheel[slot];
+    if ( tmr )
     {
-      osalTimerRec_t *freeTimer = NULL;
-     
-      HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
-      
-      if (srchTimer->timeout <= updateTime)
+      // Notify the task of a timeout
+      osal_set_event( tmr->task_id, tmr->event_flag );
+      fired = TRUE;
+
+      if ( tmr->reloadTimeout )
       {
-        srchTimer->timeout = 0;
+        // Reload the timer timeout value
+        osalTimerUnlink( tmr );
+        tmr->expiry += tmr->reloadTimeout;
+        osalTimerLink( tmr );
       }
       else
       {
-        srchTimer->timeout = srchTimer->timeout - updateTime;
+        // Setup to free memory
+        osalDeleteTimer( tmr );
+        freeTimer = tmr;
       }
-      
-      // Check for reloading
-      if ( (srchTimer->timeout == 0) && (srchTimer->reloadTimeout) && (srchTimer->event_flag) )
+    }
+
+    HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+
+    if ( freeTimer )
+    {
+      osalTimerFree( freeTimer );
+    }
+  } while ( tmr );
+
+  return ( fired );
+}
+
+/*********************************************************************
+ * @fn      osalTimerSlackExpire
+ *
+ * @brief   Fire the timers whose slack window has opened, so they share
+ *          the wakeup of a timer that just fired instead of waking the
+ *          system again later. Interrupts are held off for one pass
+ *          over the (short) list of slack timers.
+ *
+ * @param   none
+ *
+ * @return  none
+ *********************************************************************/
+static void osalTimerSlackExpire( void )
+{
+  halIntState_t intState;
+  osalTimerRec_t *tmr;
+  osalTimerRec_t *nextTimer;
+  osalTimerRec_t *freeList = NULL;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+  for ( tmr = timerSlackHead; tmr != NULL; tmr = nextTimer )
+  {
+    nextTimer = tmr->slackNext;
+
+    // Has the window (expiry - slack) to expiry been reached?
+    if ( (uint16)(timerNow - (tmr->expiry - tmr->slack)) <= tmr->slack )
+    {
+      // Notify the task of a timeout
+      osal_set_event( tmr->task_id, tmr->event_flag );
+
+      if ( timerWakeupsSaved != 0xFFFF )
       {
-        // Notify the task of a timeout
-        osal_set_event( srchTimer->task_id, srchTimer->event_flag );
-        
-        // Reload the timer timeout value
-        srchTimer->timeout = srchTimer->reloadTimeout;
+        timerWakeupsSaved++;
       }
-      
-      // When timeout or delete (event_flag == 0)
-      if ( srchTimer->timeout == 0 || srchTimer->event_flag == 0 )
-      {
-        // Take out of list
-        if ( prevTimer == NULL )
-          timerHead = srchTimer->next;
-        else
-          prevTimer->next = srchTimer->next;
 
-        // Setup to free memory
-        freeTimer = srchTimer;
-
-        // Next
-        srchTimer = srchTimer->next;
+      if ( tmr->reloadTimeout )
+      {
+        // Reload the timer timeout value
+        osalTimerUnlink( tmr );
+        tmr->expiry += tmr->reloadTimeout;
+        osalTimerLink( tmr );
       }
       else
       {
-        // Get next
-        prevTimer = srchTimer;
-        srchTimer = srchTimer->next;
+        // Setup to free memory
+        osalDeleteTimer( tmr );
+        tmr->next = freeList;
+        freeList = tmr;
       }
-      
+    }
+  }
+
+  HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+
+  while ( freeList )
+  {
+    tmr = freeList;
+    freeList = tmr->next;
+    osalTimerFree( tmr );
+  }
+}
+
+/*********************************************************************
+ * @fn      osalTimerUpdate
+ *
+ * @brief   Update the timer structures for a timer tick.
+ *
+ *          Only the wheel ticks that have a slot to cascade or expire
+ *          are visited, so the cost is proportional to the number of
+ *          timers that move or fire rather than to the elapsed time or
+ *          to the number of active timers.
+ *
+ * @param   none
+ *
+ * @return  none
+ *********************************************************************/
+void osalTimerUpdate( uint16 updateTime )
+{
+  halIntState_t intState;
+  uint16 tick;
+  uint8 level;
+  uint8 fired = FALSE;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+  // Update the system time
+  osal_systemClock += updateTime;
+  HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+
+  while ( updateTime )
+  {
+    HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+    tick = osalTimerNextTick();
+    if ( (tick == 0) || (tick > updateTime) )
+    {
+      // Nothing else is due within the elapsed time
+      timerNow += updateTime;
+
       HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
-      
-      if ( freeTimer )
+      break;
+    }
+    timerNow += tick;
+    updateTime -= tick;
+
+    HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+
+    // Cascade every level whose slot boundary was reached, then expire.
+    for ( level = 1; level < OSAL_TIMERS_WHEEL_LEVELS; level++ )
+    {
+      if ( TIMER_WHEEL_IDX( timerNow, level - 1 ) != 0 )
       {
-        if ( freeTimer->timeout == 0 )
-        {
-          osal_set_event( freeTimer->task_id, freeTimer->event_flag );
-        }
-        osal_mem_free( freeTimer );
+        break;
       }
+      osalTimerCascade( level );
     }
+    fired |= osalTimerExpire();
+  }
+
+  // The system is awake for a timer anyway - fire the slack timers that may go now.
+  if ( fired && (timerSlackHead != NULL) )
+  {
+    osalTimerSlackExpire();
   }
 }
 
@@ -494,7 +1076,7 @@ void osal_adjust_timers( void )
 {
   uint16 eTime;
 
-  if ( timerHead != NULL )
+  if ( timerCnt != 0 )
   {
     // Compute elapsed time (msec)
     eTime = TimerElapsed() /  TICK_COUNT;
@@ -509,8 +1091,14 @@ void osal_adjust_timers( void )
  *
  * @brief
  *
- *   Search timer table to return the lowest timeout value. If the
- *   timer list is empty, then the returned timeout will be zero.
+ *   Return the lowest timeout value. If there are no timers, then
+ *   the returned timeout will be zero.
+ *
+ *   The first occupied slot of each wheel level holds the earliest
+ *   timers of that level, so only one slot per level is searched
+ *   whatever the number of active timers. Timers with slack sit on
+ *   the wheel at the end of their window, so the sleep lasts until the
+ *   latest point at which one of them has to fire.
  *
  * @param   none
  *
@@ -518,31 +1106,30 @@ void osal_adjust_timers( void )
  *********************************************************************/
 uint16 osal_next_timeout( void )
 {
-  uint16 nextTimeout;
+  uint16 nextTimeout = 0;
+  uint16 tick;
+  uint8 level;
   osalTimerRec_t *srchTimer;
 
-  if ( timerHead != NULL )
+  for ( level = 0; level < OSAL_TIMERS_WHEEL_LEVELS; level++ )
   {
-    // Head of the timer list
-    srchTimer = timerHead;
-    nextTimeout = OSAL_TIMERS_MAX_TIMEOUT;
-
-    // Look for the next timeout timer
-    while ( srchTimer != NULL )
+    if ( timerWheelMap[level] )
     {
-      if (srchTimer->timeout < nextTimeout)
+      srchTimer = timerWheel[osalTimerFirstSlot( level, &tick )];
+
+      // Look for the next timeout timer
+      while ( srchTimer != NULL )
       {
-        nextTimeout = srchTimer->timeout;
+        tick = srchTimer->expiry - timerNow;
+        if ( (nextTimeout == 0) || (tick < nextTimeout) )
+        {
+          nextTimeout = tick;
+        }
+        // Check next timer
+        srchTimer = srchTimer->next;
       }
-      // Check next timer
-      srchTimer = srchTimer->next;
     }
   }
-  else
-  {
-    // No timers
-    nextTimeout = 0;
-  }
 
   return ( nextTimeout );
 }
@@ -562,5 +1149,67 @@ uint32 osal_GetSystemClock( void )
   return ( osal_systemClock );
 }
 
+/*********************************************************************
+ * @fn      osal_timer_pool_cnt
+ *
+ * @brief   Return the number of timer records now taken from the
+ *          static pool.
+ *
+ * @param   none
+ *
+ * @return  Number of pool records in use
+ */
+uint16 osal_timer_pool_cnt( void )
+{
+  return ( timerPoolCnt );
+}
+
+/*********************************************************************
+ * @fn      osal_timer_pool_max
+ *
+ * @brief   Return the maximum number of timer records ever taken from
+ *          the static pool at once.
+ *
+ * @param   none
+ *
+ * @return  High-water mark of pool records in use
+ */
+uint16 osal_timer_pool_max( void )
+{
+  return ( timerPoolMax );
+}
+
+/*********************************************************************
+ * @fn      osal_timer_pool_overflow
+ *
+ * @brief   Return the number of timer records requested while the
+ *          static pool was exhausted, whether or not they were then
+ *          taken from the heap. Saturates at 0xFFFF.
+ *
+ * @param   none
+ *
+ * @return  Pool overflow count
+ */
+uint16 osal_timer_pool_overflow( void )
+{
+  return ( timerPoolOverflow );
+}
+
+/*********************************************************************
+ * @fn      osal_timer_wakeups_saved
+ *
+ * @brief   Return the number of slack timers fired early in the wakeup
+ *          of another timer, each of which would otherwise have needed
+ *          a wakeup of its own. Saturates at 0xFFFF.
+ *
+ * @param   none
+ *
+ * @return  Wakeups saved
+ */
+uint16 osal_timer_wakeups_saved( void )
+{
+  return ( timerWakeupsSaved );
+}
+
 /*********************************************************************
 *********************************************************************/
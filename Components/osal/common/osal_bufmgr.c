@@ -55,6 +55,9 @@
 #define START_PTR( bd_ptr )  ( (bd_ptr) + 1 )
 #define END_PTR( bd_ptr )    ( (uint8 *)START_PTR( bd_ptr ) + (bd_ptr)->payload_len )
 
+// 'pool_ptr' used with this macro must be of the type 'bm_pool_t *'
+#define POOL_END_PTR( pool_ptr )  ( (pool_ptr)->base_ptr + (pool_ptr)->total * (pool_ptr)->slot_len )
+
 /*********************************************************************
  * CONSTANTS
  */
@@ -65,9 +68,39 @@
 typedef struct bm_desc
 {
   struct bm_desc *next_ptr;    // pointer to next buffer descriptor
+  struct bm_desc *prev_ptr;    // pointer to previous buffer descriptor
+  struct bm_desc *self_ptr;    // points to itself while allocated
   uint16          payload_len; // length of user's buffer
 } bm_desc_t;
 
+typedef struct
+{
+  uint8     *base_ptr;  // first buffer of the pool
+  uint16     slot_len;  // distance between two buffers
+  uint16     size;      // payload size of each buffer
+  uint8      total;     // number of buffers
+  uint8      used;      // buffers now allocated
+  uint8      max;       // most buffers ever allocated at once
+  uint16     overflow;  // requests sent to the heap with the pool empty
+  bm_desc_t *free_ptr;  // list of free buffers
+} bm_pool_t;
+
+#if ( OSAL_BM_POOL0_CNT > 0 )
+typedef struct
+{
+  bm_desc_t desc;
+  uint8     payload[OSAL_BM_POOL0_SIZE];
+} bm_slot0_t;
+#endif
+
+#if ( OSAL_BM_POOL1_CNT > 0 )
+typedef struct
+{
+  bm_desc_t desc;
+  uint8     payload[OSAL_BM_POOL1_SIZE];
+} bm_slot1_t;
+#endif
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -79,13 +112,43 @@ typedef struct bm_desc
 /*********************************************************************
  * LOCAL VARIABLES
  */
-// Linked list of allocated buffer descriptors
+// Linked list of allocated heap buffer descriptors; pool buffers are
+// found from their slot and are not on it
 static bm_desc_t *bm_list_ptr = NULL;
 
+#if ( OSAL_BM_POOL0_CNT > 0 )
+static bm_slot0_t bm_pool0_buf[OSAL_BM_POOL0_CNT];
+#endif
+
+#if ( OSAL_BM_POOL1_CNT > 0 )
+static bm_slot1_t bm_pool1_buf[OSAL_BM_POOL1_CNT];
+#endif
+
+// Packet pools, smallest payload size first
+static bm_pool_t bm_pool[OSAL_BM_POOL_MAX] =
+{
+#if ( OSAL_BM_POOL0_CNT > 0 )
+  { (uint8 *)bm_pool0_buf, sizeof( bm_slot0_t ), OSAL_BM_POOL0_SIZE, OSAL_BM_POOL0_CNT, 0, 0, 0, NULL },
+#else
+  { NULL, 0, OSAL_BM_POOL0_SIZE, 0, 0, 0, 0, NULL },
+#endif
+#if ( OSAL_BM_POOL1_CNT > 0 )
+  { (uint8 *)bm_pool1_buf, sizeof( bm_slot1_t ), OSAL_BM_POOL1_SIZE, OSAL_BM_POOL1_CNT, 0, 0, 0, NULL }
+#else
+  { NULL, 0, OSAL_BM_POOL1_SIZE, 0, 0, 0, 0, NULL }
+#endif
+};
+
+// TRUE once the pool free lists have been built
+static uint8 bm_pool_ready = FALSE;
+
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
 static bm_desc_t *bm_desc_from_payload ( uint8 *payload_ptr );
+static uint8 bm_desc_valid( bm_desc_t *bd_ptr );
+static bm_pool_t *bm_pool_of( uint8 *ptr );
+static bm_desc_t *bm_pool_alloc( uint16 size );
 
 /*********************************************************************
  * @fn      osal_bm_alloc
@@ -104,15 +167,34 @@ void *osal_bm_alloc( uint16 size )
 {
   bm_desc_t *bd_ptr;
   
-  bd_ptr = osal_mem_alloc( sizeof( bm_desc_t ) + size );
+  bd_ptr = bm_pool_alloc( size );
+  if ( bd_ptr != NULL )
+  {
+    // pool buffers are found from their slot, not from the list
+    bd_ptr->next_ptr = NULL;
+    bd_ptr->prev_ptr = NULL;
+  }
+  else
+  {
+    bd_ptr = osal_mem_alloc( sizeof( bm_desc_t ) + size );
+    if ( bd_ptr != NULL )
+    {
+      // add item to the beginning of the list
+      bd_ptr->prev_ptr = NULL;
+      bd_ptr->next_ptr = bm_list_ptr;
+      if ( bm_list_ptr != NULL )
+      {
+        bm_list_ptr->prev_ptr = bd_ptr;
+      }
+      bm_list_ptr = bd_ptr;
+    }
+  }
+
   if ( bd_ptr != NULL )
   {
     // set the buffer descriptor info
     bd_ptr->payload_len  = size;
-    
-    // add item to the beginning of the list
-    bd_ptr->next_ptr = bm_list_ptr;
-    bm_list_ptr = bd_ptr;
+    bd_ptr->self_ptr = bd_ptr;
     
     // return start of the buffer
     return ( (void *)START_PTR( bd_ptr ) );
@@ -126,42 +208,51 @@ void *osal_bm_alloc( uint16 size )
  *
  * @brief   Implementation of the de-allocator functionality.
  *
- * @param   payload_ptr - pointer to the memory to free.
+ * @param   payload_ptr - pointer to the memory to free; any pointer
+ *                        returned for the buffer by the adjust functions.
  *
  * @return  none
  */
 void osal_bm_free( void *payload_ptr )
 {
-  bm_desc_t *loop_ptr;
-  bm_desc_t *prev_ptr = NULL;
+  bm_desc_t *bd_ptr;
+  bm_pool_t *pool_ptr;
   
-  loop_ptr = bm_list_ptr;
-  while ( loop_ptr != NULL )
+  bd_ptr = bm_desc_from_payload( (uint8 *)payload_ptr );
+  if ( bd_ptr != NULL )
   {
-    if ( payload_ptr >= (void *)START_PTR( loop_ptr ) &&
-         payload_ptr <= (void *)END_PTR( loop_ptr) )
+    // so that a stale pointer into this buffer is not mistaken for a live one
+    bd_ptr->self_ptr = NULL;
+
+    pool_ptr = bm_pool_of( (uint8 *)bd_ptr );
+    if ( pool_ptr != NULL )
+    {
+      // return the buffer to its pool
+      bd_ptr->next_ptr = pool_ptr->free_ptr;
+      pool_ptr->free_ptr = bd_ptr;
+      pool_ptr->used--;
+    }
+    else
     {
       // unlink item from the linked list
-      if ( prev_ptr == NULL )
+      if ( bd_ptr->prev_ptr == NULL )
       {
         // it's the first item on the list
-        bm_list_ptr = loop_ptr->next_ptr;
+        bm_list_ptr = bd_ptr->next_ptr;
       }
       else
       {
-        prev_ptr->next_ptr = loop_ptr->next_ptr;
+        bd_ptr->prev_ptr->next_ptr = bd_ptr->next_ptr;
       }
 
-      // free the memory
-      osal_mem_free( loop_ptr );
+      if ( bd_ptr->next_ptr != NULL )
+      {
+        bd_ptr->next_ptr->prev_ptr = bd_ptr->prev_ptr;
+      }
 
-      // we're done here
-      break;
+      // free the memory
+      osal_mem_free( bd_ptr );
     }
-    
-    // move on to next item
-    prev_ptr = loop_ptr;
-    loop_ptr = loop_ptr->next_ptr;
   }
 }
 
@@ -170,6 +261,7 @@ void osal_bm_free( void *payload_ptr )
  *
  * @brief   Add or remove header space for the payload pointer. A positive
  *          adjustment adds header space, and negative removes header space.
+ *          The buffer's bytes are left as they are.
  *
  * @param   payload_ptr - pointer to payload
  * @param   size - +/- number of bytes to move (affecting header area)
@@ -218,7 +310,7 @@ void *osal_bm_adjust_tail( void *payload_ptr, int16 size )
   bd_ptr = bm_desc_from_payload( (uint8 *)payload_ptr );
   if ( bd_ptr != NULL )
   {
-    new_payload_ptr = (uint8 *)( (int16)END_PTR( bd_ptr ) - size );
+    new_payload_ptr = END_PTR( bd_ptr ) - size;
     
     // make sure the new payload is within valid range
     if ( new_payload_ptr >= (uint8 *)START_PTR( bd_ptr ) &&
@@ -233,18 +325,89 @@ void *osal_bm_adjust_tail( void *payload_ptr, int16 size )
   return ( payload_ptr );
 }
 
+/*********************************************************************
+ * @fn      osal_bm_pool_stats
+ *
+ * @brief   Get the occupancy of a packet pool.
+ *
+ * @param   pool - pool index, 0 to OSAL_BM_POOL_MAX-1
+ * @param   pStats - pointer to the statistics to fill in
+ *
+ * @return  SUCCESS, or INVALIDPARAMETER for a bad pool index
+ */
+uint8 osal_bm_pool_stats( uint8 pool, osalBmPoolStats_t *pStats )
+{
+  bm_pool_t *pool_ptr;
+
+  if ( pool >= OSAL_BM_POOL_MAX )
+  {
+    return ( INVALIDPARAMETER );
+  }
+
+  pool_ptr = &bm_pool[pool];
+
+  pStats->size = pool_ptr->size;
+  pStats->total = pool_ptr->total;
+  pStats->used = pool_ptr->used;
+  pStats->max = pool_ptr->max;
+  pStats->overflow = pool_ptr->overflow;
+
+  return ( SUCCESS );
+}
+
 /*********************************************************************
  * @fn      bm_desc_from_payload
  *
- * @brief   Find buffer descriptor from payload pointer
+ * @brief   Find buffer descriptor from payload pointer. The descriptor
+ *          stays at the start of its buffer and the payload pointer only
+ *          moves within the buffer. A pointer into a packet pool belongs
+ *          to the slot it falls in, found by its offset into the pool.
+ *          For a heap buffer, the descriptor is found by stepping back
+ *          over the header space to the first address that is preceded
+ *          by a valid descriptor; only a pointer that is more than
+ *          OSAL_BM_HDR_WALK_MAX bytes into its buffer needs the walk of
+ *          the list of heap buffers.
  *
  * @param   payload_ptr - pointer to payload
  *
- * @return  pointer to buffer descriptor
+ * @return  pointer to buffer descriptor, NULL if the pointer is not in
+ *          an allocated buffer
  */
 static bm_desc_t *bm_desc_from_payload ( uint8 *payload_ptr )
 {
   bm_desc_t *loop_ptr;
+  bm_pool_t *pool_ptr;
+  uint8 *start_ptr = payload_ptr;
+  uint16 cnt;
+
+  // A payload pointer is never in front of its own descriptor, so the
+  // slot is counted from the end of the first descriptor; the payload
+  // end of the last slot may be the end of the pool
+  pool_ptr = bm_pool_of( payload_ptr - sizeof( bm_desc_t ) );
+  if ( pool_ptr != NULL )
+  {
+    cnt = (uint16)( payload_ptr - sizeof( bm_desc_t ) - pool_ptr->base_ptr ) / pool_ptr->slot_len;
+    loop_ptr = (bm_desc_t *)( pool_ptr->base_ptr + cnt * pool_ptr->slot_len );
+
+    if ( loop_ptr->self_ptr == loop_ptr && payload_ptr <= END_PTR( loop_ptr ) )
+    {
+      return ( loop_ptr );
+    }
+
+    return ( NULL );
+  }
+
+  for ( cnt = 0; cnt <= OSAL_BM_HDR_WALK_MAX; cnt++ )
+  {
+    loop_ptr = (bm_desc_t *)start_ptr - 1;
+    if ( bm_desc_valid( loop_ptr ) )
+    {
+      // the first descriptor found is the owner, if the pointer is in range
+      return ( ( payload_ptr <= END_PTR( loop_ptr ) ) ? loop_ptr : NULL );
+    }
+
+    start_ptr--;
+  }
 
   loop_ptr = bm_list_ptr;
   while ( loop_ptr != NULL )
@@ -263,6 +426,122 @@ static bm_desc_t *bm_desc_from_payload ( uint8 *payload_ptr )
   return ( loop_ptr );
 }
 
+/*********************************************************************
+ * @fn      bm_desc_valid
+ *
+ * @brief   Check whether a buffer descriptor is on the list of allocated
+ *          heap buffers. The self pointer is tested first, so that the
+ *          links are only followed from a real descriptor.
+ *
+ * @param   bd_ptr - possible buffer descriptor
+ *
+ * @return  TRUE if the descriptor is allocated, FALSE otherwise
+ */
+static uint8 bm_desc_valid( bm_desc_t *bd_ptr )
+{
+  if ( bd_ptr->self_ptr != bd_ptr )
+  {
+    return ( FALSE );
+  }
+
+  if ( bd_ptr->prev_ptr == NULL )
+  {
+    return ( bm_list_ptr == bd_ptr );
+  }
+
+  return ( bd_ptr->prev_ptr->next_ptr == bd_ptr );
+}
+
+/*********************************************************************
+ * @fn      bm_pool_of
+ *
+ * @brief   Find the packet pool an address falls in.
+ *
+ * @param   ptr - address
+ *
+ * @return  the pool, or NULL if the address is not in a pool
+ */
+static bm_pool_t *bm_pool_of( uint8 *ptr )
+{
+  bm_pool_t *pool_ptr;
+
+  for ( pool_ptr = bm_pool; pool_ptr < &bm_pool[OSAL_BM_POOL_MAX]; pool_ptr++ )
+  {
+    if ( pool_ptr->total != 0 &&
+         ptr >= pool_ptr->base_ptr && ptr < POOL_END_PTR( pool_ptr ) )
+    {
+      return ( pool_ptr );
+    }
+  }
+
+  return ( NULL );
+}
+
+/*********************************************************************
+ * @fn      bm_pool_alloc
+ *
+ * @brief   Take a buffer from the smallest packet pool that fits.
+ *
+ * @param   size - payload size needed
+ *
+ * @return  buffer descriptor, or NULL if no pool could serve the request
+ */
+static bm_desc_t *bm_pool_alloc( uint16 size )
+{
+  bm_pool_t *pool_ptr;
+  bm_desc_t *bd_ptr;
+  uint8 idx;
+
+  if ( bm_pool_ready == FALSE )
+  {
+    // Chain all the pool buffers onto the free lists
+    for ( pool_ptr = bm_pool; pool_ptr < &bm_pool[OSAL_BM_POOL_MAX]; pool_ptr++ )
+    {
+      pool_ptr->free_ptr = NULL;
+      for ( idx = pool_ptr->total; idx > 0; idx-- )
+      {
+        bd_ptr = (bm_desc_t *)( pool_ptr->base_ptr + (idx-1) * pool_ptr->slot_len );
+        bd_ptr->self_ptr = NULL;
+        bd_ptr->next_ptr = pool_ptr->free_ptr;
+        pool_ptr->free_ptr = bd_ptr;
+      }
+    }
+
+    bm_pool_ready = TRUE;
+  }
+
+  for ( pool_ptr = bm_pool; pool_ptr < &bm_pool[OSAL_BM_POOL_MAX]; pool_ptr++ )
+  {
+    if ( pool_ptr->total == 0 || size > pool_ptr->size )
+    {
+      continue;
+    }
+
+    bd_ptr = pool_ptr->free_ptr;
+    if ( bd_ptr != NULL )
+    {
+      pool_ptr->free_ptr = bd_ptr->next_ptr;
+
+      if ( ++pool_ptr->used > pool_ptr->max )
+      {
+        pool_ptr->max = pool_ptr->used;
+      }
+
+      return ( bd_ptr );
+    }
+
+    if ( pool_ptr->overflow != 0xFFFF )
+    {
+      pool_ptr->overflow++;
+    }
+
+    // Larger pools are kept for larger packets
+    break;
+  }
+
+  return ( NULL );
+}
+
 
 /****************************************************************************
 ****************************************************************************/
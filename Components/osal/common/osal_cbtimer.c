@@ -49,26 +49,17 @@
 /*********************************************************************
  * MACROS
  */
-// Macros to convert one-dimensional index 'timer id' to two-dimensional indices
-// 'task id' and 'event id'.
-
-// Find out event id using timer id
-#define EVENT_ID( timerId )            ( 0x0001 << ( ( timerId ) % NUM_CBTIMERS_PER_TASK ) )
-
-// Find out task id using timer id
-#define TASK_ID( timerId )             ( ( ( timerId ) / NUM_CBTIMERS_PER_TASK ) + baseTaskID )
-
-// Find out bank task id using task id
-#define BANK_TASK_ID( taskId )         ( ( baseTaskID - ( taskId ) ) * NUM_CBTIMERS )
+// Wrap-safe check of whether system clock value 'a' is at or before 'b'
+#define CBTIMER_NOT_AFTER( a, b )      ( (int32)( (a) - (b) ) <= 0 )
 
 /*********************************************************************
  * CONSTANTS
  */
-// Number of callback timers supported per task (limited by the number of OSAL event timers)
-#define NUM_CBTIMERS_PER_TASK          15
+// OSAL event of the base task that fires when the first timer expires
+#define CBTIMER_EXPIRE_EVT             0x0001
 
-// Total number of callback timers
-#define NUM_CBTIMERS                   ( OSAL_CBTIMER_NUM_TASKS * NUM_CBTIMERS_PER_TASK )
+// End of a timer list
+#define CBTIMER_NONE                   0xFF
 
 /*********************************************************************
  * TYPEDEFS
@@ -78,6 +69,10 @@ typedef struct
 {
   pfnCbTimer_t pfnCbTimer; // callback function to be called when timer expires
   uint8 *pData;            // data to be passed in to callback function
+  uint32 expire;           // system clock at which the timer expires
+  uint8 next;              // next timer on the active or free list
+  uint8 prev;              // previous timer on the active list
+  uint8 due;               // TRUE once taken into the current dispatch pass
 } cbTimer_t;
 
 /*********************************************************************
@@ -98,13 +93,19 @@ uint16 baseTaskID = TASK_NO_TASK;
  * LOCAL VARIABLES
  */
 // Callback Timers table.
-#if ( NUM_CBTIMERS > 0 )
-  cbTimer_t cbTimers[NUM_CBTIMERS];
-#endif
+cbTimer_t cbTimers[OSAL_CBTIMER_NUM_TIMERS];
+
+// Running timers, first to expire first, and the list of free timers
+static uint8 cbTimerHead;
+static uint8 cbTimerTail;
+static uint8 cbTimerFree;
 
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
+static void cbTimerLink( uint8 timerId );
+static void cbTimerUnlink( uint8 timerId );
+static void cbTimerArm( void );
 
 /*********************************************************************
  * API FUNCTIONS
@@ -115,6 +116,7 @@ uint16 baseTaskID = TASK_NO_TASK;
  *
  * @brief       Callback Timer task initialization function. This function
  *              can be called more than once (OSAL_CBTIMER_NUM_TASKS times).
+ *              All timers run on the first task.
  *
  * @param       taskId - Message Timer task ID.
  *
@@ -124,18 +126,34 @@ void osal_CbTimerInit( uint8 taskId )
 {
   if ( baseTaskID == TASK_NO_TASK )
   {
+    uint8 i;
+
     // Only initialize the base task id
     baseTaskID = taskId;
 
     // Initialize all timer structures
     osal_memset( cbTimers, 0, sizeof( cbTimers ) );
+
+    // Chain all the timers onto the free list
+    for ( i = 0; i < OSAL_CBTIMER_NUM_TIMERS; i++ )
+    {
+      cbTimers[i].next = i + 1;
+    }
+    cbTimers[OSAL_CBTIMER_NUM_TIMERS-1].next = CBTIMER_NONE;
+
+    cbTimerFree = 0;
+    cbTimerHead = CBTIMER_NONE;
+    cbTimerTail = CBTIMER_NONE;
   }
 }
 
 /*********************************************************************
  * @fn          osal_CbTimerProcessEvent
  *
- * @brief       Callback Timer task event processing function.
+ * @brief       Callback Timer task event processing function. Every timer
+ *              due at the time of the event is dispatched in one pass.
+ *              Timers started by the callbacks wait for the next event,
+ *              even with a timeout of 0.
  *
  * @param       taskId - task ID.
  * @param       events - events.
@@ -144,6 +162,8 @@ void osal_CbTimerInit( uint8 taskId )
  */
 uint16 osal_CbTimerProcessEvent( uint8 taskId, uint16 events )
 {
+  (void)taskId;  // Intentionally unreferenced parameter
+
   if ( events & SYS_EVENT_MSG )
   {
     // Process OSAL messages
@@ -152,37 +172,54 @@ uint16 osal_CbTimerProcessEvent( uint8 taskId, uint16 events )
     return ( events ^ SYS_EVENT_MSG );
   }
 
-  if ( events )
+  if ( events & CBTIMER_EXPIRE_EVT )
   {
+    uint32 now = osal_GetSystemClock();
     uint8 i;
-    uint16 event;
 
-    // Process event timers
-    for ( i = 0; i < NUM_CBTIMERS_PER_TASK; i++ )
+    // Take every expired timer into this pass
+    for ( i = cbTimerHead; i != CBTIMER_NONE; i = cbTimers[i].next )
     {
-      if ( ( events >> i ) & 0x0001 )
+      if ( !CBTIMER_NOT_AFTER( cbTimers[i].expire, now ) )
       {
-        cbTimer_t *pTimer = &cbTimers[BANK_TASK_ID( taskId )+i];
+        break;
+      }
 
-        // Found the first event
-        event =  0x0001 << i;
+      cbTimers[i].due = TRUE;
+    }
 
-        // Timer expired, call the registered callback function
-        pTimer->pfnCbTimer( pTimer->pData );
+    // Timers started meanwhile are linked behind the due ones, and a due
+    // timer stopped by an earlier callback has left the list
+    while ( (cbTimerHead != CBTIMER_NONE) && (cbTimers[cbTimerHead].due == TRUE) )
+    {
+      cbTimer_t *pTimer;
+      pfnCbTimer_t pfnCbTimer;
+      uint8 *pData;
+
+      i = cbTimerHead;
+      pTimer = &cbTimers[i];
+      pfnCbTimer = pTimer->pfnCbTimer;
+      pData = pTimer->pData;
 
-        // Mark entry as free
-        pTimer->pfnCbTimer = NULL;
+      cbTimerUnlink( i );
+
+      // Mark entry as free
+      pTimer->pfnCbTimer = NULL;
         
-        // Null out data pointer
-        pTimer->pData = NULL;
-      
-        // We only process one event at a time
-        break;
-      }
+      // Null out data pointer
+      pTimer->pData = NULL;
+
+      pTimer->next = cbTimerFree;
+      cbTimerFree = i;
+
+      // Timer expired, call the registered callback function
+      pfnCbTimer( pData );
     }
 
+    cbTimerArm();
+
     // return unprocessed events
-    return ( events ^ event );
+    return ( events ^ CBTIMER_EXPIRE_EVT );
   }
 
   // If reach here, the events are unknown
@@ -215,31 +252,34 @@ Status_t osal_CbTimerStart( pfnCbTimer_t pfnCbTimer, uint8 *pData,
     return ( INVALIDPARAMETER );
   }
 
-  // Look for an unused timer first
-  for ( i = 0; i < NUM_CBTIMERS; i++ )
+  // Take a timer from the free list
+  i = cbTimerFree;
+  if ( i == CBTIMER_NONE )
   {
-    if ( cbTimers[i].pfnCbTimer == NULL )
-    {
-      // Start the OSAL event timer first
-      if ( osal_start_timerEx( TASK_ID( i ), EVENT_ID( i ), timeout ) == SUCCESS )
-      {
-        // Set up the callback timer
-        cbTimers[i].pfnCbTimer = pfnCbTimer;
-        cbTimers[i].pData = pData;
+    // No timer available
+    return ( NO_TIMER_AVAIL );
+  }
+  cbTimerFree = cbTimers[i].next;
 
-        if ( pTimerId != NULL )
-        {
-          // Caller is intreseted in the timer id
-          *pTimerId = i;
-        }
+  // Set up the callback timer
+  cbTimers[i].pfnCbTimer = pfnCbTimer;
+  cbTimers[i].pData = pData;
+  cbTimers[i].expire = osal_GetSystemClock() + timeout;
 
-        return ( SUCCESS );
-      }
-    }
+  cbTimerLink( i );
+
+  if ( cbTimerHead == i )
+  {
+    cbTimerArm();
+  }
+
+  if ( pTimerId != NULL )
+  {
+    // Caller is intreseted in the timer id
+    *pTimerId = i;
   }
 
-  // No timer available
-  return ( NO_TIMER_AVAIL );
+  return ( SUCCESS );
 }
 
 /*********************************************************************
@@ -258,18 +298,24 @@ Status_t osal_CbTimerStart( pfnCbTimer_t pfnCbTimer, uint8 *pData,
 Status_t osal_CbTimerUpdate( uint8 timerId, uint16 timeout )
 {
   // Look for the existing timer
-  if ( timerId < NUM_CBTIMERS )
+  if ( timerId < OSAL_CBTIMER_NUM_TIMERS )
   {
-    if ( cbTimers[timerId].pfnCbTimer != NULL )
+    // A timer already taken into a dispatch pass is about to fire
+    if ( (cbTimers[timerId].pfnCbTimer != NULL) && (cbTimers[timerId].due == FALSE) )
     {
-      // Make sure the corresponding OSAL event timer is still running
-      if ( osal_get_timeoutEx( TASK_ID( timerId ), EVENT_ID( timerId ) ) != 0 )
-      {
-        // Timer exists; update it
-        osal_start_timerEx( TASK_ID( timerId ), EVENT_ID( timerId ), timeout );
+      uint8 head = cbTimerHead;
+
+      // Timer exists; update it
+      cbTimerUnlink( timerId );
+      cbTimers[timerId].expire = osal_GetSystemClock() + timeout;
+      cbTimerLink( timerId );
 
-        return (  SUCCESS );
+      if ( (cbTimerHead != head) || (cbTimerHead == timerId) )
+      {
+        cbTimerArm();
       }
+
+      return (  SUCCESS );
     }
   }
 
@@ -292,12 +338,14 @@ Status_t osal_CbTimerUpdate( uint8 timerId, uint16 timeout )
 Status_t osal_CbTimerStop( uint8 timerId )
 {
   // Look for the existing timer
-  if ( timerId < NUM_CBTIMERS )
+  if ( timerId < OSAL_CBTIMER_NUM_TIMERS )
   {
     if ( cbTimers[timerId].pfnCbTimer != NULL )
     {
-      // Timer exists; stop the OSAL event timer first
-      osal_stop_timerEx( TASK_ID( timerId ), EVENT_ID( timerId ) );
+      uint8 head = cbTimerHead;
+
+      // Timer exists; take it off the running list
+      cbTimerUnlink( timerId );
 
       // Mark entry as free
       cbTimers[timerId].pfnCbTimer = NULL;
@@ -305,6 +353,14 @@ Status_t osal_CbTimerStop( uint8 timerId )
       // Null out data pointer
       cbTimers[timerId].pData = NULL;
 
+      cbTimers[timerId].next = cbTimerFree;
+      cbTimerFree = timerId;
+
+      if ( head == timerId )
+      {
+        cbTimerArm();
+      }
+
       return ( SUCCESS );
     }
   }
@@ -313,5 +369,120 @@ Status_t osal_CbTimerStop( uint8 timerId )
   return ( INVALIDPARAMETER );
 }
 
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      cbTimerLink
+ *
+ * @brief   Link a timer into the running list, behind the timers that
+ *          expire at or before it. The search starts from the tail, where
+ *          a timer started with the same timeout as earlier ones belongs.
+ *
+ * @param   timerId - timer to link
+ *
+ * @return  none
+ */
+static void cbTimerLink( uint8 timerId )
+{
+  cbTimer_t *pTimer = &cbTimers[timerId];
+  uint8 prev = cbTimerTail;
+
+  while ( (prev != CBTIMER_NONE) && !CBTIMER_NOT_AFTER( cbTimers[prev].expire, pTimer->expire ) )
+  {
+    prev = cbTimers[prev].prev;
+  }
+
+  pTimer->due = FALSE;
+  pTimer->prev = prev;
+
+  if ( prev == CBTIMER_NONE )
+  {
+    pTimer->next = cbTimerHead;
+    cbTimerHead = timerId;
+  }
+  else
+  {
+    pTimer->next = cbTimers[prev].next;
+    cbTimers[prev].next = timerId;
+  }
+
+  if ( pTimer->next == CBTIMER_NONE )
+  {
+    cbTimerTail = timerId;
+  }
+  else
+  {
+    cbTimers[pTimer->next].prev = timerId;
+  }
+}
+
+/*********************************************************************
+ * @fn      cbTimerUnlink
+ *
+ * @brief   Take a timer off the running list.
+ *
+ * @param   timerId - timer to unlink
+ *
+ * @return  none
+ */
+static void cbTimerUnlink( uint8 timerId )
+{
+  cbTimer_t *pTimer = &cbTimers[timerId];
+
+  if ( pTimer->prev == CBTIMER_NONE )
+  {
+    cbTimerHead = pTimer->next;
+  }
+  else
+  {
+    cbTimers[pTimer->prev].next = pTimer->next;
+  }
+
+  if ( pTimer->next == CBTIMER_NONE )
+  {
+    cbTimerTail = pTimer->prev;
+  }
+  else
+  {
+    cbTimers[pTimer->next].prev = pTimer->prev;
+  }
+
+  pTimer->due = FALSE;
+}
+
+/*********************************************************************
+ * @fn      cbTimerArm
+ *
+ * @brief   Set the OSAL event timer of the base task to the expiry of the
+ *          first running timer.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void cbTimerArm( void )
+{
+  if ( cbTimerHead == CBTIMER_NONE )
+  {
+    VOID osal_stop_timerEx( baseTaskID, CBTIMER_EXPIRE_EVT );
+  }
+  else
+  {
+    int32 delta = (int32)( cbTimers[cbTimerHead].expire - osal_GetSystemClock() );
+
+    if ( delta <= 0 )
+    {
+      VOID osal_stop_timerEx( baseTaskID, CBTIMER_EXPIRE_EVT );
+      VOID osal_set_event( baseTaskID, CBTIMER_EXPIRE_EVT );
+    }
+    else
+    {
+      VOID osal_start_timerEx( baseTaskID, CBTIMER_EXPIRE_EVT, (uint16)delta );
+    }
+  }
+}
+
 /****************************************************************************
 ****************************************************************************/
@@ -83,6 +83,24 @@ extern "C"
 /*** Interrupts ***/
 #define INTS_ALL    0xFF
 
+/*** Scheduler Trace ***/
+
+// Record each task dispatch of osal_run_system() into a RAM ring buffer.
+#if !defined ( OSAL_RUN_TRACE )
+  #define OSAL_RUN_TRACE  FALSE
+#endif
+
+#if ( OSAL_RUN_TRACE )
+// Size in bytes of a trace record as copied out by osal_run_trace_read().
+#define OSAL_RUN_TRACE_RECSZ  9
+#endif
+
+// Keep event processor time statistics per task and check each run
+// against a per-task budget.
+#if !defined ( OSAL_RUN_STATS )
+  #define OSAL_RUN_STATS  FALSE
+#endif
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -101,6 +119,17 @@ typedef struct
 
 typedef void * osal_msg_q_t;
 
+// Event processor time statistics of a task, in OSAL_RUN_CLOCK() ticks
+typedef struct
+{
+  uint16 runs;       // Runs counted
+  uint16 avg;        // Average run
+  uint16 max;        // Longest run
+  uint16 maxEvents;  // Events passed to the longest run
+  uint16 overruns;   // Runs over the budget
+  uint16 budget;     // Time allowed per run, 0 for no limit
+} osalRunStats_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -141,6 +170,16 @@ typedef void * osal_msg_q_t;
    */
   extern osal_event_hdr_t *osal_msg_find(uint8 task_id, uint8 event);
 
+  /*
+   * Count the Task Messages waiting for a task
+   */
+  extern uint16 osal_msg_queue_depth( uint8 task_id );
+
+  /*
+   * Most Task Messages ever waiting for a task at once
+   */
+  extern uint16 osal_msg_queue_max( uint8 task_id );
+
   /*
    * Enqueue a Task Message
    */
@@ -180,6 +219,52 @@ typedef void * osal_msg_q_t;
    */
   extern uint8 osal_clear_event( uint8 task_id, uint16 event_flag );
 
+#if ( OSAL_RUN_TRACE )
+  /*
+   * Start or stop recording task dispatches
+   */
+  extern void osal_run_trace_enable( uint8 enable );
+
+  /*
+   * Copy out and remove the oldest scheduler trace records
+   */
+  extern uint8 osal_run_trace_read( uint8 *pBuf, uint8 maxCnt );
+
+  /*
+   * Number of scheduler trace records lost before they were read
+   */
+  extern uint16 osal_run_trace_dropped( void );
+#endif
+
+  /*
+   * Post a continuation event to the active task
+   */
+  extern uint8 osal_run_continue( uint16 event_flag );
+
+#if ( OSAL_RUN_STATS )
+  /*
+   * Has the active task used up its budget?
+   */
+  extern uint8 osal_run_expired( void );
+
+  /*
+   * Set the time a task's event processor may run per call
+   */
+  extern uint8 osal_run_budget( uint8 task_id, uint16 budget );
+
+  /*
+   * Read the event processor time statistics of a task
+   */
+  extern uint8 osal_run_stats( uint8 task_id, osalRunStats_t *pStats );
+
+  /*
+   * Clear the event processor time statistics of a task
+   */
+  extern uint8 osal_run_stats_reset( uint8 task_id );
+#else
+  #define osal_run_expired()  FALSE
+#endif
+
 
 /*** Interrupt Management  ***/
 
@@ -238,6 +323,16 @@ typedef void * osal_msg_q_t;
    */
   extern void *osal_memcpy( void*, const void GENERIC *, unsigned int );
 
+  /*
+   * Memory copy from xdata to xdata
+   */
+  extern void *osal_memcpy_xx( void XDATA *dst, const void XDATA *src, unsigned int len );
+
+  /*
+   * Memory copy from a constant table in code memory to xdata
+   */
+  extern void *osal_memcpy_cx( void XDATA *dst, const void CODE *src, unsigned int len );
+
   /*
    * Memory Duplicate - allocates and copies
    */
@@ -295,6 +390,11 @@ typedef void * osal_msg_q_t;
    */
   extern uint8 osal_isbufset( uint8 *buf, uint8 val, uint8 len );
 
+  /*
+   * Find the lowest set bit of a bitmap.
+   */
+  extern uint8 osal_ffs( uint16 map );
+
 /*********************************************************************
 *********************************************************************/
 
@@ -107,6 +107,12 @@ typedef struct
    */
   extern UTCTime osal_getClock( void );
 
+  /*
+   * Gets a monotonic timestamp in microseconds since power-up.
+   * Wraps after about 71.6 minutes; compare timestamps by their difference.
+   */
+  extern uint32 osal_getClockUs( void );
+
   /*
    * Converts UTCTime to UTCTimeStruct
    *
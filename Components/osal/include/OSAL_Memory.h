@@ -58,6 +58,21 @@ extern "C"
   #define OSALMEM_METRICS  FALSE
 #endif
 
+// Record heap allocations and frees into a RAM ring buffer at run time.
+#if !defined ( OSALMEM_TRACE )
+  #define OSALMEM_TRACE  FALSE
+#endif
+
+#if ( OSALMEM_TRACE )
+// Event type, held in the two MSBs of the line number of a trace record.
+#define OSALMEM_TRACE_ALLOC  0x0000
+#define OSALMEM_TRACE_FREE   0x4000
+#define OSALMEM_TRACE_FAIL   0x8000
+
+// Size in bytes of a trace record as copied out by osal_mem_trace_read().
+#define OSALMEM_TRACE_RECSZ  8
+#endif
+
 /*********************************************************************
  * MACROS
  */
@@ -92,6 +107,9 @@ extern "C"
 #ifdef DPRINTF_OSALHEAPTRACE
   void *osal_mem_alloc_dbg( uint16 size, const char *fname, unsigned lnum );
 #define osal_mem_alloc(_size ) osal_mem_alloc_dbg(_size, __FILE__, __LINE__)
+#elif ( OSALMEM_TRACE )
+  void *osal_mem_alloc_trc( uint16 size, const char *fname, uint16 lnum );
+#define osal_mem_alloc(_size ) osal_mem_alloc_trc(_size, __FILE__, __LINE__)
 #else /* DPRINTF_OSALHEAPTRACE */
   void *osal_mem_alloc( uint16 size );
 #endif /* DPRINTF_OSALHEAPTRACE */
@@ -102,6 +120,9 @@ extern "C"
 #ifdef DPRINTF_OSALHEAPTRACE
   void osal_mem_free_dbg( void *ptr, const char *fname, unsigned lnum );
 #define osal_mem_free(_ptr ) osal_mem_free_dbg(_ptr, __FILE__, __LINE__)
+#elif ( OSALMEM_TRACE )
+  void osal_mem_free_trc( void *ptr, const char *fname, uint16 lnum );
+#define osal_mem_free(_ptr ) osal_mem_free_trc(_ptr, __FILE__, __LINE__)
 #else /* DPRINTF_OSALHEAPTRACE */
   void osal_mem_free( void *ptr );
 #endif /* DPRINTF_OSALHEAPTRACE */
@@ -128,6 +149,28 @@ extern "C"
   uint16 osal_heap_mem_used( void );
 #endif
 
+#if ( OSALMEM_TRACE )
+ /*
+  * Start or stop recording heap allocations and frees.
+  */
+  void osal_mem_trace_enable( uint8 enable );
+
+ /*
+  * Copy out and remove the oldest heap trace records.
+  */
+  uint8 osal_mem_trace_read( uint8 *pBuf, uint8 maxCnt );
+
+ /*
+  * Return the number of heap trace records lost to a full ring buffer.
+  */
+  uint16 osal_mem_trace_dropped( void );
+
+ /*
+  * Return the heap fragmentation index along with the free and largest free bytes.
+  */
+  uint8 osal_heap_frag( uint16 *pFree, uint16 *pLargest );
+#endif
+
 #if defined (ZTOOL_P1) || defined (ZTOOL_P2)
  /*
   * Return the highest number of bytes ever used in the heap.
@@ -53,6 +53,16 @@ extern "C"
  * MACROS
  */
 
+// Account awake time to the task that caused each wakeup, time to each
+// power mode and wakeups to their cause.
+#if !defined ( OSAL_PWRMGR_STATS )
+  #define OSAL_PWRMGR_STATS  FALSE
+#endif
+
+#if ( OSAL_PWRMGR_STATS ) && !defined ( POWER_SAVING )
+  #error OSAL_PWRMGR_STATS requires POWER_SAVING!
+#endif
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -81,6 +91,45 @@ typedef struct
 #define PWRMGR_CONSERVE 0
 #define PWRMGR_HOLD     1
 
+/* Power modes reported by the HAL through osal_pwrmgr_sleep(). The time
+ * between sleeps, including sleeps the HAL declines, counts as awake.
+ */
+#define PWRMGR_MODE_AWAKE  0
+#define PWRMGR_MODE_TIMER  1  // Sleep the sleep timer ends (PM2 on the CC2540)
+#define PWRMGR_MODE_DEEP   2  // Sleep only I/O ends (PM3 on the CC2540)
+#define PWRMGR_MODE_CNT    3
+
+/* Wakeup causes. The HAL names the cause expected when it enters sleep
+ * (timer, radio or other) and an ISR that ends the sleep first may
+ * replace it through osal_pwrmgr_wake().
+ */
+#define PWRMGR_WAKE_TIMER  0  // OSAL timer
+#define PWRMGR_WAKE_RADIO  1  // Next LL radio event
+#define PWRMGR_WAKE_KEY    2  // Key interrupt
+#define PWRMGR_WAKE_UART   3  // UART activity on a wakeup pin
+#define PWRMGR_WAKE_OTHER  4
+#define PWRMGR_WAKE_CNT    5
+
+#if ( OSAL_PWRMGR_STATS )
+/* Power mode time and wakeup counts since the last reset.
+ */
+typedef struct
+{
+  uint32 modeMSec[PWRMGR_MODE_CNT];  // Milliseconds spent in each power mode
+  uint16 wakes[PWRMGR_WAKE_CNT];     // Wakeups by cause
+} pwrmgr_stats_t;
+
+/* Awake time of a task since the last reset. A task is charged from the
+ * wakeup that first dispatched it until the next sleep.
+ */
+typedef struct
+{
+  uint32 awakeMSec;  // Milliseconds awake charged to the task
+  uint16 wakes;      // Wakeups that first dispatched the task
+  uint16 events;     // Events that woke the task, OR'd together
+} pwrmgr_task_stats_t;
+#endif
+
 
 /*********************************************************************
  * GLOBAL VARIABLES
@@ -129,6 +178,40 @@ extern pwrmgr_attribute_t pwrmgr_attribute;
    */
   extern void osal_pwrmgr_powerconserve( void );
 
+#if ( OSAL_PWRMGR_STATS )
+  /*
+   * Called by the HAL sleep manager right before it enters a power mode,
+   * with the cause expected to end it.
+   */
+  extern void osal_pwrmgr_sleep( uint8 mode, uint8 cause );
+
+  /*
+   * Called by an ISR that can end a sleep, with its wakeup cause.
+   */
+  extern void osal_pwrmgr_wake( uint8 cause );
+
+  /*
+   * Called by OSAL as it dispatches a task, to charge the wakeup to it.
+   */
+  extern void osal_pwrmgr_dispatch( uint8 task_id, uint16 events );
+
+  /*
+   * Snapshot of the power mode time and wakeup counts.
+   */
+  extern void osal_pwrmgr_stats( pwrmgr_stats_t *pStats );
+
+  /*
+   * Snapshot of the awake time charged to a task; task_id equal to
+   * tasksCnt reads the time no task was charged with.
+   */
+  extern uint8 osal_pwrmgr_task_stats( uint8 task_id, pwrmgr_task_stats_t *pStats );
+
+  /*
+   * Clear all power statistics.
+   */
+  extern void osal_pwrmgr_stats_reset( void );
+#endif
+
 /*********************************************************************
 *********************************************************************/
 
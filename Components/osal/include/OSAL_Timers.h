@@ -58,6 +58,17 @@ extern "C"
  */
 #define OSAL_TIMERS_MAX_TIMEOUT 0xFFFF
 
+// Number of timer records preallocated in the static timer pool (0 to 65535)
+#if !defined ( OSAL_TIMERS_POOL_CNT )
+  #define OSAL_TIMERS_POOL_CNT  12
+#endif
+
+// Allocate timer records from the heap once the static pool is exhausted.
+// When FALSE, starting a timer with the pool exhausted fails with NO_TIMER_AVAIL.
+#if !defined ( OSAL_TIMERS_POOL_HEAP_FALLBACK )
+  #define OSAL_TIMERS_POOL_HEAP_FALLBACK  TRUE
+#endif
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -85,6 +96,16 @@ extern "C"
    */
   extern uint8 osal_start_reload_timer( uint8 taskID, uint16 event_id, uint16 timeout_value );
 
+  /*
+   * Set a Timer whose expiry may be delayed to share a wakeup.
+   */
+  extern uint8 osal_start_timerEx_slack( uint8 task_id, uint16 event_id, uint16 timeout_value, uint16 slack );
+
+  /*
+   * Set a timer that reloads itself and whose expiries may be delayed to share a wakeup.
+   */
+  extern uint8 osal_start_reload_timer_slack( uint8 taskID, uint16 event_id, uint16 timeout_value, uint16 slack );
+
   /*
    * Stop a Timer
    */
@@ -134,6 +155,26 @@ extern "C"
    */
   extern uint16 osal_next_timeout( void );
 
+  /*
+   * Return the number of timer records now taken from the static pool.
+   */
+  extern uint16 osal_timer_pool_cnt( void );
+
+  /*
+   * Return the maximum number of timer records ever taken from the static pool.
+   */
+  extern uint16 osal_timer_pool_max( void );
+
+  /*
+   * Return the number of timer records requested while the static pool was exhausted.
+   */
+  extern uint16 osal_timer_pool_overflow( void );
+
+  /*
+   * Return the number of wakeups saved by firing slack timers early.
+   */
+  extern uint16 osal_timer_wakeups_saved( void );
+
 /*********************************************************************
 *********************************************************************/
 
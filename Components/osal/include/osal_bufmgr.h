@@ -53,6 +53,38 @@ extern "C"
  * CONSTANTS
  */
 
+// Fixed-size packet pools, served ahead of the heap. A request goes to the
+// smallest pool whose payload size fits it, and to the heap once that pool
+// is exhausted. A pool with a buffer count of 0 is left out.
+#if !defined ( OSAL_BM_POOL0_SIZE )
+  #define OSAL_BM_POOL0_SIZE  27
+#endif
+
+#if !defined ( OSAL_BM_POOL0_CNT )
+  #define OSAL_BM_POOL0_CNT   0
+#endif
+
+#if !defined ( OSAL_BM_POOL1_SIZE )
+  #define OSAL_BM_POOL1_SIZE  64
+#endif
+
+#if !defined ( OSAL_BM_POOL1_CNT )
+  #define OSAL_BM_POOL1_CNT   0
+#endif
+
+#if ( OSAL_BM_POOL0_CNT > 255 ) || ( OSAL_BM_POOL1_CNT > 255 )
+  #error OSAL_BM_POOLx_CNT must not exceed 255
+#endif
+
+#define OSAL_BM_POOL_MAX      2
+
+// Number of bytes searched back from a heap buffer's payload pointer for the
+// start of its buffer before falling back on a walk of all allocated heap
+// buffers (0 to 255). This must cover the header space that the stack
+// reserves in a buffer. Pool buffers are found from their slot.
+#if !defined ( OSAL_BM_HDR_WALK_MAX )
+  #define OSAL_BM_HDR_WALK_MAX  32
+#endif
 
 /*********************************************************************
  * VARIABLES
@@ -68,6 +100,15 @@ extern "C"
  * TYPEDEFS
  */
 
+// Occupancy of one packet pool
+typedef struct
+{
+  uint16 size;     // payload size of each buffer
+  uint8  total;    // number of buffers in the pool
+  uint8  used;     // buffers now allocated
+  uint8  max;      // most buffers ever allocated at once
+  uint16 overflow; // requests sent to the heap because the pool was empty
+} osalBmPoolStats_t;
 
 /*********************************************************************
  * VARIABLES
@@ -96,6 +137,11 @@ extern void *osal_bm_adjust_tail( void *payload_ptr, int16 size );
  * Free a block of memory.
  */
 extern void osal_bm_free( void *payload_ptr );
+
+/*
+ * Get the occupancy of a packet pool.
+ */
+extern uint8 osal_bm_pool_stats( uint8 pool, osalBmPoolStats_t *pStats );
   
 /*********************************************************************
 *********************************************************************/
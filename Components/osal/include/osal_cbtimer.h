@@ -66,7 +66,7 @@ extern "C"
  * MACROS
  */
 #if ( OSAL_CBTIMER_NUM_TASKS == 0 )
-  #error Callback Timer module shouldn't be included (no callback timer is needed)!
+  #error Callback Timer module should not be included (no callback timer is needed)!
 #elif ( OSAL_CBTIMER_NUM_TASKS == 1 )
   #define OSAL_CBTIMER_PROCESS_EVENT( a )          ( a )
 #elif ( OSAL_CBTIMER_NUM_TASKS == 2 )
@@ -75,6 +75,16 @@ extern "C"
   #error Maximum of 2 callback timer tasks are supported! Modify it here.
 #endif
 
+// Number of callback timers. They are shared by all the callback timer
+// tasks and run on the first of them (1 to 254).
+#if !defined ( OSAL_CBTIMER_NUM_TIMERS )
+  #define OSAL_CBTIMER_NUM_TIMERS                  ( OSAL_CBTIMER_NUM_TASKS * 15 )
+#endif
+
+#if ( OSAL_CBTIMER_NUM_TIMERS < 1 ) || ( OSAL_CBTIMER_NUM_TIMERS > 254 )
+  #error OSAL_CBTIMER_NUM_TIMERS must be 1 to 254
+#endif
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -55,10 +55,64 @@ extern "C"
  * CONSTANTS
  */
 
+// Maximum number of items in one osal_snv_write_batch() call
+#define OSAL_SNV_BATCH_MAX  16
+
+// Number of entries in the RAM index that maps an item ID to its location in
+// the active NV page, so that reads and writes need not scan the page.
+// Each entry costs 3 bytes of RAM. Size it above the number of distinct items
+// in use to keep probes short; items that do not fit are found by a page scan.
+// Set to 0 to compile the index out.
+#if !defined OSAL_SNV_INDEX_SIZE
+  #define OSAL_SNV_INDEX_SIZE  0
+#endif
+
+#if OSAL_SNV_INDEX_SIZE > 255
+  #error "OSAL_SNV_INDEX_SIZE must not exceed 255"
+#endif
+
+// Write-back cache: number of items whose latest value may be held in RAM
+// instead of being written to flash at once, and the largest such item.
+// Repeated writes of the same item then cost one flash write. Pending items
+// are written by osal_snv_flush(), when the cache is full and, with the
+// compaction task, once writes have been quiet for OSAL_SNV_CACHE_IDLE_FLUSH
+// msecs. Pending values are lost on reset. Set to 0 to disable the cache.
+#if !defined OSAL_SNV_CACHE_CNT
+  #define OSAL_SNV_CACHE_CNT          0
+#endif
+
+#if !defined OSAL_SNV_CACHE_ITEM_LEN
+  #define OSAL_SNV_CACHE_ITEM_LEN     16
+#endif
+
+#if !defined OSAL_SNV_CACHE_IDLE_FLUSH
+  #define OSAL_SNV_CACHE_IDLE_FLUSH   5000
+#endif
+
+// With OSAL_SNV_COMPACT_TASK defined, the application registers the NV
+// compaction task (osal_snv_CompactInit/osal_snv_CompactProcessEvent) and the
+// active page is compacted in the background, in bounded steps, once it is
+// filled past OSAL_SNV_COMPACT_THRESHOLD percent. Writes then only fall back
+// to a blocking compaction if the page fills up before the task catches up.
+#if !defined OSAL_SNV_COMPACT_THRESHOLD
+  #define OSAL_SNV_COMPACT_THRESHOLD  75
+#endif
+
+// Number of item headers examined per background compaction step; bounds
+// the time a step blocks. The final page erase is a step of its own.
+#if !defined OSAL_SNV_COMPACT_STEP
+  #define OSAL_SNV_COMPACT_STEP       4
+#endif
+
 /*********************************************************************
  * MACROS
  */
 
+#if !defined OSAL_SNV_COMPACT_TASK
+  #define osal_snv_compact_gate( gated )
+  #define osal_snv_compact_window()
+#endif
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -70,6 +124,14 @@ extern "C"
   typedef uint8 osalSnvLen_t;
 #endif
 
+// One item of an osal_snv_write_batch() call
+typedef struct
+{
+  osalSnvId_t id;
+  osalSnvLen_t len;
+  void *pBuf;
+} osalSnvItem_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -114,6 +176,78 @@ extern uint8 osal_snv_read( osalSnvId_t id, osalSnvLen_t len, void *pBuf);
  */
 extern uint8 osal_snv_write( osalSnvId_t id, osalSnvLen_t len, void *pBuf);
 
+/*********************************************************************
+ * @fn      osal_snv_write_batch
+ *
+ * @brief   Write a group of data items to NV as one unit: after a power
+ *          loss either all of the changed items hold their new value or
+ *          none does.
+ *
+ * @param   pItems - Items to write.
+ * @param   cnt    - Number of items, at most OSAL_SNV_BATCH_MAX.
+ *
+ * @return  SUCCESS if successful, INVALIDPARAMETER if there are too many
+ *          items or an ID appears twice, NV_OPER_FAILED if failed.
+ */
+extern uint8 osal_snv_write_batch( osalSnvItem_t *pItems, uint8 cnt );
+
+/*********************************************************************
+ * @fn      osal_snv_flush
+ *
+ * @brief   Write all items held in the write-back cache to NV.
+ *
+ * @return  SUCCESS if successful, NV_OPER_FAILED if failed.
+ */
+extern uint8 osal_snv_flush( void );
+
+/*********************************************************************
+ * @fn      osal_snv_stats
+ *
+ * @brief   Read the NV write counters.
+ *
+ * @param   pWrites - If not NULL, receives the number of osal_snv_write()
+ *                    calls since power-up.
+ * @param   pWords  - If not NULL, receives the number of flash words
+ *                    written since power-up.
+ *
+ * @return  none
+ */
+extern void osal_snv_stats( uint32 *pWrites, uint32 *pWords );
+
+#if defined OSAL_SNV_COMPACT_TASK
+/*
+ * NV compaction task initialization function.
+ */
+extern void osal_snv_CompactInit( uint8 taskId );
+
+/*
+ * NV compaction task event processing function.
+ */
+extern uint16 osal_snv_CompactProcessEvent( uint8 taskId, uint16 events );
+
+/*********************************************************************
+ * @fn      osal_snv_compact_gate
+ *
+ * @brief   Restrict background compaction steps to windows granted with
+ *          osal_snv_compact_window(), e.g. while a connection is up.
+ *
+ * @param   gated - TRUE to run steps only in granted windows,
+ *                  FALSE to run them whenever the task is scheduled.
+ *
+ * @return  none
+ */
+extern void osal_snv_compact_gate( uint8 gated );
+
+/*********************************************************************
+ * @fn      osal_snv_compact_window
+ *
+ * @brief   Grant one background compaction step while gated.
+ *
+ * @return  none
+ */
+extern void osal_snv_compact_window( void );
+#endif
+
 /*********************************************************************
 *********************************************************************/
 
@@ -49,6 +49,9 @@
 #include "osal_snv.h"
 #include "hal_assert.h"
 #include "saddr.h"
+#if defined OSAL_SNV_COMPACT_TASK
+#include "OSAL_Tasks.h"
+#endif
 
 #ifdef OSAL_SNV_UINT16_ID
 # error "This OSAL SNV implementation does not support the extended ID space"
@@ -92,6 +95,11 @@
 #define OSAL_NV_INVALID_ID_MARK  0x8000
 
 
+// Flag in an ID field of an item header to indicate a batch commit record.
+// The low byte holds the number of items in the batch, which immediately
+// precede the record; the length field is 0.
+#define OSAL_NV_BATCH_MARK       0x4000
+
 // Bit difference between active page state indicator value and
 // transfer page state indicator value
 #define OSAL_NV_ACTIVE_XFER_DIFF  0x00100000
@@ -102,6 +110,23 @@
 // transfer page state indicator value
 #define OSAL_NV_XFER_PAGE_STATE   (OSAL_NV_ACTIVE_PAGE_STATE ^ OSAL_NV_ACTIVE_XFER_DIFF)
 
+// Compaction engine states
+#define NV_COMPACT_IDLE           0
+#define NV_COMPACT_COPY           1  // copying items from the active page to the spare page
+#define NV_COMPACT_ERASE          2  // erasing the spare page
+
+// Number of bytes compared per flash read when checking for an unchanged value
+#define OSAL_NV_CMP_SIZE         (OSAL_NV_WORD_SIZE * 4)
+
+#if defined OSAL_SNV_COMPACT_TASK
+// Compaction task events
+#define OSAL_NV_COMPACT_EVT       0x0001
+#define OSAL_NV_FLUSH_EVT         0x0002
+
+// Active page offset past which a background compaction is started
+#define OSAL_NV_COMPACT_OFFSET    ((uint16)((uint32)OSAL_NV_PAGE_SIZE * OSAL_SNV_COMPACT_THRESHOLD / 100))
+#endif
+
 /*********************************************************************
  * MACROS
  */
@@ -132,6 +157,25 @@ typedef struct
 } osalNvItemHdr_t;
 // Note that osalSnvId_t and osalSnvLen_t cannot be bigger than uint16
 
+#if OSAL_SNV_INDEX_SIZE
+// RAM index entry: item ID and offset of its latest data in the active page
+typedef struct
+{
+  osalSnvId_t id;
+  uint16 offset;
+} osalNvIndex_t;
+#endif
+
+#if OSAL_SNV_CACHE_CNT
+// Write-back cache entry holding the pending value of an item
+typedef struct
+{
+  osalSnvId_t id;     // OSAL_NV_ITEM_NULL when the entry is free
+  osalSnvLen_t len;
+  uint8 data[OSAL_SNV_CACHE_ITEM_LEN];
+} osalNvCache_t;
+#endif
+
 /*********************************************************************
  * EXTERNAL FUNCTIONS
  */
@@ -165,6 +209,42 @@ static uint16 pgOff;
 // another write or erase.
 static uint8 failF;
 
+// Number of osal_snv_write() calls and of flash words actually written,
+// including item headers and compaction copies.
+static uint32 nvLogicalWrites;
+static uint32 nvWordsWritten;
+
+#if OSAL_SNV_CACHE_CNT
+// Items written but not yet flushed to flash
+static osalNvCache_t nvCache[OSAL_SNV_CACHE_CNT];
+#endif
+
+// Compaction engine state. The spare page is the page being filled while
+// copying and the page left to erase afterwards.
+static uint8 nvCompactState;
+static uint8 nvSparePg;
+static uint16 nvDstOff;   // next free offset in the spare page
+static uint16 nvScanOff;  // offset of the next item header to examine in the active page
+static uint16 nvScanEnd;  // the current scan pass ends below this offset
+static uint16 nvScanTop;  // active page offset when the current scan pass started
+
+#if defined OSAL_SNV_COMPACT_TASK
+static uint8 nvCompactTaskId = TASK_NO_TASK;
+static uint8 nvCompactGated;    // steps only run in windows granted by the application
+static uint8 nvCompactWindow;   // a window has been granted
+static uint16 nvCompactBase;    // active page offset right after the last compaction
+#endif
+
+#if OSAL_SNV_INDEX_SIZE
+// Open-addressing table of item locations in the active page, rebuilt whenever
+// the active page changes. A free slot holds OSAL_NV_ITEM_NULL.
+static osalNvIndex_t nvIndex[OSAL_SNV_INDEX_SIZE];
+
+// Set when an item did not fit into the full index, so a lookup that misses
+// must fall back to scanning the page.
+static uint8 nvIndexOvf;
+#endif
+
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
@@ -176,10 +256,29 @@ static void   setXferPage(void);
 static void   erasePage( uint8 pg );
 static void   cleanErasedPage( uint8 pg );
 static void   findOffset( void );
-static void   compactPage( uint8 pg );
+static void   compactStart( void );
+static void   compactStep( uint16 cnt );
+static void   compactPage( void );
+#if defined OSAL_SNV_COMPACT_TASK
+static void   compactCheck( void );
+#endif
 
 static void   writeWord( uint8 pg, uint16 offset, uint8 *pBuf );
 static void   writeWordM( uint8 pg, uint16 offset, uint8 *pBuf, osalSnvLen_t cnt );
+static void   writeItem( uint8 pg, uint16 offset, osalSnvId_t id, uint16 alignedLen, uint8 *pBuf, uint8 commit );
+static void   commitBatch( uint16 offset );
+static void   recoverBatch( void );
+
+static uint16 findActiveItem( osalSnvId_t id );
+static uint8  itemIsEqual( uint16 offset, osalSnvLen_t len, uint8 *pBuf );
+static uint8  updateItem( osalSnvId_t id, osalSnvLen_t len, uint8 *pBuf );
+#if OSAL_SNV_CACHE_CNT
+static osalNvCache_t *cacheFind( osalSnvId_t id );
+#endif
+#if OSAL_SNV_INDEX_SIZE
+static void   indexSet( osalSnvId_t id, uint16 offset, uint8 replace );
+static void   indexBuild( void );
+#endif
 
 
 // NOTE: Triggering erase upon power up may cause fast aging of the flash device
@@ -204,6 +303,10 @@ static uint8 initNV( void )
 
   failF = FALSE;
   activePg = OSAL_NV_PAGE_NULL;
+  nvCompactState = NV_COMPACT_IDLE;
+#if defined OSAL_SNV_COMPACT_TASK
+  nvCompactBase = OSAL_NV_PAGE_HDR_SIZE;
+#endif
 
   // Pick active page and clean up erased page if necessary
   for ( pg = OSAL_NV_PAGE_BEG; pg <= OSAL_NV_PAGE_END; pg++ )
@@ -262,8 +365,12 @@ static uint8 initNV( void )
       // Complete the compacting.
       activePg = xferPg;
       findOffset();
+      recoverBatch();
+#if OSAL_SNV_INDEX_SIZE
+      indexBuild();
+#endif
       
-      compactPage(xferPg);
+      compactPage();
     }
   }
   else
@@ -277,6 +384,7 @@ static uint8 initNV( void )
     
     // find the active page offset to write a new variable location item
     findOffset();
+    recoverBatch();
   }
   
   return TRUE;
@@ -440,7 +548,7 @@ static uint16 findItem(uint8 pg, uint16 offset, osalSnvId_t id)
     {
       // item found
       // length field could be corrupt. Mask invalid length mark.
-      uint8 len = hdr.len & ~OSAL_NV_INVALID_LEN_MARK;
+      uint16 len = hdr.len & ~OSAL_NV_INVALID_LEN_MARK;
       return offset - len;
     }
     else if (hdr.len & OSAL_NV_INVALID_LEN_MARK)
@@ -468,6 +576,157 @@ static uint16 findItem(uint8 pg, uint16 offset, osalSnvId_t id)
   return 0;
 }
 
+#if OSAL_SNV_INDEX_SIZE
+/*********************************************************************
+ * @fn      indexSet
+ *
+ * @brief   Record the location of an item in the RAM index.
+ *
+ * @param   id      - NV item ID
+ * @param   offset  - offset of the item data in the active page
+ * @param   replace - TRUE to overwrite an existing entry for the ID,
+ *                    FALSE to keep it (used when building from the newest
+ *                    item backwards).
+ *
+ * @return  none
+ */
+static void indexSet( osalSnvId_t id, uint16 offset, uint8 replace )
+{
+  uint8 slot = id % OSAL_SNV_INDEX_SIZE;
+  uint8 cnt;
+
+  if (id == OSAL_NV_ITEM_NULL)
+  {
+    // The null ID marks a free slot; such an item is always found by a scan.
+    return;
+  }
+
+  for (cnt = 0; cnt < OSAL_SNV_INDEX_SIZE; cnt++)
+  {
+    if (nvIndex[slot].id == OSAL_NV_ITEM_NULL)
+    {
+      nvIndex[slot].id = id;
+      nvIndex[slot].offset = offset;
+      return;
+    }
+
+    if (nvIndex[slot].id == id)
+    {
+      if (replace)
+      {
+        nvIndex[slot].offset = offset;
+      }
+      return;
+    }
+
+    if (++slot == OSAL_SNV_INDEX_SIZE)
+    {
+      slot = 0;
+    }
+  }
+
+  nvIndexOvf = TRUE;
+}
+
+/*********************************************************************
+ * @fn      indexBuild
+ *
+ * @brief   Rebuild the RAM index from the active page with a single
+ *          backward pass over its item headers.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void indexBuild( void )
+{
+  uint16 offset;
+  uint8 i;
+
+  for (i = 0; i < OSAL_SNV_INDEX_SIZE; i++)
+  {
+    nvIndex[i].id = OSAL_NV_ITEM_NULL;
+  }
+  nvIndexOvf = FALSE;
+
+  offset = pgOff - OSAL_NV_WORD_SIZE;
+
+  while (offset >= OSAL_NV_PAGE_HDR_SIZE)
+  {
+    osalNvItemHdr_t hdr;
+
+    HalFlashRead(activePg, offset, (uint8 *) &hdr, OSAL_NV_WORD_SIZE);
+
+    if (hdr.len & OSAL_NV_INVALID_LEN_MARK)
+    {
+      offset -= OSAL_NV_WORD_SIZE;
+    }
+    else if (hdr.len + OSAL_NV_WORD_SIZE <= offset)
+    {
+      if (!(hdr.id & (OSAL_NV_INVALID_ID_MARK | OSAL_NV_BATCH_MARK)))
+      {
+        // The first occurrence seen is the latest value of the item.
+        indexSet((osalSnvId_t) hdr.id, offset - hdr.len, FALSE);
+      }
+      offset -= hdr.len + OSAL_NV_WORD_SIZE;
+    }
+    else
+    {
+      // Corrupt page: leave lookups to findItem(), which reports it.
+      nvIndexOvf = TRUE;
+      return;
+    }
+  }
+}
+#endif
+
+/*********************************************************************
+ * @fn      findActiveItem
+ *
+ * @brief   find the latest value of an item in the active page, through
+ *          the RAM index when it is enabled.
+ *
+ * @param   id - NV item ID to search for
+ *
+ * @return  offset of the item, 0 when not found
+ */
+static uint16 findActiveItem( osalSnvId_t id )
+{
+#if OSAL_SNV_INDEX_SIZE
+  if (id != OSAL_NV_ITEM_NULL)
+  {
+    uint8 slot = id % OSAL_SNV_INDEX_SIZE;
+    uint8 cnt;
+
+    for (cnt = 0; cnt < OSAL_SNV_INDEX_SIZE; cnt++)
+    {
+      if (nvIndex[slot].id == id)
+      {
+        return nvIndex[slot].offset;
+      }
+
+      if (nvIndex[slot].id == OSAL_NV_ITEM_NULL)
+      {
+        // Entries are never removed, so a free slot ends the probe sequence.
+        return 0;
+      }
+
+      if (++slot == OSAL_SNV_INDEX_SIZE)
+      {
+        slot = 0;
+      }
+    }
+
+    if (!nvIndexOvf)
+    {
+      return 0;
+    }
+  }
+#endif
+
+  return findItem(activePg, pgOff, id);
+}
+
 /*********************************************************************
  * @fn      writeItem
  *
@@ -479,10 +738,12 @@ static uint16 findItem(uint8 pg, uint16 offset, osalSnvId_t id)
  * @param   alignedLen - Length of data to write, alinged in flash word
  *                       boundary
  * @param  *pBuf   - Data to write.
+ * @param   commit - FALSE to leave the item invalid until its batch is
+ *                   committed.
  *
  * @return  none
  */
-static void writeItem( uint8 pg, uint16 offset, osalSnvId_t id, uint16 alignedLen, uint8 *pBuf )
+static void writeItem( uint8 pg, uint16 offset, osalSnvId_t id, uint16 alignedLen, uint8 *pBuf, uint8 commit )
 {
   osalNvItemHdr_t hdr;
 
@@ -502,10 +763,87 @@ static void writeItem( uint8 pg, uint16 offset, osalSnvId_t id, uint16 alignedLe
   // value is valid. Write header except for the most significant bit.
   hdr.id = id | OSAL_NV_INVALID_ID_MARK;
   writeWord(pg, offset + alignedLen, (uint8 *) &hdr);
-    
-  // write the most significant bit
-  hdr.id &= ~OSAL_NV_INVALID_ID_MARK;
-  writeWord(pg, offset + alignedLen, (uint8 *) &hdr);
+
+  if (commit)
+  {
+    // write the most significant bit
+    hdr.id &= ~OSAL_NV_INVALID_ID_MARK;
+    writeWord(pg, offset + alignedLen, (uint8 *) &hdr);
+  }
+}
+
+/*********************************************************************
+ * @fn      commitBatch
+ *
+ * @brief   Make every item of a committed batch valid. The items were
+ *          written with their ID still marked invalid and immediately
+ *          precede the batch commit record.
+ *
+ * @param   offset - offset of the batch commit record in the active page
+ *
+ * @return  none
+ */
+static void commitBatch( uint16 offset )
+{
+  osalNvItemHdr_t hdr;
+  uint8 cnt;
+
+  HalFlashRead(activePg, offset, (uint8 *) &hdr, OSAL_NV_WORD_SIZE);
+  cnt = (uint8) hdr.id;
+
+  while (cnt--)
+  {
+    offset -= OSAL_NV_WORD_SIZE;
+    HalFlashRead(activePg, offset, (uint8 *) &hdr, OSAL_NV_WORD_SIZE);
+
+    if ((hdr.len & OSAL_NV_INVALID_LEN_MARK) || (hdr.len + OSAL_NV_WORD_SIZE > offset))
+    {
+      // A commit record is only written after all of its items.
+      HAL_ASSERT_FORCED();
+      return;
+    }
+
+    if (hdr.id & OSAL_NV_INVALID_ID_MARK)
+    {
+      // write the most significant bit
+      hdr.id &= ~OSAL_NV_INVALID_ID_MARK;
+      writeWord(activePg, offset, (uint8 *) &hdr);
+    }
+
+#if OSAL_SNV_INDEX_SIZE
+    indexSet((osalSnvId_t) hdr.id, offset - hdr.len, TRUE);
+#endif
+
+    offset -= hdr.len;
+  }
+}
+
+/*********************************************************************
+ * @fn      recoverBatch
+ *
+ * @brief   Complete a batch whose commit record was written but whose
+ *          items were not all made valid before power was lost. Only
+ *          the last record of the active page can be such a batch.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void recoverBatch( void )
+{
+  osalNvItemHdr_t hdr;
+
+  if (pgOff < OSAL_NV_PAGE_HDR_SIZE + OSAL_NV_WORD_SIZE)
+  {
+    return;
+  }
+
+  HalFlashRead(activePg, pgOff - OSAL_NV_WORD_SIZE, (uint8 *) &hdr, OSAL_NV_WORD_SIZE);
+
+  if (!(hdr.id & OSAL_NV_INVALID_ID_MARK) && (hdr.id & OSAL_NV_BATCH_MARK) && (hdr.len == 0))
+  {
+    commitBatch(pgOff - OSAL_NV_WORD_SIZE);
+  }
 }
 
 /*********************************************************************
@@ -537,163 +875,271 @@ static void xferItem( uint8 pg, uint16 offset, uint16 alignedLen, uint16 srcOff
 }
 
 /*********************************************************************
- * @fn      compactPage
+ * @fn      compactStart
  *
- * @brief   Compacts the page specified.
+ * @brief   Begin compacting the active page into the spare page. The
+ *          spare page must be erased.
  *
- * @param   srcPg - Valid NV page to compact from.
- *                  The page must have changed its state (header) to xfer state
- *                  prior to this function call. This function will not
- *                  modify the state of its header to xfer state before starting
- *                  to compact.
+ * @param   none
  *
  * @return  none.
  */
-static void compactPage( uint8 srcPg )
+static void compactStart( void )
 {
-  uint16 srcOff, dstOff;
-  uint8 dstPg;
-  osalSnvId_t lastId = (osalSnvId_t) 0xFFFF;
+  nvSparePg = (activePg == OSAL_NV_PAGE_BEG)? OSAL_NV_PAGE_END : OSAL_NV_PAGE_BEG;
+  nvDstOff = OSAL_NV_PAGE_HDR_SIZE;
 
-  dstPg = (srcPg == OSAL_NV_PAGE_BEG)? OSAL_NV_PAGE_END : OSAL_NV_PAGE_BEG;
+  // Scan from the latest item down to the page header.
+  nvScanEnd = OSAL_NV_PAGE_HDR_SIZE;
+  nvScanTop = pgOff;
+  nvScanOff = pgOff - sizeof(osalNvItemHdr_t);
 
-  dstOff = OSAL_NV_PAGE_HDR_SIZE;
-  
-  // Read from the latest value
-  srcOff = pgOff - sizeof(osalNvItemHdr_t);
-  
-  while (srcOff >= OSAL_NV_PAGE_HDR_SIZE)
+  nvCompactState = NV_COMPACT_COPY;
+}
+
+/*********************************************************************
+ * @fn      compactStep
+ *
+ * @brief   Run one bounded step of the compaction engine: examine up
+ *          to 'cnt' item headers of the active page, or perform the
+ *          single page erase that ends a compaction.
+ *
+ *          Items may still be written to the active page while it is
+ *          being compacted. Only the latest value of each item is
+ *          copied, and items written after a scan pass started are
+ *          copied by a further pass over just that region, so the
+ *          spare page never holds a value older than the active page.
+ *
+ * @param   cnt - maximum number of item headers to examine.
+ *
+ * @return  none.
+ */
+static void compactStep( uint16 cnt )
+{
+  if (failF)
+  {
+    // Failure during transfer item will make next findItem error prone.
+    nvCompactState = NV_COMPACT_IDLE;
+    return;
+  }
+
+  if (nvCompactState == NV_COMPACT_ERASE)
+  {
+    erasePage(nvSparePg);
+    nvCompactState = NV_COMPACT_IDLE;
+    return;
+  }
+
+  while (nvCompactState == NV_COMPACT_COPY && cnt--)
   {
     osalNvItemHdr_t hdr;
 
-    if (failF)
+    if (nvScanOff < nvScanEnd)
     {
-      // Failure during transfer item will make next findItem error prone.
-      return;
-    }
-        
-    HalFlashRead(srcPg, srcOff, (uint8 *) &hdr, OSAL_NV_WORD_SIZE);
-    
-    if (hdr.id == 0xFFFF)
-    {
-      // Invalid entry. Skip this one.
-      if (hdr.len & OSAL_NV_INVALID_LEN_MARK)
+      if (nvScanTop != pgOff)
       {
-        srcOff -= OSAL_NV_WORD_SIZE;
+        // Items were written during the pass. Copy them in another pass.
+        nvScanEnd = nvScanTop;
+        nvScanTop = pgOff;
+        nvScanOff = pgOff - sizeof(osalNvItemHdr_t);
       }
       else
       {
-        if (hdr.len + OSAL_NV_WORD_SIZE <= srcOff)
-        {
-          srcOff -= hdr.len + OSAL_NV_WORD_SIZE;
-        }
-        else
+        // All items copied.
+        // Activate the new page and erase the old one in the next step.
+        uint8 srcPg = activePg;
+
+        setXferPage();
+        setActivePage(nvSparePg);
+
+        if (!failF)
         {
-          // invalid length. Source page must be a corrupt page.
-          // This is possible only if the NV initialization failed upon erasing
-          // what is selected as active page.
-          // This is supposed to be a very rare case, as power should be
-          // shutdown exactly during erase and then the page header is
-          // still retained as either the Xfer or the Active state.
-
-          // For production code, it might be useful to attempt to erase the page
-          // so that at next power cycle at least the device is runnable
-          // (with all entries removed).
-          // However, it might be still better not to attempt erasing the page
-          // just to see if this very rare case actually happened.
-          //erasePage(srcPg);
-
-          HAL_ASSERT_FORCED();
-          return;
+          pgOff = nvDstOff; // update active page offset
+          nvSparePg = srcPg;
+#if defined OSAL_SNV_COMPACT_TASK
+          nvCompactBase = pgOff;
+#endif
+#if OSAL_SNV_INDEX_SIZE
+          indexBuild();
+#endif
         }
+        nvCompactState = NV_COMPACT_ERASE;
       }
+      continue;
+    }
 
+    HalFlashRead(activePg, nvScanOff, (uint8 *) &hdr, OSAL_NV_WORD_SIZE);
+
+    if (hdr.len & OSAL_NV_INVALID_LEN_MARK)
+    {
+      // Header of an item whose write never started. Skip this word.
+      nvScanOff -= OSAL_NV_WORD_SIZE;
       continue;
     }
-    
-    // Consider only valid item
-    if (!(hdr.id & OSAL_NV_INVALID_ID_MARK) && hdr.id != lastId)
-    {
-      // lastId is used to speed up compacting in case the same item ID
-      // items were neighboring each other contiguously.
-      lastId = (osalSnvId_t) hdr.id;
-     
-      // Check if the latest value of the item was already written
-      if (findItem(dstPg, dstOff, lastId) == 0)
-      {
-        // This item was not copied over yet.
-        // This must be the latest value.
-        // Write the latest value to the destination page
-        
-        xferItem(dstPg, dstOff, hdr.len, srcOff - hdr.len);
 
-        dstOff += hdr.len + OSAL_NV_WORD_SIZE;
-      }
+    if (hdr.len + OSAL_NV_WORD_SIZE > nvScanOff)
+    {
+      // invalid length. Source page must be a corrupt page.
+      // This is possible only if the NV initialization failed upon erasing
+      // what is selected as active page.
+      // Give up and erase the partially written spare page.
+      HAL_ASSERT_FORCED();
+      nvCompactState = NV_COMPACT_ERASE;
+      return;
     }
-    srcOff -= hdr.len + OSAL_NV_WORD_SIZE;
-  }
 
-  // All items copied.
-  // Activate the new page
-  setActivePage(dstPg);
+    // Consider only valid item, and only its latest value.
+    if (!(hdr.id & (OSAL_NV_INVALID_ID_MARK | OSAL_NV_BATCH_MARK)) &&
+        (findActiveItem((osalSnvId_t) hdr.id) == nvScanOff - hdr.len))
+    {
+      if (nvDstOff + hdr.len + OSAL_NV_WORD_SIZE > OSAL_NV_PAGE_SIZE)
+      {
+        // The spare page filled up with values that were superseded while
+        // the compaction was in progress. Discard it; the next compaction
+        // starts over from the current state of the active page.
+        nvCompactState = NV_COMPACT_ERASE;
+        return;
+      }
 
-  if (!failF)
-  {
-    pgOff = dstOff; // update active page offset
+      xferItem(nvSparePg, nvDstOff, hdr.len, nvScanOff - hdr.len);
+      nvDstOff += hdr.len + OSAL_NV_WORD_SIZE;
+    }
+
+    nvScanOff -= hdr.len + OSAL_NV_WORD_SIZE;
   }
-  
-  // Erase the currently active page
-  erasePage(srcPg);
 }
 
 /*********************************************************************
- * @fn      verifyWordM
+ * @fn      compactPage
  *
- * @brief   verify the written word.
+ * @brief   Compacts the active page to completion, blocking. A
+ *          compaction already in progress is finished rather than
+ *          restarted.
  *
- * @param   pg - A valid NV Flash page.
- * @param   offset - A valid offset into the page.
- * @param   pBuf - Pointer to source buffer.
- * @param   cnt - Number of 4-byte blocks to verify.
+ * @param   none
  *
- * @return  none
+ * @return  none.
  */
-static void verifyWordM( uint8 pg, uint16 offset, uint8 *pBuf, osalSnvLen_t cnt )
+static void compactPage( void )
 {
-  uint8 tmp[OSAL_NV_WORD_SIZE];
-  
-  while (cnt--)
+  uint8 restarted = FALSE;
+
+  if (nvCompactState != NV_COMPACT_COPY)
   {
-    // Reading byte per byte will reduce code size but will slow down
-    // and not sure it will meet the timing requirements.
-    HalFlashRead(pg, offset, tmp, OSAL_NV_WORD_SIZE);
-    if (FALSE == osal_memcmp(tmp, pBuf, OSAL_NV_WORD_SIZE))
+    // Complete the erase pending from an earlier compaction first.
+    if (nvCompactState == NV_COMPACT_ERASE)
     {
-      failF = TRUE;
-      return;
+      compactStep(1);
     }
-    offset += OSAL_NV_WORD_SIZE;
-    pBuf += OSAL_NV_WORD_SIZE;
+    compactStart();
   }
-}
 
-/*********************************************************************
- * @fn      writeWord
- *
- * @brief   Writes a Flash-WORD to NV.
- *
- * @param   pg - A valid NV Flash page.
- * @param   offset - A valid offset into the page.
- * @param   pBuf - Pointer to source buffer.
- *
- * @return  none
- */
-static void writeWord( uint8 pg, uint16 offset, uint8 *pBuf )
+  for (;;)
+  {
+    uint8 srcPg = activePg;
+
+    while (nvCompactState == NV_COMPACT_COPY)
+    {
+      compactStep(0xFFFF);
+    }
+
+    // Done unless the copy was discarded; in that case retry once, which
+    // cannot overflow again with no writes in between.
+    if (activePg != srcPg || nvCompactState != NV_COMPACT_ERASE || restarted)
+    {
+      break;
+    }
+
+    compactStep(1);
+    compactStart();
+    restarted = TRUE;
+  }
+
+  if (nvCompactState == NV_COMPACT_ERASE)
+  {
+    compactStep(1);
+  }
+}
+
+#if defined OSAL_SNV_COMPACT_TASK
+/*********************************************************************
+ * @fn      compactCheck
+ *
+ * @brief   Start a background compaction once the active page passes
+ *          the fill threshold, so that writes do not reach the blocking
+ *          path. A page whose live data alone is above the threshold is
+ *          only compacted again after half the space freed by its last
+ *          compaction has been used.
+ *
+ * @param   none
+ *
+ * @return  none.
+ */
+static void compactCheck( void )
+{
+  if (nvCompactTaskId == TASK_NO_TASK || nvCompactState != NV_COMPACT_IDLE)
+  {
+    return;
+  }
+
+  if ((pgOff >= OSAL_NV_COMPACT_OFFSET) &&
+      (pgOff - nvCompactBase >= (OSAL_NV_PAGE_SIZE - nvCompactBase) / 2))
+  {
+    compactStart();
+    osal_set_event(nvCompactTaskId, OSAL_NV_COMPACT_EVT);
+  }
+}
+#endif
+
+/*********************************************************************
+ * @fn      verifyWordM
+ *
+ * @brief   verify the written word.
+ *
+ * @param   pg - A valid NV Flash page.
+ * @param   offset - A valid offset into the page.
+ * @param   pBuf - Pointer to source buffer.
+ * @param   cnt - Number of 4-byte blocks to verify.
+ *
+ * @return  none
+ */
+static void verifyWordM( uint8 pg, uint16 offset, uint8 *pBuf, osalSnvLen_t cnt )
+{
+  uint8 tmp[OSAL_NV_WORD_SIZE];
+  
+  while (cnt--)
+  {
+    // Reading byte per byte will reduce code size but will slow down
+    // and not sure it will meet the timing requirements.
+    HalFlashRead(pg, offset, tmp, OSAL_NV_WORD_SIZE);
+    if (FALSE == osal_memcmp(tmp, pBuf, OSAL_NV_WORD_SIZE))
+    {
+      failF = TRUE;
+      return;
+    }
+    offset += OSAL_NV_WORD_SIZE;
+    pBuf += OSAL_NV_WORD_SIZE;
+  }
+}
+
+/*********************************************************************
+ * @fn      writeWord
+ *
+ * @brief   Writes a Flash-WORD to NV.
+ *
+ * @param   pg - A valid NV Flash page.
+ * @param   offset - A valid offset into the page.
+ * @param   pBuf - Pointer to source buffer.
+ *
+ * @return  none
+ */
+static void writeWord( uint8 pg, uint16 offset, uint8 *pBuf )
 {
   uint16 addr = (offset >> 2) + ((uint16)pg << 9);
 
   if ( !failF )
   {
+    nvWordsWritten++;
     HalFlashWrite(addr, pBuf, 1);
     verifyWordM(pg, offset, pBuf, 1);
   }
@@ -717,6 +1163,7 @@ static void writeWordM( uint8 pg, uint16 offset, uint8 *buf, osalSnvLen_t cnt )
 
   if ( !failF )
   {
+    nvWordsWritten += cnt;
     HalFlashWrite(addr, buf, cnt);
     verifyWordM(pg, offset, buf, cnt);
   }
@@ -738,12 +1185,50 @@ void osal_snv_init( void )
     
     // TODO: return failure in case HAL ASSERT is not turned on?
   }
+
+#if OSAL_SNV_INDEX_SIZE
+  indexBuild();
+#endif
 }
 
 /*********************************************************************
- * @fn      osal_snv_write
+ * @fn      itemIsEqual
  *
- * @brief   Write a data item to NV.
+ * @brief   Compare an item value in the active page with a buffer, a
+ *          block of flash at a time.
+ *
+ * @param   offset - offset of the item data in the active page
+ * @param   len    - number of bytes to compare
+ * @param   pBuf   - value to compare against
+ *
+ * @return  TRUE if the values are equal, FALSE otherwise.
+ */
+static uint8 itemIsEqual( uint16 offset, osalSnvLen_t len, uint8 *pBuf )
+{
+  uint8 tmp[OSAL_NV_CMP_SIZE];
+
+  while (len)
+  {
+    uint8 cnt = (len < OSAL_NV_CMP_SIZE) ? len : OSAL_NV_CMP_SIZE;
+
+    HalFlashRead(activePg, offset, tmp, cnt);
+    if (FALSE == osal_memcmp(tmp, pBuf, cnt))
+    {
+      return FALSE;
+    }
+    offset += cnt;
+    pBuf += cnt;
+    len -= cnt;
+  }
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      updateItem
+ *
+ * @brief   Write a data item to the active page unless it already holds
+ *          the same value.
  *
  * @param   id  - Valid NV item Id.
  * @param   len - Length of data to write.
@@ -751,34 +1236,18 @@ void osal_snv_init( void )
  *
  * @return  SUCCESS if successful, NV_OPER_FAILED if failed.
  */
-uint8 osal_snv_write( osalSnvId_t id, osalSnvLen_t len, void *pBuf )
+static uint8 updateItem( osalSnvId_t id, osalSnvLen_t len, uint8 *pBuf )
 {
   uint16 alignedLen;
 
   {
-    uint16 offset = findItem(activePg, pgOff, id);
+    uint16 offset = findActiveItem(id);
 
-    if (offset > 0)
+    if ((offset > 0) && itemIsEqual(offset, len, pBuf))
     {
-      uint8 tmp;
-      osalSnvLen_t i;
-      
-      for (i = 0; i < len; i++)
-      {
-        HalFlashRead(activePg, offset, &tmp, 1);
-        if (tmp != ((uint8 *)pBuf)[i])
-        {
-          break;
-        }
-        offset++;
-      }
-      
-      if (i == len)
-      {
-        // Changed value is the same value as before.
-        // Return here instead of re-writing the same value to NV.
-        return SUCCESS;
-      }
+      // Changed value is the same value as before.
+      // Return here instead of re-writing the same value to NV.
+      return SUCCESS;
     }
   }
   
@@ -786,22 +1255,301 @@ uint8 osal_snv_write( osalSnvId_t id, osalSnvLen_t len, void *pBuf )
 
   if ( pgOff + alignedLen + OSAL_NV_WORD_SIZE > OSAL_NV_PAGE_SIZE )
   {
-    setXferPage();
-    compactPage(activePg);
+    compactPage();
   }
   
   // pBuf shall be referenced beyond its valid length to save code size.
-  writeItem(activePg, pgOff, id, alignedLen, pBuf);
+  writeItem(activePg, pgOff, id, alignedLen, pBuf, TRUE);
   if (failF)
   {
     return NV_OPER_FAILED;
   }
+
+#if OSAL_SNV_INDEX_SIZE
+  indexSet(id, pgOff, TRUE);
+#endif
   
   pgOff += alignedLen + OSAL_NV_WORD_SIZE;
 
+#if defined OSAL_SNV_COMPACT_TASK
+  compactCheck();
+#endif
+
+  return SUCCESS;
+}
+
+#if OSAL_SNV_CACHE_CNT
+/*********************************************************************
+ * @fn      cacheFind
+ *
+ * @brief   Find the write-back cache entry of an item.
+ *
+ * @param   id - NV item ID, or OSAL_NV_ITEM_NULL to find a free entry.
+ *
+ * @return  pointer to the entry, NULL when not found
+ */
+static osalNvCache_t *cacheFind( osalSnvId_t id )
+{
+  uint8 i;
+
+  for (i = 0; i < OSAL_SNV_CACHE_CNT; i++)
+  {
+    if (nvCache[i].id == id)
+    {
+      return &nvCache[i];
+    }
+  }
+
+  return NULL;
+}
+#endif
+
+/*********************************************************************
+ * @fn      osal_snv_write
+ *
+ * @brief   Write a data item to NV.
+ *
+ * @param   id  - Valid NV item Id.
+ * @param   len - Length of data to write.
+ * @param   *pBuf - Data to write.
+ *
+ * @return  SUCCESS if successful, NV_OPER_FAILED if failed.
+ */
+uint8 osal_snv_write( osalSnvId_t id, osalSnvLen_t len, void *pBuf )
+{
+#if OSAL_SNV_CACHE_CNT
+  osalNvCache_t *pEntry = cacheFind(id);
+#endif
+
+  nvLogicalWrites++;
+
+#if OSAL_SNV_CACHE_CNT
+  if ((id != OSAL_NV_ITEM_NULL) && (len <= OSAL_SNV_CACHE_ITEM_LEN))
+  {
+    if (pEntry == NULL)
+    {
+      uint16 offset = findActiveItem(id);
+
+      if ((offset > 0) && itemIsEqual(offset, len, pBuf))
+      {
+        // Same value as in flash; nothing to hold back.
+        return SUCCESS;
+      }
+
+      pEntry = cacheFind(OSAL_NV_ITEM_NULL);
+      if (pEntry == NULL)
+      {
+        // Cache full: write all pending items out to make room.
+        if (osal_snv_flush() != SUCCESS)
+        {
+          return NV_OPER_FAILED;
+        }
+        pEntry = &nvCache[0];
+      }
+      pEntry->id = id;
+    }
+
+    pEntry->len = len;
+    osal_memcpy(pEntry->data, pBuf, len);
+
+#if defined OSAL_SNV_COMPACT_TASK
+    if (nvCompactTaskId != TASK_NO_TASK)
+    {
+      // Flush once writes have been quiet for a while.
+      VOID osal_start_timerEx(nvCompactTaskId, OSAL_NV_FLUSH_EVT, OSAL_SNV_CACHE_IDLE_FLUSH);
+    }
+#endif
+
+    return SUCCESS;
+  }
+
+  if (pEntry != NULL)
+  {
+    // The value written through supersedes the pending one.
+    pEntry->id = OSAL_NV_ITEM_NULL;
+  }
+#endif
+
+  return updateItem(id, len, pBuf);
+}
+
+/*********************************************************************
+ * @fn      osal_snv_write_batch
+ *
+ * @brief   Write a group of data items to NV as one unit: after a power
+ *          loss either all of the changed items hold their new value or
+ *          none does. The group takes one fit check and at most one
+ *          page compaction. Items whose value is unchanged are skipped.
+ *
+ * @param   pItems - Items to write.
+ * @param   cnt    - Number of items, at most OSAL_SNV_BATCH_MAX.
+ *
+ * @return  SUCCESS if successful, INVALIDPARAMETER if there are too many
+ *          items or an ID appears twice, NV_OPER_FAILED if failed.
+ */
+uint8 osal_snv_write_batch( osalSnvItem_t *pItems, uint8 cnt )
+{
+  osalNvItemHdr_t hdr;
+  uint16 changed = 0;
+  uint16 total = OSAL_NV_WORD_SIZE;  // commit record
+  uint16 offset;
+  uint8 nChanged = 0;
+  uint8 i, j;
+
+  if (cnt > OSAL_SNV_BATCH_MAX)
+  {
+    return INVALIDPARAMETER;
+  }
+
+  // The commit walks the items backwards, so a repeated ID would leave the
+  // older copy as the newest one found.
+  for (i = 1; i < cnt; i++)
+  {
+    for (j = 0; j < i; j++)
+    {
+      if (pItems[i].id == pItems[j].id)
+      {
+        return INVALIDPARAMETER;
+      }
+    }
+  }
+
+  nvLogicalWrites += cnt;
+
+  for (i = 0; i < cnt; i++)
+  {
+#if OSAL_SNV_CACHE_CNT
+    osalNvCache_t *pEntry = cacheFind(pItems[i].id);
+
+    if ((pEntry != NULL) && (pItems[i].id != OSAL_NV_ITEM_NULL))
+    {
+      // The batch supersedes the pending value.
+      pEntry->id = OSAL_NV_ITEM_NULL;
+    }
+#endif
+
+    offset = findActiveItem(pItems[i].id);
+
+    if ((offset == 0) || !itemIsEqual(offset, pItems[i].len, pItems[i].pBuf))
+    {
+      changed |= (uint16) 1 << i;
+      total += ((pItems[i].len + OSAL_NV_WORD_SIZE - 1) / OSAL_NV_WORD_SIZE + 1) * OSAL_NV_WORD_SIZE;
+      nChanged++;
+    }
+  }
+
+  if (nChanged == 0)
+  {
+    return SUCCESS;
+  }
+
+  if (pgOff + total > OSAL_NV_PAGE_SIZE)
+  {
+    compactPage();
+
+    if (pgOff + total > OSAL_NV_PAGE_SIZE)
+    {
+      return NV_OPER_FAILED;
+    }
+  }
+
+  // Write the items with their ID still marked invalid.
+  offset = pgOff;
+  for (i = 0; i < cnt; i++)
+  {
+    if (changed & ((uint16) 1 << i))
+    {
+      uint16 alignedLen = ((pItems[i].len + OSAL_NV_WORD_SIZE - 1) / OSAL_NV_WORD_SIZE) * OSAL_NV_WORD_SIZE;
+
+      // pBuf shall be referenced beyond its valid length to save code size.
+      writeItem(activePg, offset, pItems[i].id, alignedLen, pItems[i].pBuf, FALSE);
+      offset += alignedLen + OSAL_NV_WORD_SIZE;
+    }
+  }
+
+  // The commit record is a single flash word, so the batch becomes valid
+  // atomically. recoverBatch() completes the items after a power loss.
+  hdr.id = OSAL_NV_BATCH_MARK | nChanged;
+  hdr.len = 0;
+  writeWord(activePg, offset, (uint8 *) &hdr);
+  if (failF)
+  {
+    return NV_OPER_FAILED;
+  }
+
+  pgOff = offset + OSAL_NV_WORD_SIZE;
+  commitBatch(offset);
+  if (failF)
+  {
+    return NV_OPER_FAILED;
+  }
+
+#if defined OSAL_SNV_COMPACT_TASK
+  compactCheck();
+#endif
+
   return SUCCESS;
 }
 
+/*********************************************************************
+ * @fn      osal_snv_flush
+ *
+ * @brief   Write all items held in the write-back cache to NV.
+ *
+ * @return  SUCCESS if successful, NV_OPER_FAILED if failed.
+ */
+uint8 osal_snv_flush( void )
+{
+  uint8 status = SUCCESS;
+
+#if OSAL_SNV_CACHE_CNT
+  uint8 i;
+
+  for (i = 0; i < OSAL_SNV_CACHE_CNT; i++)
+  {
+    if (nvCache[i].id != OSAL_NV_ITEM_NULL)
+    {
+      if (updateItem(nvCache[i].id, nvCache[i].len, nvCache[i].data) == SUCCESS)
+      {
+        nvCache[i].id = OSAL_NV_ITEM_NULL;
+      }
+      else
+      {
+        // Keep the item pending.
+        status = NV_OPER_FAILED;
+      }
+    }
+  }
+#endif
+
+  return status;
+}
+
+/*********************************************************************
+ * @fn      osal_snv_stats
+ *
+ * @brief   Read the NV write counters.
+ *
+ * @param   pWrites - If not NULL, receives the number of osal_snv_write()
+ *                    calls since power-up.
+ * @param   pWords  - If not NULL, receives the number of flash words
+ *                    written since power-up, including item headers and
+ *                    compaction copies.
+ *
+ * @return  none
+ */
+void osal_snv_stats( uint32 *pWrites, uint32 *pWords )
+{
+  if (pWrites != NULL)
+  {
+    *pWrites = nvLogicalWrites;
+  }
+  if (pWords != NULL)
+  {
+    *pWords = nvWordsWritten;
+  }
+}
+
 /*********************************************************************
  * @fn      osal_snv_read
  *
@@ -816,7 +1564,21 @@ uint8 osal_snv_write( osalSnvId_t id, osalSnvLen_t len, void *pBuf )
  */
 uint8 osal_snv_read( osalSnvId_t id, osalSnvLen_t len, void *pBuf )
 {
-  uint16 offset = findItem(activePg, pgOff, id);
+  uint16 offset;
+
+#if OSAL_SNV_CACHE_CNT
+  {
+    osalNvCache_t *pEntry = cacheFind(id);
+
+    if ((pEntry != NULL) && (id != OSAL_NV_ITEM_NULL))
+    {
+      osal_memcpy(pBuf, pEntry->data, (len < OSAL_SNV_CACHE_ITEM_LEN) ? len : OSAL_SNV_CACHE_ITEM_LEN);
+      return SUCCESS;
+    }
+  }
+#endif
+
+  offset = findActiveItem(id);
   
   if (offset != 0)
   {
@@ -827,5 +1589,128 @@ uint8 osal_snv_read( osalSnvId_t id, osalSnvLen_t len, void *pBuf )
 }
 
 
+#if defined OSAL_SNV_COMPACT_TASK
+/*********************************************************************
+ * @fn      osal_snv_CompactInit
+ *
+ * @brief   NV compaction task initialization function.
+ *
+ * @param   taskId - NV compaction task ID.
+ *
+ * @return  none
+ */
+void osal_snv_CompactInit( uint8 taskId )
+{
+  nvCompactTaskId = taskId;
+  nvCompactGated = FALSE;
+  nvCompactWindow = FALSE;
+
+  // A compaction may already be due for the page found at start-up.
+  compactCheck();
+}
+
+/*********************************************************************
+ * @fn      osal_snv_CompactProcessEvent
+ *
+ * @brief   NV compaction task event processing function. Each event
+ *          runs one bounded step of a background compaction.
+ *
+ * @param   taskId - task ID.
+ * @param   events - events.
+ *
+ * @return  events not processed
+ */
+uint16 osal_snv_CompactProcessEvent( uint8 taskId, uint16 events )
+{
+  if ( events & SYS_EVENT_MSG )
+  {
+    // return unprocessed events
+    return ( events ^ SYS_EVENT_MSG );
+  }
+
+  if ( events & OSAL_NV_COMPACT_EVT )
+  {
+    if ( !nvCompactGated || nvCompactWindow )
+    {
+      nvCompactWindow = FALSE;
+
+      compactStep( OSAL_SNV_COMPACT_STEP );
+
+      if ( (nvCompactState != NV_COMPACT_IDLE) && !nvCompactGated )
+      {
+        // Yield to the other tasks between steps.
+        osal_set_event( taskId, OSAL_NV_COMPACT_EVT );
+      }
+    }
+
+    return ( events ^ OSAL_NV_COMPACT_EVT );
+  }
+
+  if ( events & OSAL_NV_FLUSH_EVT )
+  {
+    // While gated, pending items wait until the gate opens.
+    if ( !nvCompactGated )
+    {
+      VOID osal_snv_flush();
+    }
+
+    return ( events ^ OSAL_NV_FLUSH_EVT );
+  }
+
+  // Discard unknown events
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      osal_snv_compact_gate
+ *
+ * @brief   Restrict background compaction steps to windows granted with
+ *          osal_snv_compact_window(), e.g. while a connection is up.
+ *
+ * @param   gated - TRUE to run steps only in granted windows,
+ *                  FALSE to run them whenever the task is scheduled.
+ *
+ * @return  none
+ */
+void osal_snv_compact_gate( uint8 gated )
+{
+  nvCompactGated = gated;
+  nvCompactWindow = FALSE;
+
+  if ( !gated && (nvCompactState != NV_COMPACT_IDLE) )
+  {
+    osal_set_event( nvCompactTaskId, OSAL_NV_COMPACT_EVT );
+  }
+
+#if OSAL_SNV_CACHE_CNT
+  if ( !gated )
+  {
+    // Write out what was held back while gated.
+    osal_set_event( nvCompactTaskId, OSAL_NV_FLUSH_EVT );
+  }
+#endif
+}
+
+/*********************************************************************
+ * @fn      osal_snv_compact_window
+ *
+ * @brief   Grant one background compaction step while gated. Call it
+ *          when the radio has time to spare, e.g. right after a
+ *          connection event.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osal_snv_compact_window( void )
+{
+  if ( nvCompactGated && (nvCompactState != NV_COMPACT_IDLE) )
+  {
+    nvCompactWindow = TRUE;
+    osal_set_event( nvCompactTaskId, OSAL_NV_COMPACT_EVT );
+  }
+}
+#endif
+
 /*********************************************************************
 *********************************************************************/
@@ -54,6 +54,10 @@
   #include "osal_cbTimer.h"
 #endif
 
+#if defined ( OSAL_SNV_COMPACT_TASK )
+  #include "osal_snv.h"
+#endif
+
 /* L2CAP */
 #include "l2cap.h"
 
@@ -95,6 +99,9 @@ const pTaskEventHandlerFn tasksArr[] =
   GAPBondMgr_ProcessEvent,
   GATTServApp_ProcessEvent,
   HeartRate_ProcessEvent
+#if defined ( OSAL_SNV_COMPACT_TASK )
+  , osal_snv_CompactProcessEvent
+#endif
 };
 
 const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
@@ -154,7 +161,12 @@ void osalInitTasks( void )
   GATTServApp_Init( taskID++ );
   
   /* Application */
-  HeartRate_Init( taskID );
+  HeartRate_Init( taskID++ );
+
+#if defined ( OSAL_SNV_COMPACT_TASK )
+  /* NV Compaction Task */
+  osal_snv_CompactInit( taskID );
+#endif
 }
 
 /*********************************************************************
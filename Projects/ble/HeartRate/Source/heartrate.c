@@ -44,6 +44,7 @@ Copyright 2011 Texas Instruments Incorporated. All rights reserved.
 #include "bcomdef.h"
 #include "OSAL.h"
 #include "OnBoard.h"
+#include "osal_snv.h"
 #include "hal_led.h"
 #include "hal_key.h"
 #include "gatt.h"
@@ -109,6 +110,9 @@ Copyright 2011 Texas Instruments Incorporated. All rights reserved.
 // Battery measurement period in ms
 #define DEFAULT_BATT_PERIOD                   15000
 
+// How late in ms a battery measurement may run to share a wakeup with other work
+#define DEFAULT_BATT_SLACK                    2000
+
 // Some values used to simulate measurements
 #define BPM_DEFAULT                           73
 #define BPM_MAX                               80
@@ -565,6 +569,9 @@ static void HeartRateGapStateCB( gaprole_States_t newState )
   {
     // get connection handle
     GAPRole_GetParameter(GAPROLE_CONNHANDLE, &gapConnHandle);
+
+    // compact NV only in the gaps left by the periodic task
+    osal_snv_compact_gate( TRUE );
   }
   // if disconnected
   else if (gapProfileState == GAPROLE_CONNECTED && 
@@ -575,6 +582,9 @@ static void HeartRateGapStateCB( gaprole_States_t newState )
     // stop periodic measurement
     osal_stop_timerEx( heartRate_TaskID, HEART_PERIODIC_EVT );
 
+    // NV may be compacted freely again
+    osal_snv_compact_gate( FALSE );
+
     // reset client characteristic configuration descriptors
     uint16 param = GATT_CFG_NO_OPERATION;
     HeartRate_SetParameter(HEARTRATE_MEAS_CHAR_CFG, sizeof(uint16), (uint8 *) &param);
@@ -687,7 +697,7 @@ static void heartRateBattCB(uint8 event)
     // if connected start periodic measurement
     if (gapProfileState == GAPROLE_CONNECTED)
     {
-      osal_start_timerEx( heartRate_TaskID, BATT_PERIODIC_EVT, DEFAULT_BATT_PERIOD );
+      osal_start_timerEx_slack( heartRate_TaskID, BATT_PERIODIC_EVT, DEFAULT_BATT_PERIOD, DEFAULT_BATT_SLACK );
     } 
   }
   else if (event == BATT_LEVEL_NOTI_DISABLED)
@@ -712,6 +722,9 @@ static void heartRatePeriodicTask( void )
   {
     // send heart rate measurement notification
     heartRateMeasNotify();
+
+    // allow one bounded NV compaction step per measurement period
+    osal_snv_compact_window();
     
     // Restart timer
     osal_start_timerEx( heartRate_TaskID, HEART_PERIODIC_EVT, DEFAULT_HEARTRATE_PERIOD );
@@ -735,7 +748,7 @@ static void heartRateBattPeriodicTask( void )
     Batt_MeasLevel( );
     
     // Restart timer
-    osal_start_timerEx( heartRate_TaskID, BATT_PERIODIC_EVT, DEFAULT_BATT_PERIOD );
+    osal_start_timerEx_slack( heartRate_TaskID, BATT_PERIODIC_EVT, DEFAULT_BATT_PERIOD, DEFAULT_BATT_SLACK );
   }
 }
 
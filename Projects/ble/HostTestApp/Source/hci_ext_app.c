@@ -64,20 +64,33 @@
 #endif
 
 #include "OnBoard.h"
+#include "OSAL_PwrMgr.h"
+#include "osal_bufmgr.h"
 #include "hci_ext_app.h"
 
 /*********************************************************************
  * MACROS
  */
 
+#if ( HCI_EXT_APP_COPY_STATS == TRUE )
+  #define HCI_EXT_COPY_CNT( len )        ( hciExtCopyCnt += (len) )
+  #define HCI_EXT_SENT_CNT( len )        ( hciExtSentCnt += (len) )
+#else
+  #define HCI_EXT_COPY_CNT( len )
+  #define HCI_EXT_SENT_CNT( len )
+#endif
+
 /*********************************************************************
  * CONSTANTS
  */
 
 #define HCI_EXT_RESET_EVENT              0x0001
 #define HCI_EXT_SOFT_RESET_EVENT         0x0002
+#define HCI_EXT_COALESCE_EVENT           0x0004
+#define HCI_EXT_TX_RETRY_EVENT           0x0008
 
 #define RESET_TIMEOUT                    100   // 100 milliseconds
+#define TX_RETRY_TIMEOUT                 2     // 2 milliseconds
 
 #define RSP_PAYLOAD_IDX                  6
 #define MAX_RSP_DATA_LEN                 50
@@ -87,6 +100,63 @@
   #define HCI_EXT_APP_OUT_BUF            40
 #endif
 
+// Write outgoing events to the UART as complete HCI frames, rather than
+// passing them to HCI_SendControllerToHostEvent() which copies them again.
+// Allocated events are handed to the UART and sent without being copied.
+// Every event of this module, command status and command complete events
+// included, then takes this one path and reaches the host in the order it
+// was sent; an event the UART cannot take yet is queued, and later events
+// wait behind it. With an ISR UART, the TX buffer must hold 258 bytes.
+#if !defined ( HCI_EXT_APP_UART_TX )
+  #define HCI_EXT_APP_UART_TX            FALSE
+#endif
+
+// Count the event bytes copied on their way to the UART
+#if !defined ( HCI_EXT_APP_COPY_STATS )
+  #define HCI_EXT_APP_COPY_STATS         FALSE
+#endif
+
+// Collect notifications and read responses into HCI_EXT_GATT_COALESCED_EVENT
+// frames, once enabled by the host with HCI_EXT_UTIL_GATT_COALESCE
+#if !defined ( HCI_EXT_APP_GATT_COALESCE )
+  #define HCI_EXT_APP_GATT_COALESCE      FALSE
+#endif
+
+// Longest coalesced event (at most 255); the host may configure a lower cap
+#if !defined ( HCI_EXT_APP_COALESCE_MAX )
+  #define HCI_EXT_APP_COALESCE_MAX       200
+#endif
+
+// Default time a coalesced record may wait for others, in milliseconds
+#if !defined ( HCI_EXT_APP_COALESCE_WINDOW )
+  #define HCI_EXT_APP_COALESCE_WINDOW    5
+#endif
+
+// Room kept in front of every outgoing event for the HCI event header
+// (packet type, event code and parameter length)
+#define HCI_EXT_FRAME_HDR_LEN            3
+
+// Room kept in front of every allocated event; with HCI_EXT_APP_UART_TX it
+// also holds the UART descriptor that sends the event in place
+#if ( HCI_EXT_APP_UART_TX == TRUE )
+  #define HCI_EXT_FRAME_ROOM             ( sizeof( halUARTTxDesc_t ) + HCI_EXT_FRAME_HDR_LEN )
+#else
+  #define HCI_EXT_FRAME_ROOM             HCI_EXT_FRAME_HDR_LEN
+#endif
+
+// Number of preallocated frames for events that do not fit in out_msg. Each
+// holds the longest event, so building events takes nothing from the heap.
+// With 0, those events are allocated from the buffer manager instead.
+#if !defined ( HCI_EXT_APP_FRAME_POOL )
+  #define HCI_EXT_APP_FRAME_POOL         0
+#endif
+
+// Longest outgoing event
+#define HCI_EXT_EVENT_MAX_LEN            0xFF
+
+// Maximum number of segments an outgoing event can reference
+#define HCI_EXT_CHAIN_MAX                2
+
 #define KEYDIST_SENC                     0x01
 #define KEYDIST_SID                      0x02
 #define KEYDIST_SSIGN                    0x04
@@ -96,6 +166,12 @@
 
 #define HCI_EXT_HDR_LEN                  5
 
+// Opcode and parameter length of a vendor command frame
+#define HCI_EXT_CMD_HDR_LEN              3
+
+// Connection handle, method and PDU length in front of a coalesced PDU
+#define HCI_EXT_COALESCE_REC_HDR_LEN     4
+
 // Maximum number of reliable writes supported by Attribute Client
 #define GATT_MAX_NUM_RELIABLE_WRITES     5
 
@@ -110,6 +186,40 @@ typedef struct
   uint8  *pData;
 } hciExtCmd_t;
 
+// Segments appended to an outgoing event by reference. They are copied just
+// once, straight behind the event's head, when the event is sent.
+typedef struct
+{
+  uint8 cnt;
+  uint8 *pData[HCI_EXT_CHAIN_MAX];
+  uint8 len[HCI_EXT_CHAIN_MAX];
+} hciExtChain_t;
+
+#if ( HCI_EXT_APP_FRAME_POOL > 0 )
+// Preallocated event frame; the event starts HCI_EXT_FRAME_ROOM into buf
+typedef union hciExtFrame
+{
+  union hciExtFrame *next;   // Free list link while the frame is not in use
+  uint8 buf[HCI_EXT_FRAME_ROOM + HCI_EXT_EVENT_MAX_LEN];
+} hciExtFrame_t;
+#endif
+
+#if ( HCI_EXT_APP_GATT_COALESCE == TRUE )
+// Pending coalesced event and its counters
+typedef struct
+{
+  uint8  enabled;
+  uint8  window;      // Milliseconds the first record may wait
+  uint8  maxLen;      // Event length cap
+  uint8  cnt;         // Records in the pending event
+  uint8  len;         // Length of the pending event
+  uint32 start;       // System clock when the first record came in
+  uint32 records;     // Records sent in coalesced events
+  uint32 frames;      // Coalesced events sent
+  uint16 maxLatency;  // Longest wait of a first record, in milliseconds
+} hciExtCoalesce_t;
+#endif
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -129,8 +239,55 @@ uint8 hciExtApp_TaskID;   // Task ID for internal task/event processing
 
 uint32 hciExtSignCounter = 0;
 
-static uint8 out_msg[HCI_EXT_APP_OUT_BUF];
-uint8 rspBuf[MAX_RSP_BUF];
+// Outgoing event buffer, with room for the HCI event header in front
+static uint8 out_frame[HCI_EXT_FRAME_HDR_LEN + HCI_EXT_APP_OUT_BUF];
+static uint8 * const out_msg = &out_frame[HCI_EXT_FRAME_HDR_LEN];
+
+// Command status event buffer, with room for the HCI event header in front
+static uint8 rspFrame[HCI_EXT_FRAME_HDR_LEN + MAX_RSP_BUF];
+static uint8 * const rspBuf = &rspFrame[HCI_EXT_FRAME_HDR_LEN];
+
+// Segments referenced by the event being built
+static hciExtChain_t outChain;
+
+#if ( HCI_EXT_APP_FRAME_POOL > 0 )
+  // Event frame pool and its occupancy
+  static hciExtFrame_t frameBuf[HCI_EXT_APP_FRAME_POOL];
+  static hciExtFrame_t *frameFree = NULL;
+  static uint8 frameUsed = 0;
+  static uint8 frameMax = 0;
+  static uint16 frameExhausted = 0;   // Events that found the pool empty
+#endif
+
+#if ( HCI_EXT_APP_GATT_COALESCE == TRUE )
+  // Coalesced event being filled, with room for the HCI event header in front
+  static uint8 coalesceFrame[HCI_EXT_FRAME_HDR_LEN + HCI_EXT_APP_COALESCE_MAX];
+  static uint8 * const coalesceMsg = &coalesceFrame[HCI_EXT_FRAME_HDR_LEN];
+  static hciExtCoalesce_t coalesce =
+  {
+    FALSE,                        // enabled
+    HCI_EXT_APP_COALESCE_WINDOW,  // window
+    HCI_EXT_APP_COALESCE_MAX,     // maxLen
+    0,                            // cnt
+    0,                            // len
+    0,                            // start
+    0,                            // records
+    0,                            // frames
+    0                             // maxLatency
+  };
+#endif
+
+#if ( HCI_EXT_APP_UART_TX == TRUE )
+  // Events waiting for room in the UART, oldest first
+  static halUARTTxDesc_t *txPendHead = NULL;
+  static halUARTTxDesc_t *txPendTail = NULL;
+#endif
+
+#if ( HCI_EXT_APP_COPY_STATS == TRUE )
+  // Event bytes copied by this module or the HCI transport, and bytes sent
+  static uint32 hciExtCopyCnt = 0;
+  static uint32 hciExtSentCnt = 0;
+#endif
 
 // The device's local keys
 static uint8 IRK[KEYLEN] = {0};
@@ -165,6 +322,9 @@ static uint8 SRK[KEYLEN] = {0};
  * LOCAL FUNCTION PROTOTYPES
  */
 static uint8 processExtMsg( hciPacket_t *pMsg );
+static uint8 hciExtCmdParse( uint8 *pBuf, uint16 len, hciExtCmd_t *pCmd );
+static uint8 processExtCmd( hciExtCmd_t *pCmd, uint8 *pRspDataLen );
+static uint8 processExMsgBatch( hciExtCmd_t *pCmd, uint8 *pRspDataLen );
 static uint8 processExMsgUTIL( uint8 cmdID, hciExtCmd_t *pCmd, uint8 *pRspDataLen );
 static uint8 checkNVLen( osalSnvId_t id, osalSnvLen_t len );
 static uint8 processExMsgL2CAP( uint8 cmdID, hciExtCmd_t *pCmd );
@@ -179,6 +339,21 @@ static uint8 *processEventsGATT( gattMsgEvent_t *pPkt, uint8 *pMsg, uint8 *pMsgL
 
 static uint8 buildHCIExtHeader( uint8 *pBuf, uint16 event, uint8 status, uint16 connHandle );
 
+static uint8 *hciExtEventAlloc( uint8 len );
+static void hciExtEventFree( uint8 *pBuf );
+static void hciExtChainAppend( uint8 *pData, uint8 len, uint8 headLen );
+static uint8 *hciExtChainGather( uint8 *pHead, uint8 *pLen, uint8 *pAllocated );
+static uint8 hciExtEventSend( uint8 eventCode, uint8 *pBuf, uint8 len, uint8 allocated );
+static void hciExtCmdCompleteSend( uint16 opCode, uint8 len, uint8 *pParam );
+#if ( HCI_EXT_APP_UART_TX == TRUE )
+static void hciExtEventTxPoll( void );
+static void hciExtEventTxDone( halUARTTxDesc_t *pDesc );
+#endif
+#if ( HCI_EXT_APP_GATT_COALESCE == TRUE )
+static uint8 hciExtCoalesceAdd( uint8 *pEvt );
+static void hciExtCoalesceFlush( void );
+#endif
+
 /*********************************************************************
  * @fn      HCI_EXT_App_Init
  *
@@ -195,6 +370,17 @@ static uint8 buildHCIExtHeader( uint8 *pBuf, uint16 event, uint8 status, uint16
  */
 void HCI_EXT_App_Init( uint8 task_id )
 {
+#if ( HCI_EXT_APP_FRAME_POOL > 0 )
+  uint8 i;
+
+  // Chain all the event frames onto the free list
+  for ( i = 0; i < HCI_EXT_APP_FRAME_POOL; i++ )
+  {
+    frameBuf[i].next = frameFree;
+    frameFree = &frameBuf[i];
+  }
+#endif
+
   hciExtApp_TaskID = task_id;
 
   HCI_ExtTaskRegister( hciExtApp_TaskID );
@@ -289,7 +475,7 @@ uint16 HCI_EXT_App_ProcessEvent( uint8 task_id, uint16 events )
 
               len = (uint8)(msgHdr->len - sizeof ( hciEvt_CmdComplete_t ));
 
-              HCI_SendCommandCompleteEvent( HCI_COMMAND_COMPLETE_EVENT_CODE, pkt->cmdOpcode, len, pkt->pReturnParam );
+              hciExtCmdCompleteSend( pkt->cmdOpcode, len, pkt->pReturnParam );
             }
           }
           break;
@@ -318,6 +504,26 @@ uint16 HCI_EXT_App_ProcessEvent( uint8 task_id, uint16 events )
     return ( events ^ GAP_EVENT_SIGN_COUNTER_CHANGED );
   }
 
+#if ( HCI_EXT_APP_GATT_COALESCE == TRUE )
+  if ( events & HCI_EXT_COALESCE_EVENT )
+  {
+    // The coalescing window of the pending event is over
+    hciExtCoalesceFlush();
+
+    return ( events ^ HCI_EXT_COALESCE_EVENT );
+  }
+#endif
+
+#if ( HCI_EXT_APP_UART_TX == TRUE )
+  if ( events & HCI_EXT_TX_RETRY_EVENT )
+  {
+    // Offer the queued events to the UART again
+    hciExtEventTxPoll();
+
+    return ( events ^ HCI_EXT_TX_RETRY_EVENT );
+  }
+#endif
+
   if ( events & HCI_EXT_RESET_EVENT )
   {
     SystemReset();
@@ -355,34 +561,106 @@ static uint8 processExtMsg( hciPacket_t *pMsg )
   hciExtCmd_t msg;
   uint8 *pBuf = pMsg->pData;
 
-  // Parse the header
+  // Parse the header; the HCI transport has already framed the command
   msg.pktType = *pBuf++;
-  msg.opCode = BUILD_UINT16( pBuf[0], pBuf[1] );
-  pBuf += 2;
+  VOID hciExtCmdParse( pBuf, (HCI_EXT_CMD_HDR_LEN + pBuf[2]), &msg );
+
+  if ( (msg.opCode >> 7) == HCI_EXT_UTIL_SUBGRP &&
+       (msg.opCode & 0x007F) == HCI_EXT_UTIL_BATCH )
+  {
+    stat = processExMsgBatch( &msg, &rspDataLen );
+  }
+  else
+  {
+    stat = processExtCmd( &msg, &rspDataLen );
+  }
+
+  // Deallocate here to free up heap space for the serial message set out HCI.
+  VOID osal_msg_deallocate( (uint8 *)pMsg );
+  deallocateIncoming = FALSE;
+
+  // Send back an immediate response
+  rspBuf[0] = LO_UINT16( HCI_EXT_GAP_CMD_STATUS_EVENT );
+  rspBuf[1] = HI_UINT16( HCI_EXT_GAP_CMD_STATUS_EVENT );
+  rspBuf[2] = stat;
+  rspBuf[3] = LO_UINT16( 0xFC00 | msg.opCode );
+  rspBuf[4] = HI_UINT16( 0xFC00 | msg.opCode );
+  rspBuf[5] = rspDataLen;
 
-  msg.len = *pBuf++;
-  msg.pData = pBuf;
+  // IMPORTANT!! Fill in Payload (if needed) in case statement
+
+#if ( HCI_EXT_APP_GATT_COALESCE == TRUE )
+  // Keep the events in order
+  hciExtCoalesceFlush();
+#endif
+
+  VOID hciExtEventSend( HCI_VE_EVENT_CODE, rspBuf, (6 + rspDataLen), FALSE );
+
+  return ( deallocateIncoming );
+}
+
+/*********************************************************************
+ * @fn      hciExtCmdParse
+ *
+ * @brief   Decode the vendor command frame at the start of a buffer in
+ *          place: opcode, parameter length and parameters. The parameters
+ *          are not copied, so the buffer must outlive the command.
+ *
+ * @param   pBuf - frame data
+ * @param   len - bytes available in pBuf
+ * @param   pCmd - decoded command
+ *
+ * @return  length of the frame, or 0 if pBuf does not hold a whole frame
+ */
+static uint8 hciExtCmdParse( uint8 *pBuf, uint16 len, hciExtCmd_t *pCmd )
+{
+  if ( (len < HCI_EXT_CMD_HDR_LEN) || (len < (HCI_EXT_CMD_HDR_LEN + pBuf[2])) )
+  {
+    return ( 0 );
+  }
+
+  // Keep the OCF; the OGF is always the vendor specific 0x3F
+  pCmd->opCode = BUILD_UINT16( pBuf[0], pBuf[1] ) & 0x03FF;
+  pCmd->len = pBuf[2];
+  pCmd->pData = &pBuf[HCI_EXT_CMD_HDR_LEN];
+
+  return ( HCI_EXT_CMD_HDR_LEN + pCmd->len );
+}
+
+/*********************************************************************
+ * @fn      processExtCmd
+ *
+ * @brief   Run a decoded HCI extension command.
+ *
+ * @param   pCmd - decoded command
+ * @param   pRspDataLen - length of the response payload in rspBuf
+ *
+ * @return  SUCCESS, INVALIDPARAMETER, FAILURE or the command's status
+ */
+static uint8 processExtCmd( hciExtCmd_t *pCmd, uint8 *pRspDataLen )
+{
+  uint8 stat;
 
-  switch( msg.opCode >> 7 )
+  switch( pCmd->opCode >> 7 )
   {
     case HCI_EXT_L2CAP_SUBGRP:
-      stat = processExMsgL2CAP( (msg.opCode & 0x007F), &msg );
+      stat = processExMsgL2CAP( (pCmd->opCode & 0x007F), pCmd );
       break;
 
     case HCI_EXT_ATT_SUBGRP:
-      stat = processExMsgATT( (msg.opCode & 0x007F), &msg );
+      stat = processExMsgATT( (pCmd->opCode & 0x007F), pCmd );
       break;
 
     case HCI_EXT_GATT_SUBGRP:
-      stat = processExMsgGATT( (msg.opCode & 0x007F), &msg );
+      stat = processExMsgGATT( (pCmd->opCode & 0x007F), pCmd );
       break;
 
     case HCI_EXT_GAP_SUBGRP:
-      stat = processExMsgGAP( (msg.opCode & 0x007F), &msg, &rspDataLen );
+      stat = processExMsgGAP( (pCmd->opCode & 0x007F), pCmd, pRspDataLen );
       break;
 
     case HCI_EXT_UTIL_SUBGRP:
-      stat = processExMsgUTIL( (msg.opCode & 0x007F), &msg, &rspDataLen );
+      stat = processExMsgUTIL( (pCmd->opCode & 0x007F), pCmd, pRspDataLen );
       break;
 
     default:
@@ -390,23 +668,95 @@ static uint8 processExtMsg( hciPacket_t *pMsg )
       break;
   }
 
-  // Deallocate here to free up heap space for the serial message set out HCI.
-  VOID osal_msg_deallocate( (uint8 *)pMsg );
-  deallocateIncoming = FALSE;
+  return ( stat );
+}
 
-  // Send back an immediate response
-  rspBuf[0] = LO_UINT16( HCI_EXT_GAP_CMD_STATUS_EVENT );
-  rspBuf[1] = HI_UINT16( HCI_EXT_GAP_CMD_STATUS_EVENT );
-  rspBuf[2] = stat;
-  rspBuf[3] = LO_UINT16( 0xFC00 | msg.opCode );
-  rspBuf[4] = HI_UINT16( 0xFC00 | msg.opCode );
-  rspBuf[5] = rspDataLen;
+/*********************************************************************
+ * @fn      processExMsgBatch
+ *
+ * @brief   Run the sub-commands of an HCI_EXT_UTIL_BATCH command in
+ *          order, decoding each in place. Only the batch gets a command
+ *          status, so sub-command responses are dropped; events they
+ *          cause later are still sent. Batches do not nest.
+ *
+ *          The response payload is the number of sub-commands run, the
+ *          number that failed and the opcode of the first failure.
+ *
+ * @param   pCmd - batch command
+ * @param   pRspDataLen - length of the response payload in rspBuf
+ *
+ * @return  SUCCESS, INVALIDPARAMETER for a malformed batch, or the
+ *          status of the first failed sub-command
+ */
+static uint8 processExMsgBatch( hciExtCmd_t *pCmd, uint8 *pRspDataLen )
+{
+  uint8 *pBuf = pCmd->pData;
+  uint8 left = pCmd->len;
+  uint8 stat = SUCCESS;
+  uint8 options;
+  uint8 runCnt = 0;
+  uint8 failCnt = 0;
+  uint16 failOpCode = 0;
+  hciExtCmd_t sub;
 
-  // IMPORTANT!! Fill in Payload (if needed) in case statement
+  if ( (left == 0) || (pBuf[0] > HCI_EXT_BATCH_CONTINUE_ON_ERROR) )
+  {
+    return ( INVALIDPARAMETER );
+  }
 
-  HCI_SendControllerToHostEvent( HCI_VE_EVENT_CODE, (6 + rspDataLen), rspBuf );
+  options = *pBuf++;
+  left--;
 
-  return ( deallocateIncoming );
+  sub.pktType = pCmd->pktType;
+
+  while ( left )
+  {
+    uint8 frameLen = hciExtCmdParse( pBuf, left, &sub );
+    uint8 subStat;
+    uint8 subRspLen = 0;
+
+    if ( frameLen == 0 )
+    {
+      // Truncated sub-command, reported with opcode 0
+      sub.opCode = 0;
+      subStat = INVALIDPARAMETER;
+    }
+    else if ( ((sub.opCode >> 7) == HCI_EXT_UTIL_SUBGRP) &&
+              ((sub.opCode & 0x007F) == HCI_EXT_UTIL_BATCH) )
+    {
+      subStat = INVALIDPARAMETER;
+    }
+    else
+    {
+      subStat = processExtCmd( &sub, &subRspLen );
+      runCnt++;
+    }
+
+    if ( subStat != SUCCESS )
+    {
+      if ( failCnt++ == 0 )
+      {
+        stat = subStat;
+        failOpCode = (sub.opCode != 0) ? (0xFC00 | sub.opCode) : 0;
+      }
+
+      if ( (frameLen == 0) || (options == HCI_EXT_BATCH_STOP_ON_ERROR) )
+      {
+        break;
+      }
+    }
+
+    pBuf += frameLen;
+    left -= frameLen;
+  }
+
+  rspBuf[RSP_PAYLOAD_IDX]   = runCnt;
+  rspBuf[RSP_PAYLOAD_IDX+1] = failCnt;
+  rspBuf[RSP_PAYLOAD_IDX+2] = LO_UINT16( failOpCode );
+  rspBuf[RSP_PAYLOAD_IDX+3] = HI_UINT16( failOpCode );
+  *pRspDataLen = 4;
+
+  return ( stat );
 }
 
 /*********************************************************************
@@ -474,10 +824,314 @@ static uint8 processExMsgUTIL( uint8 cmdID, hciExtCmd_t *pCmd, uint8 *pRspDataLe
         }
         else
         {
-          stat = INVALIDPARAMETER;
+          stat = INVALIDPARAMETER;
+        }
+      }
+      break;
+
+#if ( OSALMEM_TRACE )
+    case HCI_EXT_UTIL_HEAP_TRACE:
+      {
+        uint8 *pRsp = &rspBuf[RSP_PAYLOAD_IDX];
+
+        switch ( pBuf[0] )
+        {
+          case HCI_EXT_HEAP_TRACE_STATS:
+            {
+              uint16 freeLen;
+              uint16 maxLen;
+              uint16 dropped = osal_mem_trace_dropped();
+
+              pRsp[0] = osal_heap_frag( &freeLen, &maxLen );
+              pRsp[1] = LO_UINT16( freeLen );
+              pRsp[2] = HI_UINT16( freeLen );
+              pRsp[3] = LO_UINT16( maxLen );
+              pRsp[4] = HI_UINT16( maxLen );
+              pRsp[5] = LO_UINT16( dropped );
+              pRsp[6] = HI_UINT16( dropped );
+
+              *pRspDataLen = 7;
+            }
+            break;
+
+          case HCI_EXT_HEAP_TRACE_READ:
+            // Record count followed by as many records as fit in the fixed buffer
+            pRsp[0] = osal_mem_trace_read( &pRsp[1], (MAX_RSP_DATA_LEN - 1) / OSALMEM_TRACE_RECSZ );
+            *pRspDataLen = 1 + (pRsp[0] * OSALMEM_TRACE_RECSZ);
+            break;
+
+          case HCI_EXT_HEAP_TRACE_ENABLE:
+            osal_mem_trace_enable( pBuf[1] );
+            break;
+
+          default:
+            stat = INVALIDPARAMETER;
+            break;
+        }
+      }
+      break;
+#endif // OSALMEM_TRACE
+
+#if ( OSAL_RUN_TRACE )
+    case HCI_EXT_UTIL_RUN_TRACE:
+      {
+        uint8 *pRsp = &rspBuf[RSP_PAYLOAD_IDX];
+
+        switch ( pBuf[0] )
+        {
+          case HCI_EXT_RUN_TRACE_STATS:
+            {
+              uint16 dropped = osal_run_trace_dropped();
+
+              pRsp[0] = LO_UINT16( dropped );
+              pRsp[1] = HI_UINT16( dropped );
+
+              *pRspDataLen = 2;
+            }
+            break;
+
+          case HCI_EXT_RUN_TRACE_READ:
+            // Record count followed by as many records as fit in the fixed buffer
+            pRsp[0] = osal_run_trace_read( &pRsp[1], (MAX_RSP_DATA_LEN - 1) / OSAL_RUN_TRACE_RECSZ );
+            *pRspDataLen = 1 + (pRsp[0] * OSAL_RUN_TRACE_RECSZ);
+            break;
+
+          case HCI_EXT_RUN_TRACE_ENABLE:
+            osal_run_trace_enable( pBuf[1] );
+            break;
+
+          default:
+            stat = INVALIDPARAMETER;
+            break;
+        }
+      }
+      break;
+#endif // OSAL_RUN_TRACE
+
+#if ( OSAL_RUN_STATS )
+    case HCI_EXT_UTIL_RUN_STATS:
+      {
+        uint8 *pRsp = &rspBuf[RSP_PAYLOAD_IDX];
+        osalRunStats_t stats;
+
+        if ( pBuf[0] == HCI_EXT_RUN_STATS_BUDGET )
+        {
+          stat = osal_run_budget( pBuf[1], BUILD_UINT16( pBuf[2], pBuf[3] ) );
+          break;
+        }
+        else if ( pBuf[0] > HCI_EXT_RUN_STATS_RESET )
+        {
+          stat = INVALIDPARAMETER;
+          break;
+        }
+
+        stat = osal_run_stats( pBuf[1], &stats );
+        if ( stat != SUCCESS )
+        {
+          break;
+        }
+
+        pRsp[0]  = LO_UINT16( stats.runs );
+        pRsp[1]  = HI_UINT16( stats.runs );
+        pRsp[2]  = LO_UINT16( stats.avg );
+        pRsp[3]  = HI_UINT16( stats.avg );
+        pRsp[4]  = LO_UINT16( stats.max );
+        pRsp[5]  = HI_UINT16( stats.max );
+        pRsp[6]  = LO_UINT16( stats.maxEvents );
+        pRsp[7]  = HI_UINT16( stats.maxEvents );
+        pRsp[8]  = LO_UINT16( stats.overruns );
+        pRsp[9]  = HI_UINT16( stats.overruns );
+        pRsp[10] = LO_UINT16( stats.budget );
+        pRsp[11] = HI_UINT16( stats.budget );
+
+        *pRspDataLen = 12;
+
+        if ( pBuf[0] == HCI_EXT_RUN_STATS_RESET )
+        {
+          (void)osal_run_stats_reset( pBuf[1] );
+        }
+      }
+      break;
+#endif // OSAL_RUN_STATS
+
+#if ( OSAL_PWRMGR_STATS )
+    case HCI_EXT_UTIL_PWR_STATS:
+      {
+        uint8 *pRsp = &rspBuf[RSP_PAYLOAD_IDX];
+        uint8 i;
+
+        switch ( pBuf[0] )
+        {
+          case HCI_EXT_PWR_STATS_READ:
+            {
+              pwrmgr_stats_t stats;
+
+              osal_pwrmgr_stats( &stats );
+
+              for ( i = 0; i < PWRMGR_MODE_CNT; i++ )
+              {
+                *pRsp++ = BREAK_UINT32( stats.modeMSec[i], 0 );
+                *pRsp++ = BREAK_UINT32( stats.modeMSec[i], 1 );
+                *pRsp++ = BREAK_UINT32( stats.modeMSec[i], 2 );
+                *pRsp++ = BREAK_UINT32( stats.modeMSec[i], 3 );
+              }
+
+              for ( i = 0; i < PWRMGR_WAKE_CNT; i++ )
+              {
+                *pRsp++ = LO_UINT16( stats.wakes[i] );
+                *pRsp++ = HI_UINT16( stats.wakes[i] );
+              }
+
+              *pRspDataLen = (PWRMGR_MODE_CNT * 4) + (PWRMGR_WAKE_CNT * 2);
+            }
+            break;
+
+          case HCI_EXT_PWR_STATS_TASK:
+            {
+              pwrmgr_task_stats_t stats;
+
+              stat = osal_pwrmgr_task_stats( pBuf[1], &stats );
+              if ( stat == SUCCESS )
+              {
+                pRsp[0] = BREAK_UINT32( stats.awakeMSec, 0 );
+                pRsp[1] = BREAK_UINT32( stats.awakeMSec, 1 );
+                pRsp[2] = BREAK_UINT32( stats.awakeMSec, 2 );
+                pRsp[3] = BREAK_UINT32( stats.awakeMSec, 3 );
+                pRsp[4] = LO_UINT16( stats.wakes );
+                pRsp[5] = HI_UINT16( stats.wakes );
+                pRsp[6] = LO_UINT16( stats.events );
+                pRsp[7] = HI_UINT16( stats.events );
+
+                *pRspDataLen = 8;
+              }
+            }
+            break;
+
+          case HCI_EXT_PWR_STATS_RESET:
+            osal_pwrmgr_stats_reset();
+            break;
+
+          default:
+            stat = INVALIDPARAMETER;
+            break;
+        }
+      }
+      break;
+#endif // OSAL_PWRMGR_STATS
+
+#if ( HCI_EXT_APP_COPY_STATS == TRUE )
+    case HCI_EXT_UTIL_COPY_STATS:
+      {
+        uint8 *pRsp = &rspBuf[RSP_PAYLOAD_IDX];
+
+        if ( pBuf[0] > HCI_EXT_COPY_STATS_RESET )
+        {
+          stat = INVALIDPARAMETER;
+          break;
+        }
+
+        pRsp[0] = BREAK_UINT32( hciExtCopyCnt, 0 );
+        pRsp[1] = BREAK_UINT32( hciExtCopyCnt, 1 );
+        pRsp[2] = BREAK_UINT32( hciExtCopyCnt, 2 );
+        pRsp[3] = BREAK_UINT32( hciExtCopyCnt, 3 );
+        pRsp[4] = BREAK_UINT32( hciExtSentCnt, 0 );
+        pRsp[5] = BREAK_UINT32( hciExtSentCnt, 1 );
+        pRsp[6] = BREAK_UINT32( hciExtSentCnt, 2 );
+        pRsp[7] = BREAK_UINT32( hciExtSentCnt, 3 );
+
+        *pRspDataLen = 8;
+
+        if ( pBuf[0] == HCI_EXT_COPY_STATS_RESET )
+        {
+          hciExtCopyCnt = 0;
+          hciExtSentCnt = 0;
+        }
+      }
+      break;
+#endif // HCI_EXT_APP_COPY_STATS
+
+#if ( HCI_EXT_APP_GATT_COALESCE == TRUE )
+    case HCI_EXT_UTIL_GATT_COALESCE:
+      {
+        uint8 *pRsp = &rspBuf[RSP_PAYLOAD_IDX];
+
+        if ( pBuf[0] == HCI_EXT_COALESCE_CONFIG )
+        {
+          // The smallest cap still fits one empty record
+          if ( (pBuf[2] == 0) ||
+               (pBuf[3] < (HCI_EXT_HDR_LEN + 1 + HCI_EXT_COALESCE_REC_HDR_LEN)) ||
+               (pBuf[3] > HCI_EXT_APP_COALESCE_MAX) )
+          {
+            stat = INVALIDPARAMETER;
+            break;
+          }
+
+          // The pending event was collected under the old settings
+          hciExtCoalesceFlush();
+
+          coalesce.enabled = (pBuf[1] != 0);
+          coalesce.window = pBuf[2];
+          coalesce.maxLen = pBuf[3];
+        }
+        else if ( pBuf[0] > HCI_EXT_COALESCE_RESET )
+        {
+          stat = INVALIDPARAMETER;
+          break;
+        }
+
+        pRsp[0] = BREAK_UINT32( coalesce.records, 0 );
+        pRsp[1] = BREAK_UINT32( coalesce.records, 1 );
+        pRsp[2] = BREAK_UINT32( coalesce.records, 2 );
+        pRsp[3] = BREAK_UINT32( coalesce.records, 3 );
+        pRsp[4] = BREAK_UINT32( coalesce.frames, 0 );
+        pRsp[5] = BREAK_UINT32( coalesce.frames, 1 );
+        pRsp[6] = BREAK_UINT32( coalesce.frames, 2 );
+        pRsp[7] = BREAK_UINT32( coalesce.frames, 3 );
+        pRsp[8] = LO_UINT16( coalesce.maxLatency );
+        pRsp[9] = HI_UINT16( coalesce.maxLatency );
+        pRsp[10] = coalesce.enabled;
+        pRsp[11] = coalesce.window;
+        pRsp[12] = coalesce.maxLen;
+
+        *pRspDataLen = 13;
+
+        if ( pBuf[0] == HCI_EXT_COALESCE_RESET )
+        {
+          coalesce.records = 0;
+          coalesce.frames = 0;
+          coalesce.maxLatency = 0;
+        }
+      }
+      break;
+#endif // HCI_EXT_APP_GATT_COALESCE
+
+#if ( HCI_EXT_APP_FRAME_POOL > 0 )
+    case HCI_EXT_UTIL_FRAME_POOL:
+      {
+        uint8 *pRsp = &rspBuf[RSP_PAYLOAD_IDX];
+
+        if ( pBuf[0] > HCI_EXT_FRAME_POOL_RESET )
+        {
+          stat = INVALIDPARAMETER;
+          break;
+        }
+
+        pRsp[0] = HCI_EXT_APP_FRAME_POOL;
+        pRsp[1] = frameUsed;
+        pRsp[2] = frameMax;
+        pRsp[3] = LO_UINT16( frameExhausted );
+        pRsp[4] = HI_UINT16( frameExhausted );
+
+        *pRspDataLen = 5;
+
+        if ( pBuf[0] == HCI_EXT_FRAME_POOL_RESET )
+        {
+          frameMax = frameUsed;
+          frameExhausted = 0;
         }
       }
       break;
+#endif // HCI_EXT_APP_FRAME_POOL
 
     default:
       stat = FAILURE;
@@ -1600,7 +2254,8 @@ static uint8 processEvents( osal_event_hdr_t *pMsg )
   uint8 allocated = FALSE;
   uint8 deallocateIncoming;
 
-  VOID osal_memset( out_msg, 0, sizeof ( out_msg ) );
+  VOID osal_memset( out_msg, 0, HCI_EXT_APP_OUT_BUF );
+  outChain.cnt = 0;
 
   switch ( pMsg->event )
   {
@@ -1620,18 +2275,41 @@ static uint8 processEvents( osal_event_hdr_t *pMsg )
       break; // ignore
   }
 
+  // Copy any segments that still point into the incoming message
+  if ( msgLen )
+  {
+    pBuf = hciExtChainGather( pBuf, &msgLen, &allocated );
+  }
+
+#if ( HCI_EXT_APP_GATT_COALESCE == TRUE )
+  if ( msgLen )
+  {
+    if ( (pMsg->event == GATT_MSG_EVENT) && hciExtCoalesceAdd( pBuf ) )
+    {
+      // Sent later as part of a coalesced event
+      msgLen = 0;
+    }
+    else
+    {
+      // Keep the events in order
+      hciExtCoalesceFlush();
+    }
+  }
+#endif
+
   // Deallocate here to free up heap space for the serial message set out HCI.
   VOID osal_msg_deallocate( (uint8 *)pMsg );
   deallocateIncoming = FALSE;
 
-  if ( msgLen )
+  if ( msgLen && hciExtEventSend( HCI_VE_EVENT_CODE, pBuf, msgLen, allocated ) )
   {
-    HCI_SendControllerToHostEvent( HCI_VE_EVENT_CODE,  msgLen, pBuf );
+    // The UART frees the event once it is sent
+    allocated = FALSE;
   }
 
   if ( (pBuf != NULL) && (allocated == TRUE) )
   {
-    osal_mem_free( pBuf );
+    hciExtEventFree( pBuf );
   }
 
   return ( deallocateIncoming );
@@ -1690,39 +2368,20 @@ static uint8 *processEventsGAP( gapEventHdr_t *pMsg, uint8 *pOutMsg, uint8 *pMsg
 
         if ( (pPkt->hdr.status == SUCCESS) && (pPkt->numDevs > 0) )
         {
-          uint8 x;
-          gapDevRec_t *devList = pPkt->pDevList;
+          // Report as many devices as fit in one event
+          uint8 numDevs = MIN( pPkt->numDevs, (0xFF - 4) / sizeof ( gapDevRec_t ) );
 
-          // Calculate buffer needed
+          // Fill in header
+          pOutMsg[0] = LO_UINT16( HCI_EXT_GAP_DEVICE_DISCOVERY_EVENT );
+          pOutMsg[1] = HI_UINT16( HCI_EXT_GAP_DEVICE_DISCOVERY_EVENT );
+          pOutMsg[2] = pPkt->hdr.status;
+          pOutMsg[3] = numDevs;
+          pBuf = pOutMsg;
           msgLen = 4; // Size of opCode, status and numDevs field
-          msgLen += (pPkt->numDevs * 8); // Num devices * (eventType, addrType, addr)
-
-          pBuf = osal_mem_alloc( msgLen );
-          if ( pBuf )
-          {
-            uint8 *buf = pBuf;
 
-            // Fill in header
-            *buf++ = LO_UINT16( HCI_EXT_GAP_DEVICE_DISCOVERY_EVENT );
-            *buf++ = HI_UINT16( HCI_EXT_GAP_DEVICE_DISCOVERY_EVENT );
-            *buf++ = pPkt->hdr.status;
-            *buf++ = pPkt->numDevs;
-
-            devList = pPkt->pDevList;
-            for ( x = 0; x < pPkt->numDevs; x++, devList++ )
-            {
-              *buf++ = devList->eventType;
-              *buf++ = devList->addrType;
-              VOID osal_memcpy( buf, devList->addr, B_ADDR_LEN );
-              buf += B_ADDR_LEN;
-            }
-
-            *pAllocated = TRUE;
-          }
-          else
-          {
-            pPkt->hdr.status = bleMemAllocError;
-          }
+          // The device records (eventType, addrType, addr) already have the
+          // event layout, so they are sent from the list as they are
+          hciExtChainAppend( (uint8 *)pPkt->pDevList, (numDevs * sizeof ( gapDevRec_t )), msgLen );
         }
 
         if ( (pPkt->hdr.status != SUCCESS) || (pPkt->numDevs == 0) )
@@ -1908,7 +2567,7 @@ static uint8 *processEventsGAP( gapEventHdr_t *pMsg, uint8 *pOutMsg, uint8 *pMsg
 
         msgLen = 106;
 
-        pBuf = osal_mem_alloc( msgLen );
+        pBuf = hciExtEventAlloc( msgLen );
         if ( pBuf )
         {
           uint8 *buf = pBuf;
@@ -2070,33 +2729,26 @@ static uint8 *processEventsGAP( gapEventHdr_t *pMsg, uint8 *pOutMsg, uint8 *pMsg
       {
         gapDeviceInfoEvent_t *pPkt = (gapDeviceInfoEvent_t *)pMsg;
 
-        msgLen = 13 + pPkt->dataLen;
+        uint8 *buf = pOutMsg;
 
-        pBuf = osal_mem_alloc( msgLen );
-        if ( pBuf )
-        {
-          uint8 *buf = pBuf;
+        // Fill in header
+        *buf++ = LO_UINT16( HCI_EXT_GAP_DEVICE_INFO_EVENT );
+        *buf++ = HI_UINT16( HCI_EXT_GAP_DEVICE_INFO_EVENT );
+        *buf++ = pPkt->hdr.status;
+        *buf++ = pPkt->eventType;
+        *buf++ = pPkt->addrType;
 
-          // Fill in header
-          *buf++ = LO_UINT16( HCI_EXT_GAP_DEVICE_INFO_EVENT );
-          *buf++ = HI_UINT16( HCI_EXT_GAP_DEVICE_INFO_EVENT );
-          *buf++ = pPkt->hdr.status;
-          *buf++ = pPkt->eventType;
-          *buf++ = pPkt->addrType;
+        VOID osal_memcpy( buf, pPkt->addr, B_ADDR_LEN );
+        buf += B_ADDR_LEN;
 
-          VOID osal_memcpy( buf, pPkt->addr, B_ADDR_LEN );
-          buf += B_ADDR_LEN;
+        *buf++ = (uint8)pPkt->rssi;
+        *buf = pPkt->dataLen;
 
-          *buf++ = (uint8)pPkt->rssi;
-          *buf++ = pPkt->dataLen;
-          VOID osal_memcpy( buf, pPkt->pEvtData, pPkt->dataLen );
+        pBuf = pOutMsg;
+        msgLen = 13;
 
-          *pAllocated = TRUE;
-        }
-        else
-        {
-          pPkt->hdr.status = bleMemAllocError;
-        }
+        // The advertising data follows by reference
+        hciExtChainAppend( pPkt->pEvtData, pPkt->dataLen, msgLen );
       }
       break;
 
@@ -2293,6 +2945,9 @@ static uint8 *processEventsGATT( gattMsgEvent_t *pPkt, uint8 *pMsg, uint8 *pMsgL
     }
   }
 
+  // The PDU has been copied into the event once, by the ATT build function
+  HCI_EXT_COPY_CNT( msgLen );
+
   // Build the message header
   VOID buildHCIExtHeader( pBuf, (HCI_EXT_ATT_EVENT | pPkt->method), pPkt->hdr.status, pPkt->connHandle );
 
@@ -2327,5 +2982,456 @@ static uint8 buildHCIExtHeader( uint8 *pBuf, uint16 event, uint8 status, uint16
   return ( HCI_EXT_HDR_LEN );
 }
 
+/*********************************************************************
+ * @fn      hciExtEventAlloc
+ *
+ * @brief   Allocate a buffer for an outgoing event that does not fit in
+ *          out_msg. Room for the HCI event header, and for the UART
+ *          descriptor with HCI_EXT_APP_UART_TX, is kept in front of it.
+ *          With HCI_EXT_APP_FRAME_POOL, the buffer is a preallocated frame
+ *          and the heap is never used.
+ *
+ * @param   len - event length
+ *
+ * @return  event buffer, or NULL if out of memory
+ */
+static uint8 *hciExtEventAlloc( uint8 len )
+{
+#if ( HCI_EXT_APP_FRAME_POOL > 0 )
+  hciExtFrame_t *pFrame = frameFree;
+
+  VOID len;   // Every frame holds the longest event
+
+  if ( pFrame == NULL )
+  {
+    if ( frameExhausted != 0xFFFF )
+    {
+      frameExhausted++;
+    }
+
+    return ( NULL );
+  }
+
+  frameFree = pFrame->next;
+  if ( ++frameUsed > frameMax )
+  {
+    frameMax = frameUsed;
+  }
+
+  return ( &pFrame->buf[HCI_EXT_FRAME_ROOM] );
+#else
+  uint8 *pBuf = osal_bm_alloc( HCI_EXT_FRAME_ROOM + len );
+
+  if ( pBuf != NULL )
+  {
+    pBuf = osal_bm_adjust_header( pBuf, -(int16)HCI_EXT_FRAME_ROOM );
+  }
+
+  return ( pBuf );
+#endif
+}
+
+/*********************************************************************
+ * @fn      hciExtEventFree
+ *
+ * @brief   Free a buffer from hciExtEventAlloc().
+ *
+ * @param   pBuf - event buffer
+ *
+ * @return  none
+ */
+static void hciExtEventFree( uint8 *pBuf )
+{
+#if ( HCI_EXT_APP_FRAME_POOL > 0 )
+  hciExtFrame_t *pFrame = (hciExtFrame_t *)( pBuf - HCI_EXT_FRAME_ROOM );
+
+  pFrame->next = frameFree;
+  frameFree = pFrame;
+  frameUsed--;
+#else
+  osal_bm_free( pBuf );
+#endif
+}
+
+/*********************************************************************
+ * @fn      hciExtChainAppend
+ *
+ * @brief   Append a segment to the outgoing event by reference. The data
+ *          must stay valid until the event is gathered.
+ *
+ * @param   pData - segment data
+ * @param   len - segment length
+ * @param   headLen - length of the event built so far
+ *
+ * @return  none
+ */
+static void hciExtChainAppend( uint8 *pData, uint8 len, uint8 headLen )
+{
+  uint8 i;
+  uint16 total = headLen;
+
+  for ( i = 0; i < outChain.cnt; i++ )
+  {
+    total += outChain.len[i];
+  }
+
+  // An HCI event holds at most 255 bytes of parameters
+  if ( (len > 0) && (outChain.cnt < HCI_EXT_CHAIN_MAX) && ((total + len) <= 0xFF) )
+  {
+    outChain.pData[outChain.cnt] = pData;
+    outChain.len[outChain.cnt] = len;
+    outChain.cnt++;
+  }
+}
+
+/*********************************************************************
+ * @fn      hciExtChainGather
+ *
+ * @brief   Copy the segments of the outgoing event behind its head. They
+ *          go into out_msg when they fit, or else into a new event buffer.
+ *
+ * @param   pHead - head of the event
+ * @param   pLen - length of the head, updated to the event length
+ * @param   pAllocated - whether the event buffer is locally allocated
+ *
+ * @return  event buffer
+ */
+static uint8 *hciExtChainGather( uint8 *pHead, uint8 *pLen, uint8 *pAllocated )
+{
+  uint8 *pBuf = pHead;
+  uint8 len = *pLen;
+  uint16 total = len;
+  uint8 i;
+
+  if ( outChain.cnt == 0 )
+  {
+    return ( pHead );
+  }
+
+  for ( i = 0; i < outChain.cnt; i++ )
+  {
+    total += outChain.len[i];
+  }
+
+  if ( (pHead != out_msg) || (total > HCI_EXT_APP_OUT_BUF) )
+  {
+    pBuf = hciExtEventAlloc( total );
+    if ( pBuf == NULL )
+    {
+      // Send the head alone, flagged with the failure
+      pHead[2] = bleMemAllocError;
+      outChain.cnt = 0;
+
+      return ( pHead );
+    }
+
+    VOID osal_memcpy( pBuf, pHead, len );
+    HCI_EXT_COPY_CNT( len );
+
+    if ( *pAllocated == TRUE )
+    {
+      hciExtEventFree( pHead );
+    }
+
+    *pAllocated = TRUE;
+  }
+
+  for ( i = 0; i < outChain.cnt; i++ )
+  {
+    VOID osal_memcpy( &pBuf[len], outChain.pData[i], outChain.len[i] );
+    HCI_EXT_COPY_CNT( outChain.len[i] );
+    len += outChain.len[i];
+  }
+
+  outChain.cnt = 0;
+  *pLen = len;
+
+  return ( pBuf );
+}
+
+/*********************************************************************
+ * @fn      hciExtEventSend
+ *
+ * @brief   Send an outgoing event to the host. With HCI_EXT_APP_UART_TX,
+ *          the HCI event header is filled into the room in front of the
+ *          event and the frame goes straight to the UART. out_msg and the
+ *          other static events are copied into the UART buffer; allocated
+ *          events are queued by descriptor and sent in place, whatever
+ *          their size. An event is never sent ahead of one still waiting
+ *          for the UART, so events reach the host in the order they were
+ *          sent.
+ *
+ * @param   eventCode - HCI event code
+ * @param   pBuf - event buffer
+ * @param   len - event length
+ * @param   allocated - whether the event buffer is locally allocated
+ *
+ * @return  TRUE if this module now owns the event buffer and frees it
+ *          once sent, FALSE if the caller still has to free it
+ */
+static uint8 hciExtEventSend( uint8 eventCode, uint8 *pBuf, uint8 len, uint8 allocated )
+{
+#if ( HCI_EXT_APP_UART_TX == TRUE )
+  // Every event buffer keeps room for the header in front
+  uint8 *pFrame = pBuf - HCI_EXT_FRAME_HDR_LEN;
+  halUARTTxDesc_t *pDesc;
+
+  pFrame[0] = HCI_EVENT_PACKET;
+  pFrame[1] = eventCode;
+  pFrame[2] = len;
+
+  if ( allocated == FALSE )
+  {
+    if ( (txPendHead == NULL) &&
+         (HalUARTWrite( HCI_UART_PORT, pFrame, (HCI_EXT_FRAME_HDR_LEN + len) ) != 0) )
+    {
+      HCI_EXT_SENT_CNT( len );
+
+      return ( FALSE );
+    }
+
+    // The buffer is reused before the UART has room; queue a copy instead
+    if ( (pBuf = hciExtEventAlloc( len )) == NULL )
+    {
+      // Out of memory, as the HCI transport would be; the event is lost
+      return ( FALSE );
+    }
+
+    VOID osal_memcpy( (pBuf - HCI_EXT_FRAME_HDR_LEN), pFrame, (HCI_EXT_FRAME_HDR_LEN + len) );
+    HCI_EXT_COPY_CNT( len );
+    pFrame = pBuf - HCI_EXT_FRAME_HDR_LEN;
+  }
+
+  // The descriptor sits at the start of the buffer, in front of the frame
+  pDesc = (halUARTTxDesc_t *)( pFrame - sizeof( halUARTTxDesc_t ) );
+
+  pDesc->next = NULL;
+  pDesc->pBuf = pFrame;
+  pDesc->len = HCI_EXT_FRAME_HDR_LEN + len;
+  pDesc->pfnDone = hciExtEventTxDone;
+
+  if ( txPendTail != NULL )
+  {
+    txPendTail->next = pDesc;
+  }
+  else
+  {
+    txPendHead = pDesc;
+  }
+  txPendTail = pDesc;
+
+  hciExtEventTxPoll();
+
+  return ( allocated );
+#else
+  HCI_SendControllerToHostEvent( eventCode, len, pBuf );
+
+  // The HCI transport keeps its own copy of the event
+  HCI_EXT_COPY_CNT( len );
+  HCI_EXT_SENT_CNT( len );
+
+  return ( FALSE );
+#endif
+}
+
+/*********************************************************************
+ * @fn      hciExtCmdCompleteSend
+ *
+ * @brief   Pass a Command Complete event for an HCI command sent by this
+ *          module on to the host, behind the events already sent.
+ *
+ * @param   opCode - HCI command opcode
+ * @param   len - length of the return parameters
+ * @param   pParam - return parameters
+ *
+ * @return  none
+ */
+static void hciExtCmdCompleteSend( uint16 opCode, uint8 len, uint8 *pParam )
+{
+#if ( HCI_EXT_APP_GATT_COALESCE == TRUE )
+  // Keep the events in order
+  hciExtCoalesceFlush();
+#endif
+
+#if ( HCI_EXT_APP_UART_TX == TRUE )
+  {
+    uint8 *pBuf;
+
+    // Number of HCI command packets and opcode ahead of the parameters
+    if ( (len > (HCI_EXT_EVENT_MAX_LEN - 3)) || ((pBuf = hciExtEventAlloc( 3 + len )) == NULL) )
+    {
+      return;
+    }
+
+    pBuf[0] = 1;
+    pBuf[1] = LO_UINT16( opCode );
+    pBuf[2] = HI_UINT16( opCode );
+    VOID osal_memcpy( &pBuf[3], pParam, len );
+    HCI_EXT_COPY_CNT( len );
+
+    if ( hciExtEventSend( HCI_COMMAND_COMPLETE_EVENT_CODE, pBuf, (3 + len), TRUE ) == FALSE )
+    {
+      hciExtEventFree( pBuf );
+    }
+  }
+#else
+  HCI_SendCommandCompleteEvent( HCI_COMMAND_COMPLETE_EVENT_CODE, opCode, len, pParam );
+#endif
+}
+
+#if ( HCI_EXT_APP_UART_TX == TRUE )
+/*********************************************************************
+ * @fn      hciExtEventTxPoll
+ *
+ * @brief   Hand the queued events to the UART, oldest first, and stop at
+ *          the first one it cannot take yet; it is offered again after
+ *          TX_RETRY_TIMEOUT. An event goes by descriptor when the UART
+ *          takes descriptors, and is copied into the UART buffer otherwise.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void hciExtEventTxPoll( void )
+{
+  while ( txPendHead != NULL )
+  {
+    halUARTTxDesc_t *pDesc = txPendHead;
+    uint8 len = (uint8)( pDesc->len - HCI_EXT_FRAME_HDR_LEN );
+
+    txPendHead = pDesc->next;
+
+    if ( HalUARTWriteDesc( HCI_UART_PORT, pDesc ) != HAL_UART_SUCCESS )
+    {
+      if ( HalUARTWrite( HCI_UART_PORT, pDesc->pBuf, pDesc->len ) == 0 )
+      {
+        // Still first in line
+        txPendHead = pDesc;
+
+        VOID osal_start_timerEx( hciExtApp_TaskID, HCI_EXT_TX_RETRY_EVENT, TX_RETRY_TIMEOUT );
+
+        return;
+      }
+
+      hciExtEventTxDone( pDesc );
+    }
+
+    HCI_EXT_SENT_CNT( len );
+  }
+
+  txPendTail = NULL;
+}
+
+#if ( HCI_EXT_APP_UART_TX == TRUE )
+/*********************************************************************
+ * @fn      hciExtEventTxDone
+ *
+ * @brief   Free an event once the UART has sent it.
+ *
+ * @param   pDesc - UART descriptor at the start of the event buffer
+ *
+ * @return  none
+ */
+static void hciExtEventTxDone( halUARTTxDesc_t *pDesc )
+{
+  hciExtEventFree( (uint8 *)pDesc + HCI_EXT_FRAME_ROOM );
+}
+#endif
+
+#if ( HCI_EXT_APP_GATT_COALESCE == TRUE )
+/*********************************************************************
+ * @fn      hciExtCoalesceAdd
+ *
+ * @brief   Add a successful notification or read response event to the
+ *          pending coalesced event. The first record starts the window,
+ *          and a record that does not fit sends the pending event first.
+ *
+ * @param   pEvt - ATT event built by processEventsGATT()
+ *
+ * @return  TRUE if the event was taken, FALSE if it must be sent alone
+ */
+static uint8 hciExtCoalesceAdd( uint8 *pEvt )
+{
+  uint8 pduLen = pEvt[HCI_EXT_HDR_LEN];
+  uint16 recLen = HCI_EXT_COALESCE_REC_HDR_LEN + pduLen;
+
+  if ( !coalesce.enabled || (pEvt[2] != SUCCESS) ||
+       (pEvt[1] != HI_UINT16( HCI_EXT_ATT_EVENT )) ||
+       ((pEvt[0] != LO_UINT16( HCI_EXT_ATT_EVENT | ATT_HANDLE_VALUE_NOTI )) &&
+        (pEvt[0] != LO_UINT16( HCI_EXT_ATT_EVENT | ATT_READ_RSP ))) )
+  {
+    return ( FALSE );
+  }
+
+  if ( (coalesce.cnt != 0) && ((coalesce.len + recLen) > coalesce.maxLen) )
+  {
+    hciExtCoalesceFlush();
+  }
+
+  if ( coalesce.cnt == 0 )
+  {
+    if ( (HCI_EXT_HDR_LEN + 1 + recLen) > coalesce.maxLen )
+    {
+      return ( FALSE );
+    }
+
+    coalesce.len = HCI_EXT_HDR_LEN + 1;
+    coalesce.start = osal_GetSystemClock();
+    VOID osal_start_timerEx( hciExtApp_TaskID, HCI_EXT_COALESCE_EVENT, coalesce.window );
+  }
+
+  // Connection handle, method, PDU length and PDU
+  coalesceMsg[coalesce.len]   = pEvt[3];
+  coalesceMsg[coalesce.len+1] = pEvt[4];
+  coalesceMsg[coalesce.len+2] = pEvt[0] & 0x7F;
+  coalesceMsg[coalesce.len+3] = pduLen;
+  VOID osal_memcpy( &coalesceMsg[coalesce.len + HCI_EXT_COALESCE_REC_HDR_LEN],
+                    &pEvt[HCI_EXT_HDR_LEN + 1], pduLen );
+  HCI_EXT_COPY_CNT( recLen );
+
+  coalesce.len += (uint8)recLen;
+  coalesce.cnt++;
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      hciExtCoalesceFlush
+ *
+ * @brief   Send the pending coalesced event, if any.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void hciExtCoalesceFlush( void )
+{
+  uint32 latency;
+
+  if ( coalesce.cnt == 0 )
+  {
+    return;
+  }
+
+  VOID osal_stop_timerEx( hciExtApp_TaskID, HCI_EXT_COALESCE_EVENT );
+
+  // The records carry their own connection handles
+  VOID buildHCIExtHeader( coalesceMsg, HCI_EXT_GATT_COALESCED_EVENT, SUCCESS, 0xFFFF );
+  coalesceMsg[HCI_EXT_HDR_LEN] = coalesce.cnt;
+
+  VOID hciExtEventSend( HCI_VE_EVENT_CODE, coalesceMsg, coalesce.len, FALSE );
+
+  latency = osal_GetSystemClock() - coalesce.start;
+  if ( latency > coalesce.maxLatency )
+  {
+    coalesce.maxLatency = (latency > 0xFFFF) ? 0xFFFF : (uint16)latency;
+  }
+
+  coalesce.records += coalesce.cnt;
+  coalesce.frames++;
+  coalesce.cnt = 0;
+}
+#endif // HCI_EXT_APP_GATT_COALESCE
+
 /*********************************************************************
 *********************************************************************/
@@ -79,6 +79,52 @@ extern "C"
 #define HCI_EXT_UTIL_RESET                    0x00
 #define HCI_EXT_UTIL_NV_READ                  0x01
 #define HCI_EXT_UTIL_NV_WRITE                 0x02
+#define HCI_EXT_UTIL_HEAP_TRACE               0x03
+#define HCI_EXT_UTIL_COPY_STATS               0x04
+#define HCI_EXT_UTIL_RUN_TRACE                0x05
+#define HCI_EXT_UTIL_RUN_STATS                0x06
+#define HCI_EXT_UTIL_PWR_STATS                0x07
+#define HCI_EXT_UTIL_BATCH                    0x08
+#define HCI_EXT_UTIL_GATT_COALESCE            0x09
+#define HCI_EXT_UTIL_FRAME_POOL               0x0A
+
+// HCI_EXT_UTIL_HEAP_TRACE operations (first parameter octet)
+#define HCI_EXT_HEAP_TRACE_STATS              0x00  // Fragmentation index, free and largest free bytes, lost records
+#define HCI_EXT_HEAP_TRACE_READ               0x01  // Drain the oldest trace records
+#define HCI_EXT_HEAP_TRACE_ENABLE             0x02  // Start (1) or stop (0) recording
+
+// HCI_EXT_UTIL_COPY_STATS operations (first parameter octet)
+#define HCI_EXT_COPY_STATS_READ               0x00  // Event bytes copied and sent
+#define HCI_EXT_COPY_STATS_RESET              0x01  // Read, then clear both counts
+
+// HCI_EXT_UTIL_RUN_TRACE operations (first parameter octet)
+#define HCI_EXT_RUN_TRACE_STATS               0x00  // Lost records
+#define HCI_EXT_RUN_TRACE_READ                0x01  // Drain the oldest trace records
+#define HCI_EXT_RUN_TRACE_ENABLE              0x02  // Start (1) or stop (0) recording
+
+// HCI_EXT_UTIL_RUN_STATS operations (first parameter octet, task ID second)
+#define HCI_EXT_RUN_STATS_READ                0x00  // Runs, average, max, max events, overruns, budget
+#define HCI_EXT_RUN_STATS_RESET               0x01  // Read, then clear the task's statistics
+#define HCI_EXT_RUN_STATS_BUDGET              0x02  // Set the task's budget (uint16 ticks)
+
+// HCI_EXT_UTIL_PWR_STATS operations (first parameter octet)
+#define HCI_EXT_PWR_STATS_READ                0x00  // Msec per power mode, wakeups per cause
+#define HCI_EXT_PWR_STATS_TASK                0x01  // Awake msec, wakeups and events of a task
+#define HCI_EXT_PWR_STATS_RESET               0x02  // Clear all power statistics
+
+// HCI_EXT_UTIL_BATCH options (first parameter octet), followed by the
+// sub-commands, each as opcode (2 octets), length (1 octet) and parameters
+#define HCI_EXT_BATCH_STOP_ON_ERROR           0x00  // Skip the rest after a failed sub-command
+#define HCI_EXT_BATCH_CONTINUE_ON_ERROR       0x01  // Run every sub-command
+
+// HCI_EXT_UTIL_GATT_COALESCE operations (first parameter octet)
+#define HCI_EXT_COALESCE_READ                 0x00  // Records, events, max latency and settings
+#define HCI_EXT_COALESCE_RESET                0x01  // Read, then clear the counters
+#define HCI_EXT_COALESCE_CONFIG               0x02  // Enable, window (ms) and event length cap
+
+// HCI_EXT_UTIL_FRAME_POOL operations (first parameter octet)
+#define HCI_EXT_FRAME_POOL_READ               0x00  // Frames in the pool, in use, max in use, exhaustions
+#define HCI_EXT_FRAME_POOL_RESET              0x01  // Read, then restart max in use and exhaustions
 
 // GAP Initialization and Configuration
 #define HCI_EXT_GAP_DEVICE_INIT               0x00
@@ -132,6 +178,12 @@ extern "C"
 #define HCI_EXT_GATT_EVENT                    ( HCI_EXT_BASE_EVENT | (HCI_EXT_GATT_SUBGRP << 7) )  // 0x0580
 #define HCI_EXT_GAP_EVENT                     ( HCI_EXT_BASE_EVENT | (HCI_EXT_GAP_SUBGRP << 7) )   // 0x0600
 
+// GATT Events
+// Coalesced notifications and read responses: record count (1 octet), then
+// per record the connection handle (2), ATT method (1), PDU length (1) and
+// the PDU as it would appear in its own HCI_EXT_ATT_EVENT
+#define HCI_EXT_GATT_COALESCED_EVENT                ( HCI_EXT_GATT_EVENT | 0x7E )
+
 // GAP Events
 #define HCI_EXT_GAP_DEVICE_INIT_DONE_EVENT          ( HCI_EXT_GAP_EVENT | 0x00 )
 #define HCI_EXT_GAP_DEVICE_DISCOVERY_EVENT          ( HCI_EXT_GAP_EVENT | 0x01 )
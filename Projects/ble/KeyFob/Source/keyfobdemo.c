@@ -69,6 +69,9 @@
 // How often to check battery voltage (in ms)
 #define BATTERY_CHECK_PERIOD          5000
 
+// How late (in ms) a battery check may run to share a wakeup with other work
+#define BATTERY_CHECK_SLACK           1000
+
 // Below what battery percentage value is considered "Critical"
 #define BATTERY_LEVEL_CRITICAL_PCT    20
 
@@ -422,7 +425,7 @@ uint16 KeyFobApp_ProcessEvent( uint8 task_id, uint16 events )
     VOID ProxReporter_RegisterAppCBs( &keyFob_ProximityCBs );
 
     // Set timer for first battery read event
-    osal_start_timerEx( keyfobapp_TaskID, KFD_BATTERY_CHECK_EVT, BATTERY_CHECK_PERIOD );    
+    osal_start_timerEx_slack( keyfobapp_TaskID, KFD_BATTERY_CHECK_EVT, BATTERY_CHECK_PERIOD, BATTERY_CHECK_SLACK );    
     
     // Start the Accelerometer Profile
     VOID Accel_RegisterAppCBs( &keyFob_AccelCBs );
@@ -470,7 +473,7 @@ uint16 KeyFobApp_ProcessEvent( uint8 task_id, uint16 events )
     // Restart timer
     if (BATTERY_CHECK_PERIOD)
     {
-      osal_start_timerEx( keyfobapp_TaskID, KFD_BATTERY_CHECK_EVT, BATTERY_CHECK_PERIOD );
+      osal_start_timerEx_slack( keyfobapp_TaskID, KFD_BATTERY_CHECK_EVT, BATTERY_CHECK_PERIOD, BATTERY_CHECK_SLACK );
     }
   
     // Read battery level
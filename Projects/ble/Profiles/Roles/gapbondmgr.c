@@ -953,6 +953,9 @@ void GAPBondMgr_ProcessGAPMsg( gapEventHdr_t *pMsg )
     case GAP_LINK_TERMINATED_EVENT:      
       if ( linkDB_NumActive() == 0 )
       {
+        // Write out NV items held back during the connection
+        VOID osal_snv_flush();
+
         gapBondMgrReadBonds();
         gapBondSetupPrivFlag( 0 );
       }
@@ -1168,41 +1171,61 @@ static uint8 gapBondMgrAddBond( gapBondRec_t *pBondRec,
   {
   
     gapBondCharCfg_t charCfg[GAP_CHAR_CFG_MAX];
+    osalSnvItem_t items[7];
+    uint8 cnt = 0;
       
     // Save the main information
-    VOID osal_snv_write( mainRecordNvID(idx), sizeof ( gapBondRec_t ), pBondRec );
+    items[cnt].id = mainRecordNvID(idx);
+    items[cnt].len = sizeof ( gapBondRec_t );
+    items[cnt++].pBuf = pBondRec;
 
     // If available, save the LTK information    
     if ( pLocalLTK )
     {
-      VOID osal_snv_write( localLTKNvID(idx), sizeof ( gapBondLTK_t ), pLocalLTK );
+      items[cnt].id = localLTKNvID(idx);
+      items[cnt].len = sizeof ( gapBondLTK_t );
+      items[cnt++].pBuf = pLocalLTK;
     }
     
     
     // If availabe, save the connected device's LTK information
     if ( pDevLTK )
     {
-      VOID osal_snv_write( devLTKNvID(idx), sizeof ( gapBondLTK_t ), pDevLTK );
+      items[cnt].id = devLTKNvID(idx);
+      items[cnt].len = sizeof ( gapBondLTK_t );
+      items[cnt++].pBuf = pDevLTK;
     }
     
     // If available, save the connected device's IRK 
     if ( pIRK )
     {
-      VOID osal_snv_write( devIRKNvID(idx), KEYLEN, pIRK );
+      items[cnt].id = devIRKNvID(idx);
+      items[cnt].len = KEYLEN;
+      items[cnt++].pBuf = pIRK;
     }
     
     // If available, save the connected device's Signature information 
     if ( pSRK )
     {
-      VOID osal_snv_write( devCSRKNvID(idx), KEYLEN, pSRK );
-      VOID osal_snv_write( devSignCounterNvID(idx), sizeof ( uint32 ), &signCounter );
+      items[cnt].id = devCSRKNvID(idx);
+      items[cnt].len = KEYLEN;
+      items[cnt++].pBuf = pSRK;
+      items[cnt].id = devSignCounterNvID(idx);
+      items[cnt].len = sizeof ( uint32 );
+      items[cnt++].pBuf = &signCounter;
     }
     
     // Write out FF's over the charactersitic configuration entry, to overwrite
     // any previous bond data that may have been stored    
     VOID osal_memset( charCfg, 0xFF, sizeof ( charCfg ) );
     
-    VOID osal_snv_write( gattCfgNvID(idx), sizeof ( charCfg ), charCfg );
+    items[cnt].id = gattCfgNvID(idx);
+    items[cnt].len = sizeof ( charCfg );
+    items[cnt++].pBuf = charCfg;
+
+    // Commit the whole bond as one batch, so that a reset part way through
+    // cannot leave a record that mixes keys from two different bonds
+    VOID osal_snv_write_batch( items, cnt );
 
     
   }
@@ -1430,6 +1453,7 @@ static bStatus_t gapBondMgrEraseBonding( uint8 idx )
   gapBondRec_t bondRec;
   gapBondLTK_t ltk;
   gapBondCharCfg_t charCfg[GAP_CHAR_CFG_MAX];
+  osalSnvItem_t items[7];
 
   VOID osal_memset( &bondRec, 0xFF, sizeof ( gapBondRec_t ) );
   VOID osal_memset( &ltk, 0xFF, sizeof ( gapBondLTK_t ) );
@@ -1437,15 +1461,31 @@ static bStatus_t gapBondMgrEraseBonding( uint8 idx )
   VOID osal_memset( charCfg, 0xFF, sizeof ( charCfg ) );
 
   // Write out FF's over the entire bond entry.  
-  ret = osal_snv_write( mainRecordNvID(idx), sizeof ( gapBondRec_t ), &bondRec );
-  ret |= osal_snv_write( localLTKNvID(idx), sizeof ( gapBondLTK_t ), &ltk );
-  ret |= osal_snv_write( devLTKNvID(idx), sizeof ( gapBondLTK_t ), &ltk );
-  ret |= osal_snv_write( devIRKNvID(idx), KEYLEN, ltk.LTK );
-  ret |= osal_snv_write( devCSRKNvID(idx), KEYLEN, ltk.LTK );
-  ret |= osal_snv_write( devSignCounterNvID(idx), sizeof ( uint32 ), ltk.LTK );
+  items[0].id = mainRecordNvID(idx);
+  items[0].len = sizeof ( gapBondRec_t );
+  items[0].pBuf = &bondRec;
+  items[1].id = localLTKNvID(idx);
+  items[1].len = sizeof ( gapBondLTK_t );
+  items[1].pBuf = &ltk;
+  items[2].id = devLTKNvID(idx);
+  items[2].len = sizeof ( gapBondLTK_t );
+  items[2].pBuf = &ltk;
+  items[3].id = devIRKNvID(idx);
+  items[3].len = KEYLEN;
+  items[3].pBuf = ltk.LTK;
+  items[4].id = devCSRKNvID(idx);
+  items[4].len = KEYLEN;
+  items[4].pBuf = ltk.LTK;
+  items[5].id = devSignCounterNvID(idx);
+  items[5].len = sizeof ( uint32 );
+  items[5].pBuf = ltk.LTK;
   
   // Write out FF's over the charactersitic configuration entry.
-  ret |= osal_snv_write( gattCfgNvID(idx), sizeof ( charCfg ), charCfg );
+  items[6].id = gattCfgNvID(idx);
+  items[6].len = sizeof ( charCfg );
+  items[6].pBuf = charCfg;
+
+  ret = osal_snv_write_batch( items, 7 );
 
   // Update the GAP Privacy Flag Properties
   gapBondSetupPrivFlag( 0 );
@@ -43,7 +43,7 @@
 
 #include "hal_mcu.h"
 #include "hal_sleep.h"
-#include "osal.h"
+#include "OSAL.h"
 
 /*********************************************************************
  */
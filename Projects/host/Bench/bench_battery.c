@@ -0,0 +1,404 @@
+/*************************************************************************************************
+  Filename:       bench_battery.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Projected battery life of the KeyFob wakeup mix, from the power mode
+                  times and per-task awake times of the power manager statistics
+                  (OSAL_PWRMGR_STATS) on the virtual clock of the POSIX HAL.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+
+#include "hal_mcu.h"
+#include "hal_sleep.h"
+#include "OSAL.h"
+#include "OSAL_Clock.h"
+#include "OSAL_PwrMgr.h"
+#include "OSAL_Tasks.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if !( OSAL_PWRMGR_STATS )
+  #error The battery benchmark needs the power statistics (OSAL_PWRMGR_STATS=TRUE).
+#endif
+
+// Timing of the KeyFob application (keyfobdemo.c), and the time each
+// wakeup keeps the device busy
+#define BATTERY_CHECK_PERIOD    5000
+#define BATTERY_CHECK_USEC      1000    // ADC conversion of the battery voltage
+#define ACCEL_READ_PERIOD       50
+#define ACCEL_READ_USEC         300     // SPI read of the accelerometer
+
+// Connection event at the maximum interval the KeyFob asks for, 800 * 1.25 ms,
+// including the crystal start-up and the RX and TX of an empty packet
+#define LINK_CONN_INTERVAL      1000
+#define LINK_EVENT_USEC         2000
+
+// Delay of the other timers behind the battery check, as in bench_wakeups
+#define BENCH_TIMER_PHASE       377
+
+// Supply currents of the CC2540 at 3 V (datasheet), in microamperes
+#define CURRENT_MCU_UA          6700.0  // MCU active at 32 MHz
+#define CURRENT_RADIO_UA        20000.0 // Average over a connection event at 0 dBm
+#define CURRENT_PM2_UA          0.9     // Sleep timer running
+#define CURRENT_PM3_UA          0.4     // External interrupts only
+
+// CR2032 coin cell of the KeyFob
+#define BATTERY_CAPACITY_MAH    230.0
+
+// Task IDs, the link layer first as in the BLE stack
+#define LINK_TASK_ID            0
+#define APP_TASK_ID             1
+
+// Link task events
+#define LINK_CONN_EVT           0x0001
+
+// Application task events (keyfobdemo.h)
+#define KFD_BATTERY_CHECK_EVT   0x0002
+#define KFD_ACCEL_READ_EVT      0x0004
+
+// Simulated time of a full run, in seconds
+#define BENCH_SIM_SECONDS       3600
+
+// The statistics are read and cleared this often, in milliseconds, as a
+// host reading them out would, before the 16-bit wakeup counts saturate
+#define BENCH_READ_PERIOD       60000
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Wakeup mix of one scenario
+typedef struct
+{
+  const char *name;
+  uint8 accel;      // Accelerometer enabled, read every ACCEL_READ_PERIOD
+  uint8 connected;  // Connection event every LINK_CONN_INTERVAL
+} benchScenario_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static const benchScenario_t benchScenarios[] =
+{
+  { "idle",        FALSE, FALSE },  // Battery check alone
+  { "connected",   FALSE, TRUE  },  // Battery check and connection events
+  { "accel",       TRUE,  TRUE  },  // Accelerometer reads as well
+};
+
+static uint16 benchEvents[2];
+
+static uint8 benchAccel;          // Accelerometer reads are running
+static uint32 benchConnEvents;    // Connection events done
+static uint32 benchBusyUsec;      // Time the tasks kept the device busy
+
+// Statistics of a run, summed over the readouts
+static uint32 benchModeMSec[PWRMGR_MODE_CNT];
+static uint32 benchWakes[PWRMGR_WAKE_CNT];
+static uint32 benchLinkMSec;
+static uint32 benchReadouts;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 benchLinkTask( uint8 task_id, uint16 events );
+static uint16 benchAppTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[] =
+{
+  benchLinkTask,
+  benchAppTask
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents = benchEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the benchmark tasks.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  osal_memset( benchEvents, 0, sizeof( benchEvents ) );
+}
+
+/*********************************************************************
+ * @fn      benchLinkTask
+ *
+ * @brief   Stand-in for the link layer: stay busy for each connection
+ *          event.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 benchLinkTask( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+
+  if ( events & LINK_CONN_EVT )
+  {
+    benchConnEvents++;
+    benchBusyUsec += LINK_EVENT_USEC;
+    halSleepWait( LINK_EVENT_USEC );
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      benchAppTask
+ *
+ * @brief   The timers of the KeyFob application task, each keeping the
+ *          device busy for its sensor read.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 benchAppTask( uint8 task_id, uint16 events )
+{
+  if ( events & KFD_BATTERY_CHECK_EVT )
+  {
+    benchBusyUsec += BATTERY_CHECK_USEC;
+    halSleepWait( BATTERY_CHECK_USEC );
+    osal_start_timerEx( task_id, KFD_BATTERY_CHECK_EVT, BATTERY_CHECK_PERIOD );
+  }
+
+  if ( (events & KFD_ACCEL_READ_EVT) && benchAccel )
+  {
+    benchBusyUsec += ACCEL_READ_USEC;
+    halSleepWait( ACCEL_READ_USEC );
+    osal_start_timerEx( task_id, KFD_ACCEL_READ_EVT, ACCEL_READ_PERIOD );
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      benchReadStats
+ *
+ * @brief   Add the power statistics to the totals of the run and clear
+ *          them.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchReadStats( void )
+{
+  pwrmgr_task_stats_t link;
+  pwrmgr_stats_t stats;
+  uint8 idx;
+
+  osal_pwrmgr_stats( &stats );
+  HOST_CHECK( osal_pwrmgr_task_stats( LINK_TASK_ID, &link ) == SUCCESS );
+  osal_pwrmgr_stats_reset();
+
+  for ( idx = 0; idx < PWRMGR_MODE_CNT; idx++ )
+  {
+    benchModeMSec[idx] += stats.modeMSec[idx];
+  }
+  for ( idx = 0; idx < PWRMGR_WAKE_CNT; idx++ )
+  {
+    HOST_CHECK( stats.wakes[idx] != 0xFFFF );
+    benchWakes[idx] += stats.wakes[idx];
+  }
+  benchLinkMSec += link.awakeMSec;
+  benchReadouts++;
+}
+
+/*********************************************************************
+ * @fn      benchRun
+ *
+ * @brief   Run the wakeup mix of a scenario on the virtual clock, the
+ *          power manager sleeping until the next timer whenever no
+ *          task is ready, and project the battery life from the
+ *          statistics: the awake time charged to the link task at the
+ *          radio current, the rest of the awake time at the MCU
+ *          current and each sleep mode at its own.
+ *
+ * @param   pScen - scenario
+ *
+ * @return  projected battery life in days
+ */
+static double benchRun( const benchScenario_t *pScen )
+{
+  uint32 duration = hostScale( BENCH_SIM_SECONDS ) * 1000;
+  uint32 readout = BENCH_READ_PERIOD;
+  uint32 start;
+  uint32 elapsed;
+  uint32 total;
+  double charge;
+  double average;
+  double days;
+  char metric[48];
+
+  benchAccel = pScen->accel;
+  benchConnEvents = 0;
+  osal_memset( benchModeMSec, 0, sizeof( benchModeMSec ) );
+  osal_memset( benchWakes, 0, sizeof( benchWakes ) );
+  benchLinkMSec = 0;
+  benchReadouts = 0;
+
+  osal_start_timerEx( APP_TASK_ID, KFD_BATTERY_CHECK_EVT, BATTERY_CHECK_PERIOD );
+  HalClockAdvance( (uint32)BENCH_TIMER_PHASE * 1000 );
+
+  if ( pScen->accel )
+  {
+    osal_start_timerEx( APP_TASK_ID, KFD_ACCEL_READ_EVT, ACCEL_READ_PERIOD );
+  }
+  if ( pScen->connected )
+  {
+    osal_start_reload_timer( LINK_TASK_ID, LINK_CONN_EVT, LINK_CONN_INTERVAL );
+  }
+
+  osal_pwrmgr_stats_reset();
+  benchBusyUsec = 0;
+  start = osal_GetSystemClock();
+
+  do
+  {
+    osal_run_system();
+    elapsed = osal_GetSystemClock() - start;
+    if ( elapsed >= readout )
+    {
+      benchReadStats();
+      readout += BENCH_READ_PERIOD;
+    }
+  } while ( elapsed < duration );
+
+  benchReadStats();
+
+  osal_stop_timerEx( APP_TASK_ID, KFD_BATTERY_CHECK_EVT );
+  osal_stop_timerEx( APP_TASK_ID, KFD_ACCEL_READ_EVT );
+  osal_stop_timerEx( LINK_TASK_ID, LINK_CONN_EVT );
+  osal_clear_event( APP_TASK_ID, KFD_BATTERY_CHECK_EVT | KFD_ACCEL_READ_EVT );
+  osal_clear_event( LINK_TASK_ID, LINK_CONN_EVT );
+
+  // The modes account for the whole run, but for the fraction of a
+  // millisecond of each mode a readout drops, and every sleep ended on
+  // a timer
+  total = benchModeMSec[PWRMGR_MODE_AWAKE] + benchModeMSec[PWRMGR_MODE_TIMER] +
+          benchModeMSec[PWRMGR_MODE_DEEP];
+  HOST_CHECK( total + benchReadouts * PWRMGR_MODE_CNT + 2 >= elapsed && total <= elapsed + 2 );
+  HOST_CHECK( benchWakes[PWRMGR_WAKE_TIMER] != 0 );
+  HOST_CHECK( benchWakes[PWRMGR_WAKE_KEY] == 0 );
+
+  // The awake time covers the busy time of the tasks; the link task is
+  // charged with the wakeups it was first dispatched on
+  HOST_CHECK( benchModeMSec[PWRMGR_MODE_AWAKE] + benchReadouts >= benchBusyUsec / 1000 );
+  HOST_CHECK( benchLinkMSec <= benchModeMSec[PWRMGR_MODE_AWAKE] );
+  HOST_CHECK( ( benchLinkMSec != 0 ) == pScen->connected );
+  HOST_CHECK( !pScen->connected || benchConnEvents >= elapsed / LINK_CONN_INTERVAL - 1 );
+
+  // Charge in microampere milliseconds
+  charge = benchLinkMSec * CURRENT_RADIO_UA +
+           ( benchModeMSec[PWRMGR_MODE_AWAKE] - benchLinkMSec ) * CURRENT_MCU_UA +
+           benchModeMSec[PWRMGR_MODE_TIMER] * CURRENT_PM2_UA +
+           benchModeMSec[PWRMGR_MODE_DEEP] * CURRENT_PM3_UA;
+  average = charge / total;
+  days = BATTERY_CAPACITY_MAH * 1000.0 / average / 24.0;
+
+  sprintf( metric, "%s_awake", pScen->name );
+  hostReport( "battery", metric, benchModeMSec[PWRMGR_MODE_AWAKE] * 3600000.0 / total, "ms/h" );
+  sprintf( metric, "%s_radio", pScen->name );
+  hostReport( "battery", metric, benchLinkMSec * 3600000.0 / total, "ms/h" );
+  sprintf( metric, "%s_wakeups", pScen->name );
+  hostReport( "battery", metric, benchWakes[PWRMGR_WAKE_TIMER] * 3600000.0 / total, "wakeups/h" );
+  sprintf( metric, "%s_current", pScen->name );
+  hostReport( "battery", metric, average, "uA" );
+  sprintf( metric, "%s_life", pScen->name );
+  hostReport( "battery", metric, days, "days" );
+
+  return ( days );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run every scenario and report the projected battery life.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  double life = 0;
+  double days;
+  uint8 idx;
+
+  hostInit( argc, argv, "osal" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  // All tasks agree to conserve out of reset
+  osal_pwrmgr_device( PWRMGR_BATTERY );
+
+  for ( idx = 0; idx < sizeof( benchScenarios ) / sizeof( benchScenarios[0] ); idx++ )
+  {
+    days = benchRun( &benchScenarios[idx] );
+
+    // Each scenario adds wakeups to the one before
+    HOST_CHECK( idx == 0 || days < life );
+    life = days;
+  }
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
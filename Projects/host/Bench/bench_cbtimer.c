@@ -0,0 +1,398 @@
+/*************************************************************************************************
+  Filename:       bench_cbtimer.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Callback timer throughput and dispatch latency with every one of
+                  OSAL_CBTIMER_NUM_TIMERS timers running.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Clock.h"
+#include "OSAL_Tasks.h"
+#include "osal_cbtimer.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define BENCH_TIMER_CNT     OSAL_CBTIMER_NUM_TIMERS
+
+#if ( BENCH_TIMER_CNT < 200 )
+  #error The benchmark wants hundreds of callback timers (OSAL_CBTIMER_NUM_TIMERS).
+#endif
+
+// Timeouts of the steady state run, 1 to BENCH_TIMEOUT_MAX msecs
+#define BENCH_TIMEOUT_MAX   1000
+
+// Simulated msecs of the steady state run
+#define BENCH_TICKS         200000
+
+#define BENCH_BURSTS        2000
+#define BENCH_BURST_TIMEOUT 10
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// One running timer
+typedef struct
+{
+  uint8 id;       // handle from osal_CbTimerStart()
+  uint32 expire;  // system clock at which it is due
+} benchTimer_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 benchEvents[1];
+static uint32 benchRand = 1;
+
+static benchTimer_t benchTimers[BENCH_TIMER_CNT];
+
+static uint8 benchRestart;        // Callbacks start their timer again
+static uint32 benchFired;         // Callbacks run
+static uint32 benchLateMax;       // Largest delay past the expiry, in msecs
+static uint64_t benchPassStart;   // Cycle count at the start of the scheduler pass
+static hostSamples_t benchLatency;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void benchCallback( uint8 *pData );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[] =
+{
+  osal_CbTimerProcessEvent
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents = benchEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the callback timer task.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  benchEvents[0] = 0;
+  osal_CbTimerInit( 0 );
+}
+
+/*********************************************************************
+ * @fn      benchRandom
+ *
+ * @brief   Deterministic pseudo-random numbers (xorshift32).
+ *
+ * @param   none
+ *
+ * @return  Next random number.
+ */
+static uint32 benchRandom( void )
+{
+  benchRand ^= benchRand << 13;
+  benchRand ^= benchRand >> 17;
+  benchRand ^= benchRand << 5;
+
+  return benchRand;
+}
+
+/*********************************************************************
+ * @fn      benchStart
+ *
+ * @brief   Start a callback timer.
+ *
+ * @param   pTimer - timer
+ * @param   timeout - msecs
+ *
+ * @return  none
+ */
+static void benchStart( benchTimer_t *pTimer, uint16 timeout )
+{
+  pTimer->expire = osal_GetSystemClock() + timeout;
+  HOST_CHECK( osal_CbTimerStart( benchCallback, (uint8 *)pTimer, timeout, &pTimer->id ) == SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      benchCallback
+ *
+ * @brief   Record the dispatch latency and how late the timer fired,
+ *          and in the steady state run start the timer again.
+ *
+ * @param   pData - the benchTimer_t of the timer
+ *
+ * @return  none
+ */
+static void benchCallback( uint8 *pData )
+{
+  benchTimer_t *pTimer = (benchTimer_t *)pData;
+  int32 late = (int32)( osal_GetSystemClock() - pTimer->expire );
+
+  hostSamplesAdd( &benchLatency, (uint32)( hostCycles() - benchPassStart ) );
+  benchFired++;
+
+  HOST_CHECK( late >= 0 );
+  if ( (uint32)late > benchLateMax )
+  {
+    benchLateMax = (uint32)late;
+  }
+
+  if ( benchRestart )
+  {
+    benchStart( pTimer, (uint16)( 1 + benchRandom() % BENCH_TIMEOUT_MAX ) );
+  }
+}
+
+/*********************************************************************
+ * @fn      benchRunIdle
+ *
+ * @brief   Run the system until no task is ready.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchRunIdle( void )
+{
+  do
+  {
+    benchPassStart = hostCycles();
+    osal_run_system();
+  } while ( benchEvents[0] );
+}
+
+/*********************************************************************
+ * @fn      benchSteady
+ *
+ * @brief   Every timer running with a random timeout and started again
+ *          from its callback; the clock advances a msec at a time.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchSteady( void )
+{
+  uint32 ticks = hostScale( BENCH_TICKS );
+  uint32 i;
+  uint64_t ns = 0;
+  uint64_t t0;
+
+  hostSamplesInit( &benchLatency, ticks * 2 );
+  benchRestart = TRUE;
+  benchFired = 0;
+  benchLateMax = 0;
+
+  for ( i = 0; i < BENCH_TIMER_CNT; i++ )
+  {
+    benchStart( &benchTimers[i], (uint16)( 1 + benchRandom() % BENCH_TIMEOUT_MAX ) );
+  }
+
+  for ( i = 0; i < ticks; i++ )
+  {
+    HalClockAdvance( 1000 );
+
+    t0 = hostNanos();
+    benchRunIdle();
+    ns += hostNanos() - t0;
+  }
+
+  // Roughly a timer per expected timeout, and none fired late but for the clock lag
+  HOST_CHECK( benchFired > (uint64_t)ticks * BENCH_TIMER_CNT / BENCH_TIMEOUT_MAX );
+  HOST_CHECK( benchLateMax <= 1 );
+
+  hostReport( "cbtimer", "steady_callbacks_per_sec", benchFired / ( ns / 1e9 ), "callbacks/s" );
+  hostReport( "cbtimer", "callbacks_per_tick", (double)benchFired / ticks, "callbacks" );
+  hostReport( "cbtimer", "late_max", benchLateMax, "ms" );
+  hostReportPercentiles( "cbtimer", "dispatch_latency", &benchLatency, hostCyclesUnit() );
+  hostSamplesFree( &benchLatency );
+
+  // Cancel every timer by its handle
+  for ( i = 0; i < BENCH_TIMER_CNT; i++ )
+  {
+    HOST_CHECK( osal_CbTimerStop( benchTimers[i].id ) == SUCCESS );
+  }
+}
+
+/*********************************************************************
+ * @fn      benchStartStop
+ *
+ * @brief   Start and stop one timer while the others are running.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchStartStop( void )
+{
+  hostSamples_t start, stop;
+  uint32 rounds = hostScale( 1000000 );
+  uint32 i;
+  uint64_t t0, t1, t2;
+  uint8 id;
+
+  hostSamplesInit( &start, rounds );
+  hostSamplesInit( &stop, rounds );
+
+  for ( i = 0; i < BENCH_TIMER_CNT - 1; i++ )
+  {
+    HOST_CHECK( osal_CbTimerStart( benchCallback, (uint8 *)&benchTimers[i],
+                                   (uint16)( 1 + benchRandom() % BENCH_TIMEOUT_MAX ),
+                                   &benchTimers[i].id ) == SUCCESS );
+  }
+
+  for ( i = 0; i < rounds; i++ )
+  {
+    uint16 timeout = (uint16)( 1 + benchRandom() % BENCH_TIMEOUT_MAX );
+
+    t0 = hostCycles();
+    osal_CbTimerStart( benchCallback, NULL, timeout, &id );
+    t1 = hostCycles();
+    osal_CbTimerStop( id );
+    t2 = hostCycles();
+
+    hostSamplesAdd( &start, (uint32)( t1 - t0 ) );
+    hostSamplesAdd( &stop, (uint32)( t2 - t1 ) );
+  }
+
+  // The pool is full: one more start fails
+  HOST_CHECK( osal_CbTimerStart( benchCallback, NULL, 1, &id ) == SUCCESS );
+  HOST_CHECK( osal_CbTimerStart( benchCallback, NULL, 1, NULL ) == NO_TIMER_AVAIL );
+  HOST_CHECK( osal_CbTimerStop( id ) == SUCCESS );
+  HOST_CHECK( osal_CbTimerStop( id ) == INVALIDPARAMETER );
+
+  hostReportPercentiles( "cbtimer", "start", &start, hostCyclesUnit() );
+  hostReportPercentiles( "cbtimer", "stop", &stop, hostCyclesUnit() );
+  hostSamplesFree( &start );
+  hostSamplesFree( &stop );
+
+  for ( i = 0; i < BENCH_TIMER_CNT - 1; i++ )
+  {
+    HOST_CHECK( osal_CbTimerStop( benchTimers[i].id ) == SUCCESS );
+  }
+}
+
+/*********************************************************************
+ * @fn      benchBurst
+ *
+ * @brief   Every timer due in the same tick: a single scheduler pass
+ *          must dispatch them all.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchBurst( void )
+{
+  hostSamples_t pass;
+  uint32 bursts = hostScale( BENCH_BURSTS );
+  uint32 b, i;
+  uint64_t t0;
+  uint64_t ns = 0;
+  uint64_t ns0;
+
+  hostSamplesInit( &pass, bursts );
+  hostSamplesInit( &benchLatency, bursts * BENCH_TIMER_CNT );
+  benchRestart = FALSE;
+
+  for ( b = 0; b < bursts; b++ )
+  {
+    for ( i = 0; i < BENCH_TIMER_CNT; i++ )
+    {
+      benchStart( &benchTimers[i], BENCH_BURST_TIMEOUT );
+    }
+
+    // One msec more for the lag of the OSAL clock
+    HalClockAdvance( ( BENCH_BURST_TIMEOUT + 1 ) * 1000 );
+    benchFired = 0;
+
+    ns0 = hostNanos();
+    t0 = hostCycles();
+    benchPassStart = t0;
+    osal_run_system();
+    hostSamplesAdd( &pass, (uint32)( hostCycles() - t0 ) );
+    ns += hostNanos() - ns0;
+
+    HOST_CHECK( benchFired == BENCH_TIMER_CNT );
+  }
+
+  hostReport( "cbtimer", "burst_callbacks_per_sec",
+              (double)bursts * BENCH_TIMER_CNT / ( ns / 1e9 ), "callbacks/s" );
+  hostReportPercentiles( "cbtimer", "burst_pass", &pass, hostCyclesUnit() );
+  hostReportPercentiles( "cbtimer", "burst_dispatch_latency", &benchLatency, hostCyclesUnit() );
+  hostSamplesFree( &pass );
+  hostSamplesFree( &benchLatency );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the callback timer benchmarks.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  hostInit( argc, argv, "osal" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  benchSteady();
+  benchStartStop();
+  benchBurst();
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
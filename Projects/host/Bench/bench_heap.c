@@ -0,0 +1,245 @@
+/*************************************************************************************************
+  Filename:       bench_heap.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Heap benchmark: osal_mem_alloc/osal_mem_free latency percentiles
+                  under a random mix of message-sized blocks.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OnBoard.h"
+#include "OSAL_Tasks.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Most blocks held at once
+#define BENCH_LIVE_MAX  256
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 benchEvents[1];
+static uint32 benchRand = 1;
+
+static void *benchLive[BENCH_LIVE_MAX];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 benchIdleTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[] =
+{
+  benchIdleTask
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents = benchEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the benchmark task.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  benchEvents[0] = 0;
+}
+
+/*********************************************************************
+ * @fn      benchIdleTask
+ *
+ * @brief   The benchmark runs from main(); the task has nothing to do.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 benchIdleTask( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+  (void)events;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      benchRandom
+ *
+ * @brief   Deterministic pseudo-random numbers (xorshift32).
+ *
+ * @param   none
+ *
+ * @return  Next random number.
+ */
+static uint32 benchRandom( void )
+{
+  benchRand ^= benchRand << 13;
+  benchRand ^= benchRand >> 17;
+  benchRand ^= benchRand << 5;
+
+  return benchRand;
+}
+
+/*********************************************************************
+ * @fn      benchSize
+ *
+ * @brief   Pick a block size: mostly small OSAL messages and timers,
+ *          some attribute values, a few HCI/GATT packet buffers.
+ *
+ * @param   none
+ *
+ * @return  Block size in bytes.
+ */
+static uint16 benchSize( void )
+{
+  uint32 r = benchRandom() % 100;
+
+  if ( r < 60 )
+  {
+    return (uint16)( 4 + benchRandom() % 21 );
+  }
+  else if ( r < 90 )
+  {
+    return (uint16)( 25 + benchRandom() % 56 );
+  }
+
+  return (uint16)( 81 + benchRandom() % 220 );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the heap benchmark.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  hostSamples_t alloc, dealloc;
+  uint32 ops;
+  uint32 fails = 0;
+  uint32 i;
+  uint16 idx;
+  uint64_t t0, t1;
+
+  hostInit( argc, argv, "osal" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  ops = hostScale( 2000000 );
+  hostSamplesInit( &alloc, ops );
+  hostSamplesInit( &dealloc, ops );
+
+  for ( i = 0; i < ops; i++ )
+  {
+    idx = (uint16)( benchRandom() % BENCH_LIVE_MAX );
+
+    if ( benchLive[idx] == NULL )
+    {
+      uint16 size = benchSize();
+
+      t0 = hostCycles();
+      benchLive[idx] = osal_mem_alloc( size );
+      t1 = hostCycles();
+
+      if ( benchLive[idx] == NULL )
+      {
+        fails++;
+      }
+      else
+      {
+        // Touch the block so that a heap overrun would show.
+        osal_memset( benchLive[idx], 0xA5, size );
+        hostSamplesAdd( &alloc, (uint32)( t1 - t0 ) );
+      }
+    }
+    else
+    {
+      t0 = hostCycles();
+      osal_mem_free( benchLive[idx] );
+      t1 = hostCycles();
+
+      benchLive[idx] = NULL;
+      hostSamplesAdd( &dealloc, (uint32)( t1 - t0 ) );
+    }
+  }
+
+  hostReport( "heap", "heap_size", MAXMEMHEAP, "bytes" );
+  hostReportPercentiles( "heap", "alloc", &alloc, hostCyclesUnit() );
+  hostReportPercentiles( "heap", "free", &dealloc, hostCyclesUnit() );
+  hostReport( "heap", "alloc_fail_rate", (double)fails / ( alloc.cnt + fails ), "ratio" );
+
+  for ( idx = 0; idx < BENCH_LIVE_MAX; idx++ )
+  {
+    if ( benchLive[idx] != NULL )
+    {
+      osal_mem_free( benchLive[idx] );
+    }
+  }
+
+  // With every block back, the largest allocation must fit again.
+  benchLive[0] = osal_mem_alloc( 512 );
+  HOST_CHECK( benchLive[0] != NULL );
+
+  hostSamplesFree( &alloc );
+  hostSamplesFree( &dealloc );
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
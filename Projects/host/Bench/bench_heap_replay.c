@@ -0,0 +1,536 @@
+/*************************************************************************************************
+  Filename:       bench_heap_replay.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Heap replay benchmark: alloc and free latency of the heap engine
+                  the library was built with, replaying allocation traces. A trace
+                  is the log of a DPRINTF_OSALHEAPTRACE build given on the command
+                  line or, without one, a built-in workload modelled on the heap
+                  traffic of the BLE sample applications.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if defined ( OSALMEM_SEGREGATED ) && OSALMEM_SEGREGATED
+  #define BENCH_ENGINE      "heap_replay_segregated"
+#else
+  #define BENCH_ENGINE      "heap_replay_first_fit"
+#endif
+
+#define BENCH_OP_ALLOC      0
+#define BENCH_OP_FREE       1
+
+// Most blocks a built-in workload holds at once, about half the heap
+#define BENCH_LIVE_MAX      256
+
+#define BENCH_LINE_LEN      256
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// One heap call of a trace; slot numbers the block from alloc to free
+typedef struct
+{
+  uint8  op;
+  uint16 size;
+  uint32 slot;
+} benchOp_t;
+
+// Trace to replay
+typedef struct
+{
+  benchOp_t *pOps;
+  uint32 cnt;
+  uint32 size;
+  uint32 slotCnt;
+} benchTrace_t;
+
+// Block size class of a built-in workload
+typedef struct
+{
+  uint16 sizeMin;
+  uint16 sizeMax;
+  uint8  weight;    // Share of the allocations in percent
+  uint16 lifeMin;   // Lifetime in allocations
+  uint16 lifeMax;
+} benchClass_t;
+
+// Built-in workload
+typedef struct
+{
+  const char *name;
+  const benchClass_t *pClasses;
+  uint8 classCnt;
+} benchWorkload_t;
+
+// Live block of a workload being generated or a trace being parsed
+typedef struct
+{
+  unsigned long key;  // Expiry (generated) or address (parsed)
+  uint32 slot;
+} benchLive_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 benchEvents[1];
+static uint32 benchRand = 1;
+
+/* A peripheral streaming notifications: a few long-lived blocks of
+ * connection state, OSAL and HCI event messages freed right after
+ * dispatch, ATT notification buffers held until sent, and some HCI
+ * data buffers.
+ */
+static const benchClass_t benchNotifyClasses[] =
+{
+  {   8,  16, 10, 200, 2000 },
+  {  14,  40, 55,   1,    8 },
+  {  20,  31, 25,   2,   24 },
+  {  64, 140, 10,   4,   64 }
+};
+
+/* A central reading long characteristics: small messages around large
+ * attribute value buffers, with long-lived small blocks scattered over
+ * the heap in between.
+ */
+static const benchClass_t benchLongReadClasses[] =
+{
+  {  12,  32, 50,   1,   16 },
+  { 128, 520, 20,   2,   32 },
+  {   8,  24, 30, 100, 4000 }
+};
+
+static const benchWorkload_t benchWorkloads[] =
+{
+  { "notify",    benchNotifyClasses,   sizeof( benchNotifyClasses ) / sizeof( benchClass_t ) },
+  { "long_read", benchLongReadClasses, sizeof( benchLongReadClasses ) / sizeof( benchClass_t ) }
+};
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 benchIdleTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[] =
+{
+  benchIdleTask
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents = benchEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the benchmark task.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  benchEvents[0] = 0;
+}
+
+/*********************************************************************
+ * @fn      benchIdleTask
+ *
+ * @brief   The benchmark runs from main(); the task has nothing to do.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 benchIdleTask( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+  (void)events;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      benchRandom
+ *
+ * @brief   Deterministic pseudo-random numbers (xorshift32).
+ *
+ * @param   none
+ *
+ * @return  Next random number.
+ */
+static uint32 benchRandom( void )
+{
+  benchRand ^= benchRand << 13;
+  benchRand ^= benchRand >> 17;
+  benchRand ^= benchRand << 5;
+
+  return benchRand;
+}
+
+/*********************************************************************
+ * @fn      benchTraceAdd
+ *
+ * @brief   Append a heap call to a trace.
+ *
+ * @param   pTrace - trace
+ * @param   op - BENCH_OP_ALLOC or BENCH_OP_FREE
+ * @param   size - bytes allocated
+ * @param   slot - block number
+ *
+ * @return  none
+ */
+static void benchTraceAdd( benchTrace_t *pTrace, uint8 op, uint16 size, uint32 slot )
+{
+  if ( pTrace->cnt == pTrace->size )
+  {
+    pTrace->size = ( pTrace->size != 0 ) ? ( pTrace->size * 2 ) : 4096;
+    pTrace->pOps = realloc( pTrace->pOps, pTrace->size * sizeof( benchOp_t ) );
+    if ( pTrace->pOps == NULL )
+    {
+      fprintf( stderr, "out of memory\n" );
+      exit( 2 );
+    }
+  }
+
+  pTrace->pOps[pTrace->cnt].op = op;
+  pTrace->pOps[pTrace->cnt].size = size;
+  pTrace->pOps[pTrace->cnt].slot = slot;
+  pTrace->cnt++;
+
+  if ( slot >= pTrace->slotCnt )
+  {
+    pTrace->slotCnt = slot + 1;
+  }
+}
+
+/*********************************************************************
+ * @fn      benchGenerate
+ *
+ * @brief   Generate the trace of a built-in workload. Each block is
+ *          freed once its lifetime in allocations has passed, or when
+ *          BENCH_LIVE_MAX blocks are live, the block that would expire
+ *          first.
+ *
+ * @param   pWork - workload
+ * @param   allocs - number of allocations
+ * @param   pTrace - trace to fill
+ *
+ * @return  none
+ */
+static void benchGenerate( const benchWorkload_t *pWork, uint32 allocs, benchTrace_t *pTrace )
+{
+  static benchLive_t live[BENCH_LIVE_MAX];
+  const benchClass_t *pClass;
+  uint16 liveCnt = 0;
+  uint32 i;
+  uint16 idx, first;
+  uint32 pick;
+
+  for ( i = 0; i < allocs; i++ )
+  {
+    // Free the blocks whose time has come.
+    for ( idx = 0; idx < liveCnt; )
+    {
+      if ( live[idx].key <= i )
+      {
+        benchTraceAdd( pTrace, BENCH_OP_FREE, 0, live[idx].slot );
+        live[idx] = live[--liveCnt];
+      }
+      else
+      {
+        idx++;
+      }
+    }
+
+    if ( liveCnt == BENCH_LIVE_MAX )
+    {
+      for ( first = 0, idx = 1; idx < liveCnt; idx++ )
+      {
+        if ( live[idx].key < live[first].key )
+        {
+          first = idx;
+        }
+      }
+      benchTraceAdd( pTrace, BENCH_OP_FREE, 0, live[first].slot );
+      live[first] = live[--liveCnt];
+    }
+
+    pick = benchRandom() % 100;
+    for ( pClass = pWork->pClasses; pClass < pWork->pClasses + pWork->classCnt - 1; pClass++ )
+    {
+      if ( pick < pClass->weight )
+      {
+        break;
+      }
+      pick -= pClass->weight;
+    }
+
+    // Slot i: every allocation gets a block number of its own.
+    live[liveCnt].slot = i;
+    live[liveCnt].key = i + pClass->lifeMin + benchRandom() % ( pClass->lifeMax - pClass->lifeMin + 1 );
+    liveCnt++;
+
+    benchTraceAdd( pTrace, BENCH_OP_ALLOC,
+                   (uint16)( pClass->sizeMin + benchRandom() % ( pClass->sizeMax - pClass->sizeMin + 1 ) ),
+                   i );
+  }
+
+  for ( idx = 0; idx < liveCnt; idx++ )
+  {
+    benchTraceAdd( pTrace, BENCH_OP_FREE, 0, live[idx].slot );
+  }
+}
+
+/*********************************************************************
+ * @fn      benchParse
+ *
+ * @brief   Read the heap calls out of the log of a DPRINTF_OSALHEAPTRACE
+ *          build, matching each free to its allocation by address.
+ *          Other lines, failed allocations and frees of blocks
+ *          allocated before the log started are skipped.
+ *
+ * @param   pFile - log file
+ * @param   pTrace - trace to fill
+ *
+ * @return  none
+ */
+static void benchParse( FILE *pFile, benchTrace_t *pTrace )
+{
+  char line[BENCH_LINE_LEN];
+  benchLive_t *pLive = NULL;
+  uint32 liveCnt = 0, liveSize = 0;
+  uint32 slot = 0;
+  unsigned long addr;
+  unsigned size;
+  uint32 idx;
+
+  while ( fgets( line, sizeof( line ), pFile ) != NULL )
+  {
+    if ( sscanf( line, "osal_mem_alloc(%u)->%lx", &size, &addr ) == 2 )
+    {
+      if ( addr == 0 )
+      {
+        continue;
+      }
+      if ( liveCnt == liveSize )
+      {
+        liveSize = ( liveSize != 0 ) ? ( liveSize * 2 ) : 256;
+        pLive = realloc( pLive, liveSize * sizeof( benchLive_t ) );
+        if ( pLive == NULL )
+        {
+          fprintf( stderr, "out of memory\n" );
+          exit( 2 );
+        }
+      }
+      pLive[liveCnt].key = addr;
+      pLive[liveCnt].slot = slot;
+      liveCnt++;
+
+      benchTraceAdd( pTrace, BENCH_OP_ALLOC, (uint16)size, slot++ );
+    }
+    else if ( sscanf( line, "osal_mem_free(%lx)", &addr ) == 1 )
+    {
+      for ( idx = 0; idx < liveCnt; idx++ )
+      {
+        if ( pLive[idx].key == addr )
+        {
+          benchTraceAdd( pTrace, BENCH_OP_FREE, 0, pLive[idx].slot );
+          pLive[idx] = pLive[--liveCnt];
+          break;
+        }
+      }
+    }
+  }
+
+  // Free what the log leaves allocated, so that the heap is empty again.
+  for ( idx = 0; idx < liveCnt; idx++ )
+  {
+    benchTraceAdd( pTrace, BENCH_OP_FREE, 0, pLive[idx].slot );
+  }
+
+  free( pLive );
+}
+
+/*********************************************************************
+ * @fn      benchReplay
+ *
+ * @brief   Replay a trace against the OSAL heap and report the alloc
+ *          and free latency distributions.
+ *
+ * @param   name - trace name, the metric prefix of the reports
+ * @param   pTrace - trace
+ *
+ * @return  none
+ */
+static void benchReplay( const char *name, benchTrace_t *pTrace )
+{
+  hostSamples_t alloc, freed;
+  void **pSlots;
+  benchOp_t *pOp;
+  uint32 allocCnt = 0, failCnt = 0;
+  uint32 i;
+  uint64_t t0, t1;
+  char metric[64];
+
+  pSlots = calloc( pTrace->slotCnt, sizeof( void * ) );
+  if ( pSlots == NULL )
+  {
+    fprintf( stderr, "out of memory\n" );
+    exit( 2 );
+  }
+
+  hostSamplesInit( &alloc, pTrace->cnt );
+  hostSamplesInit( &freed, pTrace->cnt );
+
+  for ( i = 0; i < pTrace->cnt; i++ )
+  {
+    pOp = &pTrace->pOps[i];
+
+    if ( pOp->op == BENCH_OP_ALLOC )
+    {
+      t0 = hostCycles();
+      pSlots[pOp->slot] = osal_mem_alloc( pOp->size );
+      t1 = hostCycles();
+      hostSamplesAdd( &alloc, (uint32)( t1 - t0 ) );
+
+      allocCnt++;
+      if ( pSlots[pOp->slot] == NULL )
+      {
+        failCnt++;
+      }
+    }
+    else if ( pSlots[pOp->slot] != NULL )
+    {
+      t0 = hostCycles();
+      osal_mem_free( pSlots[pOp->slot] );
+      t1 = hostCycles();
+      hostSamplesAdd( &freed, (uint32)( t1 - t0 ) );
+
+      pSlots[pOp->slot] = NULL;
+    }
+  }
+
+  snprintf( metric, sizeof( metric ), "%s_alloc", name );
+  hostReportPercentiles( BENCH_ENGINE, metric, &alloc, hostCyclesUnit() );
+  snprintf( metric, sizeof( metric ), "%s_free", name );
+  hostReportPercentiles( BENCH_ENGINE, metric, &freed, hostCyclesUnit() );
+  snprintf( metric, sizeof( metric ), "%s_alloc_fail_rate", name );
+  hostReport( BENCH_ENGINE, metric, allocCnt ? (double)failCnt / allocCnt : 0, "ratio" );
+
+  hostSamplesFree( &alloc );
+  hostSamplesFree( &freed );
+  free( pSlots );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Replay the log files given on the command line or, without
+ *          any, the built-in workloads.
+ *
+ * @param   argc, argv - see hostInit(); arguments are log files
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  benchTrace_t trace;
+  FILE *pFile;
+  const char *pName;
+  int i;
+
+  hostInit( argc, argv, "osal" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  if ( hostArgCnt == 0 )
+  {
+    for ( i = 0; i < (int)( sizeof( benchWorkloads ) / sizeof( benchWorkloads[0] ) ); i++ )
+    {
+      osal_memset( &trace, 0, sizeof( trace ) );
+      benchGenerate( &benchWorkloads[i], hostScale( 1000000 ), &trace );
+      benchReplay( benchWorkloads[i].name, &trace );
+      free( trace.pOps );
+    }
+  }
+
+  for ( i = 0; i < hostArgCnt; i++ )
+  {
+    pFile = fopen( hostArgs[i], "r" );
+    if ( pFile == NULL )
+    {
+      fprintf( stderr, "cannot open %s\n", hostArgs[i] );
+      return 2;
+    }
+
+    osal_memset( &trace, 0, sizeof( trace ) );
+    benchParse( pFile, &trace );
+    fclose( pFile );
+
+    // Report under the file name, without its directory.
+    pName = strrchr( hostArgs[i], '/' );
+    benchReplay( ( pName != NULL ) ? ( pName + 1 ) : hostArgs[i], &trace );
+    free( trace.pOps );
+  }
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,343 @@
+/*************************************************************************************************
+  Filename:       bench_mem.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Bytes per cycle of the OSAL memory primitives for each size class,
+                  built with the C library paths of the host or with the byte loops of
+                  the 8051 (OSAL_MEM_BYTE_LOOPS).
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if defined ( OSAL_MEM_BYTE_LOOPS )
+  #define BENCH_NAME        "mem_byte_loops"
+#else
+  #define BENCH_NAME        "mem_libc"
+#endif
+
+#define BENCH_BUF_LEN       1024
+
+// Bytes moved per size class and primitive in a full run
+#define BENCH_BYTES         ( 16UL * 1024 * 1024 )
+
+// Primitives
+#define BENCH_MEMCPY        0
+#define BENCH_MEMCPY_XX     1
+#define BENCH_MEMCPY_CX     2
+#define BENCH_REVMEMCPY     3
+#define BENCH_MEMCMP        4
+#define BENCH_MEMSET        5
+#define BENCH_ISBUFSET      6
+#define BENCH_MEMDUP        7
+#define BENCH_PRIM_CNT      8
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Size classes: short fields, keys and addresses, ATT payloads, NV items
+// and messages, and bulk copies
+static const uint16 benchSizes[] = { 1, 2, 4, 8, 16, 27, 32, 64, 128, 255, 512, 1024 };
+
+static const char * const benchPrimNames[BENCH_PRIM_CNT] =
+{
+  "memcpy", "memcpy_xx", "memcpy_cx", "revmemcpy", "memcmp", "memset", "isbufset", "memdup"
+};
+
+// Source table in code memory for osal_memcpy_cx()
+static const uint8 CODE benchTable[BENCH_BUF_LEN] = { 0x5A };
+
+static uint16 benchEvents[1];
+
+static uint8 benchSrc[BENCH_BUF_LEN];
+static uint8 benchDst[BENCH_BUF_LEN];
+
+// Results are summed here so the calls cannot be left out
+static volatile uint32 benchSink;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 benchIdleTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[] =
+{
+  benchIdleTask
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents = benchEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the benchmark task.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  benchEvents[0] = 0;
+}
+
+/*********************************************************************
+ * @fn      benchIdleTask
+ *
+ * @brief   The benchmark runs from main(); the task has nothing to do.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 benchIdleTask( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+  (void)events;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      benchCall
+ *
+ * @brief   Call a primitive once on 'len' bytes.
+ *
+ * @param   prim - primitive
+ * @param   len - bytes
+ *
+ * @return  none
+ */
+static void benchCall( uint8 prim, uint16 len )
+{
+  void *p;
+
+  switch ( prim )
+  {
+    case BENCH_MEMCPY:
+      p = osal_memcpy( benchDst, benchSrc, len );
+      benchSink += ( (uint8 *)p == benchDst + len );
+      break;
+
+    case BENCH_MEMCPY_XX:
+      p = osal_memcpy_xx( benchDst, benchSrc, len );
+      benchSink += ( (uint8 *)p == benchDst + len );
+      break;
+
+    case BENCH_MEMCPY_CX:
+      p = osal_memcpy_cx( benchDst, benchTable, len );
+      benchSink += ( (uint8 *)p == benchDst + len );
+      break;
+
+    case BENCH_REVMEMCPY:
+      p = osal_revmemcpy( benchDst, benchSrc, len );
+      benchSink += ( (uint8 *)p == benchDst + len );
+      break;
+
+    case BENCH_MEMCMP:
+      // Equal buffers: the whole length is compared
+      benchSink += osal_memcmp( benchDst, benchSrc, len );
+      break;
+
+    case BENCH_MEMSET:
+      osal_memset( benchDst, 0xA5, len );
+      benchSink += benchDst[len - 1];
+      break;
+
+    case BENCH_ISBUFSET:
+      benchSink += osal_isbufset( benchDst, 0xA5, (uint8)len );
+      break;
+
+    case BENCH_MEMDUP:
+      p = osal_memdup( benchSrc, len );
+      benchSink += ( p != NULL );
+      osal_mem_free( p );
+      break;
+  }
+}
+
+/*********************************************************************
+ * @fn      benchCheck
+ *
+ * @brief   Check the result of each primitive once per size class.
+ *
+ * @param   len - bytes
+ *
+ * @return  none
+ */
+static void benchCheck( uint16 len )
+{
+  uint16 i;
+  uint8 *p;
+
+  osal_memset( benchDst, 0, sizeof( benchDst ) );
+  HOST_CHECK( osal_memcpy( benchDst, benchSrc, len ) == benchDst + len );
+  HOST_CHECK( osal_memcmp( benchDst, benchSrc, len ) );
+  HOST_CHECK( ( len == BENCH_BUF_LEN ) || ( benchDst[len] == 0 ) );
+
+  osal_memset( benchDst, 0, sizeof( benchDst ) );
+  osal_memcpy_xx( benchDst, benchSrc, len );
+  HOST_CHECK( osal_memcmp( benchDst, benchSrc, len ) );
+
+  osal_memcpy_cx( benchDst, benchTable, len );
+  HOST_CHECK( osal_memcmp( benchDst, benchTable, len ) );
+
+  osal_memset( benchDst, 0, sizeof( benchDst ) );
+  osal_revmemcpy( benchDst, benchSrc, len );
+  for ( i = 0; i < len; i++ )
+  {
+    HOST_CHECK( benchDst[i] == benchSrc[len - 1 - i] );
+  }
+  HOST_CHECK( ( len == BENCH_BUF_LEN ) || ( benchDst[len] == 0 ) );
+
+  if ( len > 1 )
+  {
+    osal_memcpy( benchDst, benchSrc, len );
+    benchDst[len - 1] ^= 1;
+    HOST_CHECK( !osal_memcmp( benchDst, benchSrc, len ) );
+  }
+
+  if ( len <= 0xFF )
+  {
+    osal_memset( benchDst, 0xA5, len );
+    HOST_CHECK( osal_isbufset( benchDst, 0xA5, (uint8)len ) );
+    benchDst[len - 1] = 0xA4;
+    HOST_CHECK( !osal_isbufset( benchDst, 0xA5, (uint8)len ) );
+
+    p = osal_memdup( benchSrc, len );
+    HOST_CHECK( p != NULL );
+    if ( p != NULL )
+    {
+      HOST_CHECK( osal_memcmp( p, benchSrc, len ) );
+      osal_mem_free( p );
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Measure the memory primitives for each size class.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  char metric[32];
+  char unit[16];
+  uint16 i;
+  uint8 s, prim;
+
+  hostInit( argc, argv, "osal" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  for ( i = 0; i < BENCH_BUF_LEN; i++ )
+  {
+    benchSrc[i] = (uint8)( i * 7 + 1 );
+  }
+  sprintf( unit, "bytes/%s", hostCyclesUnit() );
+  if ( unit[strlen( unit ) - 1] == 's' )
+  {
+    unit[strlen( unit ) - 1] = '\0';
+  }
+
+  for ( s = 0; s < sizeof( benchSizes ) / sizeof( benchSizes[0] ); s++ )
+  {
+    uint16 len = benchSizes[s];
+    uint32 calls = hostScale( BENCH_BYTES / len );
+
+    benchCheck( len );
+
+    for ( prim = 0; prim < BENCH_PRIM_CNT; prim++ )
+    {
+      uint64_t t0, t1;
+      uint32 n;
+
+      // osal_isbufset() takes a uint8 length; the heap limits osal_memdup()
+      if ( ( ( prim == BENCH_ISBUFSET ) || ( prim == BENCH_MEMDUP ) ) && ( len > 0xFF ) )
+      {
+        continue;
+      }
+
+      osal_memset( benchDst, 0xA5, sizeof( benchDst ) );
+      osal_memcpy( benchDst, benchSrc, len );
+      if ( prim == BENCH_ISBUFSET )
+      {
+        osal_memset( benchDst, 0xA5, len );
+      }
+
+      t0 = hostCycles();
+      for ( n = 0; n < calls; n++ )
+      {
+        benchCall( prim, len );
+      }
+      t1 = hostCycles();
+
+      sprintf( metric, "%s_%u", benchPrimNames[prim], (unsigned)len );
+      hostReport( BENCH_NAME, metric, (double)len * calls / (double)( t1 - t0 ), unit );
+    }
+  }
+
+  HOST_CHECK( benchSink != 0 );
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
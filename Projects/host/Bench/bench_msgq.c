@@ -0,0 +1,243 @@
+/*************************************************************************************************
+  Filename:       bench_msgq.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Message queue benchmark: throughput of allocate, send, receive
+                  and deallocate between two tasks.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define BENCH_PRODUCER    0
+#define BENCH_CONSUMER    1
+
+#define BENCH_SEND_EVT    0x0001
+
+// Messages sent per producer run, and their payload length
+#define BENCH_BURST       16
+#define BENCH_MSG_LEN     20
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 benchEvents[2];
+
+static uint32 benchSent;
+static uint32 benchReceived;
+static uint32 benchFailed;
+
+static hostSamples_t benchSend;
+static hostSamples_t benchRecv;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 benchProducer( uint8 task_id, uint16 events );
+static uint16 benchConsumer( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[] =
+{
+  benchProducer,
+  benchConsumer
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents = benchEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the benchmark tasks.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  osal_memset( benchEvents, 0, sizeof( benchEvents ) );
+}
+
+/*********************************************************************
+ * @fn      benchProducer
+ *
+ * @brief   Send a burst of messages to the consumer.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 benchProducer( uint8 task_id, uint16 events )
+{
+  uint8 *pMsg;
+  uint8 i;
+  uint64_t t0;
+
+  (void)task_id;
+
+  if ( events & BENCH_SEND_EVT )
+  {
+    for ( i = 0; i < BENCH_BURST; i++ )
+    {
+      t0 = hostCycles();
+      pMsg = osal_msg_allocate( BENCH_MSG_LEN );
+      if ( pMsg == NULL )
+      {
+        benchFailed++;
+        break;
+      }
+      ((osal_event_hdr_t *)pMsg)->event = 0x01;
+      osal_msg_send( BENCH_CONSUMER, pMsg );
+      hostSamplesAdd( &benchSend, (uint32)( hostCycles() - t0 ) );
+      benchSent++;
+    }
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      benchConsumer
+ *
+ * @brief   Receive and release one message per run, as applications do.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  events not processed
+ */
+static uint16 benchConsumer( uint8 task_id, uint16 events )
+{
+  uint8 *pMsg;
+  uint64_t t0;
+
+  if ( events & SYS_EVENT_MSG )
+  {
+    t0 = hostCycles();
+    pMsg = osal_msg_receive( task_id );
+    if ( pMsg != NULL )
+    {
+      osal_msg_deallocate( pMsg );
+      hostSamplesAdd( &benchRecv, (uint32)( hostCycles() - t0 ) );
+      benchReceived++;
+
+      // Come back for the next message
+      return ( events );
+    }
+
+    return ( events ^ SYS_EVENT_MSG );
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the message queue benchmark.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  uint32 bursts;
+  uint32 i;
+  uint16 depth = 0;
+  uint64_t begin, elapsed;
+
+  hostInit( argc, argv, "osal" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  bursts = hostScale( 200000 );
+  hostSamplesInit( &benchSend, bursts * BENCH_BURST );
+  hostSamplesInit( &benchRecv, bursts * BENCH_BURST );
+
+  begin = hostNanos();
+
+  for ( i = 0; i < bursts; i++ )
+  {
+    osal_set_event( BENCH_PRODUCER, BENCH_SEND_EVT );
+
+    while ( tasksEvents[BENCH_PRODUCER] || tasksEvents[BENCH_CONSUMER] )
+    {
+      if ( osal_msg_queue_depth( BENCH_CONSUMER ) > depth )
+      {
+        depth = osal_msg_queue_depth( BENCH_CONSUMER );
+      }
+      osal_run_system();
+    }
+  }
+
+  elapsed = hostNanos() - begin;
+
+  hostReport( "msg_queue", "msgs_per_sec", benchReceived * 1e9 / elapsed, "1/s" );
+  hostReportPercentiles( "msg_queue", "send", &benchSend, hostCyclesUnit() );
+  hostReportPercentiles( "msg_queue", "receive", &benchRecv, hostCyclesUnit() );
+  hostReport( "msg_queue", "depth_max", osal_msg_queue_max( BENCH_CONSUMER ), "msgs" );
+
+  HOST_CHECK( benchFailed == 0 );
+  HOST_CHECK( benchSent == bursts * BENCH_BURST );
+  HOST_CHECK( benchReceived == benchSent );
+  HOST_CHECK( depth == BENCH_BURST );
+
+  hostSamplesFree( &benchSend );
+  hostSamplesFree( &benchRecv );
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,267 @@
+/*************************************************************************************************
+  Filename:       bench_sched.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Scheduler dispatch benchmark: osal_run_system() with the ready
+                  bitmap against the linear scan of tasksEvents[] it replaced,
+                  idle and dispatching the first or the last task. Built once
+                  per BENCH_TASK_CNT of 8, 16 and 32 tasks.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+
+#include "hal_mcu.h"
+#include "hal_drivers.h"
+#include "OSAL.h"
+#include "OSAL_Clock.h"
+#include "OSAL_Tasks.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if !defined ( BENCH_TASK_CNT )
+  #define BENCH_TASK_CNT  32
+#endif
+
+#if ( BENCH_TASK_CNT > 32 )
+  #error BENCH_TASK_CNT is limited by the size of tasksArr[].
+#endif
+
+#define BENCH_EVT         0x0001
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 benchEvents[BENCH_TASK_CNT];
+static uint32 benchDispatched;
+
+// Name of the benchmark in the reports, with the task count
+static char benchName[16];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 benchTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// Only the first BENCH_TASK_CNT tasks are registered with tasksCnt.
+const pTaskEventHandlerFn tasksArr[32] =
+{
+  benchTask, benchTask, benchTask, benchTask,
+  benchTask, benchTask, benchTask, benchTask,
+  benchTask, benchTask, benchTask, benchTask,
+  benchTask, benchTask, benchTask, benchTask,
+  benchTask, benchTask, benchTask, benchTask,
+  benchTask, benchTask, benchTask, benchTask,
+  benchTask, benchTask, benchTask, benchTask,
+  benchTask, benchTask, benchTask, benchTask
+};
+
+const uint8 tasksCnt = BENCH_TASK_CNT;
+uint16 *tasksEvents = benchEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the benchmark tasks.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  osal_memset( benchEvents, 0, sizeof( benchEvents ) );
+}
+
+/*********************************************************************
+ * @fn      benchTask
+ *
+ * @brief   Count the dispatch and consume the events.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 benchTask( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+  (void)events;
+
+  benchDispatched++;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      benchRefRunSystem
+ *
+ * @brief   One pass of the scheduler as it was before the ready bitmap:
+ *          a scan of tasksEvents[] from the highest priority task on
+ *          every pass, idle or not. The events are set directly in
+ *          tasksEvents[] so the ready bitmap of OSAL is left alone.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchRefRunSystem( void )
+{
+  uint8 idx = 0;
+
+  osalTimeUpdate();
+  Hal_ProcessPoll();
+
+  do {
+    if (tasksEvents[idx])  // Task is highest priority that is ready.
+    {
+      break;
+    }
+  } while (++idx < tasksCnt);
+
+  if (idx < tasksCnt)
+  {
+    uint16 events;
+    halIntState_t intState;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    events = tasksEvents[idx];
+    tasksEvents[idx] = 0;  // Clear the Events for this task.
+    HAL_EXIT_CRITICAL_SECTION(intState);
+
+    events = (tasksArr[idx])( idx, events );
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    tasksEvents[idx] |= events;  // Add back unprocessed events to the current task.
+    HAL_EXIT_CRITICAL_SECTION(intState);
+  }
+}
+
+/*********************************************************************
+ * @fn      benchPass
+ *
+ * @brief   Measure scheduler passes, each one dispatching the given
+ *          task or, with TASK_NO_TASK, finding no task ready.
+ *
+ * @param   metric - metric name of the report
+ * @param   task_id - task to dispatch, or TASK_NO_TASK
+ * @param   ref - TRUE to measure the linear scan instead of OSAL
+ *
+ * @return  none
+ */
+static void benchPass( const char *metric, uint8 task_id, uint8 ref )
+{
+  hostSamples_t pass;
+  uint32 rounds = hostScale( 1000000 );
+  uint32 i;
+  uint64_t t0, t1;
+
+  hostSamplesInit( &pass, rounds );
+  benchDispatched = 0;
+
+  for ( i = 0; i < rounds; i++ )
+  {
+    if ( task_id != TASK_NO_TASK )
+    {
+      if ( ref )
+      {
+        tasksEvents[task_id] = BENCH_EVT;
+      }
+      else
+      {
+        osal_set_event( task_id, BENCH_EVT );
+      }
+    }
+
+    t0 = hostCycles();
+    if ( ref )
+    {
+      benchRefRunSystem();
+    }
+    else
+    {
+      osal_run_system();
+    }
+    t1 = hostCycles();
+    hostSamplesAdd( &pass, (uint32)( t1 - t0 ) );
+  }
+
+  HOST_CHECK( benchDispatched == ( ( task_id != TASK_NO_TASK ) ? rounds : 0 ) );
+
+  hostReportPercentiles( benchName, metric, &pass, hostCyclesUnit() );
+  hostSamplesFree( &pass );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the scheduler benchmarks.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  hostInit( argc, argv, "osal" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  sprintf( benchName, "sched_%u", (unsigned)BENCH_TASK_CNT );
+
+  benchPass( "idle", TASK_NO_TASK, FALSE );
+  benchPass( "idle_ref", TASK_NO_TASK, TRUE );
+  benchPass( "dispatch_first", 0, FALSE );
+  benchPass( "dispatch_first_ref", 0, TRUE );
+  benchPass( "dispatch_last", BENCH_TASK_CNT - 1, FALSE );
+  benchPass( "dispatch_last_ref", BENCH_TASK_CNT - 1, TRUE );
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
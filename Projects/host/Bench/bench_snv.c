@@ -0,0 +1,252 @@
+/*************************************************************************************************
+  Filename:       bench_snv.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    SNV benchmark: read and write latency, the cost of the writes
+                  that compact the NV page, and the flash wear per write.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "osal_snv.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Items of a bond-like record set: IDs and lengths
+#define BENCH_ITEM_BASE     0x80
+#define BENCH_ITEM_CNT      24
+#define BENCH_ITEM_MAX_LEN  32
+
+// CC2540 flash timing, to turn flash operations into blocking time on the target
+#define BENCH_WORD_WRITE_US 20
+#define BENCH_PAGE_ERASE_US 20000
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 benchEvents[1];
+static uint32 benchRand = 1;
+
+static uint8 benchLen[BENCH_ITEM_CNT];
+static uint8 benchValue[BENCH_ITEM_CNT][BENCH_ITEM_MAX_LEN];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 benchIdleTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[] =
+{
+  benchIdleTask
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents = benchEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the benchmark task.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  benchEvents[0] = 0;
+}
+
+/*********************************************************************
+ * @fn      benchIdleTask
+ *
+ * @brief   The benchmark runs from main(); the task has nothing to do.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 benchIdleTask( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+  (void)events;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      benchRandom
+ *
+ * @brief   Deterministic pseudo-random numbers (xorshift32).
+ *
+ * @param   none
+ *
+ * @return  Next random number.
+ */
+static uint32 benchRandom( void )
+{
+  benchRand ^= benchRand << 13;
+  benchRand ^= benchRand >> 17;
+  benchRand ^= benchRand << 5;
+
+  return benchRand;
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the SNV benchmark.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  hostSamples_t rd, wr, compact;
+  uint8 buf[BENCH_ITEM_MAX_LEN];
+  uint32 writes;
+  uint32 i;
+  uint32 erases, erasesBefore, erasesStart;
+  uint32 words, wordsBefore, wordsStart;
+  uint32 worstUs = 0;
+  uint8 idx;
+  uint8 bad = 0;
+  uint64_t t0, t1;
+
+  hostInit( argc, argv, "osal" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+  osal_snv_init();
+
+  for ( idx = 0; idx < BENCH_ITEM_CNT; idx++ )
+  {
+    benchLen[idx] = (uint8)( 4 + ( idx * 7 ) % ( BENCH_ITEM_MAX_LEN - 3 ) );
+    osal_memset( benchValue[idx], idx, benchLen[idx] );
+    osal_snv_write( BENCH_ITEM_BASE + idx, benchLen[idx], benchValue[idx] );
+  }
+
+  writes = hostScale( 200000 );
+  hostSamplesInit( &rd, writes );
+  hostSamplesInit( &wr, writes );
+  hostSamplesInit( &compact, writes );
+
+  HalFlashStats( NULL, &erasesStart );
+  osal_snv_stats( NULL, &wordsStart );
+
+  for ( i = 0; i < writes; i++ )
+  {
+    idx = (uint8)( benchRandom() % BENCH_ITEM_CNT );
+    benchValue[idx][benchRandom() % benchLen[idx]] = (uint8)benchRandom();
+
+    HalFlashStats( NULL, &erasesBefore );
+    osal_snv_stats( NULL, &wordsBefore );
+
+    t0 = hostCycles();
+    osal_snv_write( BENCH_ITEM_BASE + idx, benchLen[idx], benchValue[idx] );
+    t1 = hostCycles();
+
+    HalFlashStats( NULL, &erases );
+    osal_snv_stats( NULL, &words );
+
+    if ( erases != erasesBefore )
+    {
+      // This write compacted the page
+      uint32 us = ( words - wordsBefore ) * BENCH_WORD_WRITE_US +
+                  ( erases - erasesBefore ) * BENCH_PAGE_ERASE_US;
+
+      hostSamplesAdd( &compact, (uint32)( t1 - t0 ) );
+      if ( us > worstUs )
+      {
+        worstUs = us;
+      }
+    }
+    else
+    {
+      hostSamplesAdd( &wr, (uint32)( t1 - t0 ) );
+    }
+
+    idx = (uint8)( benchRandom() % BENCH_ITEM_CNT );
+
+    t0 = hostCycles();
+    osal_snv_read( BENCH_ITEM_BASE + idx, benchLen[idx], buf );
+    t1 = hostCycles();
+    hostSamplesAdd( &rd, (uint32)( t1 - t0 ) );
+
+    if ( osal_memcmp( buf, benchValue[idx], benchLen[idx] ) == FALSE )
+    {
+      bad++;
+    }
+  }
+
+  HalFlashStats( NULL, &erases );
+  osal_snv_stats( NULL, &words );
+
+  hostReportPercentiles( "snv", "read", &rd, hostCyclesUnit() );
+  hostReportPercentiles( "snv", "write", &wr, hostCyclesUnit() );
+  hostReportPercentiles( "snv", "compacting_write", &compact, hostCyclesUnit() );
+  hostReport( "snv", "compactions", compact.cnt, "writes" );
+  hostReport( "snv", "compacting_write_target_max", worstUs / 1000.0, "ms" );
+  hostReport( "snv", "flash_words_per_write", (double)( words - wordsStart ) / writes, "words" );
+  hostReport( "snv", "writes_per_erase",
+              ( erases != erasesStart ) ? (double)writes / ( erases - erasesStart ) : 0, "writes" );
+
+  HOST_CHECK( bad == 0 );
+  HOST_CHECK( compact.cnt > 0 );
+
+  hostSamplesFree( &rd );
+  hostSamplesFree( &wr );
+  hostSamplesFree( &compact );
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,292 @@
+/*************************************************************************************************
+  Filename:       bench_snv_bond.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Bond save latency and flash words of the GAP bond manager's NV
+                  records, written item by item and as one batch.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+
+#include "hal_board_cfg.h"
+#include "hal_flash.h"
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "osal_snv.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// NV layout of the bond manager (gapbondmgr.c, bcomdef.h)
+#define BENCH_BONDINGS_MAX      10
+#define BENCH_BOND_NVID_START   0x20
+#define BENCH_BOND_REC_IDS      6
+#define BENCH_GATT_NVID_START   0x70
+
+// Items of a bond record, with their lengths on the target
+#define BENCH_BOND_ITEM_CNT     7
+#define BENCH_BOND_ITEM_MAX_LEN 27
+
+#define BENCH_SAVES             20000
+
+// CC2540 flash timing, to turn flash operations into blocking time on the target
+#define BENCH_WORD_WRITE_US     20
+#define BENCH_PAGE_ERASE_US     20000
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Main record, local LTK, device LTK, IRK, CSRK, sign counter, char config
+static const uint8 benchBondLen[BENCH_BOND_ITEM_CNT] = { 14, 27, 27, 16, 16, 4, 12 };
+
+static uint16 benchEvents[1];
+static uint32 benchRand = 1;
+
+static uint8 benchValue[BENCH_BOND_ITEM_CNT][BENCH_BOND_ITEM_MAX_LEN];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 benchIdleTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[] =
+{
+  benchIdleTask
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents = benchEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the benchmark task.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  benchEvents[0] = 0;
+}
+
+/*********************************************************************
+ * @fn      benchIdleTask
+ *
+ * @brief   The benchmark runs from main(); the task has nothing to do.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 benchIdleTask( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+  (void)events;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      benchRandom
+ *
+ * @brief   Deterministic pseudo-random numbers (xorshift32).
+ *
+ * @param   none
+ *
+ * @return  Next random number.
+ */
+static uint32 benchRandom( void )
+{
+  benchRand ^= benchRand << 13;
+  benchRand ^= benchRand >> 17;
+  benchRand ^= benchRand << 5;
+
+  return benchRand;
+}
+
+/*********************************************************************
+ * @fn      benchBondItems
+ *
+ * @brief   Fill in the items of a new bond in a random slot: fresh keys,
+ *          a zero sign counter and an erased char config record.
+ *
+ * @param   pItems - receives the items
+ *
+ * @return  none
+ */
+static void benchBondItems( osalSnvItem_t *pItems )
+{
+  uint8 bondIdx = (uint8)( benchRandom() % BENCH_BONDINGS_MAX );
+  uint8 k, i;
+
+  for ( k = 0; k < BENCH_BOND_ITEM_CNT; k++ )
+  {
+    for ( i = 0; i < benchBondLen[k]; i++ )
+    {
+      benchValue[k][i] = (uint8)benchRandom();
+    }
+
+    pItems[k].id = BENCH_BOND_NVID_START + bondIdx * BENCH_BOND_REC_IDS + k;
+    pItems[k].len = benchBondLen[k];
+    pItems[k].pBuf = benchValue[k];
+  }
+
+  osal_memset( benchValue[5], 0, benchBondLen[5] );
+  osal_memset( benchValue[6], 0xFF, benchBondLen[6] );
+  pItems[6].id = BENCH_GATT_NVID_START + bondIdx;
+}
+
+/*********************************************************************
+ * @fn      benchSaves
+ *
+ * @brief   Save bonds on freshly erased NV pages, item by item or as a
+ *          batch, and report the latency and flash work per save.
+ *
+ * @param   name - prefix of the metric names
+ * @param   batch - TRUE to write each bond with one batch
+ *
+ * @return  none
+ */
+static void benchSaves( const char *name, uint8 batch )
+{
+  osalSnvItem_t items[BENCH_BOND_ITEM_CNT];
+  hostSamples_t save;
+  uint32 saves = hostScale( BENCH_SAVES );
+  uint32 words, wordsStart;
+  uint32 erases, erasesStart;
+  uint32 i;
+  uint8 k;
+  uint8 bad = 0;
+  uint64_t t0, t1;
+  char metric[40];
+
+  for ( k = HAL_NV_PAGE_BEG; k < HAL_NV_PAGE_BEG + HAL_NV_PAGE_CNT; k++ )
+  {
+    HalFlashErase( k );
+  }
+  osal_snv_init();
+
+  hostSamplesInit( &save, saves );
+  osal_snv_stats( NULL, &wordsStart );
+  HalFlashStats( NULL, &erasesStart );
+
+  for ( i = 0; i < saves; i++ )
+  {
+    benchBondItems( items );
+
+    t0 = hostCycles();
+    if ( batch )
+    {
+      bad |= ( osal_snv_write_batch( items, BENCH_BOND_ITEM_CNT ) != SUCCESS );
+    }
+    else
+    {
+      for ( k = 0; k < BENCH_BOND_ITEM_CNT; k++ )
+      {
+        bad |= ( osal_snv_write( items[k].id, items[k].len, items[k].pBuf ) != SUCCESS );
+      }
+    }
+    t1 = hostCycles();
+    hostSamplesAdd( &save, (uint32)( t1 - t0 ) );
+  }
+
+  osal_snv_stats( NULL, &words );
+  HalFlashStats( NULL, &erases );
+  words -= wordsStart;
+  erases -= erasesStart;
+
+  // The last bond reads back
+  for ( k = 0; k < BENCH_BOND_ITEM_CNT; k++ )
+  {
+    uint8 buf[BENCH_BOND_ITEM_MAX_LEN];
+
+    bad |= ( osal_snv_read( items[k].id, items[k].len, buf ) != SUCCESS );
+    bad |= !osal_memcmp( buf, items[k].pBuf, items[k].len );
+  }
+  HOST_CHECK( bad == 0 );
+
+  hostReportPercentiles( "snv_bond", name, &save, hostCyclesUnit() );
+  sprintf( metric, "%s_flash_words", name );
+  hostReport( "snv_bond", metric, (double)words / saves, "words" );
+  sprintf( metric, "%s_target_mean", name );
+  hostReport( "snv_bond", metric,
+              ( (double)words * BENCH_WORD_WRITE_US + (double)erases * BENCH_PAGE_ERASE_US ) /
+              saves / 1000.0, "ms" );
+  sprintf( metric, "%s_saves_per_erase", name );
+  hostReport( "snv_bond", metric, erases ? (double)saves / erases : 0, "saves" );
+
+  hostSamplesFree( &save );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the bond save benchmark.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  hostInit( argc, argv, "osal" );
+
+  osal_snv_init();
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  benchSaves( "single", FALSE );
+  benchSaves( "batch", TRUE );
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
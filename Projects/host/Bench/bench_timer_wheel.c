@@ -0,0 +1,404 @@
+/*************************************************************************************************
+  Filename:       bench_timer_wheel.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Timer wheel benchmark with 1024 live timers: start cost, clock
+                  ticks per second and the longest critical section the timer
+                  code holds while ticking and while a whole wheel slot expires.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "OSAL_Timers.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define BENCH_TASK_CNT    64
+#define BENCH_EVT_CNT     16   // Every event bit of a task runs a timer
+#define BENCH_TIMER_CNT   ( BENCH_TASK_CNT * BENCH_EVT_CNT )
+#define BENCH_MAX_TIMEOUT 2000 // Longest timeout in msecs
+#define BENCH_BURST_TIME  1000 // Timeout shared by all timers of the burst
+
+#if ( OSAL_TIMERS_POOL_CNT < BENCH_TIMER_CNT )
+  #error The benchmark needs a timer pool of BENCH_TIMER_CNT records.
+#endif
+
+/*********************************************************************
+ * MACROS
+ */
+
+#define BENCH_TASK( idx )   ( (uint8)( (idx) / BENCH_EVT_CNT ) )
+#define BENCH_EVT( idx )    ( (uint16)BV( (idx) % BENCH_EVT_CNT ) )
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 benchEvents[BENCH_TASK_CNT];
+static uint32 benchRand = 1;
+
+// TRUE to restart each timer as it fires
+static uint8 benchRestart;
+static uint32 benchFired;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 benchTimerTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[BENCH_TASK_CNT] =
+{
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask
+};
+
+const uint8 tasksCnt = BENCH_TASK_CNT;
+uint16 *tasksEvents = benchEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the benchmark tasks.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  osal_memset( benchEvents, 0, sizeof( benchEvents ) );
+}
+
+/*********************************************************************
+ * @fn      benchRandom
+ *
+ * @brief   Deterministic pseudo-random numbers (xorshift32).
+ *
+ * @param   none
+ *
+ * @return  Next random number.
+ */
+static uint32 benchRandom( void )
+{
+  benchRand ^= benchRand << 13;
+  benchRand ^= benchRand >> 17;
+  benchRand ^= benchRand << 5;
+
+  return benchRand;
+}
+
+/*********************************************************************
+ * @fn      benchTimeout
+ *
+ * @brief   Pick a random timeout.
+ *
+ * @param   none
+ *
+ * @return  Timeout of 1 to BENCH_MAX_TIMEOUT msecs.
+ */
+static uint16 benchTimeout( void )
+{
+  return (uint16)( 1 + benchRandom() % BENCH_MAX_TIMEOUT );
+}
+
+/*********************************************************************
+ * @fn      benchTimerTask
+ *
+ * @brief   Count the timer events of a task and restart their timers.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 benchTimerTask( uint8 task_id, uint16 events )
+{
+  uint8 evt;
+
+  for ( evt = 0; evt < BENCH_EVT_CNT; evt++ )
+  {
+    if ( events & BV( evt ) )
+    {
+      benchFired++;
+
+      if ( benchRestart )
+      {
+        osal_start_timerEx( task_id, BV( evt ), benchTimeout() );
+      }
+    }
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      benchRunIdle
+ *
+ * @brief   Run the scheduler until no task has events left.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchRunIdle( void )
+{
+  uint8 idx;
+
+  do
+  {
+    osal_run_system();
+
+    for ( idx = 0; idx < tasksCnt; idx++ )
+    {
+      if ( tasksEvents[idx] )
+      {
+        break;
+      }
+    }
+  } while ( idx < tasksCnt );
+}
+
+/*********************************************************************
+ * @fn      benchStopAll
+ *
+ * @brief   Stop every timer and drain the events already set.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchStopAll( void )
+{
+  uint16 idx;
+
+  benchRestart = FALSE;
+  for ( idx = 0; idx < BENCH_TIMER_CNT; idx++ )
+  {
+    osal_stop_timerEx( BENCH_TASK( idx ), BENCH_EVT( idx ) );
+  }
+  benchRunIdle();
+}
+
+/*********************************************************************
+ * @fn      benchStart
+ *
+ * @brief   Measure starting new timers up to BENCH_TIMER_CNT live
+ *          ones, then restarting live timers.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchStart( void )
+{
+  hostSamples_t start, restart;
+  uint32 rounds = hostScale( 200000 );
+  uint32 i;
+  uint16 idx;
+  uint64_t t0, t1;
+
+  hostSamplesInit( &start, BENCH_TIMER_CNT );
+  hostSamplesInit( &restart, rounds );
+
+  for ( idx = 0; idx < BENCH_TIMER_CNT; idx++ )
+  {
+    t0 = hostCycles();
+    osal_start_timerEx( BENCH_TASK( idx ), BENCH_EVT( idx ), benchTimeout() );
+    t1 = hostCycles();
+    hostSamplesAdd( &start, (uint32)( t1 - t0 ) );
+  }
+
+  for ( i = 0; i < rounds; i++ )
+  {
+    idx = (uint16)( benchRandom() % BENCH_TIMER_CNT );
+
+    t0 = hostCycles();
+    osal_start_timerEx( BENCH_TASK( idx ), BENCH_EVT( idx ), benchTimeout() );
+    t1 = hostCycles();
+    hostSamplesAdd( &restart, (uint32)( t1 - t0 ) );
+  }
+
+  hostReport( "timer_wheel", "live_timers", BENCH_TIMER_CNT, "timers" );
+  hostReportPercentiles( "timer_wheel", "start", &start, hostCyclesUnit() );
+  hostReportPercentiles( "timer_wheel", "restart", &restart, hostCyclesUnit() );
+
+  hostSamplesFree( &start );
+  hostSamplesFree( &restart );
+}
+
+/*********************************************************************
+ * @fn      benchTicks
+ *
+ * @brief   Measure 1 msec clock ticks with all timers live, each
+ *          restarting as it fires.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchTicks( void )
+{
+  hostSamples_t tick;
+  uint32 ticks = hostScale( 1000000 );
+  uint32 i;
+  uint32 critCnt, critMax;
+  uint64_t t0, t1, begin;
+
+  benchRestart = TRUE;
+  benchFired = 0;
+
+  hostSamplesInit( &tick, ticks );
+  HalCriticalStatsReset();
+  begin = hostNanos();
+
+  for ( i = 0; i < ticks; i++ )
+  {
+    t0 = hostCycles();
+    HalClockAdvance( 1000 );
+    benchRunIdle();
+    t1 = hostCycles();
+    hostSamplesAdd( &tick, (uint32)( t1 - t0 ) );
+  }
+
+  hostReport( "timer_wheel", "ticks_per_sec", ticks * 1e9 / ( hostNanos() - begin ), "1/s" );
+  hostReport( "timer_wheel", "expiries_per_tick", (double)benchFired / ticks, "timers" );
+  hostReportPercentiles( "timer_wheel", "tick", &tick, hostCyclesUnit() );
+
+  HalCriticalStats( &critCnt, &critMax );
+  hostReport( "timer_wheel", "tick_critical_sections", (double)critCnt / ticks, "sections" );
+  hostReport( "timer_wheel", "tick_critical_p99", HalCriticalPercentile( 99 ), "ns" );
+  hostReport( "timer_wheel", "tick_critical_max", critMax, "ns" );
+
+  hostSamplesFree( &tick );
+  benchStopAll();
+}
+
+/*********************************************************************
+ * @fn      benchBurst
+ *
+ * @brief   Measure all timers expiring at the same msec, the longest
+ *          run of work the timer code does for one clock update.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchBurst( void )
+{
+  uint32 rounds = hostScale( 1000 );
+  uint32 i;
+  uint32 critMax;
+  uint16 idx;
+  uint64_t t0;
+  uint64_t total = 0;
+
+  HalCriticalStatsReset();
+
+  for ( i = 0; i < rounds; i++ )
+  {
+    for ( idx = 0; idx < BENCH_TIMER_CNT; idx++ )
+    {
+      osal_start_timerEx( BENCH_TASK( idx ), BENCH_EVT( idx ), BENCH_BURST_TIME );
+    }
+
+    benchFired = 0;
+    t0 = hostNanos();
+    HalClockAdvance( BENCH_BURST_TIME * 1000UL );
+    benchRunIdle();
+    total += hostNanos() - t0;
+
+    HOST_CHECK( benchFired == BENCH_TIMER_CNT );
+  }
+
+  HalCriticalStats( NULL, &critMax );
+  hostReport( "timer_wheel", "burst_per_timer", (double)total / rounds / BENCH_TIMER_CNT, "ns" );
+  hostReport( "timer_wheel", "burst_critical_p99", HalCriticalPercentile( 99 ), "ns" );
+  hostReport( "timer_wheel", "burst_critical_max", critMax, "ns" );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the timer wheel benchmarks.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  hostInit( argc, argv, "osal" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  benchStart();
+  benchTicks();
+  benchBurst();
+
+  HOST_CHECK( osal_timer_num_active() == 0 );
+  HOST_CHECK( osal_timer_pool_overflow() == 0 );
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,336 @@
+/*************************************************************************************************
+  Filename:       bench_timers.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Timer churn benchmark: start/stop cost with many live timers and
+                  the cost of ticking through their expiries.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "OSAL_Timers.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define BENCH_TASK_CNT    32
+#define BENCH_EVT_CNT     15   // Timer events per task, SYS_EVENT_MSG excluded
+#define BENCH_TIMER_CNT   ( BENCH_TASK_CNT * BENCH_EVT_CNT )
+#define BENCH_MAX_TIMEOUT 2000 // Longest timeout in msecs
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 benchEvents[BENCH_TASK_CNT];
+static uint32 benchRand = 1;
+
+// TRUE to restart each timer as it fires
+static uint8 benchRestart;
+static uint32 benchFired;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 benchTimerTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[BENCH_TASK_CNT] =
+{
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask,
+  benchTimerTask, benchTimerTask, benchTimerTask, benchTimerTask
+};
+
+const uint8 tasksCnt = BENCH_TASK_CNT;
+uint16 *tasksEvents = benchEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the benchmark tasks.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  osal_memset( benchEvents, 0, sizeof( benchEvents ) );
+}
+
+/*********************************************************************
+ * @fn      benchRandom
+ *
+ * @brief   Deterministic pseudo-random numbers (xorshift32).
+ *
+ * @param   none
+ *
+ * @return  Next random number.
+ */
+static uint32 benchRandom( void )
+{
+  benchRand ^= benchRand << 13;
+  benchRand ^= benchRand >> 17;
+  benchRand ^= benchRand << 5;
+
+  return benchRand;
+}
+
+/*********************************************************************
+ * @fn      benchTimeout
+ *
+ * @brief   Pick a random timeout.
+ *
+ * @param   none
+ *
+ * @return  Timeout of 1 to BENCH_MAX_TIMEOUT msecs.
+ */
+static uint16 benchTimeout( void )
+{
+  return (uint16)( 1 + benchRandom() % BENCH_MAX_TIMEOUT );
+}
+
+/*********************************************************************
+ * @fn      benchTimerTask
+ *
+ * @brief   Count the timer events of a task and restart their timers.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 benchTimerTask( uint8 task_id, uint16 events )
+{
+  uint8 evt;
+
+  for ( evt = 0; evt < BENCH_EVT_CNT; evt++ )
+  {
+    if ( events & BV( evt ) )
+    {
+      benchFired++;
+
+      if ( benchRestart )
+      {
+        osal_start_timerEx( task_id, BV( evt ), benchTimeout() );
+      }
+    }
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      benchRunIdle
+ *
+ * @brief   Run the scheduler until no task has events left.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchRunIdle( void )
+{
+  uint8 idx;
+
+  do
+  {
+    osal_run_system();
+
+    for ( idx = 0; idx < tasksCnt; idx++ )
+    {
+      if ( tasksEvents[idx] )
+      {
+        break;
+      }
+    }
+  } while ( idx < tasksCnt );
+}
+
+/*********************************************************************
+ * @fn      benchStartStop
+ *
+ * @brief   Measure starting and stopping a timer with every other
+ *          timer slot live.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchStartStop( void )
+{
+  hostSamples_t start, stop;
+  uint32 rounds = hostScale( 200000 );
+  uint32 i;
+  uint16 idx;
+  uint64_t t0, t1;
+
+  benchRestart = FALSE;
+
+  // Keep every other (task, event) pair running
+  for ( idx = 0; idx < BENCH_TIMER_CNT; idx += 2 )
+  {
+    osal_start_timerEx( idx / BENCH_EVT_CNT, BV( idx % BENCH_EVT_CNT ), benchTimeout() );
+  }
+
+  hostSamplesInit( &start, rounds );
+  hostSamplesInit( &stop, rounds );
+
+  for ( i = 0; i < rounds; i++ )
+  {
+    idx = 1 + 2 * (uint16)( benchRandom() % ( BENCH_TIMER_CNT / 2 ) );
+
+    t0 = hostCycles();
+    osal_start_timerEx( idx / BENCH_EVT_CNT, BV( idx % BENCH_EVT_CNT ), benchTimeout() );
+    t1 = hostCycles();
+    hostSamplesAdd( &start, (uint32)( t1 - t0 ) );
+
+    t0 = hostCycles();
+    osal_stop_timerEx( idx / BENCH_EVT_CNT, BV( idx % BENCH_EVT_CNT ) );
+    t1 = hostCycles();
+    hostSamplesAdd( &stop, (uint32)( t1 - t0 ) );
+  }
+
+  hostReport( "timer_churn", "live_timers", osal_timer_num_active(), "timers" );
+  hostReportPercentiles( "timer_churn", "start", &start, hostCyclesUnit() );
+  hostReportPercentiles( "timer_churn", "stop", &stop, hostCyclesUnit() );
+
+  hostSamplesFree( &start );
+  hostSamplesFree( &stop );
+
+  for ( idx = 0; idx < BENCH_TIMER_CNT; idx++ )
+  {
+    osal_stop_timerEx( idx / BENCH_EVT_CNT, BV( idx % BENCH_EVT_CNT ) );
+  }
+  benchRunIdle();
+}
+
+/*********************************************************************
+ * @fn      benchExpire
+ *
+ * @brief   Measure ticking the clock while every timer slot is live
+ *          and each timer restarts as it fires.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchExpire( void )
+{
+  hostSamples_t tick;
+  uint32 ticks = hostScale( 1000000 );
+  uint32 i;
+  uint16 idx;
+  uint64_t t0, t1, begin;
+
+  benchRestart = TRUE;
+  benchFired = 0;
+
+  for ( idx = 0; idx < BENCH_TIMER_CNT; idx++ )
+  {
+    osal_start_timerEx( idx / BENCH_EVT_CNT, BV( idx % BENCH_EVT_CNT ), benchTimeout() );
+  }
+
+  hostSamplesInit( &tick, ticks );
+  begin = hostNanos();
+
+  for ( i = 0; i < ticks; i++ )
+  {
+    // One msec tick, then dispatch (and restart) whatever fired
+    t0 = hostCycles();
+    HalClockAdvance( 1000 );
+    benchRunIdle();
+    t1 = hostCycles();
+    hostSamplesAdd( &tick, (uint32)( t1 - t0 ) );
+  }
+
+  hostReport( "timer_churn", "ticks_per_sec", ticks * 1e9 / ( hostNanos() - begin ), "1/s" );
+  hostReport( "timer_churn", "expiries_per_tick", (double)benchFired / ticks, "timers" );
+  hostReportPercentiles( "timer_churn", "tick", &tick, hostCyclesUnit() );
+  hostReport( "timer_churn", "pool_max", osal_timer_pool_max(), "records" );
+  hostReport( "timer_churn", "pool_overflow", osal_timer_pool_overflow(), "records" );
+
+  hostSamplesFree( &tick );
+
+  benchRestart = FALSE;
+  for ( idx = 0; idx < BENCH_TIMER_CNT; idx++ )
+  {
+    osal_stop_timerEx( idx / BENCH_EVT_CNT, BV( idx % BENCH_EVT_CNT ) );
+  }
+  benchRunIdle();
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the timer benchmarks.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  hostInit( argc, argv, "osal" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  benchStartStop();
+  benchExpire();
+
+  HOST_CHECK( osal_timer_num_active() == 0 );
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
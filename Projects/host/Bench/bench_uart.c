@@ -0,0 +1,460 @@
+/*************************************************************************************************
+  Filename:       bench_uart.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Benchmark of the UART DMA receive path: the CC2540 driver
+                  (_hal_uart_dma.c) built against a model of its registers and RX DMA
+                  channel, fed a continuous byte stream at 115200 baud and up.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+
+#include "hal_board_cfg.h"
+#include "hal_mcu.h"
+#include "hal_uart.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * TARGET MODEL
+ *
+ * The driver is built with the registers it touches as plain variables
+ * and with the DMA descriptor macros of the target. The model below
+ * plays the USART and the RX DMA channel: each received byte is copied
+ * with the baud rate register after it into the next word of the
+ * channel's repeated transfer, as the CC2540 DMA does.
+ */
+
+#undef HAL_DMA
+#define HAL_DMA                   TRUE
+#undef HAL_UART_DMA
+#define HAL_UART_DMA              1     // USART0, alternate 1 location
+#define HAL_UART_PRIPO            0x00
+#define HAL_DMA_CH_RX             3
+#define HAL_DMA_CH_TX             4
+
+static uint8 P0, P0DIR, P0SEL, P2DIR, PERCFG, ADCCFG;
+static uint8 U0CSR, U0UCR, U0BAUD, U0GCR;
+static uint8 DMAARM, DMAREQ, DMAIRQ;
+
+// Sleep timer LSB: 32 kHz ticks of the virtual time
+#define ST0                       ( (uint8)( benchNs * 32768ULL / 1000000000ULL ) )
+
+static uint64_t benchNs;
+
+#include "../../../Components/hal/target/CC2540EB/hal_dma.h"
+
+// The target keeps 16-bit addresses in the descriptors; the model keeps
+// the low 16 bits of the host address, which it never reads back.
+#undef HAL_DMA_SET_SOURCE
+#define HAL_DMA_SET_SOURCE( pDesc, src ) \
+  st( \
+    pDesc->srcAddrH = (uint8)((uint16)(uintptr_t)(src) >> 8); \
+    pDesc->srcAddrL = (uint8)(uint16)(uintptr_t)(src); \
+  )
+
+#undef HAL_DMA_SET_DEST
+#define HAL_DMA_SET_DEST( pDesc, dst ) \
+  st( \
+    pDesc->dstAddrH = (uint8)((uint16)(uintptr_t)(dst) >> 8); \
+    pDesc->dstAddrL = (uint8)(uint16)(uintptr_t)(dst); \
+  )
+
+halDMADesc_t dmaCh0;
+halDMADesc_t dmaCh1234[4];
+
+#include "../../../Components/hal/target/CC2540EB/_hal_uart_dma.c"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Line time of each run, in ms of virtual time
+#define BENCH_LINE_MS             1000
+
+// The OSAL loop polls the UART once per pass; a pass with other tasks to
+// run takes about this long
+#define BENCH_POLL_NS             1000000ULL
+
+// Bytes the application reads from the driver at a time
+#define BENCH_READ_LEN            64
+
+// Idle polls timed
+#define BENCH_IDLE_POLLS          100000
+
+// Bench name, with the RX buffer size
+#define BENCH_STR( n )            #n
+#define BENCH_NAME_OF( n )        "uart_rx_" BENCH_STR( n )
+#define BENCH_NAME                BENCH_NAME_OF( HAL_UART_DMA_RX_MAX )
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 benchEvents[1];
+
+static const uint32 benchBauds[] = { 115200, 230400, 460800, 921600, 2000000 };
+
+static uint16 benchDmaIdx;      // Word of rxBuf the RX DMA writes next
+static uint32 benchSent;        // Bytes put on the line
+static uint32 benchLost;        // Bytes the DMA overwrote before they were read
+static uint32 benchRcvd;        // Bytes read by the application
+static uint32 benchBad;         // Bytes read that were not the next one sent
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 benchTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[] =
+{
+  benchTask
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents = benchEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the benchmark task.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  osal_memset( benchEvents, 0, sizeof( benchEvents ) );
+}
+
+/*********************************************************************
+ * @fn      benchTask
+ *
+ * @brief   The benchmark runs from main(); the task has nothing to do.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 benchTask( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+  (void)events;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      benchByte
+ *
+ * @brief   Byte sent in a position of the stream.
+ *
+ * @param   pos - position
+ *
+ * @return  Byte.
+ */
+static uint8 benchByte( uint32 pos )
+{
+  return (uint8)( pos ^ ( pos >> 8 ) ^ ( pos >> 16 ) );
+}
+
+/*********************************************************************
+ * @fn      benchRxDma
+ *
+ * @brief   Model of a USART0 RX DMA trigger: move the received byte and
+ *          the baud rate register after it into the next word of the
+ *          repeated transfer. A word still holding an unread byte is
+ *          overwritten and the byte lost.
+ *
+ * @param   byte - byte received
+ *
+ * @return  none
+ */
+static void benchRxDma( uint8 byte )
+{
+  halDMADesc_t *ch = HAL_DMA_GET_DESC1234( HAL_DMA_CH_RX );
+
+  if ( HAL_UART_DMA_NEW_RX_BYTE( benchDmaIdx ) )
+  {
+    benchLost++;
+  }
+
+  dmaCfg.rxBuf[benchDmaIdx] = BUILD_UINT16( byte, U0BAUD );
+
+  if ( ++benchDmaIdx >= HAL_DMA_GET_LEN( ch ) )
+  {
+    benchDmaIdx = 0;
+  }
+}
+
+/*********************************************************************
+ * @fn      benchUartCback
+ *
+ * @brief   Application UART callback: on any receive event, read all
+ *          the driver holds and check it against the stream.
+ *
+ * @param   port - UART port
+ * @param   event - HAL_UART_RX_* / HAL_UART_TX_* events
+ *
+ * @return  none
+ */
+static void benchUartCback( uint8 port, uint8 event )
+{
+  uint8 buf[BENCH_READ_LEN];
+  uint16 cnt, idx;
+
+  (void)port;
+
+  if ( event & ( HAL_UART_RX_FULL | HAL_UART_RX_ABOUT_FULL | HAL_UART_RX_TIMEOUT ) )
+  {
+    while ( ( cnt = HalUARTReadDMA( buf, sizeof( buf ) ) ) != 0 )
+    {
+      for ( idx = 0; idx < cnt; idx++ )
+      {
+        benchBad += ( buf[idx] != benchByte( benchRcvd + benchLost ) );
+        benchRcvd++;
+      }
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      benchOpen
+ *
+ * @brief   Open the port at 115200 baud as HalUARTOpenDMA() does,
+ *          without the read of the USART data register that clears a
+ *          pending RX trigger on the target, and restart the DMA at the
+ *          top of rxBuf.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchOpen( void )
+{
+  UxBAUD = 216;
+  UxGCR = 11;
+  dmaCfg.txTick = 3;
+  UxUCR = UCR_STOP;
+  dmaCfg.uartCB = benchUartCback;
+
+  HAL_DMA_CLEAR_IRQ( HAL_DMA_CH_RX );
+  HAL_DMA_ARM_CH( HAL_DMA_CH_RX );
+  osal_memset( dmaCfg.rxBuf, ( DMA_PAD ^ 0xFF ), HAL_UART_DMA_RX_MAX * 2 );
+  dmaCfg.rxHead = dmaCfg.rxTail = 0;
+  dmaCfg.rxCnt = 0;
+  dmaCfg.rxNew = FALSE;
+  dmaCfg.rxTick = 0;
+  UxCSR |= CSR_RE;
+
+  benchDmaIdx = 0;
+  benchSent = benchLost = benchRcvd = benchBad = 0;
+}
+
+/*********************************************************************
+ * @fn      benchStream
+ *
+ * @brief   Receive a continuous stream at a baud rate, 10 bits a byte,
+ *          polling the driver every BENCH_POLL_NS of virtual time, then
+ *          let the idle timeout flush the rest. Reports the bytes per
+ *          second delivered intact, the bytes lost, and the host time
+ *          the driver and the application read take per byte.
+ *
+ * @param   baud - line rate
+ *
+ * @return  none
+ */
+static void benchStream( uint32 baud )
+{
+  uint64_t end = (uint64_t)hostScale( BENCH_LINE_MS ) * 1000000ULL;
+  uint64_t nextPoll = BENCH_POLL_NS;
+  uint64_t nextByte;
+  uint64_t cycles = 0;
+  uint64_t t0;
+  char metric[48];
+
+  benchOpen();
+  benchNs = 0;
+
+  for ( ;; )
+  {
+    nextByte = (uint64_t)( benchSent + 1 ) * 10000000000ULL / baud;
+
+    if ( ( nextByte <= nextPoll ) && ( nextByte <= end ) )
+    {
+      benchNs = nextByte;
+      benchRxDma( benchByte( benchSent++ ) );
+    }
+    else if ( nextPoll <= end + 2 * HAL_UART_DMA_IDLE * 1000000000ULL / 32768 )
+    {
+      benchNs = nextPoll;
+      nextPoll += BENCH_POLL_NS;
+
+      t0 = hostCycles();
+      HalUARTPollDMA();
+      cycles += hostCycles() - t0;
+    }
+    else
+    {
+      break;
+    }
+  }
+
+  // Every byte is read or lost; unless some were lost, none is out of order
+  HOST_CHECK( benchRcvd + benchLost == benchSent );
+  HOST_CHECK( ( benchLost != 0 ) || ( benchBad == 0 ) );
+
+  // The buffer holds the bytes of a poll interval: nothing may be lost
+  if ( (uint64_t)baud * BENCH_POLL_NS / 10000000000ULL < HAL_UART_DMA_HIGH )
+  {
+    HOST_CHECK( benchLost == 0 );
+  }
+
+  sprintf( metric, "%u_bytes_per_sec", (unsigned)baud );
+  hostReport( BENCH_NAME, metric, ( benchRcvd - benchBad ) / ( end / 1e9 ), "bytes/s" );
+  sprintf( metric, "%u_lost_bytes", (unsigned)baud );
+  hostReport( BENCH_NAME, metric, benchLost, "bytes" );
+  sprintf( metric, "%u_poll_per_byte", (unsigned)baud );
+  hostReport( BENCH_NAME, metric, (double)cycles / ( benchRcvd ? benchRcvd : 1 ), hostCyclesUnit() );
+}
+
+/*********************************************************************
+ * @fn      benchIdlePoll
+ *
+ * @brief   Time the polls of an idle port, which the OSAL loop makes on
+ *          every pass whether bytes arrive or not.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchIdlePoll( void )
+{
+  hostSamples_t samples;
+  uint32 polls = hostScale( BENCH_IDLE_POLLS );
+  uint32 idx;
+  uint64_t t0;
+
+  benchOpen();
+  hostSamplesInit( &samples, polls );
+
+  for ( idx = 0; idx < polls; idx++ )
+  {
+    t0 = hostCycles();
+    HalUARTPollDMA();
+    hostSamplesAdd( &samples, (uint32)( hostCycles() - t0 ) );
+  }
+
+  HOST_CHECK( benchRcvd == 0 );
+  hostReportPercentiles( BENCH_NAME, "idle_poll", &samples, hostCyclesUnit() );
+  hostSamplesFree( &samples );
+}
+
+/*********************************************************************
+ * @fn      benchDescLimits
+ *
+ * @brief   Check that the TX descriptor path takes only the lengths one
+ *          DMA arm can send, 1 to 8191 bytes, and arms the channel with
+ *          the whole of the longest.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchDescLimits( void )
+{
+  static uint8 buf[8192];
+  halUARTTxDesc_t desc;
+  halDMADesc_t *ch = HAL_DMA_GET_DESC1234( HAL_DMA_CH_TX );
+
+  desc.pBuf = buf;
+  desc.pfnDone = NULL;
+
+  desc.len = 0;
+  HOST_CHECK( HalUARTWriteDescDMA( &desc ) == HAL_UART_NOT_SUPPORTED );
+  desc.len = sizeof( buf );
+  HOST_CHECK( HalUARTWriteDescDMA( &desc ) == HAL_UART_NOT_SUPPORTED );
+
+  desc.len = sizeof( buf ) - 1;
+  HOST_CHECK( HalUARTWriteDescDMA( &desc ) == HAL_UART_SUCCESS );
+  benchNs += 1000000;
+  HalUARTPollDMA();
+  HOST_CHECK( HAL_DMA_GET_LEN( ch ) == sizeof( buf ) - 1 );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the UART receive benchmarks.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  uint8 idx;
+
+  hostInit( argc, argv, "osal" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  HalUARTInitDMA();
+
+  for ( idx = 0; idx < sizeof( benchBauds ) / sizeof( benchBauds[0] ); idx++ )
+  {
+    benchStream( benchBauds[idx] );
+  }
+
+  benchIdlePoll();
+  benchDescLimits();
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,354 @@
+/*************************************************************************************************
+  Filename:       bench_wakeups.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Wakeups per hour of the KeyFob timer mix, with and without the
+                  slack of the battery check, on the virtual clock of the POSIX HAL.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Clock.h"
+#include "OSAL_PwrMgr.h"
+#include "OSAL_Tasks.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Timing of the KeyFob application (keyfobdemo.c)
+#define BATTERY_CHECK_PERIOD    5000
+#define BATTERY_CHECK_SLACK     1000
+#define ACCEL_READ_PERIOD       50
+
+// Connection event at the maximum interval the KeyFob asks for, 800 * 1.25 ms
+#define LINK_CONN_INTERVAL      1000
+
+// Delay of the other timers behind the battery check, so they start out
+// of phase as on the device, where unrelated events start them
+#define BENCH_TIMER_PHASE       377
+
+// Task IDs, the link layer first as in the BLE stack
+#define LINK_TASK_ID            0
+#define APP_TASK_ID             1
+
+// Link task events
+#define LINK_CONN_EVT           0x0001
+
+// Application task events (keyfobdemo.h)
+#define KFD_BATTERY_CHECK_EVT   0x0002
+#define KFD_ACCEL_READ_EVT      0x0004
+
+// Simulated time of a full run, in seconds
+#define BENCH_SIM_SECONDS       3600
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Timer mix of one scenario
+typedef struct
+{
+  const char *name;
+  uint8 accel;      // Accelerometer enabled, read every ACCEL_READ_PERIOD
+  uint8 connected;  // Connection event every LINK_CONN_INTERVAL
+} benchScenario_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static const benchScenario_t benchScenarios[] =
+{
+  { "idle",        FALSE, FALSE },  // Battery check alone
+  { "connected",   FALSE, TRUE  },  // Battery check and connection events
+  { "accel",       TRUE,  TRUE  },  // Accelerometer reads as well
+};
+
+static uint16 benchEvents[2];
+
+static uint8 benchAccel;          // Accelerometer reads are running
+static uint16 benchSlack;         // Slack of the battery check
+static uint32 benchLastCheck;     // Time of the last battery check
+static uint32 benchChecks;        // Battery checks done
+
+static uint32 benchSleeps;        // Sleeps of the power manager
+static uint32 benchWokenSleep;    // Sleep that ended with the last counted wakeup
+static uint32 benchWakeups;       // Sleeps that ended with a task dispatched
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 benchLinkTask( uint8 task_id, uint16 events );
+static uint16 benchAppTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[] =
+{
+  benchLinkTask,
+  benchAppTask
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents = benchEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the benchmark tasks.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  osal_memset( benchEvents, 0, sizeof( benchEvents ) );
+}
+
+/*********************************************************************
+ * @fn      benchWake
+ *
+ * @brief   Count a wakeup on the first dispatch after a sleep. A sleep
+ *          that ends before the OSAL clock has caught up with the
+ *          timer dispatches nothing and is continued, not counted.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void benchWake( void )
+{
+  if ( benchWokenSleep != benchSleeps )
+  {
+    benchWokenSleep = benchSleeps;
+    benchWakeups++;
+  }
+}
+
+/*********************************************************************
+ * @fn      benchLinkTask
+ *
+ * @brief   Stand-in for the link layer: wake for each connection event.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 benchLinkTask( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+  (void)events;
+
+  benchWake();
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      benchAppTask
+ *
+ * @brief   The timers of the KeyFob application task: the battery check
+ *          restarted with its slack and the accelerometer read
+ *          restarted without.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 benchAppTask( uint8 task_id, uint16 events )
+{
+  benchWake();
+
+  if ( events & KFD_BATTERY_CHECK_EVT )
+  {
+    uint32 now = osal_GetSystemClock();
+    uint32 interval = now - benchLastCheck;
+
+    // Never early, and late by no more than the slack (and the clock lag)
+    HOST_CHECK( interval >= BATTERY_CHECK_PERIOD );
+    HOST_CHECK( interval <= BATTERY_CHECK_PERIOD + benchSlack + 1 );
+
+    benchLastCheck = now;
+    benchChecks++;
+    osal_start_timerEx_slack( task_id, KFD_BATTERY_CHECK_EVT, BATTERY_CHECK_PERIOD, benchSlack );
+  }
+
+  if ( (events & KFD_ACCEL_READ_EVT) && benchAccel )
+  {
+    osal_start_timerEx( task_id, KFD_ACCEL_READ_EVT, ACCEL_READ_PERIOD );
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      benchRun
+ *
+ * @brief   Run the timer mix of a scenario on the virtual clock, the
+ *          power manager sleeping until the next timer whenever no
+ *          task is ready.
+ *
+ * @param   pScen - scenario
+ * @param   slack - slack of the battery check
+ * @param   pSaved - receives the wakeups the slack timers saved
+ *
+ * @return  wakeups per hour
+ */
+static uint32 benchRun( const benchScenario_t *pScen, uint16 slack, uint16 *pSaved )
+{
+  uint32 duration = hostScale( BENCH_SIM_SECONDS ) * 1000;
+  uint32 start;
+  uint32 clock;
+  uint32 elapsed;
+  uint16 saved = osal_timer_wakeups_saved();
+
+  benchAccel = pScen->accel;
+  benchSlack = slack;
+  benchChecks = 0;
+  benchSleeps = 0;
+  benchWokenSleep = 0;
+  benchWakeups = 0;
+
+  start = osal_GetSystemClock();
+  benchLastCheck = start;
+
+  osal_start_timerEx_slack( APP_TASK_ID, KFD_BATTERY_CHECK_EVT, BATTERY_CHECK_PERIOD, slack );
+  HalClockAdvance( (uint32)BENCH_TIMER_PHASE * 1000 );
+
+  if ( pScen->accel )
+  {
+    osal_start_timerEx( APP_TASK_ID, KFD_ACCEL_READ_EVT, ACCEL_READ_PERIOD );
+  }
+  if ( pScen->connected )
+  {
+    osal_start_reload_timer( LINK_TASK_ID, LINK_CONN_EVT, LINK_CONN_INTERVAL );
+  }
+
+  do
+  {
+    clock = HalClockRead();
+    osal_run_system();
+    if ( HalClockRead() != clock )
+    {
+      benchSleeps++;
+    }
+    elapsed = osal_GetSystemClock() - start;
+  } while ( elapsed < duration );
+
+  osal_stop_timerEx( APP_TASK_ID, KFD_BATTERY_CHECK_EVT );
+  osal_stop_timerEx( APP_TASK_ID, KFD_ACCEL_READ_EVT );
+  osal_stop_timerEx( LINK_TASK_ID, LINK_CONN_EVT );
+  osal_clear_event( APP_TASK_ID, KFD_BATTERY_CHECK_EVT | KFD_ACCEL_READ_EVT );
+  osal_clear_event( LINK_TASK_ID, LINK_CONN_EVT );
+
+  // Every battery check of the run has been done
+  HOST_CHECK( benchChecks >= elapsed / (BATTERY_CHECK_PERIOD + slack + 1) );
+
+  *pSaved = osal_timer_wakeups_saved() - saved;
+
+  return (uint32)( (uint64_t)benchWakeups * 3600000 / elapsed );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run every scenario with and without the slack of the battery
+ *          check and report the wakeups per hour.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  uint8 idx;
+  char metric[48];
+
+  hostInit( argc, argv, "osal" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  // All tasks agree to conserve out of reset
+  osal_pwrmgr_device( PWRMGR_BATTERY );
+
+  for ( idx = 0; idx < sizeof( benchScenarios ) / sizeof( benchScenarios[0] ); idx++ )
+  {
+    const benchScenario_t *pScen = &benchScenarios[idx];
+    uint16 saved;
+    uint16 savedRigid;
+    uint32 wakeups = benchRun( pScen, BATTERY_CHECK_SLACK, &saved );
+    uint32 rigid = benchRun( pScen, 0, &savedRigid );
+
+    // Without slack nothing is saved; with it, the battery check shares
+    // a wakeup whenever another timer fires inside its window.
+    HOST_CHECK( savedRigid == 0 );
+    HOST_CHECK( wakeups <= rigid );
+    if ( pScen->accel || pScen->connected )
+    {
+      HOST_CHECK( saved != 0 );
+      HOST_CHECK( wakeups < rigid );
+    }
+    else
+    {
+      HOST_CHECK( saved == 0 );
+    }
+
+    sprintf( metric, "%s_per_hour", pScen->name );
+    hostReport( "wakeups", metric, wakeups, "wakeups/h" );
+    sprintf( metric, "%s_no_slack_per_hour", pScen->name );
+    hostReport( "wakeups", metric, rigid, "wakeups/h" );
+    sprintf( metric, "%s_saved", pScen->name );
+    hostReport( "wakeups", metric, saved, "wakeups" );
+  }
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,376 @@
+/*************************************************************************************************
+  Filename:       host_harness.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Test and benchmark support for the OSAL host programs.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined ( __x86_64__ ) || defined ( __i386__ )
+#include <x86intrin.h>
+#endif
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+uint8 hostQuick = FALSE;
+
+int hostArgCnt = 0;
+char **hostArgs = NULL;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Name of the program's suite, reported with each result
+static const char *hostSuite = "";
+
+static uint32 hostChecks;
+static uint32 hostFailures;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static int hostSampleCmp( const void *a, const void *b );
+
+/*********************************************************************
+ * @fn      hostInit
+ *
+ * @brief   Parse the common command line options. --quick runs a
+ *          hundredth of the iterations, so that ctest can run every
+ *          benchmark as a smoke test. The other arguments are left in
+ *          hostArgs[] for the program.
+ *
+ * @param   argc - argument count of main()
+ * @param   argv - arguments of main()
+ * @param   suite - name reported with each result
+ *
+ * @return  none
+ */
+void hostInit( int argc, char **argv, const char *suite )
+{
+  int i;
+
+  hostSuite = suite;
+  hostArgs = argv + 1;
+
+  for ( i = 1; i < argc; i++ )
+  {
+    if ( strcmp( argv[i], "--quick" ) == 0 )
+    {
+      hostQuick = TRUE;
+    }
+    else if ( strncmp( argv[i], "--", 2 ) == 0 )
+    {
+      fprintf( stderr, "usage: %s [--quick] [argument...]\n", argv[0] );
+      exit( 2 );
+    }
+    else
+    {
+      // Move the argument down over the options before it.
+      hostArgs[hostArgCnt++] = argv[i];
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      hostScale
+ *
+ * @brief   Number of iterations to run.
+ *
+ * @param   full - iterations of a full run
+ *
+ * @return  full, or a hundredth of it (at least 1) in quick mode
+ */
+uint32 hostScale( uint32 full )
+{
+  if ( hostQuick )
+  {
+    full /= 100;
+  }
+
+  return ( full ? full : 1 );
+}
+
+/*********************************************************************
+ * @fn      hostCheck
+ *
+ * @brief   Record the outcome of a check, reporting a failure.
+ *
+ * @param   ok - TRUE if the check passed
+ * @param   expr - text of the checked expression
+ * @param   file - source file of the check
+ * @param   line - source line of the check
+ *
+ * @return  none
+ */
+void hostCheck( uint8 ok, const char *expr, const char *file, int line )
+{
+  hostChecks++;
+
+  if ( !ok )
+  {
+    hostFailures++;
+    fprintf( stderr, "%s:%d: check failed: %s\n", file, line, expr );
+  }
+}
+
+/*********************************************************************
+ * @fn      hostResult
+ *
+ * @brief   Print the check summary.
+ *
+ * @param   none
+ *
+ * @return  Process exit status: 0 if every check passed, 1 otherwise.
+ */
+int hostResult( void )
+{
+  fprintf( stderr, "%s: %lu checks, %lu failed\n", hostSuite,
+           (unsigned long)hostChecks, (unsigned long)hostFailures );
+
+  return ( hostFailures ? 1 : 0 );
+}
+
+/*********************************************************************
+ * @fn      hostCycles
+ *
+ * @brief   Read the host cycle counter: the time stamp counter on x86,
+ *          the monotonic clock in nanoseconds elsewhere.
+ *
+ * @param   none
+ *
+ * @return  Counter value.
+ */
+uint64_t hostCycles( void )
+{
+#if defined ( __x86_64__ ) || defined ( __i386__ )
+  return __rdtsc();
+#else
+  return hostNanos();
+#endif
+}
+
+/*********************************************************************
+ * @fn      hostCyclesUnit
+ *
+ * @brief   Unit of hostCycles().
+ *
+ * @param   none
+ *
+ * @return  "cycles" or "ns".
+ */
+const char *hostCyclesUnit( void )
+{
+#if defined ( __x86_64__ ) || defined ( __i386__ )
+  return "cycles";
+#else
+  return "ns";
+#endif
+}
+
+/*********************************************************************
+ * @fn      hostNanos
+ *
+ * @brief   Read a monotonic wall clock.
+ *
+ * @param   none
+ *
+ * @return  Nanoseconds from an arbitrary origin.
+ */
+uint64_t hostNanos( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+
+  return ( (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec );
+}
+
+/*********************************************************************
+ * @fn      hostReport
+ *
+ * @brief   Print one result as a JSON line on stdout, e.g.
+ *          {"suite":"osal","bench":"heap","metric":"alloc_p99",
+ *           "value":120,"unit":"cycles"}
+ *
+ * @param   bench - benchmark name
+ * @param   metric - what was measured
+ * @param   value - measurement
+ * @param   unit - unit of the measurement
+ *
+ * @return  none
+ */
+void hostReport( const char *bench, const char *metric, double value, const char *unit )
+{
+  printf( "{\"suite\":\"%s\",\"bench\":\"%s\",\"metric\":\"%s\",\"value\":%.6g,\"unit\":\"%s\"}\n",
+          hostSuite, bench, metric, value, unit );
+  fflush( stdout );
+}
+
+/*********************************************************************
+ * @fn      hostSamplesInit
+ *
+ * @brief   Allocate room for a set of measurements.
+ *
+ * @param   pSamples - set to initialize
+ * @param   size - most measurements the set holds
+ *
+ * @return  none
+ */
+void hostSamplesInit( hostSamples_t *pSamples, uint32 size )
+{
+  pSamples->pBuf = malloc( (size ? size : 1) * sizeof( uint32 ) );
+  pSamples->cnt = 0;
+  pSamples->size = ( pSamples->pBuf != NULL ) ? size : 0;
+}
+
+/*********************************************************************
+ * @fn      hostSamplesAdd
+ *
+ * @brief   Add a measurement to a set.
+ *
+ * @param   pSamples - set to add to
+ * @param   value - measurement; dropped if the set is full
+ *
+ * @return  none
+ */
+void hostSamplesAdd( hostSamples_t *pSamples, uint32 value )
+{
+  if ( pSamples->cnt < pSamples->size )
+  {
+    pSamples->pBuf[pSamples->cnt++] = value;
+  }
+}
+
+/*********************************************************************
+ * @fn      hostSamplesPercentile
+ *
+ * @brief   Return a percentile of the measurements, by the nearest
+ *          rank method. Sorts the set.
+ *
+ * @param   pSamples - set of measurements
+ * @param   pct - percentile, 0 to 100
+ *
+ * @return  The measurement at the percentile, 0 for an empty set.
+ */
+uint32 hostSamplesPercentile( hostSamples_t *pSamples, uint8 pct )
+{
+  uint32 rank;
+
+  if ( pSamples->cnt == 0 )
+  {
+    return 0;
+  }
+
+  qsort( pSamples->pBuf, pSamples->cnt, sizeof( uint32 ), hostSampleCmp );
+
+  rank = (uint32)( ( (uint64_t)pSamples->cnt * pct + 99 ) / 100 );
+
+  return pSamples->pBuf[( rank > 0 ) ? rank - 1 : 0];
+}
+
+/*********************************************************************
+ * @fn      hostReportPercentiles
+ *
+ * @brief   Report the 50th, 90th and 99th percentiles and the maximum
+ *          of a set as <metric>_p50, _p90, _p99 and _max.
+ *
+ * @param   bench - benchmark name
+ * @param   metric - what was measured
+ * @param   pSamples - set of measurements
+ * @param   unit - unit of the measurements
+ *
+ * @return  none
+ */
+void hostReportPercentiles( const char *bench, const char *metric,
+                            hostSamples_t *pSamples, const char *unit )
+{
+  static const uint8 pcts[] = { 50, 90, 99, 100 };
+  static const char *names[] = { "p50", "p90", "p99", "max" };
+  char name[64];
+  uint8 i;
+
+  for ( i = 0; i < sizeof( pcts ); i++ )
+  {
+    snprintf( name, sizeof( name ), "%s_%s", metric, names[i] );
+    hostReport( bench, name, hostSamplesPercentile( pSamples, pcts[i] ), unit );
+  }
+}
+
+/*********************************************************************
+ * @fn      hostSamplesFree
+ *
+ * @brief   Release the room of a set of measurements.
+ *
+ * @param   pSamples - set to release
+ *
+ * @return  none
+ */
+void hostSamplesFree( hostSamples_t *pSamples )
+{
+  free( pSamples->pBuf );
+  pSamples->pBuf = NULL;
+  pSamples->cnt = pSamples->size = 0;
+}
+
+/*********************************************************************
+ * @fn      hostSampleCmp
+ *
+ * @brief   qsort() comparison of two measurements.
+ *
+ * @param   a, b - measurements to compare
+ *
+ * @return  <0, 0 or >0 as a is below, equal to or above b.
+ */
+static int hostSampleCmp( const void *a, const void *b )
+{
+  uint32 x = *(const uint32 *)a;
+  uint32 y = *(const uint32 *)b;
+
+  return ( x > y ) - ( x < y );
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,164 @@
+/*************************************************************************************************
+  Filename:       host_harness.h
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Test and benchmark support for the OSAL host programs: checks,
+                  host cycle counter, sample percentiles and machine-readable reports.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+#ifndef HOST_HARNESS_H
+#define HOST_HARNESS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+#include "hal_types.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Record a failed check and carry on, so that one run reports every failure.
+#define HOST_CHECK( expr ) \
+  hostCheck( (expr) ? TRUE : FALSE, #expr, __FILE__, __LINE__ )
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Set of measurements to take percentiles of
+typedef struct
+{
+  uint32 *pBuf;   // measurements
+  uint32  cnt;    // measurements taken
+  uint32  size;   // room in pBuf
+} hostSamples_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// TRUE when the program runs in quick mode (--quick), as under ctest
+extern uint8 hostQuick;
+
+// Command line arguments other than options, e.g. input files
+extern int hostArgCnt;
+extern char **hostArgs;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Parse the common command line options. Call first from main().
+ */
+extern void hostInit( int argc, char **argv, const char *suite );
+
+/*
+ * Number of iterations to run: full, or a hundredth of it in quick mode.
+ */
+extern uint32 hostScale( uint32 full );
+
+/*
+ * Record the outcome of a check.
+ */
+extern void hostCheck( uint8 ok, const char *expr, const char *file, int line );
+
+/*
+ * Print the check summary and return the process exit status.
+ */
+extern int hostResult( void );
+
+/*
+ * Read the host cycle counter.
+ */
+extern uint64_t hostCycles( void );
+
+/*
+ * Unit of hostCycles(): "cycles" or "ns".
+ */
+extern const char *hostCyclesUnit( void );
+
+/*
+ * Read a monotonic wall clock in nanoseconds.
+ */
+extern uint64_t hostNanos( void );
+
+/*
+ * Print one result as a JSON line.
+ */
+extern void hostReport( const char *bench, const char *metric, double value, const char *unit );
+
+/*
+ * Allocate room for a set of measurements.
+ */
+extern void hostSamplesInit( hostSamples_t *pSamples, uint32 size );
+
+/*
+ * Add a measurement; those beyond the room of the set are dropped.
+ */
+extern void hostSamplesAdd( hostSamples_t *pSamples, uint32 value );
+
+/*
+ * Return a percentile, 0 to 100, of the measurements. Sorts the set.
+ */
+extern uint32 hostSamplesPercentile( hostSamples_t *pSamples, uint8 pct );
+
+/*
+ * Report the 50th, 90th, 99th percentiles and the maximum of a set.
+ */
+extern void hostReportPercentiles( const char *bench, const char *metric,
+                                   hostSamples_t *pSamples, const char *unit );
+
+/*
+ * Release the room of a set of measurements.
+ */
+extern void hostSamplesFree( hostSamples_t *pSamples );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_HARNESS_H */
@@ -0,0 +1,411 @@
+/*************************************************************************************************
+  Filename:       test_bufmgr.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Host test of the buffer manager: header and tail adjustments,
+                  frees through any adjusted payload pointer, and the return of every
+                  buffer to its pool or the heap.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "osal_bufmgr.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if !( OSALMEM_METRICS )
+  #error The buffer manager test needs the heap metrics (OSALMEM_METRICS=TRUE).
+#endif
+
+// Buffers held at once by the random round trips
+#define TEST_LIVE_CNT       12
+
+#define TEST_ROUNDS         50000
+
+// Largest payload: above the largest pool, so the heap serves some
+#define TEST_MAX_LEN        96
+
+// Header space the stack strips and restores
+#define TEST_MAX_HDR        24
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  uint8 *pStart;    // Payload pointer returned by osal_bm_alloc()
+  uint8 *pPayload;  // Current payload pointer
+  uint16 len;
+  uint8 seed;       // Contents: seed + offset into the buffer
+} testBuf_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 testEvents[1];
+static uint32 testRand = 1;
+
+static testBuf_t testBufs[TEST_LIVE_CNT];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 testTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[] =
+{
+  testTask
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents = testEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the test task.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  osal_memset( testEvents, 0, sizeof( testEvents ) );
+}
+
+/*********************************************************************
+ * @fn      testTask
+ *
+ * @brief   The test runs from main(); the task has nothing to do.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 testTask( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+  (void)events;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      testRandom
+ *
+ * @brief   Deterministic pseudo-random numbers (xorshift32).
+ *
+ * @param   none
+ *
+ * @return  Next random number.
+ */
+static uint32 testRandom( void )
+{
+  testRand ^= testRand << 13;
+  testRand ^= testRand >> 17;
+  testRand ^= testRand << 5;
+
+  return testRand;
+}
+
+/*********************************************************************
+ * @fn      testPoolsUsed
+ *
+ * @brief   Count the buffers allocated from the packet pools.
+ *
+ * @param   none
+ *
+ * @return  Buffers in use over all pools.
+ */
+static uint16 testPoolsUsed( void )
+{
+  osalBmPoolStats_t stats;
+  uint16 used = 0;
+  uint8 pool;
+
+  for ( pool = 0; pool < OSAL_BM_POOL_MAX; pool++ )
+  {
+    HOST_CHECK( osal_bm_pool_stats( pool, &stats ) == SUCCESS );
+    used += stats.used;
+  }
+
+  return used;
+}
+
+/*********************************************************************
+ * @fn      testIntact
+ *
+ * @brief   Check that every byte of a buffer, header space included,
+ *          still holds what was written at allocation.
+ *
+ * @param   pBuf - buffer
+ *
+ * @return  TRUE if intact.
+ */
+static uint8 testIntact( const testBuf_t *pBuf )
+{
+  uint16 idx;
+
+  for ( idx = 0; idx < pBuf->len; idx++ )
+  {
+    if ( pBuf->pStart[idx] != (uint8)( pBuf->seed + idx ) )
+    {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      testAlloc
+ *
+ * @brief   Allocate a buffer and fill it.
+ *
+ * @param   pBuf - buffer to fill in
+ * @param   len - payload length
+ *
+ * @return  none
+ */
+static void testAlloc( testBuf_t *pBuf, uint16 len )
+{
+  uint16 idx;
+
+  pBuf->pStart = osal_bm_alloc( len );
+  HOST_CHECK( pBuf->pStart != NULL );
+  pBuf->pPayload = pBuf->pStart;
+  pBuf->len = len;
+  pBuf->seed = (uint8)testRandom();
+
+  for ( idx = 0; idx < len; idx++ )
+  {
+    pBuf->pStart[idx] = (uint8)( pBuf->seed + idx );
+  }
+}
+
+/*********************************************************************
+ * @fn      testRoundTrip
+ *
+ * @brief   Strip a header, restore it, and free through a pointer
+ *          returned by osal_bm_adjust_tail(), as a received packet
+ *          passed up and back down the stack would be.
+ *
+ * @param   len - payload length
+ *
+ * @return  none
+ */
+static void testRoundTrip( uint16 len )
+{
+  testBuf_t buf;
+  uint16 hdr = len / 3;
+  uint16 tail = len / 4;
+  uint8 *pTail;
+
+  testAlloc( &buf, len );
+
+  // Strip the header: its bytes stay in place
+  buf.pPayload = osal_bm_adjust_header( buf.pStart, -(int16)hdr );
+  HOST_CHECK( buf.pPayload == buf.pStart + hdr );
+  HOST_CHECK( testIntact( &buf ) );
+
+  // A header longer than the buffer is refused
+  HOST_CHECK( osal_bm_adjust_header( buf.pPayload, (int16)( hdr + 1 ) ) == buf.pPayload );
+
+  // Restore it through the interior pointer of the tail
+  pTail = osal_bm_adjust_tail( buf.pPayload, (int16)tail );
+  HOST_CHECK( pTail == buf.pStart + len - tail );
+  HOST_CHECK( osal_bm_adjust_header( pTail, (int16)tail ) == pTail - tail );
+  HOST_CHECK( osal_bm_adjust_header( buf.pPayload, (int16)hdr ) == buf.pStart );
+  HOST_CHECK( testIntact( &buf ) );
+
+  // Strip everything: the payload pointer is the end of the buffer
+  HOST_CHECK( osal_bm_adjust_header( buf.pStart, -(int16)len ) == buf.pStart + len );
+
+  osal_bm_free( pTail );
+}
+
+/*********************************************************************
+ * @fn      testFixed
+ *
+ * @brief   Round trips of every length, then frees through the end of
+ *          the buffer, a stale pointer, and a pointer into no buffer.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testFixed( void )
+{
+  uint16 heapUsed = osal_heap_mem_used();
+  uint8 foreign[16];
+  testBuf_t buf;
+  uint16 len;
+
+  for ( len = 1; len <= TEST_MAX_LEN; len++ )
+  {
+    testRoundTrip( len );
+    HOST_CHECK( testPoolsUsed() == 0 );
+    HOST_CHECK( osal_heap_mem_used() == heapUsed );
+  }
+
+  testAlloc( &buf, 27 );
+  osal_bm_free( buf.pStart + 27 );
+  HOST_CHECK( testPoolsUsed() == 0 );
+  HOST_CHECK( osal_heap_mem_used() == heapUsed );
+
+  // A stale pointer is ignored, as is one into no buffer
+  osal_bm_free( buf.pStart );
+  HOST_CHECK( osal_bm_adjust_header( buf.pStart, -1 ) == buf.pStart );
+  osal_memset( foreign, 0, sizeof( foreign ) );
+  osal_bm_free( &foreign[8] );
+  HOST_CHECK( testPoolsUsed() == 0 );
+  HOST_CHECK( osal_heap_mem_used() == heapUsed );
+}
+
+/*********************************************************************
+ * @fn      testRandomTrips
+ *
+ * @brief   Keep TEST_LIVE_CNT buffers of random lengths alive, moving
+ *          their payload pointers at random and freeing each through
+ *          a random pointer into it, and check that no byte of a live
+ *          buffer changes and that every buffer comes back.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testRandomTrips( void )
+{
+  uint16 heapUsed = osal_heap_mem_used();
+  uint32 round;
+  testBuf_t *pBuf;
+  uint8 *pNew;
+  int16 size;
+  uint8 idx;
+
+  for ( idx = 0; idx < TEST_LIVE_CNT; idx++ )
+  {
+    testAlloc( &testBufs[idx], (uint16)( 1 + testRandom() % TEST_MAX_LEN ) );
+  }
+
+  for ( round = 0; round < hostScale( TEST_ROUNDS ); round++ )
+  {
+    pBuf = &testBufs[testRandom() % TEST_LIVE_CNT];
+
+    switch ( testRandom() % 4 )
+    {
+      case 0:
+        // Strip or restore header space
+        size = (int16)( testRandom() % ( 2 * TEST_MAX_HDR + 1 ) ) - TEST_MAX_HDR;
+        pNew = osal_bm_adjust_header( pBuf->pPayload, size );
+        if ( pBuf->pPayload - size >= pBuf->pStart &&
+             pBuf->pPayload - size <= pBuf->pStart + pBuf->len )
+        {
+          HOST_CHECK( pNew == pBuf->pPayload - size );
+        }
+        else
+        {
+          HOST_CHECK( pNew == pBuf->pPayload );
+        }
+        pBuf->pPayload = pNew;
+        break;
+
+      case 1:
+        // Point at the tail
+        size = (int16)( testRandom() % ( pBuf->len + 1 ) );
+        pNew = osal_bm_adjust_tail( pBuf->pPayload, size );
+        HOST_CHECK( pNew == pBuf->pStart + pBuf->len - size );
+        pBuf->pPayload = pNew;
+        break;
+
+      default:
+        // Free through the current pointer and allocate again
+        HOST_CHECK( testIntact( pBuf ) );
+        osal_bm_free( pBuf->pPayload );
+        testAlloc( pBuf, (uint16)( 1 + testRandom() % TEST_MAX_LEN ) );
+        break;
+    }
+  }
+
+  for ( idx = 0; idx < TEST_LIVE_CNT; idx++ )
+  {
+    HOST_CHECK( testIntact( &testBufs[idx] ) );
+    osal_bm_free( testBufs[idx].pPayload );
+  }
+
+  HOST_CHECK( testPoolsUsed() == 0 );
+  HOST_CHECK( osal_heap_mem_used() == heapUsed );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the buffer manager tests.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  hostInit( argc, argv, "osal" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  testFixed();
+  testRandomTrips();
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
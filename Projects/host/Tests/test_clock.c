@@ -0,0 +1,396 @@
+/*************************************************************************************************
+  Filename:       test_clock.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Host test of the OSAL clock: the calendar conversions against the
+                  year by year reference over the whole UTCTime range, and the
+                  microsecond clock against the virtual clock.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Clock.h"
+#include "OSAL_Tasks.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define TEST_BEGYEAR        2000     // UTCTime 0 is 1 January 2000
+#define TEST_DAY            86400UL
+
+// Days in the UTCTime range, the last one partial (7 February 2136)
+#define TEST_DAYS           ( 0xFFFFFFFFUL / TEST_DAY + 1 )
+
+// Virtual clock steps of the microsecond clock test, and the time they
+// cover: past the 32-bit wrap of both clocks
+#define TEST_CLOCK_STEPS    400000
+#define TEST_CLOCK_MAX_STEP 50000
+
+#if defined ( OSAL_CLOCK_INTERPOLATE ) && OSAL_CLOCK_INTERPOLATE
+// The clock is interpolated from the sleep timer: it may lead the
+// virtual clock by up to a sleep timer tick and lag it by up to the
+// time since the LL timer tick
+  #define TEST_CLOCK_LEAD   31
+  #define TEST_CLOCK_LAG    625
+
+// Steps of the interpolation test, which reads the clock at least this
+// often and so keeps the lag within a step and a sleep timer tick
+  #define TEST_INTERP_STEPS 200000
+  #define TEST_INTERP_STEP  50
+#endif
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+extern uint16 ll_McuPrecisionCount( void );
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 testEvents[1];
+static uint32 testRand = 1;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 testTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[] =
+{
+  testTask
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents = testEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the test task.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  osal_memset( testEvents, 0, sizeof( testEvents ) );
+}
+
+/*********************************************************************
+ * @fn      testTask
+ *
+ * @brief   The test runs from main(); the task has nothing to do.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 testTask( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+  (void)events;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      testRandom
+ *
+ * @brief   Deterministic pseudo-random numbers (xorshift32).
+ *
+ * @param   none
+ *
+ * @return  Next random number.
+ */
+static uint32 testRandom( void )
+{
+  testRand ^= testRand << 13;
+  testRand ^= testRand >> 17;
+  testRand ^= testRand << 5;
+
+  return testRand;
+}
+
+/*********************************************************************
+ * @fn      testMonthLength
+ *
+ * @brief   Days in a month, as the year and month loops of the
+ *          reference conversion count them.
+ *
+ * @param   year - year
+ * @param   month - 0 - 11 (jan - dec)
+ *
+ * @return  Days in the month.
+ */
+static uint8 testMonthLength( uint16 year, uint8 month )
+{
+  static const uint8 days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+  return (uint8)( days[month] + ( ( month == 1 ) && IsLeapYear( year ) ) );
+}
+
+/*********************************************************************
+ * @fn      testReference
+ *
+ * @brief   Reference conversion of a day count to a date: walk year by
+ *          year, then month by month.
+ *
+ * @param   tm - date, time of day left alone
+ * @param   numDays - days since 1 January 2000
+ *
+ * @return  none
+ */
+static void testReference( UTCTimeStruct *tm, uint32 numDays )
+{
+  tm->year = TEST_BEGYEAR;
+  while ( numDays >= ( IsLeapYear( tm->year ) ? 366UL : 365UL ) )
+  {
+    numDays -= IsLeapYear( tm->year ) ? 366 : 365;
+    tm->year++;
+  }
+
+  tm->month = 0;
+  while ( numDays >= testMonthLength( tm->year, tm->month ) )
+  {
+    numDays -= testMonthLength( tm->year, tm->month );
+    tm->month++;
+  }
+
+  tm->day = (uint8)numDays;
+}
+
+/*********************************************************************
+ * @fn      testCheckSecs
+ *
+ * @brief   Convert a time both ways and check the date against the
+ *          reference.
+ *
+ * @param   secs - time to convert
+ *
+ * @return  none
+ */
+static void testCheckSecs( UTCTime secs )
+{
+  UTCTimeStruct tm, ref;
+
+  osal_ConvertUTCTime( &tm, secs );
+
+  testReference( &ref, secs / TEST_DAY );
+  HOST_CHECK( tm.year == ref.year );
+  HOST_CHECK( tm.month == ref.month );
+  HOST_CHECK( tm.day == ref.day );
+  HOST_CHECK( tm.hour == ( secs % TEST_DAY ) / 3600 );
+  HOST_CHECK( tm.minutes == ( secs % 3600 ) / 60 );
+  HOST_CHECK( tm.seconds == secs % 60 );
+
+  HOST_CHECK( osal_ConvertUTCSecs( &tm ) == secs );
+}
+
+/*********************************************************************
+ * @fn      testConvert
+ *
+ * @brief   Check every day of the UTCTime range at a time of day that
+ *          moves from day to day, both ends of each day, and the last
+ *          second of the range.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testConvert( void )
+{
+  UTCTimeStruct tm;
+  uint32 day;
+
+  for ( day = 0; day < TEST_DAYS - 1; day++ )
+  {
+    testCheckSecs( day * TEST_DAY );
+    testCheckSecs( day * TEST_DAY + testRandom() % TEST_DAY );
+    testCheckSecs( day * TEST_DAY + TEST_DAY - 1 );
+  }
+
+  testCheckSecs( day * TEST_DAY );
+  testCheckSecs( 0xFFFFFFFFUL );
+
+  osal_ConvertUTCTime( &tm, 0xFFFFFFFFUL );
+  HOST_CHECK( ( tm.year == 2136 ) && ( tm.month == 1 ) && ( tm.day == 6 ) );
+  HOST_CHECK( ( tm.hour == 6 ) && ( tm.minutes == 28 ) && ( tm.seconds == 15 ) );
+
+  // Leap days: 2000 is a leap year, 2100 is not
+  osal_ConvertUTCTime( &tm, 59 * TEST_DAY );
+  HOST_CHECK( ( tm.year == 2000 ) && ( tm.month == 1 ) && ( tm.day == 28 ) );
+  tm.year = 2100;
+  tm.month = 2;
+  tm.day = 0;
+  osal_ConvertUTCTime( &tm, osal_ConvertUTCSecs( &tm ) - TEST_DAY );
+  HOST_CHECK( ( tm.year == 2100 ) && ( tm.month == 1 ) && ( tm.day == 27 ) );
+}
+
+/*********************************************************************
+ * @fn      testClockUs
+ *
+ * @brief   Advance the virtual clock in random steps, most of them
+ *          fractions of an LL timer tick, and check that the
+ *          microsecond clock follows it exactly, moves only forwards,
+ *          ignores osal_setClock(), and wraps with it.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testClockUs( void )
+{
+  uint32 last = osal_getClockUs();
+  uint32 now, step;
+  uint32 wraps = 0;
+  uint32 idx;
+
+#if defined ( TEST_CLOCK_LAG )
+  HOST_CHECK( (uint32)( HalClockRead() - last ) < TEST_CLOCK_LAG );
+#else
+  HOST_CHECK( last == HalClockRead() );
+#endif
+
+  for ( idx = 0; idx < TEST_CLOCK_STEPS; idx++ )
+  {
+    step = ( idx & 1 ) ? ( testRandom() % 625 ) : ( testRandom() % TEST_CLOCK_MAX_STEP );
+    HalClockAdvance( step );
+
+    if ( ( idx % 1000 ) == 0 )
+    {
+      osal_setClock( testRandom() );
+    }
+
+    now = osal_getClockUs();
+#if defined ( TEST_CLOCK_LAG )
+    HOST_CHECK( (int32)( HalClockRead() - now ) > -TEST_CLOCK_LEAD );
+    HOST_CHECK( (int32)( HalClockRead() - now ) < TEST_CLOCK_LAG );
+    HOST_CHECK( (int32)( now - last ) >= 0 );
+#else
+    HOST_CHECK( now == HalClockRead() );
+    HOST_CHECK( (uint32)( now - last ) == step );
+#endif
+    wraps += ( now < last );
+    last = now;
+  }
+
+  HOST_CHECK( wraps == 1 );
+}
+
+#if defined ( TEST_CLOCK_LAG )
+/*********************************************************************
+ * @fn      testClockInterp
+ *
+ * @brief   Read the interpolated clock every few microseconds and check
+ *          that, once the LL timer has ticked, it resolves the tick to
+ *          within a step and a sleep timer tick, and never steps back.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testClockInterp( void )
+{
+  uint32 last = osal_getClockUs();
+  uint16 llTick = ll_McuPrecisionCount();
+  uint8 synced = FALSE;
+  uint32 fractions = 0;
+  uint32 now;
+  uint32 idx;
+
+  for ( idx = 0; idx < TEST_INTERP_STEPS; idx++ )
+  {
+    HalClockAdvance( 1 + testRandom() % TEST_INTERP_STEP );
+
+    now = osal_getClockUs();
+    HOST_CHECK( (int32)( HalClockRead() - now ) > -TEST_CLOCK_LEAD );
+    HOST_CHECK( (int32)( now - last ) >= 0 );
+
+    // Until the tick, the fraction counts from a reading long after it
+    synced |= ( ll_McuPrecisionCount() != llTick );
+    if ( synced )
+    {
+      HOST_CHECK( (int32)( HalClockRead() - now ) <= TEST_INTERP_STEP + TEST_CLOCK_LEAD );
+    }
+    fractions += ( ( now % 625 ) != 0 );
+    last = now;
+  }
+
+  // Most readings fall between the LL timer ticks
+  HOST_CHECK( fractions > TEST_INTERP_STEPS / 2 );
+}
+#endif
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the clock tests.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  hostInit( argc, argv, "osal" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  testConvert();
+  testClockUs();
+#if defined ( TEST_CLOCK_LAG )
+  testClockInterp();
+#endif
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
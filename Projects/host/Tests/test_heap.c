@@ -0,0 +1,331 @@
+/*************************************************************************************************
+  Filename:       test_heap.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Heap tests, run against each allocator engine: filling the
+                  small-block bucket, block integrity under random churn, and the
+                  return of all memory once every block is freed.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "OnBoard.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Bound on allocations when filling the heap, far above what fits
+#define TEST_FILL_MAX   ( MAXMEMHEAP )
+
+// Blocks of the small-block bucket (OSALMEM_SMALL_BLKCNT of OSAL_Memory.c)
+#define TEST_SMALL_BLKCNT  8
+
+// Blocks held at once by the churn test
+#define TEST_LIVE_MAX   32
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 testEvents[1];
+static uint32 testRand = 1;
+
+static uint8 *testFill[TEST_FILL_MAX];
+
+static uint8 *testLive[TEST_LIVE_MAX];
+static uint16 testLen[TEST_LIVE_MAX];
+
+// Largest block of the heap right after initialization
+static uint16 testLargest;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 testIdleTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[] =
+{
+  testIdleTask
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents = testEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the test task.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  testEvents[0] = 0;
+}
+
+/*********************************************************************
+ * @fn      testIdleTask
+ *
+ * @brief   The tests run from main(); the task has nothing to do.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 testIdleTask( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+  (void)events;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      testRandom
+ *
+ * @brief   Deterministic pseudo-random numbers (xorshift32).
+ *
+ * @param   none
+ *
+ * @return  Next random number.
+ */
+static uint32 testRandom( void )
+{
+  testRand ^= testRand << 13;
+  testRand ^= testRand >> 17;
+  testRand ^= testRand << 5;
+
+  return testRand;
+}
+
+/*********************************************************************
+ * @fn      testLargestAlloc
+ *
+ * @brief   Find the largest block that can be allocated.
+ *
+ * @param   none
+ *
+ * @return  Size of the largest block in bytes.
+ */
+static uint16 testLargestAlloc( void )
+{
+  uint16 lo = 0;
+  uint16 hi = MAXMEMHEAP;
+  uint16 mid;
+  void *p;
+
+  while ( lo < hi )
+  {
+    mid = (uint16)( ( lo + hi + 1 ) / 2 );
+    p = osal_mem_alloc( mid );
+    if ( p != NULL )
+    {
+      osal_mem_free( p );
+      lo = mid;
+    }
+    else
+    {
+      hi = mid - 1;
+    }
+  }
+
+  return lo;
+}
+
+/*********************************************************************
+ * @fn      testLargestFits
+ *
+ * @brief   Check that the largest block of the fresh heap can be
+ *          allocated again, i.e. that freed blocks were coalesced.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testLargestFits( void )
+{
+  HOST_CHECK( testLargestAlloc() == testLargest );
+}
+
+/*********************************************************************
+ * @fn      testFillSmallBucket
+ *
+ * @brief   Allocate one-byte blocks until the heap is exhausted. The
+ *          small-block bucket fills first and the allocations must
+ *          then move on to the rest of the heap and finally fail.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testFillSmallBucket( void )
+{
+  uint16 cnt;
+  uint16 i;
+  uint8 bad = 0;
+
+  for ( cnt = 0; cnt < TEST_FILL_MAX; cnt++ )
+  {
+    testFill[cnt] = osal_mem_alloc( 1 );
+    if ( testFill[cnt] == NULL )
+    {
+      break;
+    }
+    *testFill[cnt] = (uint8)cnt;
+  }
+
+  HOST_CHECK( cnt < TEST_FILL_MAX );
+  HOST_CHECK( cnt > TEST_SMALL_BLKCNT );
+
+  // Once exhausted, the heap stays exhausted.
+  HOST_CHECK( osal_mem_alloc( 1 ) == NULL );
+
+  for ( i = 0; i < cnt; i++ )
+  {
+    if ( *testFill[i] != (uint8)i )
+    {
+      bad++;
+    }
+    osal_mem_free( testFill[i] );
+  }
+
+  HOST_CHECK( bad == 0 );
+  testLargestFits();
+
+  // The small-block bucket is usable again after the free.
+  testFill[0] = osal_mem_alloc( 1 );
+  HOST_CHECK( testFill[0] != NULL );
+  osal_mem_free( testFill[0] );
+}
+
+/*********************************************************************
+ * @fn      testChurn
+ *
+ * @brief   Allocate and free blocks of random sizes, each filled with
+ *          a pattern that is checked when it is freed.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testChurn( void )
+{
+  uint32 ops;
+  uint16 i, j;
+  uint8 bad = 0;
+
+  for ( ops = 0; ops < 200000; ops++ )
+  {
+    i = (uint16)( testRandom() % TEST_LIVE_MAX );
+
+    if ( testLive[i] == NULL )
+    {
+      testLen[i] = (uint16)( 1 + testRandom() % 200 );
+      testLive[i] = osal_mem_alloc( testLen[i] );
+      if ( testLive[i] != NULL )
+      {
+        osal_memset( testLive[i], (uint8)i, testLen[i] );
+      }
+    }
+    else
+    {
+      for ( j = 0; j < testLen[i]; j++ )
+      {
+        if ( testLive[i][j] != (uint8)i )
+        {
+          bad++;
+          break;
+        }
+      }
+      osal_mem_free( testLive[i] );
+      testLive[i] = NULL;
+    }
+  }
+
+  for ( i = 0; i < TEST_LIVE_MAX; i++ )
+  {
+    if ( testLive[i] != NULL )
+    {
+      osal_mem_free( testLive[i] );
+      testLive[i] = NULL;
+    }
+  }
+
+  HOST_CHECK( bad == 0 );
+  testLargestFits();
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the heap tests.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  hostInit( argc, argv, "heap" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  testLargest = testLargestAlloc();
+  HOST_CHECK( testLargest > 0 );
+
+  testFillSmallBucket();
+  testChurn();
+  testFillSmallBucket();
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,315 @@
+/*************************************************************************************************
+  Filename:       test_run_trace.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Host test of the scheduler trace: the ready, dispatch and run times
+                  recorded for each task, the ring buffer overwriting its oldest records,
+                  and a trace dump for the runtrace tool.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if !( OSAL_RUN_TRACE )
+  #error The scheduler trace test needs the trace (OSAL_RUN_TRACE=TRUE).
+#endif
+
+#define TEST_TASK_CNT       3
+
+// Rounds of the timeline: long enough for the 16-bit tick clock to wrap
+#define TEST_ROUNDS         2000
+
+// Idle ticks after each round
+#define TEST_IDLE_TICKS     25
+
+// Length of an OSAL_RUN_CLOCK() tick
+#define TEST_TICK_USEC      625
+
+// Records the trace ring buffer holds (OSAL_RUN_TRACE_LEN in OSAL.c)
+#define TEST_TRACE_LEN      32
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+// OSAL_RUN_CLOCK() of the host build
+extern uint16 ll_McuPrecisionCount( void );
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 testEvents[TEST_TASK_CNT];
+
+// Ticks each task's event processor runs, highest priority first
+static const uint16 testRunTicks[TEST_TASK_CNT] = { 1, 4, 10 };
+
+static uint8 testRecs[TEST_TRACE_LEN * OSAL_RUN_TRACE_RECSZ];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 testTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[TEST_TASK_CNT] =
+{
+  testTask,
+  testTask,
+  testTask
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents = testEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the test tasks.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  osal_memset( testEvents, 0, sizeof( testEvents ) );
+}
+
+/*********************************************************************
+ * @fn      testTask
+ *
+ * @brief   Take the task's run time of the virtual clock.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 testTask( uint8 task_id, uint16 events )
+{
+  (void)events;
+
+  HalClockAdvance( (uint32)testRunTicks[task_id] * TEST_TICK_USEC );
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      testRound
+ *
+ * @brief   Make every task ready at once, run them all, then idle.
+ *          Task 2 gets a second event every fourth round.
+ *
+ * @param   round - round number
+ *
+ * @return  Clock tick the tasks became ready.
+ */
+static uint16 testRound( uint32 round )
+{
+  uint16 ready = ll_McuPrecisionCount();
+  uint8 id;
+
+  for ( id = 0; id < TEST_TASK_CNT; id++ )
+  {
+    osal_set_event( id, BV( id ) );
+  }
+  if ( ( round % 4 ) == 0 )
+  {
+    osal_set_event( 2, 0x8000 );
+  }
+
+  while ( testEvents[0] | testEvents[1] | testEvents[2] )
+  {
+    osal_run_system();
+  }
+
+  HalClockAdvance( TEST_IDLE_TICKS * TEST_TICK_USEC );
+
+  return ready;
+}
+
+/*********************************************************************
+ * @fn      testTimeline
+ *
+ * @brief   Check the records of each round against the times the
+ *          tasks were made ready and ran: each waits for the run
+ *          times of the tasks above it. Write the records to the dump
+ *          as hex text, one per line, if one was given.
+ *
+ * @param   pDump - dump file, or NULL
+ *
+ * @return  none
+ */
+static void testTimeline( FILE *pDump )
+{
+  uint32 round;
+  uint16 ready;
+  uint16 wait;
+  uint8 cnt;
+  uint8 idx, byte;
+
+  osal_run_trace_enable( TRUE );
+
+  for ( round = 0; round < TEST_ROUNDS; round++ )
+  {
+    ready = testRound( round );
+
+    cnt = osal_run_trace_read( testRecs, TEST_TRACE_LEN );
+    HOST_CHECK( cnt == TEST_TASK_CNT );
+
+    for ( wait = 0, idx = 0; idx < cnt; idx++ )
+    {
+      const uint8 *pRec = &testRecs[idx * OSAL_RUN_TRACE_RECSZ];
+      uint16 events = ( idx == 2 && ( round % 4 ) == 0 ) ? ( BV( idx ) | 0x8000 ) : BV( idx );
+
+      HOST_CHECK( pRec[0] == idx );
+      HOST_CHECK( BUILD_UINT16( pRec[1], pRec[2] ) == events );
+      HOST_CHECK( BUILD_UINT16( pRec[3], pRec[4] ) == ready );
+      HOST_CHECK( BUILD_UINT16( pRec[5], pRec[6] ) == (uint16)( ready + wait ) );
+      HOST_CHECK( BUILD_UINT16( pRec[7], pRec[8] ) == testRunTicks[idx] );
+      wait += testRunTicks[idx];
+
+      if ( pDump != NULL )
+      {
+        for ( byte = 0; byte < OSAL_RUN_TRACE_RECSZ; byte++ )
+        {
+          fprintf( pDump, "%s%02X", byte ? " " : "", pRec[byte] );
+        }
+        fprintf( pDump, "\n" );
+      }
+    }
+  }
+
+  HOST_CHECK( osal_run_trace_dropped() == 0 );
+}
+
+/*********************************************************************
+ * @fn      testOverrun
+ *
+ * @brief   Check that a full ring buffer keeps the newest records and
+ *          counts the ones it overwrote, that stopping the trace stops
+ *          recording, and that starting it again discards the records
+ *          not read.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testOverrun( void )
+{
+  uint32 round;
+  uint8 cnt;
+
+  osal_run_trace_enable( TRUE );
+
+  for ( round = 0; round < 20; round++ )
+  {
+    testRound( round );
+  }
+
+  // The last round's records are the newest three
+  HOST_CHECK( osal_run_trace_dropped() == 20 * TEST_TASK_CNT - TEST_TRACE_LEN );
+  cnt = osal_run_trace_read( testRecs, TEST_TRACE_LEN );
+  HOST_CHECK( cnt == TEST_TRACE_LEN );
+  HOST_CHECK( testRecs[( TEST_TRACE_LEN - 1 ) * OSAL_RUN_TRACE_RECSZ] == TEST_TASK_CNT - 1 );
+  HOST_CHECK( testRecs[( TEST_TRACE_LEN - 3 ) * OSAL_RUN_TRACE_RECSZ] == 0 );
+
+  osal_run_trace_enable( FALSE );
+  testRound( 1 );
+  HOST_CHECK( osal_run_trace_read( testRecs, TEST_TRACE_LEN ) == 0 );
+
+  osal_run_trace_enable( TRUE );
+  testRound( 1 );
+  osal_run_trace_enable( FALSE );
+  osal_run_trace_enable( TRUE );
+  HOST_CHECK( osal_run_trace_read( testRecs, TEST_TRACE_LEN ) == 0 );
+  HOST_CHECK( osal_run_trace_dropped() == 0 );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the scheduler trace tests. The first argument, if any,
+ *          names the dump file to write for the runtrace tool.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  FILE *pDump = NULL;
+
+  hostInit( argc, argv, "osal" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  if ( hostArgCnt > 0 )
+  {
+    pDump = fopen( hostArgs[0], "w" );
+    HOST_CHECK( pDump != NULL );
+  }
+
+  testTimeline( pDump );
+
+  if ( pDump != NULL )
+  {
+    fclose( pDump );
+  }
+
+  testOverrun();
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,390 @@
+/*************************************************************************************************
+  Filename:       test_snv_batch.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Batch writes of SNV: random batches against a model of the items,
+                  with power lost part way through some of them. After the reset every
+                  batch must be found either completely written or not at all.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <setjmp.h>
+
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "osal_snv.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define TEST_ITEM_BASE      0x80
+#define TEST_ITEM_CNT       40
+#define TEST_ITEM_MAX_LEN   20
+#define TEST_BATCH_MAX      6
+
+#define TEST_ROUNDS         30000
+
+// One round in TEST_LOSS_RATE loses power, after up to TEST_LOSS_OPS flash operations
+#define TEST_LOSS_RATE      20
+#define TEST_LOSS_OPS       40
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 testEvents[1];
+static uint32 testRand = 1;
+
+// Model: the value of each item as last committed, length 0 if never written
+static uint8 testLen[TEST_ITEM_CNT];
+static uint8 testValue[TEST_ITEM_CNT][TEST_ITEM_MAX_LEN];
+
+// Simulated reset at a power loss
+static jmp_buf testReset;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 testIdleTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[] =
+{
+  testIdleTask
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents = testEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the test task.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  testEvents[0] = 0;
+}
+
+/*********************************************************************
+ * @fn      testIdleTask
+ *
+ * @brief   The test runs from main(); the task has nothing to do.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 testIdleTask( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+  (void)events;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      testRandom
+ *
+ * @brief   Deterministic pseudo-random numbers (xorshift32).
+ *
+ * @param   none
+ *
+ * @return  Next random number.
+ */
+static uint32 testRandom( void )
+{
+  testRand ^= testRand << 13;
+  testRand ^= testRand >> 17;
+  testRand ^= testRand << 5;
+
+  return testRand;
+}
+
+/*********************************************************************
+ * @fn      testPowerLoss
+ *
+ * @brief   Power loss callback of the flash: reset.
+ *
+ * @param   none
+ *
+ * @return  does not return
+ */
+static void testPowerLoss( void )
+{
+  longjmp( testReset, 1 );
+}
+
+/*********************************************************************
+ * @fn      testHolds
+ *
+ * @brief   Check whether NV holds an item with the given value.
+ *
+ * @param   idx - item index
+ * @param   len - length of the value, 0 for an item never written
+ * @param   pValue - value
+ *
+ * @return  TRUE if NV holds the value
+ */
+static uint8 testHolds( uint8 idx, uint8 len, const uint8 *pValue )
+{
+  uint8 buf[TEST_ITEM_MAX_LEN];
+
+  if ( len == 0 )
+  {
+    return ( osal_snv_read( TEST_ITEM_BASE + idx, 1, buf ) != SUCCESS );
+  }
+
+  return ( ( osal_snv_read( TEST_ITEM_BASE + idx, len, buf ) == SUCCESS ) &&
+           osal_memcmp( buf, pValue, len ) );
+}
+
+/*********************************************************************
+ * @fn      testCheckAll
+ *
+ * @brief   Check that NV holds the model value of every item.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testCheckAll( void )
+{
+  uint8 idx;
+
+  for ( idx = 0; idx < TEST_ITEM_CNT; idx++ )
+  {
+    HOST_CHECK( testHolds( idx, testLen[idx], testValue[idx] ) );
+  }
+}
+
+/*********************************************************************
+ * @fn      testPowerFail
+ *
+ * @brief   Write random batches, and now and then single items, with
+ *          power lost part way through some of them. After each reset
+ *          every item of the interrupted batch must hold its old value
+ *          or every one its new value.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testPowerFail( void )
+{
+  static osalSnvItem_t items[TEST_BATCH_MAX];
+  static uint8 idxs[TEST_BATCH_MAX];
+  static uint8 bufs[TEST_BATCH_MAX][TEST_ITEM_MAX_LEN];
+  static uint8 cnt;
+  static uint32 losses;
+  static uint32 rolledForward;
+  uint32 round;
+  uint8 k, i;
+
+  for ( round = 0; round < TEST_ROUNDS; round++ )
+  {
+    cnt = (uint8)( 1 + testRandom() % TEST_BATCH_MAX );
+
+    for ( k = 0; k < cnt; k++ )
+    {
+      // Distinct items, random contents
+      do
+      {
+        idxs[k] = (uint8)( testRandom() % TEST_ITEM_CNT );
+        for ( i = 0; ( i < k ) && ( idxs[i] != idxs[k] ); i++ );
+      } while ( i < k );
+
+      items[k].id = TEST_ITEM_BASE + idxs[k];
+      items[k].len = (uint8)( 1 + testRandom() % TEST_ITEM_MAX_LEN );
+      items[k].pBuf = bufs[k];
+      for ( i = 0; i < items[k].len; i++ )
+      {
+        bufs[k][i] = (uint8)( testRandom() % 4 );
+      }
+    }
+
+    if ( ( testRandom() % TEST_LOSS_RATE ) == 0 )
+    {
+      HalFlashPowerLoss( (int32)( testRandom() % TEST_LOSS_OPS ), testPowerLoss );
+    }
+
+    if ( setjmp( testReset ) == 0 )
+    {
+      uint8 status;
+
+      if ( ( cnt == 1 ) && ( testRandom() & 1 ) )
+      {
+        status = osal_snv_write( items[0].id, items[0].len, items[0].pBuf );
+      }
+      else
+      {
+        status = osal_snv_write_batch( items, cnt );
+      }
+      HalFlashPowerLoss( -1, NULL );
+
+      HOST_CHECK( status == SUCCESS );
+      for ( k = 0; k < cnt; k++ )
+      {
+        testLen[idxs[k]] = items[k].len;
+        osal_memcpy( testValue[idxs[k]], bufs[k], items[k].len );
+      }
+    }
+    else
+    {
+      uint8 newOnly = FALSE;
+      uint8 oldOnly = FALSE;
+
+      // Reset: the device comes up again and initializes NV
+      losses++;
+      osal_snv_init();
+
+      for ( k = 0; k < cnt; k++ )
+      {
+        uint8 isNew = testHolds( idxs[k], items[k].len, bufs[k] );
+        uint8 isOld = testHolds( idxs[k], testLen[idxs[k]], testValue[idxs[k]] );
+
+        HOST_CHECK( isNew || isOld );
+        newOnly |= ( isNew && !isOld );
+        oldOnly |= ( isOld && !isNew );
+      }
+
+      // All or nothing
+      HOST_CHECK( !( newOnly && oldOnly ) );
+
+      if ( newOnly )
+      {
+        rolledForward++;
+        for ( k = 0; k < cnt; k++ )
+        {
+          testLen[idxs[k]] = items[k].len;
+          osal_memcpy( testValue[idxs[k]], bufs[k], items[k].len );
+        }
+      }
+    }
+
+    testCheckAll();
+  }
+
+  // Power was lost both before and after commit records went down
+  HOST_CHECK( losses > TEST_ROUNDS / TEST_LOSS_RATE / 2 );
+  HOST_CHECK( rolledForward > 0 );
+  HOST_CHECK( rolledForward < losses );
+}
+
+/*********************************************************************
+ * @fn      testDuplicate
+ *
+ * @brief   A batch naming an item twice is refused and writes nothing.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testDuplicate( void )
+{
+  uint8 a[4] = { 1, 1, 1, 1 };
+  uint8 b[4] = { 2, 2, 2, 2 };
+  osalSnvItem_t items[3];
+  uint32 words, wordsBefore;
+
+  items[0].id = TEST_ITEM_BASE;
+  items[0].len = sizeof( a );
+  items[0].pBuf = a;
+  items[1].id = TEST_ITEM_BASE + 1;
+  items[1].len = sizeof( a );
+  items[1].pBuf = a;
+  items[2].id = TEST_ITEM_BASE;
+  items[2].len = sizeof( b );
+  items[2].pBuf = b;
+
+  osal_snv_stats( NULL, &wordsBefore );
+  HOST_CHECK( osal_snv_write_batch( items, 3 ) == INVALIDPARAMETER );
+  osal_snv_stats( NULL, &words );
+
+  HOST_CHECK( words == wordsBefore );
+  testCheckAll();
+
+  // The same batch without the repeat goes through
+  HOST_CHECK( osal_snv_write_batch( items, 2 ) == SUCCESS );
+  testLen[0] = sizeof( a );
+  osal_memcpy( testValue[0], a, sizeof( a ) );
+  testLen[1] = sizeof( a );
+  osal_memcpy( testValue[1], a, sizeof( a ) );
+  testCheckAll();
+
+  // After a reset, too
+  osal_snv_init();
+  testCheckAll();
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the batch write tests.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  hostInit( argc, argv, "osal" );
+
+  osal_snv_init();
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  testPowerFail();
+  testDuplicate();
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,387 @@
+/*************************************************************************************************
+  Filename:       test_snv_compact.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Background SNV compaction on the simulated flash: every step of the
+                  compaction task must block for no longer than its bound, and writes
+                  must never fall back to a blocking compaction.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_board_cfg.h"
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "osal_snv.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if !defined OSAL_SNV_COMPACT_TASK
+  #error The compaction test needs the compaction task (OSAL_SNV_COMPACT_TASK).
+#endif
+
+// Items of a bond-like record set: IDs and lengths
+#define TEST_ITEM_BASE      0x80
+#define TEST_ITEM_CNT       24
+#define TEST_ITEM_MAX_LEN   32
+
+#define TEST_WRITES         20000
+
+// CC2540 flash timing, to turn flash operations into blocking time on the target
+#define TEST_WORD_WRITE_US  20
+#define TEST_PAGE_ERASE_US  20000
+
+// Flash words a copy step may write: a header and the data of each item it
+// examines, and the two page header words that switch the active page
+#define TEST_STEP_MAX_WORDS ( OSAL_SNV_COMPACT_STEP * \
+                              ( 1 + TEST_ITEM_MAX_LEN / HAL_FLASH_WORD_SIZE ) + 2 )
+
+// Task IDs, the compaction task last
+#define TEST_APP_TASK_ID    0
+#define TEST_NV_TASK_ID     1
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 testEvents[2];
+static uint32 testRand = 1;
+
+static uint8 testLen[TEST_ITEM_CNT];
+static uint8 testValue[TEST_ITEM_CNT][TEST_ITEM_MAX_LEN];
+
+static uint32 testSteps;        // Compaction steps run
+static uint32 testEraseSteps;   // Steps that erased a page
+static uint32 testStepMaxUs;    // Longest step, in target microseconds
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 testAppTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[] =
+{
+  testAppTask,
+  osal_snv_CompactProcessEvent
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents = testEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the test tasks.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  osal_memset( testEvents, 0, sizeof( testEvents ) );
+  osal_snv_CompactInit( TEST_NV_TASK_ID );
+}
+
+/*********************************************************************
+ * @fn      testAppTask
+ *
+ * @brief   The test runs from main(); the task has nothing to do.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 testAppTask( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+  (void)events;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      testRandom
+ *
+ * @brief   Deterministic pseudo-random numbers (xorshift32).
+ *
+ * @param   none
+ *
+ * @return  Next random number.
+ */
+static uint32 testRandom( void )
+{
+  testRand ^= testRand << 13;
+  testRand ^= testRand >> 17;
+  testRand ^= testRand << 5;
+
+  return testRand;
+}
+
+/*********************************************************************
+ * @fn      testFlashOps
+ *
+ * @brief   Read the flash words written and the pages erased so far.
+ *
+ * @param   pWords - receives the flash words written
+ * @param   pErases - receives the pages erased
+ *
+ * @return  none
+ */
+static void testFlashOps( uint32 *pWords, uint32 *pErases )
+{
+  osal_snv_stats( NULL, pWords );
+  HalFlashStats( NULL, pErases );
+}
+
+/*********************************************************************
+ * @fn      testRunIdle
+ *
+ * @brief   Run the system until no task is ready, checking the flash
+ *          work of every compaction step against its bound: a copy
+ *          step writes at most TEST_STEP_MAX_WORDS words and erases
+ *          nothing, and the erase step erases one page and writes
+ *          nothing.
+ *
+ * @param   none
+ *
+ * @return  Number of compaction steps run.
+ */
+static uint32 testRunIdle( void )
+{
+  uint32 steps = 0;
+  uint32 words, erases;
+  uint32 wordsBefore, erasesBefore;
+  uint32 us;
+
+  while ( testEvents[TEST_APP_TASK_ID] | testEvents[TEST_NV_TASK_ID] )
+  {
+    uint8 nvReady = ( testEvents[TEST_APP_TASK_ID] == 0 ) &&
+                    ( testEvents[TEST_NV_TASK_ID] != 0 );
+
+    testFlashOps( &wordsBefore, &erasesBefore );
+    osal_run_system();
+    testFlashOps( &words, &erases );
+
+    if ( !nvReady || ( words == wordsBefore && erases == erasesBefore ) )
+    {
+      continue;
+    }
+
+    steps++;
+    if ( erases != erasesBefore )
+    {
+      testEraseSteps++;
+      HOST_CHECK( erases - erasesBefore == 1 );
+      HOST_CHECK( words == wordsBefore );
+    }
+    else
+    {
+      HOST_CHECK( words - wordsBefore <= TEST_STEP_MAX_WORDS );
+    }
+
+    us = ( words - wordsBefore ) * TEST_WORD_WRITE_US +
+         ( erases - erasesBefore ) * TEST_PAGE_ERASE_US;
+    if ( us > testStepMaxUs )
+    {
+      testStepMaxUs = us;
+    }
+  }
+
+  testSteps += steps;
+
+  return steps;
+}
+
+/*********************************************************************
+ * @fn      testWrite
+ *
+ * @brief   Change a byte of a random item and write it. The write
+ *          itself must not erase a page: compaction is left to the
+ *          task.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testWrite( void )
+{
+  uint8 idx = (uint8)( testRandom() % TEST_ITEM_CNT );
+  uint32 erases, erasesBefore;
+
+  testValue[idx][testRandom() % testLen[idx]] = (uint8)testRandom();
+
+  HalFlashStats( NULL, &erasesBefore );
+  HOST_CHECK( osal_snv_write( TEST_ITEM_BASE + idx, testLen[idx], testValue[idx] ) == SUCCESS );
+  HalFlashStats( NULL, &erases );
+
+  HOST_CHECK( erases == erasesBefore );
+}
+
+/*********************************************************************
+ * @fn      testCheckItems
+ *
+ * @brief   Read back every item and compare it with the model.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testCheckItems( void )
+{
+  uint8 buf[TEST_ITEM_MAX_LEN];
+  uint8 idx;
+
+  for ( idx = 0; idx < TEST_ITEM_CNT; idx++ )
+  {
+    HOST_CHECK( osal_snv_read( TEST_ITEM_BASE + idx, testLen[idx], buf ) == SUCCESS );
+    HOST_CHECK( osal_memcmp( buf, testValue[idx], testLen[idx] ) );
+  }
+}
+
+/*********************************************************************
+ * @fn      testFree
+ *
+ * @brief   Compaction runs free: a step is dispatched whenever no other
+ *          task is ready.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testFree( void )
+{
+  uint32 i;
+
+  for ( i = 0; i < TEST_WRITES; i++ )
+  {
+    testWrite();
+    testRunIdle();
+  }
+
+  testCheckItems();
+
+  // Many compactions ran, each ending with its erase step
+  HOST_CHECK( testEraseSteps > 10 );
+  HOST_CHECK( testSteps > testEraseSteps );
+}
+
+/*********************************************************************
+ * @fn      testGated
+ *
+ * @brief   Compaction gated by the application: steps only run in the
+ *          windows it grants, one step per window.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testGated( void )
+{
+  uint32 erasesStart = testEraseSteps;
+  uint32 i;
+
+  osal_snv_compact_gate( TRUE );
+
+  for ( i = 0; i < TEST_WRITES; i++ )
+  {
+    testWrite();
+
+    // No step runs outside a window
+    HOST_CHECK( testRunIdle() == 0 );
+
+    // Two windows per write, e.g. the idle time after connection events
+    osal_snv_compact_window();
+    HOST_CHECK( testRunIdle() <= 1 );
+    osal_snv_compact_window();
+    HOST_CHECK( testRunIdle() <= 1 );
+  }
+
+  osal_snv_compact_gate( FALSE );
+  testRunIdle();
+
+  testCheckItems();
+
+  HOST_CHECK( testEraseSteps > erasesStart + 10 );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the compaction tests.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  uint8 idx;
+
+  hostInit( argc, argv, "osal" );
+
+  osal_snv_init();
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  for ( idx = 0; idx < TEST_ITEM_CNT; idx++ )
+  {
+    testLen[idx] = (uint8)( 4 + ( idx * 7 ) % ( TEST_ITEM_MAX_LEN - 3 ) );
+    osal_memset( testValue[idx], idx, testLen[idx] );
+    HOST_CHECK( osal_snv_write( TEST_ITEM_BASE + idx, testLen[idx], testValue[idx] ) == SUCCESS );
+  }
+
+  testFree();
+  testGated();
+
+  // The longest step is the page erase; no copy step comes near it
+  HOST_CHECK( testStepMaxUs == TEST_PAGE_ERASE_US );
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,390 @@
+/*************************************************************************************************
+  Filename:       test_timer_pool.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Timer pool tests: timer churn within the static pool makes no
+                  heap call at all, as recorded by the heap trace, and timers
+                  beyond the pool take the heap fallback or fail with
+                  NO_TIMER_AVAIL, as configured.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "OSAL_Timers.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define TEST_TASK_CNT     4
+#define TEST_EVT_CNT      16
+#define TEST_TIMER_CNT    ( TEST_TASK_CNT * TEST_EVT_CNT )
+
+// Timers started beyond the pool by the overflow test
+#define TEST_EXTRA_CNT    4
+
+#define TEST_CHURN_OPS    200000
+
+#if ( OSALMEM_TRACE == FALSE )
+  #error The timer pool test reads the heap trace (OSALMEM_TRACE).
+#endif
+
+#if ( OSAL_TIMERS_POOL_CNT + TEST_EXTRA_CNT > TEST_TIMER_CNT )
+  #error The timer pool is too big for the test tasks.
+#endif
+
+/*********************************************************************
+ * MACROS
+ */
+
+#define TEST_TASK( idx )    ( (uint8)( (idx) / TEST_EVT_CNT ) )
+#define TEST_EVT( idx )     ( (uint16)BV( (idx) % TEST_EVT_CNT ) )
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Heap calls found in the trace
+typedef struct
+{
+  uint32 alloc;
+  uint32 free;
+  uint32 fail;
+} testHeapCalls_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 testEvents[TEST_TASK_CNT];
+static uint32 testRand = 1;
+
+static uint32 testFired;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 testTimerTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[TEST_TASK_CNT] =
+{
+  testTimerTask, testTimerTask, testTimerTask, testTimerTask
+};
+
+const uint8 tasksCnt = TEST_TASK_CNT;
+uint16 *tasksEvents = testEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the test tasks.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  osal_memset( testEvents, 0, sizeof( testEvents ) );
+}
+
+/*********************************************************************
+ * @fn      testRandom
+ *
+ * @brief   Deterministic pseudo-random numbers (xorshift32).
+ *
+ * @param   none
+ *
+ * @return  Next random number.
+ */
+static uint32 testRandom( void )
+{
+  testRand ^= testRand << 13;
+  testRand ^= testRand >> 17;
+  testRand ^= testRand << 5;
+
+  return testRand;
+}
+
+/*********************************************************************
+ * @fn      testTimerTask
+ *
+ * @brief   Count the timer events of a task.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 testTimerTask( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+
+  while ( events )
+  {
+    testFired += events & 1;
+    events >>= 1;
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      testRunIdle
+ *
+ * @brief   Run the scheduler until no task has events left.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testRunIdle( void )
+{
+  uint8 idx;
+
+  do
+  {
+    osal_run_system();
+
+    for ( idx = 0; idx < tasksCnt; idx++ )
+    {
+      if ( tasksEvents[idx] )
+      {
+        break;
+      }
+    }
+  } while ( idx < tasksCnt );
+}
+
+/*********************************************************************
+ * @fn      testHeapCalls
+ *
+ * @brief   Drain the heap trace and add up its records by type.
+ *
+ * @param   pCalls - counts to add to
+ *
+ * @return  none
+ */
+static void testHeapCalls( testHeapCalls_t *pCalls )
+{
+  uint8 buf[4 * OSALMEM_TRACE_RECSZ];
+  uint8 cnt, idx;
+  uint16 line;
+
+  while ( ( cnt = osal_mem_trace_read( buf, 4 ) ) != 0 )
+  {
+    for ( idx = 0; idx < cnt; idx++ )
+    {
+      line = BUILD_UINT16( buf[idx * OSALMEM_TRACE_RECSZ + 2], buf[idx * OSALMEM_TRACE_RECSZ + 3] );
+
+      switch ( line & ( OSALMEM_TRACE_FREE | OSALMEM_TRACE_FAIL ) )
+      {
+        case OSALMEM_TRACE_ALLOC:
+          pCalls->alloc++;
+          break;
+        case OSALMEM_TRACE_FREE:
+          pCalls->free++;
+          break;
+        default:
+          pCalls->fail++;
+          break;
+      }
+    }
+  }
+
+  HOST_CHECK( osal_mem_trace_dropped() == 0 );
+}
+
+/*********************************************************************
+ * @fn      testChurn
+ *
+ * @brief   Start, restart, reload, stop and expire timers at random,
+ *          never more at once than the pool holds, and check that the
+ *          timer subsystem made no heap call.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testChurn( void )
+{
+  testHeapCalls_t calls = { 0, 0, 0 };
+  uint32 ops;
+  uint16 idx;
+  uint32 r;
+
+  testFired = 0;
+
+  for ( ops = 0; ops < TEST_CHURN_OPS; ops++ )
+  {
+    idx = (uint16)( testRandom() % OSAL_TIMERS_POOL_CNT );
+    r = testRandom() % 8;
+
+    if ( r < 3 )
+    {
+      HOST_CHECK( osal_start_timerEx( TEST_TASK( idx ), TEST_EVT( idx ),
+                                      (uint16)( 1 + testRandom() % 100 ) ) == SUCCESS );
+    }
+    else if ( r < 4 )
+    {
+      HOST_CHECK( osal_start_reload_timer( TEST_TASK( idx ), TEST_EVT( idx ),
+                                           (uint16)( 1 + testRandom() % 100 ) ) == SUCCESS );
+    }
+    else if ( r < 5 )
+    {
+      osal_stop_timerEx( TEST_TASK( idx ), TEST_EVT( idx ) );
+    }
+    else
+    {
+      HalClockAdvance( ( 1 + testRandom() % 20 ) * 1000UL );
+      testRunIdle();
+    }
+
+    testHeapCalls( &calls );
+  }
+
+  for ( idx = 0; idx < OSAL_TIMERS_POOL_CNT; idx++ )
+  {
+    osal_stop_timerEx( TEST_TASK( idx ), TEST_EVT( idx ) );
+  }
+  testRunIdle();
+  testHeapCalls( &calls );
+
+  HOST_CHECK( testFired > 0 );
+  HOST_CHECK( calls.alloc == 0 );
+  HOST_CHECK( calls.free == 0 );
+  HOST_CHECK( calls.fail == 0 );
+  HOST_CHECK( osal_timer_pool_max() == OSAL_TIMERS_POOL_CNT );
+  HOST_CHECK( osal_timer_pool_cnt() == 0 );
+  HOST_CHECK( osal_timer_pool_overflow() == 0 );
+}
+
+/*********************************************************************
+ * @fn      testOverflow
+ *
+ * @brief   Start TEST_EXTRA_CNT timers more than the pool holds. With
+ *          the heap fallback each extra timer takes one heap block and
+ *          returns it when it expires or is stopped; without it, the
+ *          extra timers fail and the heap is not touched.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testOverflow( void )
+{
+  testHeapCalls_t calls = { 0, 0, 0 };
+  uint16 idx;
+  uint8 status;
+  uint8 started = 0;
+
+  testFired = 0;
+
+  for ( idx = 0; idx < OSAL_TIMERS_POOL_CNT + TEST_EXTRA_CNT; idx++ )
+  {
+    status = osal_start_timerEx( TEST_TASK( idx ), TEST_EVT( idx ), (uint16)( 10 + idx % 2 ) );
+
+    if ( idx < OSAL_TIMERS_POOL_CNT )
+    {
+      HOST_CHECK( status == SUCCESS );
+    }
+    else
+    {
+      HOST_CHECK( status == ( OSAL_TIMERS_POOL_HEAP_FALLBACK ? SUCCESS : NO_TIMER_AVAIL ) );
+    }
+    started += ( status == SUCCESS );
+  }
+
+  testHeapCalls( &calls );
+  HOST_CHECK( calls.alloc == ( OSAL_TIMERS_POOL_HEAP_FALLBACK ? TEST_EXTRA_CNT : 0 ) );
+  HOST_CHECK( osal_timer_pool_cnt() == OSAL_TIMERS_POOL_CNT );
+  HOST_CHECK( osal_timer_pool_overflow() == TEST_EXTRA_CNT );
+  HOST_CHECK( osal_timer_num_active() == started );
+
+  // Half the timers expire and half are stopped, from the pool and from the heap.
+  HalClockAdvance( 10 * 1000UL );
+  testRunIdle();
+  for ( idx = 0; idx < OSAL_TIMERS_POOL_CNT + TEST_EXTRA_CNT; idx++ )
+  {
+    osal_stop_timerEx( TEST_TASK( idx ), TEST_EVT( idx ) );
+  }
+  testRunIdle();
+
+  testHeapCalls( &calls );
+  HOST_CHECK( testFired > 0 );
+  HOST_CHECK( testFired < started );
+  HOST_CHECK( calls.free == calls.alloc );
+  HOST_CHECK( calls.fail == 0 );
+  HOST_CHECK( osal_timer_num_active() == 0 );
+  HOST_CHECK( osal_timer_pool_cnt() == 0 );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the timer pool tests.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  hostInit( argc, argv, "timer_pool" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  // Trace the heap from here on; initialization allocates.
+  osal_mem_trace_enable( TRUE );
+
+  testChurn();
+  testOverflow();
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
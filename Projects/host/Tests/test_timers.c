@@ -0,0 +1,523 @@
+/*************************************************************************************************
+  Filename:       test_timers.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Timer tests against a reference model: random starts, reloads,
+                  and stops of hundreds of timers over clock steps of 1 msec to
+                  5 secs, checking each step that exactly the due timers fired,
+                  never early, and that the remaining times match the model.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "OSAL_Timers.h"
+
+#include "host_harness.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define TEST_TASK_CNT     16
+#define TEST_EVT_CNT      16   // Every event bit of a task runs a timer
+#define TEST_TIMER_CNT    ( TEST_TASK_CNT * TEST_EVT_CNT )
+
+#define TEST_STEPS        30000
+#define TEST_OPS_MAX      8    // Timer operations between clock steps
+
+/*********************************************************************
+ * MACROS
+ */
+
+#define TEST_TASK( idx )    ( (uint8)( (idx) / TEST_EVT_CNT ) )
+#define TEST_EVT( idx )     ( (uint16)BV( (idx) % TEST_EVT_CNT ) )
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Reference model of one timer
+typedef struct
+{
+  uint8  active;
+  uint32 expiry;    // Absolute expiry time in msecs
+  uint16 reload;    // Reload timeout, 0 for a one-shot timer
+} testTimer_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint16 testEvents[TEST_TASK_CNT];
+static uint32 testRand = 1;
+
+// Events dispatched to each task since the last step
+static uint16 testFired[TEST_TASK_CNT];
+
+static testTimer_t testModel[TEST_TIMER_CNT];
+static uint16 testActiveCnt;
+
+// Model time in msecs
+static uint32 testNow;
+
+// Failure counts
+static uint32 testBadFire;
+static uint32 testBadTimeout;
+static uint32 testBadStatus;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16 testTimerTask( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const pTaskEventHandlerFn tasksArr[TEST_TASK_CNT] =
+{
+  testTimerTask, testTimerTask, testTimerTask, testTimerTask,
+  testTimerTask, testTimerTask, testTimerTask, testTimerTask,
+  testTimerTask, testTimerTask, testTimerTask, testTimerTask,
+  testTimerTask, testTimerTask, testTimerTask, testTimerTask
+};
+
+const uint8 tasksCnt = TEST_TASK_CNT;
+uint16 *tasksEvents = testEvents;
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   Initialize the test tasks.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  osal_memset( testEvents, 0, sizeof( testEvents ) );
+}
+
+/*********************************************************************
+ * @fn      testRandom
+ *
+ * @brief   Deterministic pseudo-random numbers (xorshift32).
+ *
+ * @param   none
+ *
+ * @return  Next random number.
+ */
+static uint32 testRandom( void )
+{
+  testRand ^= testRand << 13;
+  testRand ^= testRand >> 17;
+  testRand ^= testRand << 5;
+
+  return testRand;
+}
+
+/*********************************************************************
+ * @fn      testTimeout
+ *
+ * @brief   Pick a random timeout: mostly within one or two levels of
+ *          the wheel, some over the whole 16-bit range. Zero is
+ *          included and expires on the next tick.
+ *
+ * @param   none
+ *
+ * @return  Timeout in msecs.
+ */
+static uint16 testTimeout( void )
+{
+  uint32 r = testRandom() % 100;
+
+  if ( r < 50 )
+  {
+    return (uint16)( testRandom() % 33 );
+  }
+  else if ( r < 85 )
+  {
+    return (uint16)( testRandom() % 2001 );
+  }
+  else
+  {
+    return (uint16)( testRandom() % 0x10000 );
+  }
+}
+
+/*********************************************************************
+ * @fn      testTimerTask
+ *
+ * @brief   Record the events dispatched to a task.
+ *
+ * @param   task_id - task ID
+ * @param   events - events to process
+ *
+ * @return  none left
+ */
+static uint16 testTimerTask( uint8 task_id, uint16 events )
+{
+  testFired[task_id] |= events;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      testRunIdle
+ *
+ * @brief   Run the scheduler until no task has events left.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testRunIdle( void )
+{
+  uint8 idx;
+
+  do
+  {
+    osal_run_system();
+
+    for ( idx = 0; idx < tasksCnt; idx++ )
+    {
+      if ( tasksEvents[idx] )
+      {
+        break;
+      }
+    }
+  } while ( idx < tasksCnt );
+}
+
+/*********************************************************************
+ * @fn      testStart
+ *
+ * @brief   Start (or restart) a timer in OSAL and in the model.
+ *
+ * @param   idx - timer index
+ * @param   reload - TRUE for a reload timer
+ *
+ * @return  none
+ */
+static void testStart( uint16 idx, uint8 reload )
+{
+  testTimer_t *pTimer = &testModel[idx];
+  uint16 timeout = testTimeout();
+  uint8 status;
+
+  if ( reload )
+  {
+    status = osal_start_reload_timer( TEST_TASK( idx ), TEST_EVT( idx ), timeout );
+  }
+  else
+  {
+    status = osal_start_timerEx( TEST_TASK( idx ), TEST_EVT( idx ), timeout );
+  }
+
+  if ( status != SUCCESS )
+  {
+    // Only a new timer can fail, when no record is left.
+    if ( (status != NO_TIMER_AVAIL) || pTimer->active )
+    {
+      testBadStatus++;
+    }
+    return;
+  }
+
+  if ( !pTimer->active )
+  {
+    pTimer->active = TRUE;
+    pTimer->reload = 0;
+    testActiveCnt++;
+  }
+
+  // A restart keeps the reload timeout unless it sets a new one.
+  if ( reload )
+  {
+    pTimer->reload = timeout;
+  }
+  pTimer->expiry = testNow + ( (timeout != 0) ? timeout : 1 );
+}
+
+/*********************************************************************
+ * @fn      testStop
+ *
+ * @brief   Stop a timer in OSAL and in the model.
+ *
+ * @param   idx - timer index
+ *
+ * @return  none
+ */
+static void testStop( uint16 idx )
+{
+  testTimer_t *pTimer = &testModel[idx];
+  uint8 status = osal_stop_timerEx( TEST_TASK( idx ), TEST_EVT( idx ) );
+
+  if ( status != ( pTimer->active ? SUCCESS : INVALID_EVENT_ID ) )
+  {
+    testBadStatus++;
+  }
+
+  if ( pTimer->active )
+  {
+    pTimer->active = FALSE;
+    testActiveCnt--;
+  }
+}
+
+/*********************************************************************
+ * @fn      testCheckTimeout
+ *
+ * @brief   Compare the remaining time of a timer with the model.
+ *
+ * @param   idx - timer index
+ *
+ * @return  none
+ */
+static void testCheckTimeout( uint16 idx )
+{
+  testTimer_t *pTimer = &testModel[idx];
+  uint16 expected = pTimer->active ? (uint16)( pTimer->expiry - testNow ) : 0;
+
+  if ( osal_get_timeoutEx( TEST_TASK( idx ), TEST_EVT( idx ) ) != expected )
+  {
+    testBadTimeout++;
+  }
+}
+
+/*********************************************************************
+ * @fn      testStep
+ *
+ * @brief   Advance the clock, dispatch the timer events and check that
+ *          exactly the timers due within the step fired.
+ *
+ *          The OSAL clock counts 625 usec ticks, so it may lag the step
+ *          by a fraction of a msec; the model follows the OSAL clock.
+ *
+ * @param   msecs - clock step
+ *
+ * @return  none
+ */
+static void testStep( uint16 msecs )
+{
+  uint16 expected[TEST_TASK_CNT];
+  testTimer_t *pTimer;
+  uint32 prev = testNow;
+  uint16 idx;
+
+  HalClockAdvance( msecs * 1000UL );
+  testRunIdle();
+
+  testNow = osal_GetSystemClock();
+  HOST_CHECK( ( testNow - prev + 1 >= msecs ) && ( testNow - prev <= msecs + 1UL ) );
+
+  osal_memset( expected, 0, sizeof( expected ) );
+
+  for ( idx = 0; idx < TEST_TIMER_CNT; idx++ )
+  {
+    pTimer = &testModel[idx];
+
+    if ( pTimer->active && ( pTimer->expiry <= testNow ) )
+    {
+      expected[TEST_TASK( idx )] |= TEST_EVT( idx );
+
+      if ( pTimer->reload )
+      {
+        // A long step may pass several periods; they fire as one event.
+        while ( pTimer->expiry <= testNow )
+        {
+          pTimer->expiry += pTimer->reload;
+        }
+      }
+      else
+      {
+        pTimer->active = FALSE;
+        testActiveCnt--;
+      }
+    }
+  }
+
+  for ( idx = 0; idx < TEST_TASK_CNT; idx++ )
+  {
+    if ( testFired[idx] != expected[idx] )
+    {
+      testBadFire++;
+    }
+    testFired[idx] = 0;
+  }
+}
+
+/*********************************************************************
+ * @fn      testStepLength
+ *
+ * @brief   Pick a random clock step: mostly single ticks, some long
+ *          enough to cross several wheel levels at once.
+ *
+ * @param   none
+ *
+ * @return  Step in msecs.
+ */
+static uint16 testStepLength( void )
+{
+  uint32 r = testRandom() % 100;
+
+  if ( r < 70 )
+  {
+    return 1;
+  }
+  else if ( r < 95 )
+  {
+    return (uint16)( 2 + testRandom() % 299 );
+  }
+  else
+  {
+    return (uint16)( 300 + testRandom() % 4701 );
+  }
+}
+
+/*********************************************************************
+ * @fn      testModelRun
+ *
+ * @brief   Drive OSAL and the model with random timer operations and
+ *          clock steps.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testModelRun( void )
+{
+  uint32 step;
+  uint8 ops;
+  uint16 idx;
+  uint32 r;
+
+  for ( step = 0; step < TEST_STEPS; step++ )
+  {
+    for ( ops = (uint8)( testRandom() % TEST_OPS_MAX ); ops > 0; ops-- )
+    {
+      idx = (uint16)( testRandom() % TEST_TIMER_CNT );
+      r = testRandom() % 8;
+
+      if ( r < 3 )
+      {
+        testStart( idx, FALSE );
+      }
+      else if ( r < 4 )
+      {
+        testStart( idx, TRUE );
+      }
+      else if ( r < 6 )
+      {
+        testStop( idx );
+      }
+      else
+      {
+        testCheckTimeout( idx );
+      }
+    }
+
+    testStep( testStepLength() );
+
+    HOST_CHECK( osal_timer_num_active() == ( (testActiveCnt < 0xFF) ? testActiveCnt : 0xFF ) );
+
+    if ( ( step % 1000 ) == 0 )
+    {
+      for ( idx = 0; idx < TEST_TIMER_CNT; idx++ )
+      {
+        testCheckTimeout( idx );
+      }
+    }
+  }
+
+  HOST_CHECK( testBadFire == 0 );
+  HOST_CHECK( testBadTimeout == 0 );
+  HOST_CHECK( testBadStatus == 0 );
+}
+
+/*********************************************************************
+ * @fn      testStopAll
+ *
+ * @brief   Stop every timer and check that the records were returned.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void testStopAll( void )
+{
+  uint16 idx;
+
+  for ( idx = 0; idx < TEST_TIMER_CNT; idx++ )
+  {
+    testStop( idx );
+  }
+  testRunIdle();
+
+  HOST_CHECK( testActiveCnt == 0 );
+  HOST_CHECK( osal_timer_num_active() == 0 );
+  HOST_CHECK( osal_timer_pool_cnt() == 0 );
+  HOST_CHECK( testBadStatus == 0 );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the timer tests.
+ *
+ * @param   argc, argv - see hostInit()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  hostInit( argc, argv, "timers" );
+
+  osal_init_system();
+  HAL_ENABLE_INTERRUPTS();
+
+  testModelRun();
+  testStopAll();
+
+  return hostResult();
+}
+
+/*********************************************************************
+*********************************************************************/
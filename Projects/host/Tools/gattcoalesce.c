@@ -0,0 +1,538 @@
+/*************************************************************************************************
+  Filename:       gattcoalesce.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Host tool for HCI captures of HostTestApp: splits the
+                  HCI_EXT_GATT_COALESCED_EVENT frames (HCI_EXT_APP_GATT_COALESCE) back into
+                  their notification and read response records.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hal_types.h"
+#include "hal_defs.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// HCI packet types and the vendor specific event code (hci.h)
+#define GCO_CMD_PACKET        0x01
+#define GCO_ACL_PACKET        0x02
+#define GCO_EVENT_PACKET      0x04
+#define GCO_VE_EVENT_CODE     0xFF
+
+// Coalesced event (hci_ext_app.h): the extension event header of event
+// code, status and connection handle, then the record count
+#define GCO_COALESCED_EVENT   0x05FE
+#define GCO_HDR_LEN           5
+#define GCO_CNT_LEN           1
+
+// Record: connection handle (2), ATT method (1), PDU length (1), PDU
+#define GCO_REC_HDR_LEN       4
+
+// ATT methods HostTestApp coalesces (att.h)
+#define GCO_ATT_READ_RSP      0x0B
+#define GCO_ATT_NOTI          0x1B
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint8 gcoJson;
+
+static uint32 gcoPackets;     // HCI packets in the capture
+static uint32 gcoEvents;      // Coalesced events among them
+static uint32 gcoRecords;     // Records decoded from them
+static uint8 gcoErrors;       // A packet or record was cut short
+
+/*********************************************************************
+ * @fn      gcoAlloc
+ *
+ * @brief   realloc() that gives up the program on failure.
+ *
+ * @param   ptr - block to resize, or NULL
+ * @param   size - new size in bytes
+ *
+ * @return  The resized block.
+ */
+static void *gcoAlloc( void *ptr, size_t size )
+{
+  ptr = realloc( ptr, size );
+  if ( ptr == NULL )
+  {
+    fprintf( stderr, "gattcoalesce: out of memory\n" );
+    exit( 2 );
+  }
+
+  return ptr;
+}
+
+/*********************************************************************
+ * @fn      gcoIsText
+ *
+ * @brief   Tell a hex text capture from a binary one: text holds only
+ *          printable characters and white space.
+ *
+ * @param   pBuf - capture
+ * @param   len - capture length
+ *
+ * @return  TRUE for a text capture.
+ */
+static uint8 gcoIsText( const uint8 *pBuf, size_t len )
+{
+  size_t idx;
+
+  for ( idx = 0; idx < len; idx++ )
+  {
+    if ( !isprint( pBuf[idx] ) && !isspace( pBuf[idx] ) )
+    {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      gcoParseHex
+ *
+ * @brief   Convert a hex text capture to bytes in place. Bytes are pairs
+ *          of hex digits, optionally prefixed with 0x and separated by
+ *          anything else, e.g. white space, commas or colons; text
+ *          after '#' up to the end of the line is a comment.
+ *
+ * @param   pBuf - capture, converted in place
+ * @param   len - capture length
+ * @param   path - file name for error messages
+ *
+ * @return  Number of bytes.
+ */
+static size_t gcoParseHex( uint8 *pBuf, size_t len, const char *path )
+{
+  size_t in = 0, out = 0;
+  int digits = 0;
+  uint8 byte = 0;
+  uint8 c;
+
+  while ( in < len )
+  {
+    c = pBuf[in++];
+
+    if ( c == '#' )
+    {
+      while ( ( in < len ) && ( pBuf[in] != '\n' ) )
+      {
+        in++;
+      }
+    }
+    else if ( ( c == '0' ) && ( digits == 0 ) && ( in < len ) &&
+              ( ( pBuf[in] == 'x' ) || ( pBuf[in] == 'X' ) ) )
+    {
+      in++;
+      continue;
+    }
+    else if ( isxdigit( c ) )
+    {
+      byte = (uint8)( ( byte << 4 ) | ( isdigit( c ) ? ( c - '0' ) : ( tolower( c ) - 'a' + 10 ) ) );
+      if ( ++digits == 2 )
+      {
+        pBuf[out++] = byte;
+        digits = 0;
+        byte = 0;
+      }
+      continue;
+    }
+
+    if ( digits != 0 )
+    {
+      fprintf( stderr, "gattcoalesce: %s: odd number of hex digits\n", path );
+      exit( 2 );
+    }
+  }
+
+  if ( digits != 0 )
+  {
+    fprintf( stderr, "gattcoalesce: %s: odd number of hex digits\n", path );
+    exit( 2 );
+  }
+
+  return out;
+}
+
+/*********************************************************************
+ * @fn      gcoMethodName
+ *
+ * @brief   Name of the ATT method of a record.
+ *
+ * @param   method - ATT method
+ *
+ * @return  Method name.
+ */
+static const char *gcoMethodName( uint8 method )
+{
+  static char number[16];
+
+  switch ( method )
+  {
+    case GCO_ATT_NOTI:
+      return "notification";
+
+    case GCO_ATT_READ_RSP:
+      return "read_rsp";
+
+    default:
+      sprintf( number, "method_0x%02X", method );
+      return number;
+  }
+}
+
+/*********************************************************************
+ * @fn      gcoPrintRecord
+ *
+ * @brief   Print one record. A notification PDU starts with the
+ *          attribute handle; a read response PDU is the value alone.
+ *
+ * @param   event - number of the coalesced event in the capture
+ * @param   rec - number of the record in the event
+ * @param   pRec - record, GCO_REC_HDR_LEN bytes and the PDU
+ *
+ * @return  none
+ */
+static void gcoPrintRecord( uint32 event, uint8 rec, const uint8 *pRec )
+{
+  uint16 connHandle = BUILD_UINT16( pRec[0], pRec[1] );
+  uint8 method = pRec[2];
+  uint8 pduLen = pRec[3];
+  const uint8 *pValue = pRec + GCO_REC_HDR_LEN;
+  uint8 valueLen = pduLen;
+  int32 handle = -1;
+  uint8 idx;
+
+  if ( ( method == GCO_ATT_NOTI ) && ( pduLen >= 2 ) )
+  {
+    handle = BUILD_UINT16( pValue[0], pValue[1] );
+    pValue += 2;
+    valueLen -= 2;
+  }
+
+  if ( gcoJson )
+  {
+    printf( "{\"event\":%u,\"record\":%u,\"conn\":%u,\"method\":\"%s\",",
+            (unsigned)event, rec, connHandle, gcoMethodName( method ) );
+    if ( handle >= 0 )
+    {
+      printf( "\"handle\":%d,", (int)handle );
+    }
+    printf( "\"value\":\"" );
+    for ( idx = 0; idx < valueLen; idx++ )
+    {
+      printf( "%02X", pValue[idx] );
+    }
+    printf( "\"}\n" );
+  }
+  else
+  {
+    printf( "  %3u  conn 0x%04X  %-12s", rec, connHandle, gcoMethodName( method ) );
+    if ( handle >= 0 )
+    {
+      printf( "  handle 0x%04X", (unsigned)handle );
+    }
+    printf( "  value" );
+    for ( idx = 0; idx < valueLen; idx++ )
+    {
+      printf( " %02X", pValue[idx] );
+    }
+    printf( "\n" );
+  }
+}
+
+/*********************************************************************
+ * @fn      gcoDecodeEvent
+ *
+ * @brief   Split a coalesced event into its records. Each record must
+ *          end within the event, the event must hold as many records
+ *          as it counts, and nothing may follow the last one.
+ *
+ * @param   pParams - event parameters, from the extension event code
+ * @param   len - parameter length the event declares
+ * @param   avail - parameter bytes in the capture, less than len if the
+ *                  capture ends inside the event
+ * @param   offset - capture offset of the packet, for messages
+ *
+ * @return  none
+ */
+static void gcoDecodeEvent( const uint8 *pParams, uint16 len, uint16 avail, size_t offset )
+{
+  uint32 event = ++gcoEvents;
+  uint16 pos = GCO_HDR_LEN + GCO_CNT_LEN;
+  uint8 cnt, rec;
+
+  if ( avail < pos )
+  {
+    fprintf( stderr, "gattcoalesce: event %u at byte %u: header cut short\n",
+             (unsigned)event, (unsigned)offset );
+    gcoErrors = TRUE;
+    return;
+  }
+
+  cnt = pParams[GCO_HDR_LEN];
+  if ( !gcoJson )
+  {
+    printf( "event %u at byte %u: %u record%s, %u bytes\n",
+            (unsigned)event, (unsigned)offset, cnt, ( cnt == 1 ) ? "" : "s", len );
+  }
+
+  for ( rec = 1; rec <= cnt; rec++ )
+  {
+    if ( ( pos + GCO_REC_HDR_LEN > avail ) ||
+         ( pos + GCO_REC_HDR_LEN + pParams[pos + 3] > avail ) )
+    {
+      fprintf( stderr, "gattcoalesce: event %u: record %u of %u runs past the end of the %s\n",
+               (unsigned)event, rec, cnt, ( avail < len ) ? "capture" : "event" );
+      gcoErrors = TRUE;
+      return;
+    }
+
+    gcoPrintRecord( event, rec, pParams + pos );
+    gcoRecords++;
+    pos += GCO_REC_HDR_LEN + pParams[pos + 3];
+  }
+
+  if ( pos != len )
+  {
+    fprintf( stderr, "gattcoalesce: event %u: %u bytes after the last record\n",
+             (unsigned)event, (unsigned)( len - pos ) );
+    gcoErrors = TRUE;
+  }
+}
+
+/*********************************************************************
+ * @fn      gcoReadCapture
+ *
+ * @brief   Read a capture of the HCI traffic, binary or hex text, split
+ *          it into HCI packets and decode the coalesced events. A packet
+ *          of an unknown type ends the capture, as its length is not
+ *          known.
+ *
+ * @param   pFile - capture file
+ * @param   path - file name for error messages
+ * @param   format - 'b' binary, 'x' hex text, 0 to tell from the contents
+ *
+ * @return  none
+ */
+static void gcoReadCapture( FILE *pFile, const char *path, char format )
+{
+  uint8 *pBuf = NULL;
+  size_t len = 0, size = 0, got;
+  size_t pos = 0;
+  size_t hdrLen, pktLen;
+  const uint8 *pPkt;
+
+  do
+  {
+    if ( len == size )
+    {
+      size = ( size != 0 ) ? ( size * 2 ) : 4096;
+      pBuf = gcoAlloc( pBuf, size );
+    }
+    got = fread( pBuf + len, 1, size - len, pFile );
+    len += got;
+  } while ( got != 0 );
+
+  if ( ( format == 'x' ) || ( ( format == 0 ) && gcoIsText( pBuf, len ) ) )
+  {
+    len = gcoParseHex( pBuf, len, path );
+  }
+
+  while ( pos < len )
+  {
+    pPkt = pBuf + pos;
+
+    // Header length, then the parameter length it gives
+    switch ( pPkt[0] )
+    {
+      case GCO_CMD_PACKET:
+        hdrLen = 4;
+        break;
+
+      case GCO_ACL_PACKET:
+        hdrLen = 5;
+        break;
+
+      case GCO_EVENT_PACKET:
+        hdrLen = 3;
+        break;
+
+      default:
+        fprintf( stderr, "gattcoalesce: %s: unknown packet type 0x%02X at byte %u\n",
+                 path, pPkt[0], (unsigned)pos );
+        gcoErrors = TRUE;
+        free( pBuf );
+        return;
+    }
+
+    if ( pos + hdrLen > len )
+    {
+      fprintf( stderr, "gattcoalesce: %s: capture ends inside the packet header at byte %u\n",
+               path, (unsigned)pos );
+      gcoErrors = TRUE;
+      break;
+    }
+
+    pktLen = ( pPkt[0] == GCO_ACL_PACKET ) ? BUILD_UINT16( pPkt[3], pPkt[4] ) : pPkt[hdrLen - 1];
+    gcoPackets++;
+
+    if ( ( pPkt[0] == GCO_EVENT_PACKET ) && ( pPkt[1] == GCO_VE_EVENT_CODE ) &&
+         ( pktLen >= 2 ) && ( pos + hdrLen + 2 <= len ) &&
+         ( BUILD_UINT16( pPkt[hdrLen], pPkt[hdrLen + 1] ) == GCO_COALESCED_EVENT ) )
+    {
+      size_t avail = len - pos - hdrLen;
+
+      gcoDecodeEvent( pPkt + hdrLen, (uint16)pktLen,
+                      (uint16)( ( avail < pktLen ) ? avail : pktLen ), pos );
+    }
+
+    if ( pos + hdrLen + pktLen > len )
+    {
+      fprintf( stderr, "gattcoalesce: %s: capture ends %u bytes into the %u byte packet at byte %u\n",
+               path, (unsigned)( len - pos - hdrLen ), (unsigned)pktLen, (unsigned)pos );
+      gcoErrors = TRUE;
+      break;
+    }
+
+    pos += hdrLen + pktLen;
+  }
+
+  free( pBuf );
+}
+
+/*********************************************************************
+ * @fn      gcoUsage
+ *
+ * @brief   Print the usage and give up.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void gcoUsage( void )
+{
+  fprintf( stderr,
+    "usage: gattcoalesce [-b | -x] [-j] [capture...]\n"
+    "  Reads HCI packets, each starting with its packet type octet, from the\n"
+    "  captures, or from stdin, and prints the records of every\n"
+    "  HCI_EXT_GATT_COALESCED_EVENT. Exits with 1 if a packet or record is\n"
+    "  cut short.\n"
+    "  -b    captures are binary\n"
+    "  -x    captures are hex text (default: told from the contents)\n"
+    "  -j    print one JSON object per record\n" );
+  exit( 2 );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Read the captures and print the coalesced records.
+ *
+ * @param   argc, argv - see gcoUsage()
+ *
+ * @return  0, or 1 if a packet or record was cut short
+ */
+int main( int argc, char **argv )
+{
+  FILE *pFile;
+  char format = 0;
+  uint8 captures = 0;
+  int i;
+
+  for ( i = 1; ( i < argc ) && ( argv[i][0] == '-' ) && ( argv[i][1] != '\0' ); i++ )
+  {
+    if ( strcmp( argv[i], "-b" ) == 0 )
+    {
+      format = 'b';
+    }
+    else if ( strcmp( argv[i], "-x" ) == 0 )
+    {
+      format = 'x';
+    }
+    else if ( strcmp( argv[i], "-j" ) == 0 )
+    {
+      gcoJson = TRUE;
+    }
+    else
+    {
+      gcoUsage();
+    }
+  }
+
+  for ( ; i < argc; i++ )
+  {
+    pFile = ( strcmp( argv[i], "-" ) == 0 ) ? stdin : fopen( argv[i], "rb" );
+    if ( pFile == NULL )
+    {
+      fprintf( stderr, "gattcoalesce: cannot open %s\n", argv[i] );
+      return 2;
+    }
+    gcoReadCapture( pFile, argv[i], format );
+    if ( pFile != stdin )
+    {
+      fclose( pFile );
+    }
+    captures++;
+  }
+
+  if ( captures == 0 )
+  {
+    gcoReadCapture( stdin, "stdin", format );
+  }
+
+  if ( !gcoJson )
+  {
+    printf( "%u packets, %u coalesced events, %u records\n",
+            (unsigned)gcoPackets, (unsigned)gcoEvents, (unsigned)gcoRecords );
+  }
+
+  return gcoErrors ? 1 : 0;
+}
+
+/*********************************************************************
+*********************************************************************/
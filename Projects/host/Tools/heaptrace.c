@@ -0,0 +1,675 @@
+/*************************************************************************************************
+  Filename:       heaptrace.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Host tool turning heap trace dumps (OSALMEM_TRACE records read
+                  out with HCI_EXT_UTIL_HEAP_TRACE) into per call site histograms
+                  of the block lengths allocated, freed and failed.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hal_types.h"
+#include "hal_defs.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Trace record: site, line and event type, length and time, each a uint16 LSB first
+#define TRC_RECSZ         8
+
+// Event type in the two MSBs of the line number (OSALMEM_TRACE_ in OSAL_Memory.h)
+#define TRC_TYPE_MASK     0xC000
+#define TRC_ALLOC         0x0000
+#define TRC_FREE          0x4000
+#define TRC_FAIL          0x8000
+
+// Histogram buckets: bucket n counts lengths of 2^(n-1)+1 to 2^n bytes
+#define TRC_BUCKETS       16
+
+#define TRC_NAME_LEN      64
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Heap calls of one call site
+typedef struct
+{
+  uint16 site;
+  uint16 line;
+  uint32 cnt[3];                    // Allocs, frees and failures
+  uint32 bytes[3];                  // Total length of each
+  uint16 minLen;                    // Shortest and longest block requested
+  uint16 maxLen;
+  uint32 hist[3][TRC_BUCKETS];      // Lengths of each by bucket
+} trcSite_t;
+
+// Name of a site from the map file
+typedef struct
+{
+  uint16 site;
+  char name[TRC_NAME_LEN];
+} trcName_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static const char *trcTypeName[3] = { "alloc", "free", "fail" };
+
+static trcSite_t *trcSites;
+static uint32 trcSiteCnt;
+
+static trcName_t *trcNames;
+static uint32 trcNameCnt;
+
+static uint32 trcRecCnt;
+static uint32 trcSpan;       // Msecs from the first to the last record
+static uint16 trcLastTime;
+
+/*********************************************************************
+ * @fn      trcAlloc
+ *
+ * @brief   realloc() that gives up the program on failure.
+ *
+ * @param   ptr - block to resize, or NULL
+ * @param   size - new size in bytes
+ *
+ * @return  The resized block.
+ */
+static void *trcAlloc( void *ptr, size_t size )
+{
+  ptr = realloc( ptr, size );
+  if ( ptr == NULL )
+  {
+    fprintf( stderr, "heaptrace: out of memory\n" );
+    exit( 2 );
+  }
+
+  return ptr;
+}
+
+/*********************************************************************
+ * @fn      trcBucket
+ *
+ * @brief   Histogram bucket of a block length.
+ *
+ * @param   len - block length
+ *
+ * @return  Bucket: the number of bits needed for len - 1.
+ */
+static uint8 trcBucket( uint16 len )
+{
+  uint8 bucket = 0;
+
+  if ( len > 0 )
+  {
+    len--;
+  }
+  while ( len != 0 )
+  {
+    len >>= 1;
+    bucket++;
+  }
+
+  return ( bucket < TRC_BUCKETS ) ? bucket : ( TRC_BUCKETS - 1 );
+}
+
+/*********************************************************************
+ * @fn      trcSiteName
+ *
+ * @brief   Name of a call site from the map file, or its number.
+ *
+ * @param   site - site number
+ *
+ * @return  Site name.
+ */
+static const char *trcSiteName( uint16 site )
+{
+  static char number[8];
+  uint32 idx;
+
+  for ( idx = 0; idx < trcNameCnt; idx++ )
+  {
+    if ( trcNames[idx].site == site )
+    {
+      return trcNames[idx].name;
+    }
+  }
+
+  if ( site == 0 )
+  {
+    return "(unknown)";
+  }
+
+  sprintf( number, "0x%04X", site );
+  return number;
+}
+
+/*********************************************************************
+ * @fn      trcAddRecord
+ *
+ * @brief   Count a trace record against its call site.
+ *
+ * @param   pRec - TRC_RECSZ bytes of the record
+ *
+ * @return  none
+ */
+static void trcAddRecord( const uint8 *pRec )
+{
+  uint16 site = BUILD_UINT16( pRec[0], pRec[1] );
+  uint16 line = BUILD_UINT16( pRec[2], pRec[3] );
+  uint16 len  = BUILD_UINT16( pRec[4], pRec[5] );
+  uint16 time = BUILD_UINT16( pRec[6], pRec[7] );
+  trcSite_t *pSite = NULL;
+  uint8 type;
+  uint32 idx;
+
+  switch ( line & TRC_TYPE_MASK )
+  {
+    case TRC_ALLOC:
+      type = 0;
+      break;
+    case TRC_FREE:
+      type = 1;
+      break;
+    default:
+      type = 2;
+      break;
+  }
+  line &= ~TRC_TYPE_MASK;
+
+  // The time stamp is the low 16 bits of the msec clock.
+  if ( trcRecCnt != 0 )
+  {
+    trcSpan += (uint16)( time - trcLastTime );
+  }
+  trcLastTime = time;
+  trcRecCnt++;
+
+  for ( idx = 0; idx < trcSiteCnt; idx++ )
+  {
+    if ( ( trcSites[idx].site == site ) && ( trcSites[idx].line == line ) )
+    {
+      pSite = &trcSites[idx];
+      break;
+    }
+  }
+
+  if ( pSite == NULL )
+  {
+    trcSites = trcAlloc( trcSites, ( trcSiteCnt + 1 ) * sizeof( trcSite_t ) );
+    pSite = &trcSites[trcSiteCnt++];
+    memset( pSite, 0, sizeof( trcSite_t ) );
+    pSite->site = site;
+    pSite->line = line;
+    pSite->minLen = 0xFFFF;
+  }
+
+  pSite->cnt[type]++;
+  pSite->bytes[type] += len;
+  pSite->hist[type][trcBucket( len )]++;
+  if ( type != 1 )
+  {
+    if ( len < pSite->minLen )
+    {
+      pSite->minLen = len;
+    }
+    if ( len > pSite->maxLen )
+    {
+      pSite->maxLen = len;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      trcReadMap
+ *
+ * @brief   Read a site name map: one "<site> <name>" pair per line,
+ *          the site in hex as printed by heaptrace, the name e.g. the
+ *          file whose name string the linker map places at that
+ *          address. Text after '#' is a comment.
+ *
+ * @param   path - map file
+ *
+ * @return  none
+ */
+static void trcReadMap( const char *path )
+{
+  FILE *pFile = fopen( path, "r" );
+  char line[256];
+  char name[TRC_NAME_LEN];
+  unsigned long site;
+  char *pHash;
+
+  if ( pFile == NULL )
+  {
+    fprintf( stderr, "heaptrace: cannot open %s\n", path );
+    exit( 2 );
+  }
+
+  while ( fgets( line, sizeof( line ), pFile ) != NULL )
+  {
+    pHash = strchr( line, '#' );
+    if ( pHash != NULL )
+    {
+      *pHash = '\0';
+    }
+
+    if ( sscanf( line, "%lx %63s", &site, name ) == 2 )
+    {
+      trcNames = trcAlloc( trcNames, ( trcNameCnt + 1 ) * sizeof( trcName_t ) );
+      trcNames[trcNameCnt].site = (uint16)site;
+      strcpy( trcNames[trcNameCnt].name, name );
+      trcNameCnt++;
+    }
+  }
+
+  fclose( pFile );
+}
+
+/*********************************************************************
+ * @fn      trcIsText
+ *
+ * @brief   Tell a hex text dump from a binary one: text holds only
+ *          printable characters and white space.
+ *
+ * @param   pBuf - dump
+ * @param   len - dump length
+ *
+ * @return  TRUE for a text dump.
+ */
+static uint8 trcIsText( const uint8 *pBuf, size_t len )
+{
+  size_t idx;
+
+  for ( idx = 0; idx < len; idx++ )
+  {
+    if ( !isprint( pBuf[idx] ) && !isspace( pBuf[idx] ) )
+    {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      trcParseHex
+ *
+ * @brief   Convert a hex text dump to bytes in place. Bytes are pairs
+ *          of hex digits, optionally prefixed with 0x and separated by
+ *          anything else, e.g. white space, commas or colons; text
+ *          after '#' up to the end of the line is a comment.
+ *
+ * @param   pBuf - dump, converted in place
+ * @param   len - dump length
+ * @param   path - file name for error messages
+ *
+ * @return  Number of bytes.
+ */
+static size_t trcParseHex( uint8 *pBuf, size_t len, const char *path )
+{
+  size_t in = 0, out = 0;
+  int digits = 0;
+  uint8 byte = 0;
+  uint8 c;
+
+  while ( in < len )
+  {
+    c = pBuf[in++];
+
+    if ( c == '#' )
+    {
+      while ( ( in < len ) && ( pBuf[in] != '\n' ) )
+      {
+        in++;
+      }
+    }
+    else if ( ( c == '0' ) && ( digits == 0 ) && ( in < len ) &&
+              ( ( pBuf[in] == 'x' ) || ( pBuf[in] == 'X' ) ) )
+    {
+      in++;
+      continue;
+    }
+    else if ( isxdigit( c ) )
+    {
+      byte = (uint8)( ( byte << 4 ) | ( isdigit( c ) ? ( c - '0' ) : ( tolower( c ) - 'a' + 10 ) ) );
+      if ( ++digits == 2 )
+      {
+        pBuf[out++] = byte;
+        digits = 0;
+        byte = 0;
+      }
+      continue;
+    }
+
+    if ( digits != 0 )
+    {
+      fprintf( stderr, "heaptrace: %s: odd number of hex digits\n", path );
+      exit( 2 );
+    }
+  }
+
+  if ( digits != 0 )
+  {
+    fprintf( stderr, "heaptrace: %s: odd number of hex digits\n", path );
+    exit( 2 );
+  }
+
+  return out;
+}
+
+/*********************************************************************
+ * @fn      trcReadDump
+ *
+ * @brief   Read a trace dump, binary or hex text, and count its
+ *          records.
+ *
+ * @param   pFile - dump file
+ * @param   path - file name for error messages
+ * @param   format - 'b' binary, 'x' hex text, 0 to tell from the contents
+ *
+ * @return  none
+ */
+static void trcReadDump( FILE *pFile, const char *path, char format )
+{
+  uint8 *pBuf = NULL;
+  size_t len = 0, size = 0, got;
+  size_t idx;
+
+  do
+  {
+    if ( len == size )
+    {
+      size = ( size != 0 ) ? ( size * 2 ) : 4096;
+      pBuf = trcAlloc( pBuf, size );
+    }
+    got = fread( pBuf + len, 1, size - len, pFile );
+    len += got;
+  } while ( got != 0 );
+
+  if ( ( format == 'x' ) || ( ( format == 0 ) && trcIsText( pBuf, len ) ) )
+  {
+    len = trcParseHex( pBuf, len, path );
+  }
+
+  if ( ( len % TRC_RECSZ ) != 0 )
+  {
+    fprintf( stderr, "heaptrace: %s: %u bytes left over after the last whole record\n",
+             path, (unsigned)( len % TRC_RECSZ ) );
+  }
+
+  for ( idx = 0; idx + TRC_RECSZ <= len; idx += TRC_RECSZ )
+  {
+    trcAddRecord( pBuf + idx );
+  }
+
+  free( pBuf );
+}
+
+/*********************************************************************
+ * @fn      trcSiteCmp
+ *
+ * @brief   qsort() order of the sites: most allocated bytes first.
+ *
+ * @param   a, b - sites
+ *
+ * @return  Comparison result.
+ */
+static int trcSiteCmp( const void *a, const void *b )
+{
+  const trcSite_t *pA = a;
+  const trcSite_t *pB = b;
+  uint32 heavyA = pA->bytes[0] + pA->bytes[2];
+  uint32 heavyB = pB->bytes[0] + pB->bytes[2];
+
+  if ( heavyA != heavyB )
+  {
+    return ( heavyA > heavyB ) ? -1 : 1;
+  }
+  if ( pA->site != pB->site )
+  {
+    return ( pA->site < pB->site ) ? -1 : 1;
+  }
+  return ( pA->line < pB->line ) ? -1 : ( pA->line > pB->line );
+}
+
+/*********************************************************************
+ * @fn      trcPrintText
+ *
+ * @brief   Print a table of the sites, each followed by the histograms
+ *          of its calls.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void trcPrintText( void )
+{
+  trcSite_t *pSite;
+  uint32 idx;
+  uint8 type, bucket;
+
+  printf( "%u records over %u ms, %u call sites\n\n",
+          (unsigned)trcRecCnt, (unsigned)trcSpan, (unsigned)trcSiteCnt );
+  printf( "%-24s %5s %8s %8s %8s %10s %6s %6s\n",
+          "site", "line", "allocs", "frees", "fails", "allocated", "min", "max" );
+
+  for ( idx = 0; idx < trcSiteCnt; idx++ )
+  {
+    pSite = &trcSites[idx];
+
+    printf( "%-24s %5u %8u %8u %8u %10u %6u %6u\n",
+            trcSiteName( pSite->site ), pSite->line,
+            (unsigned)pSite->cnt[0], (unsigned)pSite->cnt[1], (unsigned)pSite->cnt[2],
+            (unsigned)pSite->bytes[0],
+            ( pSite->minLen != 0xFFFF ) ? pSite->minLen : 0, pSite->maxLen );
+
+    for ( type = 0; type < 3; type++ )
+    {
+      if ( pSite->cnt[type] == 0 )
+      {
+        continue;
+      }
+
+      printf( "    %-5s", trcTypeName[type] );
+      for ( bucket = 0; bucket < TRC_BUCKETS; bucket++ )
+      {
+        if ( pSite->hist[type][bucket] != 0 )
+        {
+          printf( " <=%u:%u", 1U << bucket, (unsigned)pSite->hist[type][bucket] );
+        }
+      }
+      printf( "\n" );
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      trcPrintJson
+ *
+ * @brief   Print one JSON object per site.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void trcPrintJson( void )
+{
+  trcSite_t *pSite;
+  uint32 idx;
+  uint8 type, bucket;
+  uint8 first;
+
+  for ( idx = 0; idx < trcSiteCnt; idx++ )
+  {
+    pSite = &trcSites[idx];
+
+    printf( "{\"site\":\"%s\",\"line\":%u", trcSiteName( pSite->site ), pSite->line );
+    for ( type = 0; type < 3; type++ )
+    {
+      printf( ",\"%ss\":%u,\"%s_bytes\":%u", trcTypeName[type], (unsigned)pSite->cnt[type],
+              trcTypeName[type], (unsigned)pSite->bytes[type] );
+    }
+    for ( type = 0; type < 3; type++ )
+    {
+      printf( ",\"%s_hist\":{", trcTypeName[type] );
+      for ( first = TRUE, bucket = 0; bucket < TRC_BUCKETS; bucket++ )
+      {
+        if ( pSite->hist[type][bucket] != 0 )
+        {
+          printf( "%s\"%u\":%u", first ? "" : ",", 1U << bucket, (unsigned)pSite->hist[type][bucket] );
+          first = FALSE;
+        }
+      }
+      printf( "}" );
+    }
+    printf( "}\n" );
+  }
+}
+
+/*********************************************************************
+ * @fn      trcUsage
+ *
+ * @brief   Print the usage and give up.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void trcUsage( void )
+{
+  fprintf( stderr,
+    "usage: heaptrace [-b | -x] [-j] [-m map] [dump...]\n"
+    "  Reads heap trace records (HCI_EXT_HEAP_TRACE_READ payloads without the\n"
+    "  record count octet) from the dumps, or from stdin, and prints the calls\n"
+    "  and block length histograms of each call site.\n"
+    "  -b    dumps are binary\n"
+    "  -x    dumps are hex text (default: told from the contents)\n"
+    "  -j    print one JSON object per site\n"
+    "  -m    read site names from a map of \"<site hex> <name>\" lines\n" );
+  exit( 2 );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Read the dumps and print the per site histograms.
+ *
+ * @param   argc, argv - see trcUsage()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  FILE *pFile;
+  char format = 0;
+  uint8 json = FALSE;
+  uint8 dumps = 0;
+  int i;
+
+  for ( i = 1; ( i < argc ) && ( argv[i][0] == '-' ) && ( argv[i][1] != '\0' ); i++ )
+  {
+    if ( strcmp( argv[i], "-b" ) == 0 )
+    {
+      format = 'b';
+    }
+    else if ( strcmp( argv[i], "-x" ) == 0 )
+    {
+      format = 'x';
+    }
+    else if ( strcmp( argv[i], "-j" ) == 0 )
+    {
+      json = TRUE;
+    }
+    else if ( ( strcmp( argv[i], "-m" ) == 0 ) && ( i + 1 < argc ) )
+    {
+      trcReadMap( argv[++i] );
+    }
+    else
+    {
+      trcUsage();
+    }
+  }
+
+  for ( ; i < argc; i++ )
+  {
+    pFile = ( strcmp( argv[i], "-" ) == 0 ) ? stdin : fopen( argv[i], "rb" );
+    if ( pFile == NULL )
+    {
+      fprintf( stderr, "heaptrace: cannot open %s\n", argv[i] );
+      return 2;
+    }
+    trcReadDump( pFile, argv[i], format );
+    if ( pFile != stdin )
+    {
+      fclose( pFile );
+    }
+    dumps++;
+  }
+
+  if ( dumps == 0 )
+  {
+    trcReadDump( stdin, "stdin", format );
+  }
+
+  if ( trcSiteCnt != 0 )
+  {
+    qsort( trcSites, trcSiteCnt, sizeof( trcSite_t ), trcSiteCmp );
+  }
+
+  if ( json )
+  {
+    trcPrintJson();
+  }
+  else
+  {
+    trcPrintText();
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,794 @@
+/*************************************************************************************************
+  Filename:       runtrace.c
+  Revised:        $Date: 2011-08-10 10:00:00 -0700 (Wed, 10 Aug 2011) $
+  Revision:       $Revision: 27000 $
+
+  Description:    Host tool for scheduler trace dumps (OSAL_RUN_TRACE records read
+                  out with HCI_EXT_UTIL_RUN_TRACE): per task latency and run time
+                  histograms, CPU share, and a Chrome trace / Perfetto timeline.
+
+
+  Copyright 2006-2010 Texas Instruments Incorporated. All rights reserved.
+
+  IMPORTANT: Your use of this Software is limited to those specific rights
+  granted under the terms of a software license agreement between the user
+  who downloaded the software, his/her employer (which must be your employer)
+  and Texas Instruments Incorporated (the "License").  You may not use this
+  Software unless you agree to abide by the terms of the License. The License
+  limits your use, and you acknowledge, that the Software may not be modified,
+  copied or distributed unless embedded on a Texas Instruments microcontroller
+  or used solely and exclusively in conjunction with a Texas Instruments radio
+  frequency transceiver, which is integrated into your product.  Other than for
+  the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+  works of, modify, distribute, perform, display or sell this Software and/or
+  its documentation for any purpose.
+
+  YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+  PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+  INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+  NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+  TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+  NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+  LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+  INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+  OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+  OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+  (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+  Should you have any questions regarding your right to use this Software,
+  contact Texas Instruments Incorporated at www.TI.com.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hal_types.h"
+#include "hal_defs.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Trace record: task ID, then events, ready time, dispatch time and duration,
+// each a uint16 LSB first (OSAL_RUN_TRACE_RECSZ in OSAL.h)
+#define RTR_RECSZ         9
+
+// Task IDs a record can hold
+#define RTR_TASK_CNT      256
+
+// Histogram buckets: bucket n counts times of 2^(n-1)+1 to 2^n ticks
+#define RTR_BUCKETS       17
+
+// Length in microseconds of an OSAL_RUN_CLOCK() tick: ll_McuPrecisionCount()
+#define RTR_TICK_USEC     625.0
+
+#define RTR_NAME_LEN      32
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// One task dispatch, its times unwrapped onto one timeline in ticks
+typedef struct
+{
+  uint32 dispatch;
+  uint16 wait;
+  uint16 duration;
+  uint16 events;
+  uint8 taskID;
+} rtrRec_t;
+
+// Dispatches of one task
+typedef struct
+{
+  uint32 runs;
+  uint32 busy;                  // Ticks the event processor ran
+  uint32 waitTotal;             // Ticks from ready to dispatch
+  uint16 waitMax;
+  uint16 durMax;
+  uint32 waitHist[RTR_BUCKETS];
+  uint32 durHist[RTR_BUCKETS];
+  uint32 evtRuns[16];           // Dispatches with each event bit
+  uint32 evtBusy[16];           // and the ticks they ran
+  char name[RTR_NAME_LEN];      // From the map file, empty if none
+} rtrTask_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static rtrTask_t rtrTasks[RTR_TASK_CNT];
+
+static rtrRec_t *rtrRecs;
+static uint32 rtrRecCnt;
+static uint32 rtrRecSize;
+
+static uint16 rtrLastDispatch;  // Dispatch time of the last record, as recorded
+static uint32 rtrClock;         // and on the unwrapped timeline
+
+static double rtrTickUsec = RTR_TICK_USEC;
+
+/*********************************************************************
+ * @fn      rtrAlloc
+ *
+ * @brief   realloc() that gives up the program on failure.
+ *
+ * @param   ptr - block to resize, or NULL
+ * @param   size - new size in bytes
+ *
+ * @return  The resized block.
+ */
+static void *rtrAlloc( void *ptr, size_t size )
+{
+  ptr = realloc( ptr, size );
+  if ( ptr == NULL )
+  {
+    fprintf( stderr, "runtrace: out of memory\n" );
+    exit( 2 );
+  }
+
+  return ptr;
+}
+
+/*********************************************************************
+ * @fn      rtrBucket
+ *
+ * @brief   Histogram bucket of a time.
+ *
+ * @param   ticks - time
+ *
+ * @return  Bucket: the number of bits needed for ticks - 1.
+ */
+static uint8 rtrBucket( uint16 ticks )
+{
+  uint8 bucket = 0;
+
+  if ( ticks > 0 )
+  {
+    ticks--;
+  }
+  while ( ticks != 0 )
+  {
+    ticks >>= 1;
+    bucket++;
+  }
+
+  return bucket;
+}
+
+/*********************************************************************
+ * @fn      rtrTaskName
+ *
+ * @brief   Name of a task from the map file, or its ID.
+ *
+ * @param   taskID - task ID
+ *
+ * @return  Task name.
+ */
+static const char *rtrTaskName( uint8 taskID )
+{
+  static char number[16];
+
+  if ( rtrTasks[taskID].name[0] != '\0' )
+  {
+    return rtrTasks[taskID].name;
+  }
+
+  sprintf( number, "task %u", taskID );
+  return number;
+}
+
+/*********************************************************************
+ * @fn      rtrAddRecord
+ *
+ * @brief   Place a trace record on the timeline and count it against
+ *          its task. Records are in dispatch order, so each dispatch
+ *          time follows the last one modulo 2^16.
+ *
+ * @param   pRec - RTR_RECSZ bytes of the record
+ *
+ * @return  none
+ */
+static void rtrAddRecord( const uint8 *pRec )
+{
+  uint8 taskID    = pRec[0];
+  uint16 events   = BUILD_UINT16( pRec[1], pRec[2] );
+  uint16 ready    = BUILD_UINT16( pRec[3], pRec[4] );
+  uint16 dispatch = BUILD_UINT16( pRec[5], pRec[6] );
+  uint16 duration = BUILD_UINT16( pRec[7], pRec[8] );
+  uint16 wait = (uint16)( dispatch - ready );
+  rtrTask_t *pTask = &rtrTasks[taskID];
+  rtrRec_t *pOut;
+  uint8 bit;
+
+  if ( rtrRecCnt == 0 )
+  {
+    // Leave room on the timeline for the wait of the first record
+    rtrClock = 0x10000;
+  }
+  else
+  {
+    rtrClock += (uint16)( dispatch - rtrLastDispatch );
+  }
+  rtrLastDispatch = dispatch;
+
+  if ( rtrRecCnt == rtrRecSize )
+  {
+    rtrRecSize = ( rtrRecSize != 0 ) ? ( rtrRecSize * 2 ) : 1024;
+    rtrRecs = rtrAlloc( rtrRecs, rtrRecSize * sizeof( rtrRec_t ) );
+  }
+  pOut = &rtrRecs[rtrRecCnt++];
+  pOut->dispatch = rtrClock;
+  pOut->wait = wait;
+  pOut->duration = duration;
+  pOut->events = events;
+  pOut->taskID = taskID;
+
+  pTask->runs++;
+  pTask->busy += duration;
+  pTask->waitTotal += wait;
+  pTask->waitHist[rtrBucket( wait )]++;
+  pTask->durHist[rtrBucket( duration )]++;
+  if ( wait > pTask->waitMax )
+  {
+    pTask->waitMax = wait;
+  }
+  if ( duration > pTask->durMax )
+  {
+    pTask->durMax = duration;
+  }
+
+  for ( bit = 0; bit < 16; bit++ )
+  {
+    if ( events & BV( bit ) )
+    {
+      pTask->evtRuns[bit]++;
+      pTask->evtBusy[bit] += duration;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      rtrReadMap
+ *
+ * @brief   Read a task name map: one "<task ID> <name>" pair per line,
+ *          the ID in decimal, in the order of tasksArr[]. Text after
+ *          '#' is a comment.
+ *
+ * @param   path - map file
+ *
+ * @return  none
+ */
+static void rtrReadMap( const char *path )
+{
+  FILE *pFile = fopen( path, "r" );
+  char line[256];
+  char name[RTR_NAME_LEN];
+  unsigned id;
+  char *pHash;
+
+  if ( pFile == NULL )
+  {
+    fprintf( stderr, "runtrace: cannot open %s\n", path );
+    exit( 2 );
+  }
+
+  while ( fgets( line, sizeof( line ), pFile ) != NULL )
+  {
+    pHash = strchr( line, '#' );
+    if ( pHash != NULL )
+    {
+      *pHash = '\0';
+    }
+
+    if ( ( sscanf( line, "%u %31s", &id, name ) == 2 ) && ( id < RTR_TASK_CNT ) )
+    {
+      strcpy( rtrTasks[id].name, name );
+    }
+  }
+
+  fclose( pFile );
+}
+
+/*********************************************************************
+ * @fn      rtrIsText
+ *
+ * @brief   Tell a hex text dump from a binary one: text holds only
+ *          printable characters and white space.
+ *
+ * @param   pBuf - dump
+ * @param   len - dump length
+ *
+ * @return  TRUE for a text dump.
+ */
+static uint8 rtrIsText( const uint8 *pBuf, size_t len )
+{
+  size_t idx;
+
+  for ( idx = 0; idx < len; idx++ )
+  {
+    if ( !isprint( pBuf[idx] ) && !isspace( pBuf[idx] ) )
+    {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      rtrParseHex
+ *
+ * @brief   Convert a hex text dump to bytes in place. Bytes are pairs
+ *          of hex digits, optionally prefixed with 0x and separated by
+ *          anything else, e.g. white space, commas or colons; text
+ *          after '#' up to the end of the line is a comment.
+ *
+ * @param   pBuf - dump, converted in place
+ * @param   len - dump length
+ * @param   path - file name for error messages
+ *
+ * @return  Number of bytes.
+ */
+static size_t rtrParseHex( uint8 *pBuf, size_t len, const char *path )
+{
+  size_t in = 0, out = 0;
+  int digits = 0;
+  uint8 byte = 0;
+  uint8 c;
+
+  while ( in < len )
+  {
+    c = pBuf[in++];
+
+    if ( c == '#' )
+    {
+      while ( ( in < len ) && ( pBuf[in] != '\n' ) )
+      {
+        in++;
+      }
+    }
+    else if ( ( c == '0' ) && ( digits == 0 ) && ( in < len ) &&
+              ( ( pBuf[in] == 'x' ) || ( pBuf[in] == 'X' ) ) )
+    {
+      in++;
+      continue;
+    }
+    else if ( isxdigit( c ) )
+    {
+      byte = (uint8)( ( byte << 4 ) | ( isdigit( c ) ? ( c - '0' ) : ( tolower( c ) - 'a' + 10 ) ) );
+      if ( ++digits == 2 )
+      {
+        pBuf[out++] = byte;
+        digits = 0;
+        byte = 0;
+      }
+      continue;
+    }
+
+    if ( digits != 0 )
+    {
+      fprintf( stderr, "runtrace: %s: odd number of hex digits\n", path );
+      exit( 2 );
+    }
+  }
+
+  if ( digits != 0 )
+  {
+    fprintf( stderr, "runtrace: %s: odd number of hex digits\n", path );
+    exit( 2 );
+  }
+
+  return out;
+}
+
+/*********************************************************************
+ * @fn      rtrReadDump
+ *
+ * @brief   Read a trace dump, binary or hex text, and add its records.
+ *
+ * @param   pFile - dump file
+ * @param   path - file name for error messages
+ * @param   format - 'b' binary, 'x' hex text, 0 to tell from the contents
+ *
+ * @return  none
+ */
+static void rtrReadDump( FILE *pFile, const char *path, char format )
+{
+  uint8 *pBuf = NULL;
+  size_t len = 0, size = 0, got;
+  size_t idx;
+
+  do
+  {
+    if ( len == size )
+    {
+      size = ( size != 0 ) ? ( size * 2 ) : 4096;
+      pBuf = rtrAlloc( pBuf, size );
+    }
+    got = fread( pBuf + len, 1, size - len, pFile );
+    len += got;
+  } while ( got != 0 );
+
+  if ( ( format == 'x' ) || ( ( format == 0 ) && rtrIsText( pBuf, len ) ) )
+  {
+    len = rtrParseHex( pBuf, len, path );
+  }
+
+  if ( ( len % RTR_RECSZ ) != 0 )
+  {
+    fprintf( stderr, "runtrace: %s: %u bytes left over after the last whole record\n",
+             path, (unsigned)( len % RTR_RECSZ ) );
+  }
+
+  for ( idx = 0; idx + RTR_RECSZ <= len; idx += RTR_RECSZ )
+  {
+    rtrAddRecord( pBuf + idx );
+  }
+
+  free( pBuf );
+}
+
+/*********************************************************************
+ * @fn      rtrSpan
+ *
+ * @brief   Ticks from the first dispatch to the end of the last one.
+ *
+ * @param   none
+ *
+ * @return  Span, at least 1.
+ */
+static uint32 rtrSpan( void )
+{
+  uint32 end = 0;
+  uint32 idx;
+
+  if ( rtrRecCnt == 0 )
+  {
+    return 1;
+  }
+
+  for ( idx = 0; idx < rtrRecCnt; idx++ )
+  {
+    if ( rtrRecs[idx].dispatch + rtrRecs[idx].duration > end )
+    {
+      end = rtrRecs[idx].dispatch + rtrRecs[idx].duration;
+    }
+  }
+
+  return ( end > rtrRecs[0].dispatch ) ? ( end - rtrRecs[0].dispatch ) : 1;
+}
+
+/*********************************************************************
+ * @fn      rtrPrintHist
+ *
+ * @brief   Print the non-empty buckets of a histogram.
+ *
+ * @param   label - histogram label
+ * @param   pHist - RTR_BUCKETS counts
+ *
+ * @return  none
+ */
+static void rtrPrintHist( const char *label, const uint32 *pHist )
+{
+  uint8 bucket;
+
+  printf( "    %-6s", label );
+  for ( bucket = 0; bucket < RTR_BUCKETS; bucket++ )
+  {
+    if ( pHist[bucket] != 0 )
+    {
+      printf( " <=%lu:%u", 1UL << bucket, (unsigned)pHist[bucket] );
+    }
+  }
+  printf( "\n" );
+}
+
+/*********************************************************************
+ * @fn      rtrPrintText
+ *
+ * @brief   Print a table of the tasks, each followed by the histograms
+ *          of its waits and run times, in ticks, and the share of its
+ *          run time spent on dispatches with each event bit.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void rtrPrintText( void )
+{
+  uint32 span = rtrSpan();
+  uint32 busy = 0;
+  uint32 tasks = 0;
+  uint32 id;
+  uint8 bit;
+
+  for ( id = 0; id < RTR_TASK_CNT; id++ )
+  {
+    busy += rtrTasks[id].busy;
+    tasks += ( rtrTasks[id].runs != 0 );
+  }
+
+  printf( "%u records over %u ticks of %g us, %u tasks, %.1f%% busy\n\n",
+          (unsigned)rtrRecCnt, (unsigned)span, rtrTickUsec, (unsigned)tasks,
+          100.0 * busy / span );
+  printf( "%-16s %8s %6s %10s %10s %10s %10s %10s\n",
+          "task", "runs", "cpu%", "busy us", "run avg", "run max", "wait avg", "wait max" );
+
+  for ( id = 0; id < RTR_TASK_CNT; id++ )
+  {
+    rtrTask_t *pTask = &rtrTasks[id];
+
+    if ( pTask->runs == 0 )
+    {
+      continue;
+    }
+
+    printf( "%-16s %8u %6.1f %10.0f %10.0f %10.0f %10.0f %10.0f\n",
+            rtrTaskName( (uint8)id ), (unsigned)pTask->runs, 100.0 * pTask->busy / span,
+            pTask->busy * rtrTickUsec,
+            pTask->busy * rtrTickUsec / pTask->runs, pTask->durMax * rtrTickUsec,
+            pTask->waitTotal * rtrTickUsec / pTask->runs, pTask->waitMax * rtrTickUsec );
+
+    rtrPrintHist( "wait", pTask->waitHist );
+    rtrPrintHist( "run", pTask->durHist );
+
+    printf( "    %-6s", "events" );
+    for ( bit = 0; bit < 16; bit++ )
+    {
+      if ( pTask->evtRuns[bit] != 0 )
+      {
+        printf( " 0x%04X:%u/%.0f%%", BV( bit ), (unsigned)pTask->evtRuns[bit],
+                pTask->busy ? 100.0 * pTask->evtBusy[bit] / pTask->busy : 0.0 );
+      }
+    }
+    printf( "\n" );
+  }
+}
+
+/*********************************************************************
+ * @fn      rtrPrintJson
+ *
+ * @brief   Print one JSON object per task, times in microseconds.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void rtrPrintJson( void )
+{
+  uint32 span = rtrSpan();
+  uint32 id;
+  uint8 bucket;
+  uint8 first;
+
+  for ( id = 0; id < RTR_TASK_CNT; id++ )
+  {
+    rtrTask_t *pTask = &rtrTasks[id];
+
+    if ( pTask->runs == 0 )
+    {
+      continue;
+    }
+
+    printf( "{\"task\":%u,\"name\":\"%s\",\"runs\":%u,\"cpu_share\":%.4f,"
+            "\"busy_us\":%.0f,\"run_max_us\":%.0f,\"wait_avg_us\":%.1f,\"wait_max_us\":%.0f",
+            (unsigned)id, rtrTaskName( (uint8)id ), (unsigned)pTask->runs,
+            (double)pTask->busy / span, pTask->busy * rtrTickUsec, pTask->durMax * rtrTickUsec,
+            pTask->waitTotal * rtrTickUsec / pTask->runs, pTask->waitMax * rtrTickUsec );
+
+    printf( ",\"wait_hist\":{" );
+    for ( first = TRUE, bucket = 0; bucket < RTR_BUCKETS; bucket++ )
+    {
+      if ( pTask->waitHist[bucket] != 0 )
+      {
+        printf( "%s\"%lu\":%u", first ? "" : ",", 1UL << bucket, (unsigned)pTask->waitHist[bucket] );
+        first = FALSE;
+      }
+    }
+    printf( "},\"run_hist\":{" );
+    for ( first = TRUE, bucket = 0; bucket < RTR_BUCKETS; bucket++ )
+    {
+      if ( pTask->durHist[bucket] != 0 )
+      {
+        printf( "%s\"%lu\":%u", first ? "" : ",", 1UL << bucket, (unsigned)pTask->durHist[bucket] );
+        first = FALSE;
+      }
+    }
+    printf( "}}\n" );
+  }
+}
+
+/*********************************************************************
+ * @fn      rtrWriteChrome
+ *
+ * @brief   Write the timeline in the Chrome trace event format, which
+ *          chrome://tracing and Perfetto open: a track per task with a
+ *          slice for each wait and each run.
+ *
+ * @param   path - output file
+ *
+ * @return  none
+ */
+static void rtrWriteChrome( const char *path )
+{
+  FILE *pFile = fopen( path, "w" );
+  uint32 origin = 0;
+  uint32 idx, id;
+
+  if ( pFile == NULL )
+  {
+    fprintf( stderr, "runtrace: cannot create %s\n", path );
+    exit( 2 );
+  }
+
+  // Time 0 is the earliest ready time
+  if ( rtrRecCnt != 0 )
+  {
+    origin = rtrRecs[0].dispatch - rtrRecs[0].wait;
+  }
+  for ( idx = 1; idx < rtrRecCnt; idx++ )
+  {
+    if ( rtrRecs[idx].dispatch - rtrRecs[idx].wait < origin )
+    {
+      origin = rtrRecs[idx].dispatch - rtrRecs[idx].wait;
+    }
+  }
+
+  fprintf( pFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+  fprintf( pFile, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"OSAL\"}}" );
+
+  for ( id = 0; id < RTR_TASK_CNT; id++ )
+  {
+    if ( rtrTasks[id].runs != 0 )
+    {
+      fprintf( pFile, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+               "\"args\":{\"name\":\"%s\"}}", (unsigned)id, rtrTaskName( (uint8)id ) );
+    }
+  }
+
+  for ( idx = 0; idx < rtrRecCnt; idx++ )
+  {
+    rtrRec_t *pRec = &rtrRecs[idx];
+    double start = ( pRec->dispatch - origin ) * rtrTickUsec;
+
+    if ( pRec->wait != 0 )
+    {
+      fprintf( pFile, ",\n{\"name\":\"ready\",\"cat\":\"wait\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+               "\"ts\":%.1f,\"dur\":%.1f}",
+               pRec->taskID, start - pRec->wait * rtrTickUsec, pRec->wait * rtrTickUsec );
+    }
+    fprintf( pFile, ",\n{\"name\":\"0x%04X\",\"cat\":\"run\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+             "\"ts\":%.1f,\"dur\":%.1f,\"args\":{\"events\":\"0x%04X\",\"wait_us\":%.1f}}",
+             pRec->events, pRec->taskID, start, pRec->duration * rtrTickUsec,
+             pRec->events, pRec->wait * rtrTickUsec );
+  }
+
+  fprintf( pFile, "\n]}\n" );
+  fclose( pFile );
+}
+
+/*********************************************************************
+ * @fn      rtrUsage
+ *
+ * @brief   Print the usage and give up.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void rtrUsage( void )
+{
+  fprintf( stderr,
+    "usage: runtrace [-b | -x] [-j] [-m map] [-t usec] [-c chrome.json] [dump...]\n"
+    "  Reads scheduler trace records (HCI_EXT_RUN_TRACE_READ payloads without\n"
+    "  the record count octet) from the dumps, or from stdin, in the order read\n"
+    "  out, and prints the waits, run times and CPU share of each task.\n"
+    "  -b    dumps are binary\n"
+    "  -x    dumps are hex text (default: told from the contents)\n"
+    "  -j    print one JSON object per task\n"
+    "  -m    read task names from a map of \"<task ID> <name>\" lines\n"
+    "  -t    microseconds per OSAL_RUN_CLOCK() tick (default 625)\n"
+    "  -c    write the timeline for chrome://tracing or Perfetto\n" );
+  exit( 2 );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Read the dumps and print the per task statistics.
+ *
+ * @param   argc, argv - see rtrUsage()
+ *
+ * @return  Process exit status.
+ */
+int main( int argc, char **argv )
+{
+  FILE *pFile;
+  const char *pChrome = NULL;
+  char format = 0;
+  uint8 json = FALSE;
+  uint8 dumps = 0;
+  int i;
+
+  for ( i = 1; ( i < argc ) && ( argv[i][0] == '-' ) && ( argv[i][1] != '\0' ); i++ )
+  {
+    if ( strcmp( argv[i], "-b" ) == 0 )
+    {
+      format = 'b';
+    }
+    else if ( strcmp( argv[i], "-x" ) == 0 )
+    {
+      format = 'x';
+    }
+    else if ( strcmp( argv[i], "-j" ) == 0 )
+    {
+      json = TRUE;
+    }
+    else if ( ( strcmp( argv[i], "-m" ) == 0 ) && ( i + 1 < argc ) )
+    {
+      rtrReadMap( argv[++i] );
+    }
+    else if ( ( strcmp( argv[i], "-t" ) == 0 ) && ( i + 1 < argc ) )
+    {
+      rtrTickUsec = atof( argv[++i] );
+      if ( rtrTickUsec <= 0 )
+      {
+        rtrUsage();
+      }
+    }
+    else if ( ( strcmp( argv[i], "-c" ) == 0 ) && ( i + 1 < argc ) )
+    {
+      pChrome = argv[++i];
+    }
+    else
+    {
+      rtrUsage();
+    }
+  }
+
+  for ( ; i < argc; i++ )
+  {
+    pFile = ( strcmp( argv[i], "-" ) == 0 ) ? stdin : fopen( argv[i], "rb" );
+    if ( pFile == NULL )
+    {
+      fprintf( stderr, "runtrace: cannot open %s\n", argv[i] );
+      return 2;
+    }
+    rtrReadDump( pFile, argv[i], format );
+    if ( pFile != stdin )
+    {
+      fclose( pFile );
+    }
+    dumps++;
+  }
+
+  if ( dumps == 0 )
+  {
+    rtrReadDump( stdin, "stdin", format );
+  }
+
+  if ( json )
+  {
+    rtrPrintJson();
+  }
+  else
+  {
+    rtrPrintText();
+  }
+
+  if ( pChrome != NULL )
+  {
+    rtrWriteChrome( pChrome );
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+*********************************************************************/